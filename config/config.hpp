@@ -120,6 +120,12 @@ struct SystemConfig {
         int max_retry_attempts = 12;        // 最大重试次数（60秒/5秒=12次）
         bool wait_for_device = true;        // 等待设备连接
         std::string decode_mode = "cuda";  // 解码模式: cpu, cuda, vaapi
+        int frame_pool_size = 16;           // 帧缓冲池容量(应覆盖流水线中同时在途的帧数)
+        float playback_rate = 1.0f;         // 视频文件回放倍速，1为按原始帧率，0为不限速(尽快读取)
+        int read_timeout_ms = 2000;         // 网络流打开和读帧超时(毫秒，FFmpeg后端)，超时即断流重连
+        int stale_timeout_ms = 500;         // 实时源超过该时间无新帧时重复交付最后一帧并标记为stale
+        int reconnect_initial_ms = 250;     // 断流重连的初始退避(毫秒)，每次失败加倍
+        int reconnect_max_ms = 10000;       // 重连退避上限(毫秒)
         
         // 从JSON加载
         void fromJson(const json& j) {
@@ -128,6 +134,10 @@ struct SystemConfig {
             if (j.contains("height")) height = j["height"];
             if (j.contains("fps")) fps = j["fps"];
             if (j.contains("enable_roi")) enable_roi = j["enable_roi"];
+            if (j.contains("roi_rect") && j["roi_rect"].is_array() && j["roi_rect"].size() == 4) {
+                std::vector<int> r = j["roi_rect"].get<std::vector<int>>();
+                roi_rect = cv::Rect(r[0], r[1], r[2], r[3]);
+            }
             if (j.contains("correct_distortion")) correct_distortion = j["correct_distortion"];
             
             // 连接配置
@@ -135,6 +145,13 @@ struct SystemConfig {
             if (j.contains("retry_interval_sec")) retry_interval_sec = j["retry_interval_sec"];
             if (j.contains("max_retry_attempts")) max_retry_attempts = j["max_retry_attempts"];
             if (j.contains("wait_for_device")) wait_for_device = j["wait_for_device"];
+            if (j.contains("decode_mode")) decode_mode = j["decode_mode"];
+            if (j.contains("frame_pool_size")) frame_pool_size = j["frame_pool_size"];
+            if (j.contains("playback_rate")) playback_rate = j["playback_rate"];
+            if (j.contains("read_timeout_ms")) read_timeout_ms = j["read_timeout_ms"];
+            if (j.contains("stale_timeout_ms")) stale_timeout_ms = j["stale_timeout_ms"];
+            if (j.contains("reconnect_initial_ms")) reconnect_initial_ms = j["reconnect_initial_ms"];
+            if (j.contains("reconnect_max_ms")) reconnect_max_ms = j["reconnect_max_ms"];
         }
         
         // 转换为JSON
@@ -145,6 +162,7 @@ struct SystemConfig {
             j["height"] = height;
             j["fps"] = fps;
             j["enable_roi"] = enable_roi;
+            j["roi_rect"] = {roi_rect.x, roi_rect.y, roi_rect.width, roi_rect.height};
             j["correct_distortion"] = correct_distortion;
             
             // 连接配置
@@ -152,6 +170,13 @@ struct SystemConfig {
             j["retry_interval_sec"] = retry_interval_sec;
             j["max_retry_attempts"] = max_retry_attempts;
             j["wait_for_device"] = wait_for_device;
+            j["decode_mode"] = decode_mode;
+            j["frame_pool_size"] = frame_pool_size;
+            j["playback_rate"] = playback_rate;
+            j["read_timeout_ms"] = read_timeout_ms;
+            j["stale_timeout_ms"] = stale_timeout_ms;
+            j["reconnect_initial_ms"] = reconnect_initial_ms;
+            j["reconnect_max_ms"] = reconnect_max_ms;
             return j;
         }
     } video;
@@ -166,6 +191,21 @@ struct SystemConfig {
         float nms_threshold = 0.45f;                       // NMS阈值
         std::string precision = "fp16";                    // 精度: fp32, fp16, int8
         std::string calibration_path = "data/calibration"; // 校准数据路径(INT8时使用)
+        int batch_size = 1;                                // 流水线批量推理大小(需模型支持动态batch)
+        int max_batch_wait_ms = 5;                         // 凑批最长等待时间(毫秒)
+        std::string backend = "auto";                      // 推理后端: auto, opencv, tensorrt, onnxruntime
+        int device_id = 0;                                 // GPU设备编号
+        int workspace_mb = 1024;                           // TensorRT构建引擎时的工作空间(MB)
+        std::string engine_cache_dir = "models/cache";     // 编译引擎缓存目录(按模型哈希、精度和GPU区分，空为不缓存)
+        bool letterbox = true;                             // 等比缩放并填充(false为直接拉伸)
+        bool tiling = false;                               // 切片推理：高分辨率帧按原分辨率切片检测远处小目标
+        int tile_width = 0;                                // 切片宽度(像素，0为网络输入宽度)
+        int tile_height = 0;                               // 切片高度(像素，0为网络输入高度)
+        float tile_overlap = 0.2f;                         // 相邻切片的重叠比例
+        float tile_band_top = 0.3f;                        // 切片覆盖的水平带上沿(相对帧高，远处目标集中在地平线附近)
+        float tile_band_bottom = 0.7f;                     // 切片覆盖的水平带下沿(相对帧高)
+        bool tile_coarse_pass = true;                      // 另做一次全图缩放检测，覆盖近处大目标
+        float tile_merge_threshold = 0.6f;                 // 跨切片合并阈值(交集占较小框的比例)
         
         // 从JSON加载
         void fromJson(const json& j) {
@@ -177,6 +217,21 @@ struct SystemConfig {
             if (j.contains("nms_threshold")) nms_threshold = j["nms_threshold"];
             if (j.contains("precision")) precision = j["precision"];
             if (j.contains("calibration_path")) calibration_path = j["calibration_path"];
+            if (j.contains("batch_size")) batch_size = j["batch_size"];
+            if (j.contains("max_batch_wait_ms")) max_batch_wait_ms = j["max_batch_wait_ms"];
+            if (j.contains("backend")) backend = j["backend"];
+            if (j.contains("device_id")) device_id = j["device_id"];
+            if (j.contains("workspace_mb")) workspace_mb = j["workspace_mb"];
+            if (j.contains("engine_cache_dir")) engine_cache_dir = j["engine_cache_dir"];
+            if (j.contains("letterbox")) letterbox = j["letterbox"];
+            if (j.contains("tiling")) tiling = j["tiling"];
+            if (j.contains("tile_width")) tile_width = j["tile_width"];
+            if (j.contains("tile_height")) tile_height = j["tile_height"];
+            if (j.contains("tile_overlap")) tile_overlap = j["tile_overlap"];
+            if (j.contains("tile_band_top")) tile_band_top = j["tile_band_top"];
+            if (j.contains("tile_band_bottom")) tile_band_bottom = j["tile_band_bottom"];
+            if (j.contains("tile_coarse_pass")) tile_coarse_pass = j["tile_coarse_pass"];
+            if (j.contains("tile_merge_threshold")) tile_merge_threshold = j["tile_merge_threshold"];
         }
         
         // 转换为JSON
@@ -189,7 +244,22 @@ struct SystemConfig {
                 {"confidence_threshold", confidence_threshold},
                 {"nms_threshold", nms_threshold},
                 {"precision", precision},
-                {"calibration_path", calibration_path}
+                {"calibration_path", calibration_path},
+                {"batch_size", batch_size},
+                {"max_batch_wait_ms", max_batch_wait_ms},
+                {"backend", backend},
+                {"device_id", device_id},
+                {"workspace_mb", workspace_mb},
+                {"engine_cache_dir", engine_cache_dir},
+                {"letterbox", letterbox},
+                {"tiling", tiling},
+                {"tile_width", tile_width},
+                {"tile_height", tile_height},
+                {"tile_overlap", tile_overlap},
+                {"tile_band_top", tile_band_top},
+                {"tile_band_bottom", tile_band_bottom},
+                {"tile_coarse_pass", tile_coarse_pass},
+                {"tile_merge_threshold", tile_merge_threshold}
             };
         }
     } detector;
@@ -202,6 +272,10 @@ struct SystemConfig {
         float iou_threshold = 0.3f;         // IOU阈值
         bool use_appearance = true;         // 是否使用外观特征
         std::string reid_model_path = "models/reid.engine"; // ReID模型路径
+        int reid_input_width = 64;          // ReID输入宽度
+        int reid_input_height = 128;        // ReID输入高度
+        float max_cosine_distance = 0.2f;   // 外观匹配的最大余弦距离
+        int gallery_size = 32;              // 每条轨迹保存的外观特征数
         
         // 从JSON加载
         void fromJson(const json& j) {
@@ -211,6 +285,10 @@ struct SystemConfig {
             if (j.contains("iou_threshold")) iou_threshold = j["iou_threshold"];
             if (j.contains("use_appearance")) use_appearance = j["use_appearance"];
             if (j.contains("reid_model_path")) reid_model_path = j["reid_model_path"];
+            if (j.contains("reid_input_width")) reid_input_width = j["reid_input_width"];
+            if (j.contains("reid_input_height")) reid_input_height = j["reid_input_height"];
+            if (j.contains("max_cosine_distance")) max_cosine_distance = j["max_cosine_distance"];
+            if (j.contains("gallery_size")) gallery_size = j["gallery_size"];
         }
         
         // 转换为JSON
@@ -221,7 +299,11 @@ struct SystemConfig {
                 {"min_hits", min_hits},
                 {"iou_threshold", iou_threshold},
                 {"use_appearance", use_appearance},
-                {"reid_model_path", reid_model_path}
+                {"reid_model_path", reid_model_path},
+                {"reid_input_width", reid_input_width},
+                {"reid_input_height", reid_input_height},
+                {"max_cosine_distance", max_cosine_distance},
+                {"gallery_size", gallery_size}
             };
         }
     } tracker;
@@ -233,6 +315,8 @@ struct SystemConfig {
         int trajectory_history_length = 30; // 轨迹历史长度
         float pedestrian_running_threshold = 2.5f; // 行人奔跑速度阈值(米/秒)
         float non_motor_speeding_threshold = 5.0f; // 非机动车超速阈值(米/秒)
+        std::string distance_model = "bbox"; // 测距模型: bbox(框高估算), ground_plane(相机几何地面投影)
+        float max_distance = 50.0f;         // 测距上限(米)
         
         // 从JSON加载
         void fromJson(const json& j) {
@@ -241,6 +325,8 @@ struct SystemConfig {
             if (j.contains("trajectory_history_length")) trajectory_history_length = j["trajectory_history_length"];
             if (j.contains("pedestrian_running_threshold")) pedestrian_running_threshold = j["pedestrian_running_threshold"];
             if (j.contains("non_motor_speeding_threshold")) non_motor_speeding_threshold = j["non_motor_speeding_threshold"];
+            if (j.contains("distance_model")) distance_model = j["distance_model"];
+            if (j.contains("max_distance")) max_distance = j["max_distance"];
         }
         
         // 转换为JSON
@@ -250,7 +336,9 @@ struct SystemConfig {
                 {"collision_risk_ttc", collision_risk_ttc},
                 {"trajectory_history_length", trajectory_history_length},
                 {"pedestrian_running_threshold", pedestrian_running_threshold},
-                {"non_motor_speeding_threshold", non_motor_speeding_threshold}
+                {"non_motor_speeding_threshold", non_motor_speeding_threshold},
+                {"distance_model", distance_model},
+                {"max_distance", max_distance}
             };
         }
     } behavior;
@@ -261,6 +349,9 @@ struct SystemConfig {
         std::string type = "api";          // 类型: local, api
         std::string server_address = "http://localhost:8000"; // 服务器地址
         int analysis_interval = 10;        // 分析间隔(帧)
+        int min_interval_ms = 1000;        // 同一视频流两次请求的最小间隔(毫秒)
+        int queue_size = 2;                // 待处理请求队列容量(满时丢弃最旧请求)
+        int cache_size = 512;              // 结果缓存条目数
         int max_tokens = 100;              // 最大生成tokens
         float temperature = 0.3f;          // 温度参数
         
@@ -270,6 +361,9 @@ struct SystemConfig {
             if (j.contains("type")) type = j["type"];
             if (j.contains("server_address")) server_address = j["server_address"];
             if (j.contains("analysis_interval")) analysis_interval = j["analysis_interval"];
+            if (j.contains("min_interval_ms")) min_interval_ms = j["min_interval_ms"];
+            if (j.contains("queue_size")) queue_size = j["queue_size"];
+            if (j.contains("cache_size")) cache_size = j["cache_size"];
             if (j.contains("max_tokens")) max_tokens = j["max_tokens"];
             if (j.contains("temperature")) temperature = j["temperature"];
         }
@@ -281,6 +375,9 @@ struct SystemConfig {
                 {"type", type},
                 {"server_address", server_address},
                 {"analysis_interval", analysis_interval},
+                {"min_interval_ms", min_interval_ms},
+                {"queue_size", queue_size},
+                {"cache_size", cache_size},
                 {"max_tokens", max_tokens},
                 {"temperature", temperature}
             };
@@ -291,27 +388,55 @@ struct SystemConfig {
     struct OutputConfig {
         bool save_video = false;           // 是否保存视频
         std::string video_path = "output/videos/"; // 视频保存路径
+        std::string video_encoder = "auto"; // 视频编码器: auto, nvenc, vaapi, cpu
+        int video_bitrate_kbps = 4000;     // 硬件编码码率(kbps)
+        float video_scale = 1.0f;          // 录制分辨率缩放比例(0-1]
+        float video_fps = 0.0f;            // 录制帧率，0为视频源帧率
+        std::string video_record_mode = "continuous"; // 录制模式: continuous, events(仅高风险事件片段)
+        float event_pre_seconds = 5.0f;    // 事件片段预录时长(秒)
+        float event_post_seconds = 5.0f;   // 风险消失后继续录制的时长(秒)
         bool save_results = true;          // 是否保存结果
         std::string results_path = "output/results/"; // 结果保存路径
+        std::string results_format = "json"; // 结果格式: json, ndjson, binary
+        int index_interval = 256;          // 二进制格式每隔多少帧写一个索引块
+        int video_queue_size = 4;          // 写出线程中同时在途的可视化帧上限(超出时丢弃帧)
+        int result_queue_size = 256;       // 待写出结果记录队列容量(满时丢弃最旧记录)
+        int flush_bytes = 65536;           // 结果缓冲区达到该字节数时写盘
+        int flush_interval_ms = 1000;      // 结果写盘最长间隔(毫秒)
         bool draw_bboxes = true;           // 是否绘制边界框
         bool draw_trails = true;           // 是否绘制轨迹
         bool draw_labels = true;           // 是否绘制标签
         bool log_to_file = true;           // 是否记录日志到文件
         std::string log_path = "logs/";    // 日志路径
         int log_level = 2;                 // 日志级别: 0(trace)-5(critical)
+        std::string log_overflow = "drop"; // 日志缓冲区满时: drop(丢弃新日志，不阻塞调用线程), block(等待)
         
         // 从JSON加载
         void fromJson(const json& j) {
             if (j.contains("save_video")) save_video = j["save_video"];
             if (j.contains("video_path")) video_path = j["video_path"];
+            if (j.contains("video_encoder")) video_encoder = j["video_encoder"];
+            if (j.contains("video_bitrate_kbps")) video_bitrate_kbps = j["video_bitrate_kbps"];
+            if (j.contains("video_scale")) video_scale = j["video_scale"];
+            if (j.contains("video_fps")) video_fps = j["video_fps"];
+            if (j.contains("video_record_mode")) video_record_mode = j["video_record_mode"];
+            if (j.contains("event_pre_seconds")) event_pre_seconds = j["event_pre_seconds"];
+            if (j.contains("event_post_seconds")) event_post_seconds = j["event_post_seconds"];
             if (j.contains("save_results")) save_results = j["save_results"];
             if (j.contains("results_path")) results_path = j["results_path"];
+            if (j.contains("results_format")) results_format = j["results_format"];
+            if (j.contains("index_interval")) index_interval = j["index_interval"];
+            if (j.contains("video_queue_size")) video_queue_size = j["video_queue_size"];
+            if (j.contains("result_queue_size")) result_queue_size = j["result_queue_size"];
+            if (j.contains("flush_bytes")) flush_bytes = j["flush_bytes"];
+            if (j.contains("flush_interval_ms")) flush_interval_ms = j["flush_interval_ms"];
             if (j.contains("draw_bboxes")) draw_bboxes = j["draw_bboxes"];
             if (j.contains("draw_trails")) draw_trails = j["draw_trails"];
             if (j.contains("draw_labels")) draw_labels = j["draw_labels"];
             if (j.contains("log_to_file")) log_to_file = j["log_to_file"];
             if (j.contains("log_path")) log_path = j["log_path"];
             if (j.contains("log_level")) log_level = j["log_level"];
+            if (j.contains("log_overflow")) log_overflow = j["log_overflow"];
         }
         
         // 转换为JSON
@@ -319,24 +444,226 @@ struct SystemConfig {
             return {
                 {"save_video", save_video},
                 {"video_path", video_path},
+                {"video_encoder", video_encoder},
+                {"video_bitrate_kbps", video_bitrate_kbps},
+                {"video_scale", video_scale},
+                {"video_fps", video_fps},
+                {"video_record_mode", video_record_mode},
+                {"event_pre_seconds", event_pre_seconds},
+                {"event_post_seconds", event_post_seconds},
                 {"save_results", save_results},
                 {"results_path", results_path},
+                {"results_format", results_format},
+                {"index_interval", index_interval},
+                {"video_queue_size", video_queue_size},
+                {"result_queue_size", result_queue_size},
+                {"flush_bytes", flush_bytes},
+                {"flush_interval_ms", flush_interval_ms},
                 {"draw_bboxes", draw_bboxes},
                 {"draw_trails", draw_trails},
                 {"draw_labels", draw_labels},
                 {"log_to_file", log_to_file},
                 {"log_path", log_path},
-                {"log_level", log_level}
+                {"log_level", log_level},
+                {"log_overflow", log_overflow}
             };
         }
     } output;
     
+    // 流水线配置
+    struct PipelineConfig {
+        int preprocess_threads = 2;         // 预处理线程数(无状态，可并行)
+        int preprocess_queue_depth = 4;     // 预处理队列深度
+        int inference_queue_depth = 2;      // 推理队列深度
+        int track_queue_depth = 4;          // 跟踪队列深度
+        int analyze_queue_depth = 4;        // 分析队列深度
+        int output_queue_depth = 8;         // 输出队列深度
+        std::string live_ingest_policy = "drop_oldest"; // 实时流入口丢帧策略: block, drop_oldest, drop_newest, latest
+        int worker_threads = 0;             // 共享线程池工作线程数，0表示CPU核心数
+        std::vector<int> cpu_affinity;      // 工作线程绑定的CPU核心，为空时不绑定
+        
+        // 从JSON加载
+        void fromJson(const json& j) {
+            if (j.contains("preprocess_threads")) preprocess_threads = j["preprocess_threads"];
+            if (j.contains("preprocess_queue_depth")) preprocess_queue_depth = j["preprocess_queue_depth"];
+            if (j.contains("inference_queue_depth")) inference_queue_depth = j["inference_queue_depth"];
+            if (j.contains("track_queue_depth")) track_queue_depth = j["track_queue_depth"];
+            if (j.contains("analyze_queue_depth")) analyze_queue_depth = j["analyze_queue_depth"];
+            if (j.contains("output_queue_depth")) output_queue_depth = j["output_queue_depth"];
+            if (j.contains("live_ingest_policy")) live_ingest_policy = j["live_ingest_policy"];
+            if (j.contains("worker_threads")) worker_threads = j["worker_threads"];
+            if (j.contains("cpu_affinity")) cpu_affinity = j["cpu_affinity"].get<std::vector<int>>();
+        }
+        
+        // 转换为JSON
+        json toJson() const {
+            return {
+                {"preprocess_threads", preprocess_threads},
+                {"preprocess_queue_depth", preprocess_queue_depth},
+                {"inference_queue_depth", inference_queue_depth},
+                {"track_queue_depth", track_queue_depth},
+                {"analyze_queue_depth", analyze_queue_depth},
+                {"output_queue_depth", output_queue_depth},
+                {"live_ingest_policy", live_ingest_policy},
+                {"worker_threads", worker_threads},
+                {"cpu_affinity", cpu_affinity}
+            };
+        }
+    } pipeline;
+    
+    // 运行指标配置
+    struct MetricsConfig {
+        bool enable = true;                      // 是否启用指标导出
+        int prometheus_port = 0;                 // Prometheus文本格式HTTP端口(GET /metrics)，0为不启用
+        std::string bind_address = "127.0.0.1"; // HTTP监听地址
+        std::string snapshot_path;               // 定期写出JSON快照的文件路径，为空时不写
+        int interval_ms = 1000;                  // 采样和快照间隔(毫秒)，分位数按该区间统计
+        int log_interval_ms = 5000;              // 日志中输出指标摘要的间隔(毫秒)，0为不输出
+        
+        // 从JSON加载
+        void fromJson(const json& j) {
+            if (j.contains("enable")) enable = j["enable"];
+            if (j.contains("prometheus_port")) prometheus_port = j["prometheus_port"];
+            if (j.contains("bind_address")) bind_address = j["bind_address"];
+            if (j.contains("snapshot_path")) snapshot_path = j["snapshot_path"];
+            if (j.contains("interval_ms")) interval_ms = j["interval_ms"];
+            if (j.contains("log_interval_ms")) log_interval_ms = j["log_interval_ms"];
+        }
+        
+        // 转换为JSON
+        json toJson() const {
+            return {
+                {"enable", enable},
+                {"prometheus_port", prometheus_port},
+                {"bind_address", bind_address},
+                {"snapshot_path", snapshot_path},
+                {"interval_ms", interval_ms},
+                {"log_interval_ms", log_interval_ms}
+            };
+        }
+    } metrics;
+    
+    // 逐帧延迟追踪配置
+    struct TraceConfig {
+        bool enable = false;                     // 是否写出抽样帧的追踪记录
+        int sample_interval = 30;                // 每路每隔多少帧追踪一帧
+        int max_frames = 2000;                   // 最多追踪的帧数，达到后停止记录
+        std::string output_path = "trace/frames.json"; // Chrome trace(JSON数组格式)输出文件，可用Perfetto打开
+        
+        // 从JSON加载
+        void fromJson(const json& j) {
+            if (j.contains("enable")) enable = j["enable"];
+            if (j.contains("sample_interval")) sample_interval = j["sample_interval"];
+            if (j.contains("max_frames")) max_frames = j["max_frames"];
+            if (j.contains("output_path")) output_path = j["output_path"];
+        }
+        
+        // 转换为JSON
+        json toJson() const {
+            return {
+                {"enable", enable},
+                {"sample_interval", sample_interval},
+                {"max_frames", max_frames},
+                {"output_path", output_path}
+            };
+        }
+    } trace;
+    
+    // 自适应检测调度配置：按耗时预算隔帧检测，中间帧由跟踪器外推，出现风险时提高检测频率
+    struct SchedulerConfig {
+        bool enable = false;                     // 是否启用(关闭时每帧全图检测)
+        float latency_budget_ms = 33.0f;         // 检测(预处理+推理)每帧平均耗时预算(毫秒)
+        int max_detect_interval = 4;             // 两次检测之间最多间隔的帧数
+        int calm_detect_interval = 3;            // 场景平静(无目标或全部安全)时的最小检测间隔
+        int risk_level = 2;                      // 任一结果达到该风险等级(2为中风险)时每帧全图检测
+        int risk_hold_frames = 30;               // 风险出现后保持每帧检测的帧数
+        bool enable_roi = true;                  // 是否只在轨迹周围和道路区域内检测
+        float roi_margin = 0.5f;                 // 轨迹框向外扩展的比例(相对框宽高)
+        cv::Rect2f road_corridor = cv::Rect2f(0.2f, 0.4f, 0.6f, 0.6f); // 道路区域(相对帧宽高的x, y, w, h)
+        float roi_max_area = 0.6f;               // ROI面积超过全图该比例时改为全图检测
+        int full_frame_interval = 5;             // ROI模式下每隔多少次检测做一次全图检测(发现新目标)
+        
+        // 从JSON加载
+        void fromJson(const json& j) {
+            if (j.contains("enable")) enable = j["enable"];
+            if (j.contains("latency_budget_ms")) latency_budget_ms = j["latency_budget_ms"];
+            if (j.contains("max_detect_interval")) max_detect_interval = j["max_detect_interval"];
+            if (j.contains("calm_detect_interval")) calm_detect_interval = j["calm_detect_interval"];
+            if (j.contains("risk_level")) risk_level = j["risk_level"];
+            if (j.contains("risk_hold_frames")) risk_hold_frames = j["risk_hold_frames"];
+            if (j.contains("enable_roi")) enable_roi = j["enable_roi"];
+            if (j.contains("roi_margin")) roi_margin = j["roi_margin"];
+            if (j.contains("road_corridor") && j["road_corridor"].is_array() && j["road_corridor"].size() == 4) {
+                std::vector<float> r = j["road_corridor"].get<std::vector<float>>();
+                road_corridor = cv::Rect2f(r[0], r[1], r[2], r[3]);
+            }
+            if (j.contains("roi_max_area")) roi_max_area = j["roi_max_area"];
+            if (j.contains("full_frame_interval")) full_frame_interval = j["full_frame_interval"];
+        }
+        
+        // 转换为JSON
+        json toJson() const {
+            return {
+                {"enable", enable},
+                {"latency_budget_ms", latency_budget_ms},
+                {"max_detect_interval", max_detect_interval},
+                {"calm_detect_interval", calm_detect_interval},
+                {"risk_level", risk_level},
+                {"risk_hold_frames", risk_hold_frames},
+                {"enable_roi", enable_roi},
+                {"roi_margin", roi_margin},
+                {"road_corridor", {road_corridor.x, road_corridor.y, road_corridor.width, road_corridor.height}},
+                {"roi_max_area", roi_max_area},
+                {"full_frame_interval", full_frame_interval}
+            };
+        }
+    } scheduler;
+    
     // 摄像头参数
     CameraParams camera;
     
     // 车辆参数
     VehicleParams vehicle;
     
+    // 多路视频流配置，每路拥有独立的视频源、相机参数、跟踪和分析状态，共享检测器
+    struct StreamConfig {
+        std::string name;                  // 流名称(用于日志和输出子目录)
+        VideoSourceConfig video;           // 视频源
+        CameraParams camera;               // 相机参数
+        
+        // 从JSON加载，未指定的video/camera字段继承顶层配置
+        void fromJson(const json& j, const VideoSourceConfig& default_video,
+                      const CameraParams& default_camera) {
+            video = default_video;
+            camera = default_camera;
+            if (j.contains("name")) name = j["name"];
+            if (j.contains("video")) video.fromJson(j["video"]);
+            if (j.contains("camera")) camera.fromJson(j["camera"]);
+        }
+        
+        // 转换为JSON
+        json toJson() const {
+            return {
+                {"name", name},
+                {"video", video.toJson()},
+                {"camera", camera.toJson()}
+            };
+        }
+    };
+    std::vector<StreamConfig> streams;     // 为空时为单路模式，使用video和camera
+    
+    // 获取实际使用的视频流列表
+    std::vector<StreamConfig> resolveStreams() const {
+        if (!streams.empty()) {
+            return streams;
+        }
+        StreamConfig single;
+        single.name = "main";
+        single.video = video;
+        single.camera = camera;
+        return {single};
+    }
+    
     // 从JSON文件加载配置
     bool loadFromFile(const std::string& path) {
         try {
@@ -354,9 +681,26 @@ struct SystemConfig {
             if (j.contains("behavior")) behavior.fromJson(j["behavior"]);
             if (j.contains("llm")) llm.fromJson(j["llm"]);
             if (j.contains("output")) output.fromJson(j["output"]);
+            if (j.contains("pipeline")) pipeline.fromJson(j["pipeline"]);
+            if (j.contains("metrics")) metrics.fromJson(j["metrics"]);
+            if (j.contains("trace")) trace.fromJson(j["trace"]);
+            if (j.contains("scheduler")) scheduler.fromJson(j["scheduler"]);
             if (j.contains("camera")) camera.fromJson(j["camera"]);
             if (j.contains("vehicle")) vehicle.fromJson(j["vehicle"]);
             
+            // 多路流继承顶层video和camera，需在二者之后解析
+            streams.clear();
+            if (j.contains("streams") && j["streams"].is_array()) {
+                for (const auto& item : j["streams"]) {
+                    StreamConfig stream;
+                    stream.fromJson(item, video, camera);
+                    if (stream.name.empty()) {
+                        stream.name = "stream" + std::to_string(streams.size());
+                    }
+                    streams.push_back(stream);
+                }
+            }
+            
             return true;
         } catch (...) {
             return false;
@@ -384,9 +728,19 @@ struct SystemConfig {
             j["behavior"] = behavior.toJson();
             j["llm"] = llm.toJson();
             j["output"] = output.toJson();
+            j["pipeline"] = pipeline.toJson();
+            j["metrics"] = metrics.toJson();
+            j["trace"] = trace.toJson();
+            j["scheduler"] = scheduler.toJson();
             j["camera"] = camera.toJson();
             j["vehicle"] = vehicle.toJson();
             
+            json streams_json = json::array();
+            for (const auto& stream : streams) {
+                streams_json.push_back(stream.toJson());
+            }
+            j["streams"] = streams_json;
+            
             ofs << std::setw(4) << j << std::endl;
             return true;
         } catch (...) {
@@ -10,16 +10,23 @@
  * 2. 行为类型枚举(BehaviorType)：定义各类目标的行为模式
  * 3. 风险等级枚举(RiskLevel)：定义不同级别的风险程度
  * 4. 检测结果结构(Detection)：存储单帧目标检测结果
- * 5. 跟踪目标结构(TrackedObject)：存储目标跟踪状态和历史轨迹
+ * 5. 跟踪目标结构(TrackedObject)：存储目标跟踪状态和历史轨迹(固定容量环形缓冲区)
  * 6. 行为分析结构(BehaviorAnalysis)：存储目标行为分析和风险评估结果
- * 7. 性能统计结构(DetectionPerformance)：统计检测系统性能指标
+ * 7. 检测器输入结构(DetectorInput)：存储预处理后的网络输入张量
+ * 8. 性能统计结构(DetectionPerformance)：统计检测系统性能指标
+ * 9. 跟踪结果快照(TrackSnapshot/TrackView)：跟踪器发布、下游只读访问的结果
+ * 10. 帧追踪上下文(FrameTrace)：采集序号和采集时间，随检测、跟踪和分析结果传递
  * 所有结构均支持JSON序列化，便于数据传输和存储
  */
 #ifndef DATA_STRUCTURES_HPP
 #define DATA_STRUCTURES_HPP
 
 #include <vector>
+#include <memory>
 #include <string>
+#include <iterator>
+#include <chrono>
+#include <cstdint>
 #include <opencv2/opencv.hpp>
 #include <nlohmann/json.hpp>
 
@@ -70,39 +77,136 @@ enum class RiskLevel {
     CRITICAL_RISK = 4    // 极高风险
 };
 
+// 检测模型的类别名称(COCO)，下标为模型输出的类别编号
+inline constexpr const char* kDetectionClassNames[] = {
+    "person", "bicycle", "car", "motorcycle", "airplane", "bus", "train", "truck",
+    "boat", "traffic light", "fire hydrant", "stop sign", "parking meter", "bench",
+    "bird", "cat", "dog", "horse", "sheep", "cow", "elephant", "bear", "zebra",
+    "giraffe", "backpack", "umbrella", "handbag", "tie", "suitcase", "frisbee",
+    "skis", "snowboard", "sports ball", "kite", "baseball bat", "baseball glove",
+    "skateboard", "surfboard", "tennis racket", "bottle", "wine glass", "cup",
+    "fork", "knife", "spoon", "bowl", "banana", "apple", "sandwich", "orange",
+    "broccoli", "carrot", "hot dog", "pizza", "donut", "cake", "chair", "couch",
+    "potted plant", "bed", "dining table", "toilet", "tv", "laptop", "mouse",
+    "remote", "keyboard", "cell phone", "microwave", "oven", "toaster", "sink",
+    "refrigerator", "book", "clock", "vase", "scissors", "teddy bear", "hair drier",
+    "toothbrush"
+};
+
+// 按类别编号查询名称，越界时返回"unknown"
+inline const char* detectionClassName(int class_index) {
+    constexpr int count = static_cast<int>(std::size(kDetectionClassNames));
+    return (class_index >= 0 && class_index < count) ? kDetectionClassNames[class_index] : "unknown";
+}
+
+// 追踪时钟(steady_clock微秒)，采集时间和各级进出时间均以此记录
+inline uint64_t traceClockMicros() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// 帧追踪上下文，标识结果来自哪一帧以及该帧何时采集
+struct FrameTrace {
+    uint64_t frame_id = 0;            // 视频源内的采集序号(从1开始，0为未知)
+    uint64_t capture_time_us = 0;     // 采集时刻(traceClockMicros)，0为未知
+    double media_time_ms = -1.0;      // 源媒体时间(CAP_PROP_POS_MSEC，网络流为PTS换算)，未知为-1
+    bool stale = false;               // 实时源断流期间重复交付的最后一帧，结果由跟踪外推得到
+};
+
 // 目标检测结果
 struct Detection {
     int id = -1;                      // 检测ID
     ObjectClass class_id = ObjectClass::UNKNOWN; // 类别ID
-    std::string class_name;           // 类别名称
+    int class_index = -1;             // 模型输出的类别编号(名称见className())
     float confidence = 0.0f;          // 置信度(0-1)
     cv::Rect2f bbox;                  // 边界框(x, y, width, height)
     cv::Point2f center;               // 中心点坐标
     float area = 0.0f;                // 面积
     float aspect_ratio = 0.0f;        // 宽高比
-    uint64_t timestamp = 0;           // 时间戳(毫秒)
+    uint64_t timestamp = 0;           // 采集时间戳(毫秒)
+    FrameTrace trace;                 // 来源帧
+    
+    // 类别名称(静态字符串，不分配内存)
+    const char* className() const {
+        return detectionClassName(class_index);
+    }
     
     // 序列化函数
     json toJson() const {
         return {
             {"id", id},
             {"class_id", static_cast<int>(class_id)},
-            {"class_name", class_name},
+            {"class_name", className()},
             {"confidence", confidence},
             {"bbox", {bbox.x, bbox.y, bbox.width, bbox.height}},
             {"center", {center.x, center.y}},
             {"area", area},
             {"aspect_ratio", aspect_ratio},
-            {"timestamp", timestamp}
+            {"timestamp", timestamp},
+            {"frame_id", trace.frame_id}
         };
     }
 };
 
+/**
+ * @brief 固定容量的轨迹环形缓冲区
+ * 写满后覆盖最旧的点，下标0为最旧、size()-1为最新。
+ * 容量不变时拷贝赋值复用已有内存，不再分配
+ */
+class TrajectoryBuffer {
+public:
+    static constexpr size_t kDefaultCapacity = 50;
+    
+    TrajectoryBuffer() = default;
+    explicit TrajectoryBuffer(size_t capacity) { reset(capacity); }
+    
+    // 设置容量并清空
+    void reset(size_t capacity) {
+        points_.resize(capacity > 0 ? capacity : 1);
+        head_ = 0;
+        count_ = 0;
+    }
+    
+    void clear() {
+        head_ = 0;
+        count_ = 0;
+    }
+    
+    void push_back(const cv::Point2f& point) {
+        if (points_.empty()) {
+            reset(kDefaultCapacity);
+        }
+        const size_t capacity = points_.size();
+        if (count_ < capacity) {
+            points_[(head_ + count_) % capacity] = point;
+            ++count_;
+        } else {
+            points_[head_] = point;
+            head_ = (head_ + 1) % capacity;
+        }
+    }
+    
+    const cv::Point2f& operator[](size_t index) const {
+        return points_[(head_ + index) % points_.size()];
+    }
+    
+    const cv::Point2f& front() const { return (*this)[0]; }
+    const cv::Point2f& back() const { return (*this)[count_ - 1]; }
+    size_t size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+    size_t capacity() const { return points_.size(); }
+    
+private:
+    std::vector<cv::Point2f> points_;
+    size_t head_ = 0;
+    size_t count_ = 0;
+};
+
 // 跟踪目标
 struct TrackedObject {
     int track_id = -1;                // 跟踪ID
     Detection detection;              // 最新检测结果
-    std::vector<cv::Point2f> trajectory; // 轨迹历史
+    TrajectoryBuffer trajectory;      // 轨迹历史
     cv::Point2f velocity;             // 速度矢量(像素/帧)
     float speed = 0.0f;               // 速度大小(像素/帧)
     cv::Point2f acceleration;         // 加速度矢量
@@ -137,6 +241,39 @@ struct TrackedObject {
     }
 };
 
+// 跟踪结果的只读视图，元素由发布方持有
+class TrackView {
+public:
+    TrackView() = default;
+    TrackView(const TrackedObject* data, size_t size) : data_(data), size_(size) {}
+    TrackView(const std::vector<TrackedObject>& tracks) : data_(tracks.data()), size_(tracks.size()) {}
+    
+    const TrackedObject* begin() const { return data_; }
+    const TrackedObject* end() const { return data_ + size_; }
+    const TrackedObject& operator[](size_t index) const { return data_[index]; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    
+private:
+    const TrackedObject* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+/**
+ * @brief 跟踪器每帧发布的确认轨迹快照
+ * 快照由跟踪器循环复用：tracks只增不减，前count个有效，
+ * 复用时逐元素拷贝赋值，轨迹缓冲区内存不重新分配
+ */
+struct TrackSnapshot {
+    std::vector<TrackedObject> tracks;
+    size_t count = 0;
+    
+    TrackView view() const { return TrackView(tracks.data(), count); }
+};
+
+// 快照句柄，下游持有期间跟踪器不会复用该快照
+using TrackSnapshotHandle = std::shared_ptr<const TrackSnapshot>;
+
 // 行为分析结果
 struct BehaviorAnalysis {
     int track_id = -1;                  // 跟踪ID
@@ -150,6 +287,8 @@ struct BehaviorAnalysis {
     float time_to_collision = 0.0f;     // 碰撞时间预测(秒)
     uint64_t timestamp = 0;             // 时间戳(毫秒)
     std::string llm_analysis;           // 大模型分析结果
+    int stream_id = 0;                  // 来源视频流编号(多路模式)
+    FrameTrace trace;                   // 产生该结果的帧
     
     // 序列化函数
     json toJson() const {
@@ -164,11 +303,34 @@ struct BehaviorAnalysis {
             {"distance_to_vehicle", distance_to_vehicle},
             {"time_to_collision", time_to_collision},
             {"timestamp", timestamp},
-            {"llm_analysis", llm_analysis}
+            {"llm_analysis", llm_analysis},
+            {"stream_id", stream_id},
+            {"frame_id", trace.frame_id},
+            {"capture_time_us", trace.capture_time_us}
         };
     }
 };
 
+// 检测器网络输入(预处理结果)
+struct DetectorInput {
+    cv::Mat blob;                       // NCHW输入张量
+    cv::Size image_size;                // 原始图像尺寸
+    float scale_x = 1.0f;               // 原图到网络输入的缩放比例(x)
+    float scale_y = 1.0f;               // 原图到网络输入的缩放比例(y)
+    float pad_x = 0.0f;                 // 信箱填充偏移(x，网络输入像素)
+    float pad_y = 0.0f;                 // 信箱填充偏移(y，网络输入像素)
+    float preprocess_time_ms = 0.0f;    // 预处理耗时(毫秒)
+    FrameTrace trace;                   // 来源帧，检测结果沿用
+    std::shared_ptr<void> buffer_lease; // 输入缓冲区租约，释放后缓冲区归还复用池
+};
+
+// 一帧的检测方式(自适应检测调度)
+enum class DetectionMode {
+    FULL = 0,            // 全图检测
+    ROI = 1,             // 只检测轨迹周围和道路区域
+    SKIP = 2             // 不检测，跟踪器按运动模型外推
+};
+
 // 检测性能统计
 struct DetectionPerformance {
     float preprocess_time_ms = 0.0f;    // 预处理时间(毫秒)
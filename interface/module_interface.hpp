@@ -12,6 +12,7 @@
  * 
  * 2. IObjectDetector: 目标检测接口，负责图像中的目标检测
  *    - 支持单帧和批量检测
+ *    - 预处理与推理可拆分，供流水线分级执行
  *    - 可配置置信度和NMS阈值
  *    - 提供性能统计功能
  * 
@@ -47,6 +48,7 @@
 #include <opencv2/opencv.hpp>
 #include "data_structs.hpp"
 #include "config.hpp"
+#include "frame_pool.hpp"
 
 // 视频处理器接口
 class IVideoProcessor {
@@ -90,6 +92,9 @@ public:
     // 获取当前处理状态
     virtual ProcessingState getState() const = 0;
     
+    // 视频文件是否已读到末尾(实时流始终为false)
+    virtual bool isFinished() const { return false; }
+    
     // 获取视频属性
     virtual VideoProperties getVideoProperties() const = 0;
     
@@ -103,6 +108,17 @@ public:
     virtual void registerFrameCallback(
         std::function<void(const cv::Mat&, uint64_t)> callback) = 0;
     
+    // 注册池化帧回调，注册后替代registerFrameCallback，帧以引用计数句柄交付，不复制像素
+    virtual void registerFrameBufferCallback(
+        std::function<void(const FrameHandle&)> callback) = 0;
+    
+    // 注册GPU帧回调，GPU解码时帧以GpuMat形式直接交付，不下载到主机内存
+    virtual void registerGpuFrameCallback(
+        std::function<void(const cv::cuda::GpuMat&, const FrameTrace&)> callback) = 0;
+    
+    // 当前是否为GPU解码(帧位于显存)
+    virtual bool isGpuDecoding() const = 0;
+    
     // 设置ROI区域
     virtual void setROI(const cv::Rect& roi) = 0;
     
@@ -127,6 +143,18 @@ public:
     // 批量检测目标
     virtual std::vector<std::vector<Detection>> detectBatch(const std::vector<cv::Mat>& images) = 0;
     
+    // 预处理图像，生成网络输入(不修改检测器状态，可多线程并发调用)
+    virtual DetectorInput preprocess(const cv::Mat& image) const = 0;
+    
+    // 预处理显存中的图像(GPU解码路径)，避免下载再上传
+    virtual DetectorInput preprocess(const cv::cuda::GpuMat& image) const = 0;
+    
+    // 对预处理后的输入执行推理和后处理
+    virtual std::vector<Detection> infer(const DetectorInput& input) = 0;
+    
+    // 对多个预处理结果拼批，执行一次推理
+    virtual std::vector<std::vector<Detection>> inferBatch(const std::vector<DetectorInput>& inputs) = 0;
+    
     // 获取类别名称列表
     virtual const std::vector<std::string>& getClassNames() const = 0;
     
@@ -151,10 +179,23 @@ public:
     // 初始化跟踪器
     virtual bool initialize(const SystemConfig::TrackerConfig& config) = 0;
     
-    // 更新跟踪
-    virtual std::vector<TrackedObject> update(
+    // 更新跟踪，返回确认轨迹的只读快照(持有期间不会被跟踪器复用)
+    virtual TrackSnapshotHandle update(
         const std::vector<Detection>& detections, uint64_t timestamp) = 0;
     
+    // 更新跟踪，附带当前帧图像(外观特征跟踪器使用，默认忽略图像)
+    virtual TrackSnapshotHandle update(
+        const std::vector<Detection>& detections, const cv::Mat& frame, uint64_t timestamp) {
+        (void)frame;
+        return update(detections, timestamp);
+    }
+    
+    // 不做关联，只按运动模型把轨迹外推一帧(隔帧检测时的中间帧)，不计为漏检
+    virtual TrackSnapshotHandle predictTracks(uint64_t timestamp) = 0;
+    
+    // 是否需要主机内存中的帧图像
+    virtual bool needsFrame() const { return false; }
+    
     // 获取所有跟踪目标
     virtual std::vector<TrackedObject> getTracks() const = 0;
     
@@ -167,8 +208,17 @@ public:
     // 设置最小检测数
     virtual void setMinHits(int min_hits) = 0;
     
+    // 设置关联的IOU阈值
+    virtual void setIouThreshold(float threshold) = 0;
+    
+    // 设置每条轨迹保留的轨迹点数(对之后创建的轨迹生效)
+    virtual void setTrajectoryLength(int length) = 0;
+    
     // 创建实例
     static std::unique_ptr<IObjectTracker> create();
+    
+    // 按类型创建实例: simple, sort, deepsort
+    static std::unique_ptr<IObjectTracker> create(const std::string& type);
 };
 
 // 行为分析器接口
@@ -182,8 +232,10 @@ public:
                           const VehicleParams& vehicle_params) = 0;
     
     // 分析目标行为
-    virtual std::vector<BehaviorAnalysis> analyze(
-        const std::vector<TrackedObject>& tracked_objects) = 0;
+    virtual std::vector<BehaviorAnalysis> analyze(TrackView tracked_objects) = 0;
+    
+    // 更新行为和风险判定阈值(距离、TTC、速度阈值)，不清除轨迹的运动状态
+    virtual void setThresholds(const SystemConfig::BehaviorConfig& config) = 0;
     
     // 设置车辆当前速度(km/h)
     virtual void setVehicleSpeed(float speed_kmh) = 0;
@@ -203,12 +255,16 @@ public:
     // 初始化结果处理器
     virtual bool initialize(const SystemConfig::OutputConfig& config) = 0;
     
-    // 处理分析结果
-    virtual void process(const std::vector<BehaviorAnalysis>& results,
-                       const cv::Mat& frame, uint64_t timestamp) = 0;
+    // 提交一帧的分析结果和帧引用后立即返回，绘制、编码和写盘在写出线程中完成
+    // 叠加信息直接绘制在frame上(调用方交出后不得再使用该帧)，frame_buffer为其池化缓冲区(可为空)
+    virtual void process(std::vector<BehaviorAnalysis> results, const cv::Mat& frame,
+                         FrameHandle frame_buffer, uint64_t timestamp) = 0;
+    
+    // 等待已提交的输出全部写入文件
+    virtual void flush() = 0;
     
-    // 获取处理后的帧(带叠加)
-    virtual cv::Mat getProcessedFrame() const = 0;
+    // 设置视频源帧率(录制视频使用)
+    virtual void setSourceFps(double fps) = 0;
     
     // 保存结果到文件
     virtual bool saveResults(const std::string& path) const = 0;
@@ -225,10 +281,9 @@ public:
     // 初始化LLM增强器
     virtual bool initialize(const SystemConfig::LLMConfig& config) = 0;
     
-    // 增强行为分析结果
-    virtual std::vector<BehaviorAnalysis> enhanceAnalysis(
-        const std::vector<BehaviorAnalysis>& basic_analysis,
-        const std::vector<TrackedObject>& tracked_objects) = 0;
+    // 增强行为分析结果：原地附带已到达的LLM文本并按调度提交异步请求，不阻塞调用方
+    virtual void enhanceAnalysis(std::vector<BehaviorAnalysis>& analysis,
+                                 TrackView tracked_objects) = 0;
     
     // 设置车辆当前速度(km/h)
     virtual void setVehicleSpeed(float speed_kmh) = 0;
@@ -0,0 +1,235 @@
+/**
+ * @file bounded_queue.hpp
+ * @brief 有界阻塞队列实现 - 用于流水线各级之间传递数据
+ * @author pengchengkang
+ * @date 2025-9-7
+ *
+ * 功能描述：
+ * - 固定容量，队列满时按策略阻塞生产者或丢弃元素，防止内存无限增长
+ * - 队列空时阻塞消费者
+ * - 支持关闭队列，唤醒所有等待线程并排空剩余元素
+ * - 出队时可返回单调递增的出队序号，便于下游恢复顺序
+ * - 支持限时出队，便于消费者在截止时间内凑批
+ * - 支持非阻塞出队，便于线程池任务取完即让出线程
+ * - 统计因溢出被丢弃的元素数量
+ */
+
+#ifndef BOUNDED_QUEUE_HPP
+#define BOUNDED_QUEUE_HPP
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+
+/**
+ * @brief 队列满时的处理策略
+ */
+enum class OverflowPolicy {
+    BLOCK,         // 阻塞生产者直到有空位
+    DROP_OLDEST,   // 丢弃队首(最旧)元素后入队
+    DROP_NEWEST,   // 丢弃新元素，保留已排队的元素
+    LATEST_ONLY    // 邮箱模式：容量为1，只保留最新元素
+};
+
+/**
+ * @brief 有界阻塞队列
+ * 多生产者多消费者安全，close()之后push失败，pop在取完剩余元素后返回false
+ */
+template <typename T>
+class BoundedQueue {
+public:
+    /**
+     * @brief 构造函数
+     * @param max_size 队列容量，至少为1(邮箱模式固定为1)
+     * @param policy 队列满时的处理策略
+     */
+    explicit BoundedQueue(size_t max_size, OverflowPolicy policy = OverflowPolicy::BLOCK)
+        : max_size_(policy == OverflowPolicy::LATEST_ONLY ? 1 : (max_size > 0 ? max_size : 1)),
+          policy_(policy), closed_(false), pop_count_(0), dropped_(0) {}
+
+    // 禁止拷贝
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    /**
+     * @brief 入队，队列满时按溢出策略处理
+     * @param item 入队元素
+     * @return bool 队列已关闭或新元素被丢弃时返回false
+     */
+    bool push(T item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        if (policy_ == OverflowPolicy::BLOCK) {
+            not_full_.wait(lock, [this]() { return closed_ || queue_.size() < max_size_; });
+        }
+
+        if (closed_) {
+            return false;
+        }
+
+        if (queue_.size() >= max_size_) {
+            dropped_++;
+            if (policy_ == OverflowPolicy::DROP_NEWEST) {
+                return false;
+            }
+            // DROP_OLDEST / LATEST_ONLY：移除最旧的元素，为新元素腾出位置
+            queue_.pop_front();
+        }
+
+        queue_.push_back(std::move(item));
+        lock.unlock();
+        not_empty_.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief 出队，队列空时阻塞
+     * @param item 出队元素
+     * @param ticket 可选，返回该元素的出队序号（在锁内分配，保证与出队顺序一致）
+     * @return bool 队列已关闭且为空时返回false
+     */
+    bool pop(T& item, uint64_t* ticket = nullptr) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this]() { return closed_ || !queue_.empty(); });
+
+        if (queue_.empty()) {
+            return false;
+        }
+
+        item = std::move(queue_.front());
+        queue_.pop_front();
+        if (ticket) {
+            *ticket = pop_count_;
+        }
+        pop_count_++;
+        lock.unlock();
+        not_full_.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief 限时出队，超时或队列关闭且为空时返回false
+     * @param item 出队元素
+     * @param timeout 最长等待时间
+     * @param ticket 可选，返回该元素的出队序号
+     * @return bool 成功取到元素时返回true
+     */
+    template <typename Rep, typename Period>
+    bool popFor(T& item, const std::chrono::duration<Rep, Period>& timeout, uint64_t* ticket = nullptr) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait_for(lock, timeout, [this]() { return closed_ || !queue_.empty(); });
+
+        if (queue_.empty()) {
+            return false;
+        }
+
+        item = std::move(queue_.front());
+        queue_.pop_front();
+        if (ticket) {
+            *ticket = pop_count_;
+        }
+        pop_count_++;
+        lock.unlock();
+        not_full_.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief 非阻塞出队，队列为空时立即返回false
+     * @param item 出队元素
+     * @param ticket 可选，返回该元素的出队序号
+     * @return bool 成功取到元素时返回true
+     */
+    bool tryPop(T& item, uint64_t* ticket = nullptr) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (queue_.empty()) {
+            return false;
+        }
+
+        item = std::move(queue_.front());
+        queue_.pop_front();
+        if (ticket) {
+            *ticket = pop_count_;
+        }
+        pop_count_++;
+        lock.unlock();
+        not_full_.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief 关闭队列，唤醒所有等待的生产者和消费者
+     */
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        not_full_.notify_all();
+        not_empty_.notify_all();
+    }
+
+    /**
+     * @brief 重新打开已关闭的队列，并清空残留元素
+     */
+    void reopen() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.clear();
+        closed_ = false;
+        pop_count_ = 0;
+        dropped_ = 0;
+    }
+
+    /**
+     * @brief 清空队列
+     */
+    void clear() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.clear();
+        }
+        not_full_.notify_all();
+    }
+
+    bool isClosed() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return closed_;
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return queue_.size();
+    }
+
+    size_t capacity() const {
+        return max_size_;
+    }
+
+    OverflowPolicy policy() const {
+        return policy_;
+    }
+
+    /**
+     * @brief 获取因溢出被丢弃的元素总数
+     */
+    uint64_t droppedCount() const {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::deque<T> queue_;
+    mutable std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    const size_t max_size_;
+    const OverflowPolicy policy_;
+    bool closed_;
+    uint64_t pop_count_;
+    std::atomic<uint64_t> dropped_;
+};
+
+#endif // BOUNDED_QUEUE_HPP
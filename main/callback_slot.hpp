@@ -0,0 +1,80 @@
+/**
+ * @file callback_slot.hpp
+ * @brief 回调槽 - 每帧调用的回调以原子指针发布，调用方不加锁
+ * @author pengchengkang
+ * @date 2025-9-16
+ *
+ * 功能描述：
+ * - 注册很少发生，加锁后构造新回调并以release语义替换当前指针
+ * - 调用只做一次acquire读取，不加锁，不与注册互斥
+ * - 被替换的回调保留到槽位析构，替换前已开始的调用可以安全执行完
+ *   (每次注册保留一个std::function，注册次数应是有限的)
+ * - 与原先互斥量保护的回调不同，注册返回后旧回调可能仍在其他线程上执行完最后一次
+ */
+
+#ifndef CALLBACK_SLOT_HPP
+#define CALLBACK_SLOT_HPP
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+template <typename Signature>
+class CallbackSlot;
+
+/**
+ * @brief 签名为void(Args...)的回调槽，调用多线程安全且无锁
+ */
+template <typename... Args>
+class CallbackSlot<void(Args...)> {
+public:
+    using Function = std::function<void(Args...)>;
+
+    CallbackSlot() = default;
+
+    // 禁止拷贝
+    CallbackSlot(const CallbackSlot&) = delete;
+    CallbackSlot& operator=(const CallbackSlot&) = delete;
+
+    /**
+     * @brief 替换当前回调，传入空函数即注销
+     */
+    void set(Function function) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!function) {
+            current_.store(nullptr, std::memory_order_release);
+            return;
+        }
+        owned_.push_back(std::make_unique<const Function>(std::move(function)));
+        current_.store(owned_.back().get(), std::memory_order_release);
+    }
+
+    // 是否已注册回调
+    bool empty() const {
+        return current_.load(std::memory_order_acquire) == nullptr;
+    }
+
+    /**
+     * @brief 调用当前回调
+     * @return bool 未注册回调时返回false
+     */
+    template <typename... CallArgs>
+    bool operator()(CallArgs&&... args) const {
+        const Function* function = current_.load(std::memory_order_acquire);
+        if (!function) {
+            return false;
+        }
+        (*function)(std::forward<CallArgs>(args)...);
+        return true;
+    }
+
+private:
+    std::atomic<const Function*> current_{nullptr};
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<const Function>> owned_;  // 全部注册过的回调，析构时释放
+};
+
+#endif // CALLBACK_SLOT_HPP
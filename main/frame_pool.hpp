@@ -0,0 +1,156 @@
+/**
+ * @file frame_pool.hpp
+ * @brief 预分配帧缓冲池 - 帧在流水线各级之间以引用计数句柄传递
+ * @author pengchengkang
+ * @date 2025-9-11
+ *
+ * 功能描述：
+ * - 按视频流分辨率预分配固定数量的帧缓冲区，运行期间解码不再分配内存
+ * - acquire()返回std::shared_ptr句柄，最后一个持有者释放时缓冲区自动归还
+ * - 池耗尽时按调用方选择阻塞等待(带超时)或立即返回空句柄(丢帧)
+ * - 句柄携带流编号、采集序号和时间戳等元数据
+ * - 池可先于句柄销毁，未归还的缓冲区随最后一个句柄释放
+ */
+
+#ifndef FRAME_POOL_HPP
+#define FRAME_POOL_HPP
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdint>
+#include <opencv2/opencv.hpp>
+
+/**
+ * @brief 池化帧缓冲区
+ * storage为池持有的完整图像内存，image为交付给下游的视图(可能是ROI子区域)
+ */
+struct FrameBuffer {
+    cv::Mat storage;          // 预分配的图像内存
+    cv::Mat image;            // 有效图像(storage或其子区域)
+    int stream_id = 0;        // 视频流编号
+    uint64_t sequence = 0;    // 该视频源的采集序号
+    uint64_t timestamp = 0;   // 采集时间戳(毫秒)
+    uint64_t capture_time_us = 0;  // 采集时刻(steady_clock微秒)
+    double media_time_ms = -1.0;   // 源媒体时间(毫秒)，未知为-1
+    bool stale = false;            // 实时源断流期间重复交付的最后一帧
+};
+
+// 帧句柄，按引用计数在流水线中传递，不复制像素
+using FrameHandle = std::shared_ptr<FrameBuffer>;
+
+/**
+ * @brief 固定容量帧缓冲池，线程安全
+ */
+class FramePool {
+public:
+    FramePool() : state_(std::make_shared<State>()) {}
+
+    // 禁止拷贝
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    /**
+     * @brief 重新分配缓冲区，已借出的旧缓冲区归还时直接释放
+     * @param size 图像尺寸
+     * @param type 图像类型(如CV_8UC3)
+     * @param capacity 缓冲区数量
+     */
+    void reset(const cv::Size& size, int type, size_t capacity) {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        state_->generation++;
+        state_->free.clear();
+        state_->capacity = capacity > 0 ? capacity : 1;
+        for (size_t i = 0; i < state_->capacity; ++i) {
+            auto buffer = std::make_unique<FrameBuffer>();
+            if (size.area() > 0) {
+                buffer->storage.create(size, type);
+            }
+            state_->free.push_back(std::move(buffer));
+        }
+        state_->cv.notify_all();
+    }
+
+    /**
+     * @brief 借出一个缓冲区
+     * @param timeout 池耗尽时的最长等待时间，为0时不等待
+     * @return FrameHandle 池耗尽且超时时为空
+     */
+    template <typename Rep, typename Period>
+    FrameHandle acquire(const std::chrono::duration<Rep, Period>& timeout) {
+        std::unique_lock<std::mutex> lock(state_->mutex);
+        if (state_->free.empty()) {
+            state_->exhausted++;
+            if (!state_->cv.wait_for(lock, timeout, [this] { return !state_->free.empty(); })) {
+                return nullptr;
+            }
+        }
+
+        std::unique_ptr<FrameBuffer> buffer = std::move(state_->free.back());
+        state_->free.pop_back();
+        buffer->image = buffer->storage;
+        buffer->stream_id = 0;
+        buffer->sequence = 0;
+        buffer->timestamp = 0;
+
+        // 删除器持有池状态，池先销毁时缓冲区随句柄释放
+        std::shared_ptr<State> state = state_;
+        uint64_t generation = state_->generation;
+        return FrameHandle(buffer.release(), [state, generation](FrameBuffer* released) {
+            std::unique_ptr<FrameBuffer> owned(released);
+            owned->image.release();
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (generation != state->generation) {
+                return;   // reset()之前借出的缓冲区直接释放
+            }
+            // 像素仍被外部浅拷贝引用时不能复用，否则会覆盖他人正在读取的数据
+            if (owned->storage.u && owned->storage.u->refcount > 1) {
+                state->replaced++;
+                owned->storage = cv::Mat(owned->storage.size(), owned->storage.type());
+            }
+            state->free.push_back(std::move(owned));
+            state->cv.notify_one();
+        });
+    }
+
+    // 缓冲区总数
+    size_t capacity() const {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        return state_->capacity;
+    }
+
+    // 当前空闲缓冲区数量
+    size_t available() const {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        return state_->free.size();
+    }
+
+    // 借出时池为空的次数
+    uint64_t exhaustedCount() const {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        return state_->exhausted;
+    }
+
+    // 因仍被浅拷贝引用而重新分配的缓冲区数量(应为0，非0说明下游泄漏了cv::Mat引用)
+    uint64_t replacedCount() const {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        return state_->replaced;
+    }
+
+private:
+    struct State {
+        mutable std::mutex mutex;
+        std::condition_variable cv;
+        std::vector<std::unique_ptr<FrameBuffer>> free;
+        size_t capacity = 0;
+        uint64_t generation = 0;
+        uint64_t exhausted = 0;
+        uint64_t replaced = 0;
+    };
+
+    std::shared_ptr<State> state_;
+};
+
+#endif // FRAME_POOL_HPP
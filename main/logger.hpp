@@ -1,9 +1,9 @@
 /**
  * @file logger.hpp
- * @brief 日志系统实现 - 提供线程安全的日志记录功能
+ * @brief 日志系统实现 - 提供线程安全的异步日志记录功能
  * @author pengchengkang
  * @date 2025-9-8
- * 
+ *
  * 功能描述：
  * - 支持多级别日志记录(TRACE/DEBUG/INFO/WARN/ERROR/CRITICAL)
  * - 支持同时输出到控制台和文件
@@ -12,6 +12,14 @@
  * - 线程安全的日志记录机制
  * - 自动记录时间戳、文件名和行号
  * - 支持格式化字符串输出
+ *
+ * 异步实现：
+ * - 调用线程只把级别、时间戳、文件行号和原始参数编码进无锁环形缓冲区(多生产者单消费者)，
+ *   不格式化、不加锁、不做I/O
+ * - 后台线程批量取出记录，格式化后一次写入控制台和文件，每批只flush一次
+ * - 编译期级别(LOG_ACTIVE_LEVEL)以下的日志语句不生成代码；运行时级别以下的日志不求值参数
+ * - 缓冲区满时按溢出策略丢弃新日志(默认，并定期报告丢弃数量)或等待空位
+ * - CRITICAL日志等待后台线程写出后才返回，便于随后退出的进程保留现场
  */
 #ifndef LOGGER_HPP
 #define LOGGER_HPP
@@ -20,11 +28,26 @@
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
 #include <chrono>
 #include <iomanip>
 #include <filesystem>
 #include <cstring>
+#include <cstdio>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <type_traits>
+#include <algorithm>
+
+// 编译期最低日志级别: 0(trace)-5(critical)，低于该级别的日志语句被编译器整体删除
+#ifndef LOG_ACTIVE_LEVEL
+#define LOG_ACTIVE_LEVEL 0
+#endif
 
 /**
  * @brief 日志级别枚举
@@ -39,6 +62,196 @@ enum class LogLevel {
     CRITICAL = 5
 };
 
+/**
+ * @brief 日志缓冲区满时的处理策略
+ */
+enum class LogOverflowPolicy {
+    DROP,     // 丢弃新日志，调用线程从不等待
+    BLOCK     // 等待后台线程腾出空位
+};
+
+namespace log_detail {
+
+// 参数编码标签
+enum ArgTag : uint8_t {
+    kArgInt = 0,
+    kArgUInt,
+    kArgFloat,
+    kArgChar,
+    kArgString
+};
+
+constexpr size_t kSlotSize = 256;
+
+struct RecordHeader {
+    std::chrono::system_clock::time_point time;
+    const char* file;
+    const char* format;       // 字面量格式串直接引用；为空时格式串作为第一个字符串参数存放
+    int line;
+    LogLevel level;
+    uint8_t arg_count;
+    uint8_t truncated;        // 参数超出槽位容量时被截断
+    uint16_t payload_size;
+};
+
+// 环形缓冲区槽位，一条日志占一个槽位
+struct alignas(64) Slot {
+    std::atomic<size_t> sequence;
+    RecordHeader header;
+    unsigned char payload[kSlotSize - sizeof(std::atomic<size_t>) - sizeof(RecordHeader)];
+};
+static_assert(sizeof(Slot) == kSlotSize, "log slot layout changed");
+
+/**
+ * @brief 把参数按类型标签编码到槽位负载中，字符串按剩余空间截断
+ */
+class ArgWriter {
+public:
+    ArgWriter(unsigned char* begin, size_t capacity) : pos_(begin), begin_(begin), end_(begin + capacity) {}
+
+    template <typename T>
+    void write(const T& value) {
+        using V = typename std::decay<T>::type;
+        if constexpr (std::is_same<V, char>::value || std::is_same<V, signed char>::value ||
+                      std::is_same<V, unsigned char>::value) {
+            putScalar(kArgChar, static_cast<char>(value));
+        } else if constexpr (std::is_same<V, bool>::value) {
+            putScalar(kArgInt, static_cast<int64_t>(value));
+        } else if constexpr (std::is_integral<V>::value && std::is_signed<V>::value) {
+            putScalar(kArgInt, static_cast<int64_t>(value));
+        } else if constexpr (std::is_integral<V>::value) {
+            putScalar(kArgUInt, static_cast<uint64_t>(value));
+        } else if constexpr (std::is_enum<V>::value) {
+            write(static_cast<typename std::underlying_type<V>::type>(value));
+            return;
+        } else if constexpr (std::is_floating_point<V>::value) {
+            putScalar(kArgFloat, static_cast<double>(value));
+        } else if constexpr (std::is_array<T>::value) {
+            putString(std::string_view(value));
+        } else if constexpr (std::is_same<V, const char*>::value || std::is_same<V, char*>::value) {
+            putString(value ? std::string_view(value) : std::string_view("(null)"));
+        } else if constexpr (std::is_convertible<const V&, std::string_view>::value) {
+            putString(std::string_view(value));
+        } else {
+            // 其他类型(cv::Size等)按operator<<立即转换为字符串
+            std::ostringstream oss;
+            oss << value;
+            putString(oss.str());
+        }
+        count_++;
+    }
+
+    void putString(std::string_view text) {
+        const size_t header = 1 + sizeof(uint16_t);
+        if (pos_ + header > end_) {
+            truncated_ = true;
+            return;
+        }
+        size_t length = std::min(text.size(), static_cast<size_t>(end_ - pos_) - header);
+        if (length < text.size()) {
+            truncated_ = true;
+        }
+        const uint16_t stored = static_cast<uint16_t>(length);
+        *pos_++ = kArgString;
+        std::memcpy(pos_, &stored, sizeof(stored));
+        pos_ += sizeof(stored);
+        std::memcpy(pos_, text.data(), length);
+        pos_ += length;
+    }
+
+    uint8_t count() const { return count_; }
+    bool truncated() const { return truncated_; }
+    size_t size() const { return static_cast<size_t>(pos_ - begin_); }
+
+private:
+    template <typename S>
+    void putScalar(ArgTag tag, S value) {
+        if (pos_ + 1 + sizeof(S) > end_) {
+            truncated_ = true;
+            return;
+        }
+        *pos_++ = tag;
+        std::memcpy(pos_, &value, sizeof(S));
+        pos_ += sizeof(S);
+    }
+
+    unsigned char* pos_;
+    unsigned char* begin_;
+    unsigned char* end_;
+    uint8_t count_ = 0;
+    bool truncated_ = false;
+};
+
+/**
+ * @brief 顺序读取编码后的参数
+ */
+class ArgReader {
+public:
+    ArgReader(const unsigned char* begin, size_t size) : pos_(begin), end_(begin + size) {}
+
+    bool done() const { return pos_ >= end_; }
+
+    // 把下一个参数追加到out
+    void appendNext(std::string& out) {
+        const uint8_t tag = *pos_++;
+        char buffer[32];
+        switch (tag) {
+            case kArgInt: {
+                int64_t value;
+                read(value);
+                out.append(buffer, std::snprintf(buffer, sizeof(buffer), "%lld", static_cast<long long>(value)));
+                break;
+            }
+            case kArgUInt: {
+                uint64_t value;
+                read(value);
+                out.append(buffer, std::snprintf(buffer, sizeof(buffer), "%llu", static_cast<unsigned long long>(value)));
+                break;
+            }
+            case kArgFloat: {
+                // 与std::ostream默认格式一致
+                double value;
+                read(value);
+                out.append(buffer, std::snprintf(buffer, sizeof(buffer), "%g", value));
+                break;
+            }
+            case kArgChar: {
+                char value;
+                read(value);
+                out.push_back(value);
+                break;
+            }
+            default: {
+                std::string_view text = readString();
+                out.append(text.data(), text.size());
+                break;
+            }
+        }
+    }
+
+    std::string_view readString() {
+        uint16_t length;
+        read(length);
+        std::string_view text(reinterpret_cast<const char*>(pos_), length);
+        pos_ += length;
+        return text;
+    }
+
+    void skipTag() { pos_++; }
+
+private:
+    template <typename S>
+    void read(S& value) {
+        std::memcpy(&value, pos_, sizeof(S));
+        pos_ += sizeof(S);
+    }
+
+    const unsigned char* pos_;
+    const unsigned char* end_;
+};
+
+} // namespace log_detail
+
 /**
  * @brief 单例模式的日志管理器
  * 提供全局统一的日志记录接口，支持多线程安全访问
@@ -53,39 +266,72 @@ public:
         static Logger instance;
         return instance;
     }
-    
+
     /**
-     * @brief 初始化日志系统
+     * @brief 初始化日志系统，重复调用时只有文件设置变化才重新打开日志文件
      * @param log_path 日志文件保存路径
      * @param level 最低日志级别
      * @param log_to_file 是否输出到文件
+     * @param overflow 缓冲区满时的处理策略
      */
-    static void initialize(const std::string& log_path = "logs/", 
+    static void initialize(const std::string& log_path = "logs/",
                           LogLevel level = LogLevel::INFO,
-                          bool log_to_file = true) {
+                          bool log_to_file = true,
+                          LogOverflowPolicy overflow = LogOverflowPolicy::DROP) {
         auto& logger = getInstance();
-        logger.log_level_ = level;
+        logger.log_level_.store(static_cast<int>(level), std::memory_order_relaxed);
+        logger.overflow_.store(overflow, std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(logger.sink_mutex_);
+        if (log_to_file == logger.log_to_file_ && log_path == logger.log_path_ && logger.log_file_.is_open()) {
+            return;
+        }
         logger.log_to_file_ = log_to_file;
-        
+        logger.log_path_ = log_path;
+        if (logger.log_file_.is_open()) {
+            logger.log_file_.close();
+        }
+
         if (log_to_file) {
             // 创建日志目录
             std::filesystem::create_directories(log_path);
-            
+
             // 生成日志文件名（包含时间戳）
             auto now = std::chrono::system_clock::now();
             auto time_t = std::chrono::system_clock::to_time_t(now);
             auto tm = *std::localtime(&time_t);
-            
+
             std::ostringstream oss;
-            oss << log_path << "vehicle_perception_" 
+            oss << log_path << "vehicle_perception_"
                 << std::put_time(&tm, "%Y%m%d_%H%M%S") << ".log";
-            
+
             logger.log_file_.open(oss.str(), std::ios::app);
         }
     }
-    
+
+    /**
+     * @brief 运行时级别检查，日志宏在求值参数之前调用
+     */
+    bool shouldLog(LogLevel level) const {
+        return static_cast<int>(level) >= log_level_.load(std::memory_order_relaxed);
+    }
+
+    void setLevel(LogLevel level) {
+        log_level_.store(static_cast<int>(level), std::memory_order_relaxed);
+    }
+
+    void setOverflowPolicy(LogOverflowPolicy policy) {
+        overflow_.store(policy, std::memory_order_relaxed);
+    }
+
+    // 因缓冲区满被丢弃的日志总数
+    uint64_t droppedCount() const {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
     /**
      * @brief 记录日志消息
+     * @tparam Format 格式串类型：字符串字面量(字符数组)只保存指针，其他字符串复制到记录中
      * @tparam Args 可变参数类型
      * @param level 日志级别
      * @param file 调用日志的文件名
@@ -93,114 +339,292 @@ public:
      * @param format 格式化字符串
      * @param args 格式化参数
      */
-    template<typename... Args>
-    void log(LogLevel level, const char* file, int line, const std::string& format, Args&&... args) {
-        if (level < log_level_) return;
-        
-        std::lock_guard<std::mutex> lock(mutex_);
-        
-        // 格式化消息
-        std::string message = formatString(format, std::forward<Args>(args)...);
-        
-        // 获取时间戳
-        auto now = std::chrono::system_clock::now();
-        auto time_t = std::chrono::system_clock::to_time_t(now);
-        auto tm = *std::localtime(&time_t);
-        
-        // 获取毫秒级时间
-        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-            now.time_since_epoch() % std::chrono::seconds(1)
-        );
-        
-        // 提取文件名（去掉路径）
-        std::string filename = getFileName(file);
-        
-        // 构建完整日志消息
-        std::ostringstream oss;
-        oss << "[" << std::put_time(&tm, "%Y-%m-%d %H:%M:%S") << "." 
-            << std::setw(3) << std::setfill('0') << ms.count() << "] "
-            << "[" << filename << ":" << line << "] "
-            << "[" << levelToString(level) << "] " << message;
-        
-        std::string full_message = oss.str();
-        
-        // 输出到控制台，不同级别使用不同颜色
-        if (level >= LogLevel::ERROR) {
-            // 错误级别输出到cerr，并添加红色
-            std::cerr << "\033[31m" << full_message << "\033[0m" << std::endl;
-        } else if (level == LogLevel::WARN) {
-            // 警告级别添加黄色
-            std::cout << "\033[33m" << full_message << "\033[0m" << std::endl;
+    template<typename Format, typename... Args>
+    void log(LogLevel level, const char* file, int line, const Format& format, Args&&... args) {
+        if (!shouldLog(level)) return;
+        if constexpr (std::is_array<Format>::value) {
+            enqueue(level, file, line, format, std::string_view(), std::forward<Args>(args)...);
+        } else if constexpr (std::is_pointer<Format>::value) {
+            enqueue(level, file, line, nullptr, std::string_view(format ? format : ""),
+                    std::forward<Args>(args)...);
         } else {
-            // 其他级别正常输出
-            std::cout << full_message << std::endl;
-        }
-        
-        // 输出到文件
-        if (log_to_file_ && log_file_.is_open()) {
-            log_file_ << full_message << std::endl;
-            log_file_.flush();
+            enqueue(level, file, line, nullptr, std::string_view(format), std::forward<Args>(args)...);
         }
     }
-    
+
+    /**
+     * @brief 等待此前提交的日志全部写出
+     */
+    void flush() {
+        const size_t target = enqueue_pos_.load(std::memory_order_acquire);
+        std::unique_lock<std::mutex> lock(flush_mutex_);
+        wake_cv_.notify_one();
+        flush_cv_.wait_for(lock, std::chrono::seconds(2), [this, target]() {
+            return written_pos_.load(std::memory_order_acquire) >= target || !running_;
+        });
+    }
+
 private:
-    Logger() = default;
+    static constexpr size_t kCapacity = 8192;   // 槽位数(2的幂)，共2MB
+    static constexpr size_t kMask = kCapacity - 1;
+    static constexpr auto kIdleWait = std::chrono::milliseconds(20);
+
+    Logger() : slots_(new log_detail::Slot[kCapacity]) {
+        for (size_t i = 0; i < kCapacity; ++i) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        running_ = true;
+        writer_ = std::thread(&Logger::writerLoop, this);
+    }
+
     ~Logger() {
+        {
+            std::lock_guard<std::mutex> lock(flush_mutex_);
+            stop_ = true;
+        }
+        wake_cv_.notify_one();
+        if (writer_.joinable()) {
+            writer_.join();
+        }
         if (log_file_.is_open()) {
             log_file_.close();
         }
     }
-    
+
     // 禁止拷贝构造和赋值
     Logger(const Logger&) = delete;
     Logger& operator=(const Logger&) = delete;
-    
+
+    /**
+     * @brief 占用一个槽位并编码记录，缓冲区满时按溢出策略丢弃或等待
+     */
+    template<typename... Args>
+    void enqueue(LogLevel level, const char* file, int line, const char* literal,
+                 std::string_view format, Args&&... args) {
+        log_detail::Slot* slot = nullptr;
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        for (;;) {
+            log_detail::Slot& candidate = slots_[pos & kMask];
+            const size_t sequence = candidate.sequence.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    slot = &candidate;
+                    break;
+                }
+            } else if (diff < 0) {
+                // 缓冲区已满
+                if (overflow_.load(std::memory_order_relaxed) == LogOverflowPolicy::DROP) {
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                wake_cv_.notify_one();
+                std::this_thread::yield();
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+
+        log_detail::RecordHeader& header = slot->header;
+        header.time = std::chrono::system_clock::now();
+        header.file = file;
+        header.format = literal;
+        header.line = line;
+        header.level = level;
+
+        log_detail::ArgWriter writer(slot->payload, sizeof(slot->payload));
+        if (!literal) {
+            writer.putString(format);
+        }
+        (writer.write(args), ...);
+        header.arg_count = writer.count();
+        header.truncated = writer.truncated();
+        header.payload_size = static_cast<uint16_t>(writer.size());
+        slot->sequence.store(pos + 1, std::memory_order_release);
+
+        // 错误日志和缓冲区过四分之一时立即唤醒后台线程，其余由后台线程定时取走
+        if (level >= LogLevel::ERROR || (pos & (kCapacity / 4 - 1)) == 0) {
+            wake_cv_.notify_one();
+        }
+        if (level == LogLevel::CRITICAL) {
+            flush();
+        }
+    }
+
+    /**
+     * @brief 后台线程：批量取出记录，格式化后统一写出
+     */
+    void writerLoop() {
+        std::string out;
+        std::string err;
+        std::string file;
+        std::string line;
+        out.reserve(64 * 1024);
+        file.reserve(64 * 1024);
+        uint64_t reported_drops = 0;
+        size_t pos = 0;
+
+        for (;;) {
+            size_t batch = 0;
+            for (;;) {
+                log_detail::Slot& slot = slots_[pos & kMask];
+                if (slot.sequence.load(std::memory_order_acquire) != pos + 1) {
+                    break;
+                }
+                line.clear();
+                formatRecord(slot, line);
+                const LogLevel level = slot.header.level;
+                slot.sequence.store(pos + kCapacity, std::memory_order_release);
+                pos++;
+                appendLine(level, line, out, err, file);
+                // 控制单批大小，避免长时间不写出
+                if (++batch >= kCapacity / 2) {
+                    break;
+                }
+            }
+
+            const uint64_t drops = dropped_.load(std::memory_order_relaxed);
+            if (drops != reported_drops) {
+                line = "[logger] [WARN] " + std::to_string(drops - reported_drops) +
+                       " log messages dropped (buffer full)";
+                appendLine(LogLevel::WARN, line, out, err, file);
+                reported_drops = drops;
+            }
+
+            if (!file.empty()) {
+                writeBatch(out, err, file);
+                out.clear();
+                err.clear();
+                file.clear();
+            }
+
+            {
+                std::unique_lock<std::mutex> lock(flush_mutex_);
+                written_pos_.store(pos, std::memory_order_release);
+                flush_cv_.notify_all();
+                if (batch > 0) {
+                    continue;
+                }
+                if (stop_) {
+                    break;
+                }
+                wake_cv_.wait_for(lock, kIdleWait);
+            }
+        }
+
+        running_ = false;
+        flush_cv_.notify_all();
+    }
+
+    /**
+     * @brief 把一条记录格式化为一行(不含换行)
+     */
+    void formatRecord(const log_detail::Slot& slot, std::string& out) {
+        const log_detail::RecordHeader& header = slot.header;
+
+        // 时间戳，同一秒内复用已格式化的日期时间
+        const auto since_epoch = header.time.time_since_epoch();
+        const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(since_epoch);
+        const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(since_epoch - seconds).count();
+        if (seconds.count() != cached_second_) {
+            cached_second_ = seconds.count();
+            const std::time_t time = static_cast<std::time_t>(cached_second_);
+            std::tm tm{};
+            localtime_r(&time, &tm);
+            cached_time_length_ = std::strftime(cached_time_, sizeof(cached_time_), "%Y-%m-%d %H:%M:%S", &tm);
+        }
+
+        char buffer[32];
+        out.push_back('[');
+        out.append(cached_time_, cached_time_length_);
+        out.append(buffer, std::snprintf(buffer, sizeof(buffer), ".%03d] [", static_cast<int>(ms)));
+        out.append(getFileName(header.file));
+        out.append(buffer, std::snprintf(buffer, sizeof(buffer), ":%d] [", header.line));
+        out.append(levelToString(header.level));
+        out.append("] ");
+
+        // 逐个替换{}，与参数数量不符时保留多余的{}或忽略多余的参数
+        log_detail::ArgReader reader(slot.payload, header.payload_size);
+        std::string_view format;
+        if (header.format) {
+            format = header.format;
+        } else {
+            reader.skipTag();
+            format = reader.readString();
+        }
+        uint8_t remaining = header.arg_count;
+        while (remaining > 0 && !reader.done()) {
+            const size_t placeholder = format.find("{}");
+            if (placeholder == std::string_view::npos) {
+                break;
+            }
+            out.append(format.data(), placeholder);
+            reader.appendNext(out);
+            format.remove_prefix(placeholder + 2);
+            remaining--;
+        }
+        out.append(format.data(), format.size());
+        if (header.truncated) {
+            out.append(" ...");
+        }
+    }
+
+    /**
+     * @brief 追加一行到控制台缓冲区(不同级别使用不同颜色)和文件缓冲区
+     */
+    static void appendLine(LogLevel level, const std::string& line,
+                           std::string& out, std::string& err, std::string& file) {
+        if (level >= LogLevel::ERROR) {
+            // 错误级别输出到cerr，并添加红色
+            err.append("\033[31m").append(line).append("\033[0m\n");
+        } else if (level == LogLevel::WARN) {
+            // 警告级别添加黄色
+            out.append("\033[33m").append(line).append("\033[0m\n");
+        } else {
+            out.append(line).push_back('\n');
+        }
+        file.append(line).push_back('\n');
+    }
+
+    /**
+     * @brief 一次写出一批日志，控制台和文件各flush一次
+     */
+    void writeBatch(const std::string& out, const std::string& err, const std::string& file) {
+        if (!out.empty()) {
+            std::cout.write(out.data(), static_cast<std::streamsize>(out.size()));
+            std::cout.flush();
+        }
+        if (!err.empty()) {
+            std::cerr.write(err.data(), static_cast<std::streamsize>(err.size()));
+            std::cerr.flush();
+        }
+
+        std::lock_guard<std::mutex> lock(sink_mutex_);
+        if (log_to_file_ && log_file_.is_open()) {
+            log_file_.write(file.data(), static_cast<std::streamsize>(file.size()));
+            log_file_.flush();
+        }
+    }
+
     /**
      * @brief 从完整路径中提取文件名
      */
-    std::string getFileName(const char* path) {
+    static std::string_view getFileName(const char* path) {
         if (!path) return "";
-        
+
         // 处理不同操作系统的路径分隔符
         const char* last_slash = std::strrchr(path, '/');
         const char* last_backslash = std::strrchr(path, '\\');
         const char* last_sep = std::max(last_slash, last_backslash);
-        
+
         if (last_sep) {
-            return std::string(last_sep + 1);
+            return std::string_view(last_sep + 1);
         }
-        return std::string(path);
+        return std::string_view(path);
     }
-    
-    template<typename... Args>
-    std::string formatString(const std::string& format, Args&&... args) {
-        if constexpr (sizeof...(args) == 0) {
-            return format;
-        } else {
-            // 简单的字符串格式化实现
-            std::ostringstream oss;
-            formatImpl(oss, format, std::forward<Args>(args)...);
-            return oss.str();
-        }
-    }
-    
-    template<typename T, typename... Args>
-    void formatImpl(std::ostringstream& oss, const std::string& format, T&& value, Args&&... args) {
-        size_t pos = format.find("{}");
-        if (pos != std::string::npos) {
-            oss << format.substr(0, pos) << std::forward<T>(value);
-            std::string remaining = format.substr(pos + 2);
-            if constexpr (sizeof...(args) > 0) {
-                formatImpl(oss, remaining, std::forward<Args>(args)...);
-            } else {
-                oss << remaining;
-            }
-        } else {
-            oss << format;
-        }
-    }
-    
-    std::string levelToString(LogLevel level) {
+
+    static const char* levelToString(LogLevel level) {
         switch (level) {
             case LogLevel::TRACE: return "TRACE";
             case LogLevel::DEBUG: return "DEBUG";
@@ -211,19 +635,51 @@ private:
             default: return "UNKNOWN";
         }
     }
-    
-    LogLevel log_level_ = LogLevel::INFO;
-    bool log_to_file_ = true;
+
+    std::atomic<int> log_level_{static_cast<int>(LogLevel::INFO)};
+    std::atomic<LogOverflowPolicy> overflow_{LogOverflowPolicy::DROP};
+    std::atomic<uint64_t> dropped_{0};
+
+    // 环形缓冲区
+    std::unique_ptr<log_detail::Slot[]> slots_;
+    alignas(64) std::atomic<size_t> enqueue_pos_{0};
+    alignas(64) std::atomic<size_t> written_pos_{0};
+
+    // 后台线程
+    std::thread writer_;
+    std::mutex flush_mutex_;
+    std::condition_variable wake_cv_;
+    std::condition_variable flush_cv_;
+    bool stop_ = false;
+    std::atomic<bool> running_{false};
+
+    // 输出目标，由sink_mutex_保护
+    std::mutex sink_mutex_;
+    bool log_to_file_ = false;
+    std::string log_path_;
     std::ofstream log_file_;
-    std::mutex mutex_;
+
+    // 后台线程的时间戳缓存
+    int64_t cached_second_ = -1;
+    char cached_time_[32] = {};
+    size_t cached_time_length_ = 0;
 };
 
-// 便捷宏定义，自动添加文件名和行号
-#define LOG_TRACE(...) Logger::getInstance().log(LogLevel::TRACE, __FILE__, __LINE__, __VA_ARGS__)
-#define LOG_DEBUG(...) Logger::getInstance().log(LogLevel::DEBUG, __FILE__, __LINE__, __VA_ARGS__)
-#define LOG_INFO(...) Logger::getInstance().log(LogLevel::INFO, __FILE__, __LINE__, __VA_ARGS__)
-#define LOG_WARN(...) Logger::getInstance().log(LogLevel::WARN, __FILE__, __LINE__, __VA_ARGS__)
-#define LOG_ERROR(...) Logger::getInstance().log(LogLevel::ERROR, __FILE__, __LINE__, __VA_ARGS__)
-#define LOG_CRITICAL(...) Logger::getInstance().log(LogLevel::CRITICAL, __FILE__, __LINE__, __VA_ARGS__)
+// 便捷宏定义，自动添加文件名和行号；编译期和运行时级别过滤在求值参数之前完成
+#define LOG_AT_LEVEL(level, ...)                                                        \
+    do {                                                                                \
+        if constexpr (static_cast<int>(level) >= LOG_ACTIVE_LEVEL) {                    \
+            if (Logger::getInstance().shouldLog(level)) {                               \
+                Logger::getInstance().log(level, __FILE__, __LINE__, __VA_ARGS__);      \
+            }                                                                           \
+        }                                                                               \
+    } while (0)
+
+#define LOG_TRACE(...) LOG_AT_LEVEL(LogLevel::TRACE, __VA_ARGS__)
+#define LOG_DEBUG(...) LOG_AT_LEVEL(LogLevel::DEBUG, __VA_ARGS__)
+#define LOG_INFO(...) LOG_AT_LEVEL(LogLevel::INFO, __VA_ARGS__)
+#define LOG_WARN(...) LOG_AT_LEVEL(LogLevel::WARN, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT_LEVEL(LogLevel::ERROR, __VA_ARGS__)
+#define LOG_CRITICAL(...) LOG_AT_LEVEL(LogLevel::CRITICAL, __VA_ARGS__)
 
 #endif // LOGGER_HPP
@@ -41,15 +41,15 @@ void printSystemState(SystemState state) {
     std::cout << "System state: " << state_str << std::endl;
 }
 
-// 打印性能统计
-void printPerformanceStats(const SystemPerformance& stats) {
-    std::cout << std::fixed << std::setprecision(2);
-    std::cout << "Performance stats - ";
+// 打印运行结束时最近一个采样区间的统计(运行期间由指标导出线程定期写日志)
+void printPerformanceSummary(const SystemPerformance& stats) {
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Performance summary - ";
     std::cout << "FPS: " << stats.fps << ", ";
-    std::cout << "Latency: " << stats.total_latency_ms << "ms, ";
-    std::cout << "Detection: " << stats.detection_time_ms << "ms, ";
-    std::cout << "Tracking: " << stats.tracking_time_ms << "ms, ";
-    std::cout << "Analysis: " << stats.analysis_time_ms << "ms" << std::endl;
+    std::cout << "Latency p50/p99/max: " << stats.latency_p50_ms << "/" << stats.latency_p99_ms << "/"
+              << stats.latency_max_ms << "ms, ";
+    std::cout << "Inference p99: " << stats.detection_p99_ms << "ms, ";
+    std::cout << "Dropped: " << stats.frames_dropped << "/" << stats.frames_submitted << std::endl;
 }
 
 int main(int argc, char* argv[]) {
@@ -97,14 +97,14 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
-    // 主循环，定期打印性能统计
+    // 主循环，性能指标由指标导出线程按metrics配置输出
     while (system_instance->getState() != SystemState::STOPPED && 
            system_instance->getState() != SystemState::ERROR) {
-        printPerformanceStats(system_instance->getPerformanceStats());
         std::this_thread::sleep_for(std::chrono::seconds(1));
     }
     
     // 停止系统
+    printPerformanceSummary(system_instance->getPerformanceStats());
     system_instance->stop();
     std::cout << "System exited normally" << std::endl;
     
@@ -0,0 +1,318 @@
+/**
+ * @file metrics.hpp
+ * @brief 运行指标 - 无锁计数器、仪表和延迟直方图
+ * @author pengchengkang
+ * @date 2025-9-16
+ *
+ * 功能描述：
+ * - 计数器和直方图按线程分片，记录只做relaxed原子加，不加锁、不分配内存
+ * - 延迟直方图为HDR式对数-线性分桶(每个2的幂区间等分32桶，相对误差约3%)，
+ *   以微秒记录，覆盖1us到约19小时，可求任意分位数
+ * - 指标按(名称, 标签)注册到全局注册表，注册后地址不变，调用方缓存引用即可
+ * - 导出方对直方图取快照，两次快照相减即得区间内的分布
+ */
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace metrics_detail {
+
+constexpr size_t kShards = 8;
+
+// 当前线程的分片编号，线程首次记录时依次分配
+inline size_t shardIndex() {
+    static std::atomic<size_t> next{0};
+    thread_local size_t index = next.fetch_add(1, std::memory_order_relaxed) % kShards;
+    return index;
+}
+
+struct alignas(64) PaddedCounter {
+    std::atomic<uint64_t> value{0};
+};
+
+} // namespace metrics_detail
+
+/**
+ * @brief 单调递增计数器
+ */
+class Counter {
+public:
+    void add(uint64_t delta = 1) {
+        shards_[metrics_detail::shardIndex()].value.fetch_add(delta, std::memory_order_relaxed);
+    }
+
+    uint64_t value() const {
+        uint64_t total = 0;
+        for (const auto& shard : shards_) {
+            total += shard.value.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+private:
+    std::array<metrics_detail::PaddedCounter, metrics_detail::kShards> shards_;
+};
+
+/**
+ * @brief 瞬时值(队列深度、CPU使用率等)
+ */
+class Gauge {
+public:
+    void set(double value) {
+        value_.store(value, std::memory_order_relaxed);
+    }
+
+    double value() const {
+        return value_.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<double> value_{0.0};
+};
+
+/**
+ * @brief 直方图快照，桶计数为累计值
+ */
+struct HistogramSnapshot {
+    std::vector<uint64_t> buckets;
+    uint64_t count = 0;
+    uint64_t sum_us = 0;
+    uint64_t max_us = 0;
+
+    // 分位数(微秒)，取所在桶的上界，偏保守
+    double quantile(double q) const;
+
+    double mean() const {
+        return count > 0 ? static_cast<double>(sum_us) / static_cast<double>(count) : 0.0;
+    }
+
+    // 本快照减去更早的快照，得到区间内的分布(区间最大值取本快照的最大值)
+    HistogramSnapshot since(const HistogramSnapshot& earlier) const;
+};
+
+/**
+ * @brief HDR式延迟直方图
+ */
+class LatencyHistogram {
+public:
+    static constexpr int kSubBucketBits = 5;
+    static constexpr uint64_t kSubBuckets = uint64_t(1) << kSubBucketBits;
+    static constexpr int kMaxShift = 31;
+    static constexpr size_t kBucketCount = (kMaxShift + 2) * kSubBuckets;
+    static constexpr uint64_t kMaxValue = (uint64_t(2) * kSubBuckets << kMaxShift) - 1;
+
+    LatencyHistogram() : shards_(new Shard[metrics_detail::kShards]) {}
+
+    // 记录一次耗时(微秒)
+    void record(uint64_t micros) {
+        if (micros > kMaxValue) {
+            micros = kMaxValue;
+        }
+        Shard& shard = shards_[metrics_detail::shardIndex()];
+        shard.buckets[bucketIndex(micros)].fetch_add(1, std::memory_order_relaxed);
+        shard.count.fetch_add(1, std::memory_order_relaxed);
+        shard.sum.fetch_add(micros, std::memory_order_relaxed);
+        uint64_t max = shard.max.load(std::memory_order_relaxed);
+        while (micros > max && !shard.max.compare_exchange_weak(max, micros, std::memory_order_relaxed)) {
+        }
+    }
+
+    void recordMs(double ms) {
+        record(ms > 0.0 ? static_cast<uint64_t>(ms * 1000.0 + 0.5) : 0);
+    }
+
+    template <typename Duration>
+    void record(Duration duration) {
+        const auto micros = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+        record(micros > 0 ? static_cast<uint64_t>(micros) : 0);
+    }
+
+    HistogramSnapshot snapshot() const {
+        HistogramSnapshot snap;
+        snap.buckets.assign(kBucketCount, 0);
+        for (size_t s = 0; s < metrics_detail::kShards; ++s) {
+            const Shard& shard = shards_[s];
+            for (size_t i = 0; i < kBucketCount; ++i) {
+                snap.buckets[i] += shard.buckets[i].load(std::memory_order_relaxed);
+            }
+            snap.count += shard.count.load(std::memory_order_relaxed);
+            snap.sum_us += shard.sum.load(std::memory_order_relaxed);
+            snap.max_us = std::max(snap.max_us, shard.max.load(std::memory_order_relaxed));
+        }
+        return snap;
+    }
+
+    // 清零(与并发记录之间不保证原子性，只用于统计重置)
+    void reset() {
+        for (size_t s = 0; s < metrics_detail::kShards; ++s) {
+            Shard& shard = shards_[s];
+            for (auto& bucket : shard.buckets) {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+            shard.count.store(0, std::memory_order_relaxed);
+            shard.sum.store(0, std::memory_order_relaxed);
+            shard.max.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    static size_t bucketIndex(uint64_t value) {
+        if (value < 2 * kSubBuckets) {
+            return static_cast<size_t>(value);
+        }
+        const int msb = 63 - __builtin_clzll(value);
+        const int shift = msb - kSubBucketBits;
+        return static_cast<size_t>((shift + 1) * kSubBuckets + ((value >> shift) - kSubBuckets));
+    }
+
+    // 桶内最大值(微秒)
+    static uint64_t bucketUpperBound(size_t index) {
+        if (index < 2 * kSubBuckets) {
+            return index;
+        }
+        const int shift = static_cast<int>(index / kSubBuckets) - 1;
+        const uint64_t sub = index % kSubBuckets + kSubBuckets;
+        return ((sub + 1) << shift) - 1;
+    }
+
+private:
+    struct alignas(64) Shard {
+        std::array<std::atomic<uint64_t>, kBucketCount> buckets{};
+        std::atomic<uint64_t> count{0};
+        std::atomic<uint64_t> sum{0};
+        std::atomic<uint64_t> max{0};
+    };
+
+    std::unique_ptr<Shard[]> shards_;
+};
+
+inline double HistogramSnapshot::quantile(double q) const {
+    if (count == 0) {
+        return 0.0;
+    }
+    const double clamped = q < 0.0 ? 0.0 : (q > 1.0 ? 1.0 : q);
+    uint64_t rank = static_cast<uint64_t>(clamped * static_cast<double>(count) + 0.5);
+    rank = rank < 1 ? 1 : (rank > count ? count : rank);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            const uint64_t upper = LatencyHistogram::bucketUpperBound(i);
+            return static_cast<double>(max_us > 0 ? std::min(upper, max_us) : upper);
+        }
+    }
+    return static_cast<double>(max_us);
+}
+
+inline HistogramSnapshot HistogramSnapshot::since(const HistogramSnapshot& earlier) const {
+    HistogramSnapshot delta = *this;
+    if (earlier.buckets.size() != buckets.size() || earlier.count > count) {
+        return delta;   // 期间被重置
+    }
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        delta.buckets[i] -= std::min(delta.buckets[i], earlier.buckets[i]);
+    }
+    delta.count -= earlier.count;
+    delta.sum_us -= std::min(delta.sum_us, earlier.sum_us);
+    return delta;
+}
+
+/**
+ * @brief 全局指标注册表
+ * 指标名按Prometheus习惯(vps_前缀、单位后缀)，标签写成`key="value"`形式
+ */
+class MetricsRegistry {
+public:
+    template <typename T>
+    struct Entry {
+        std::string name;
+        std::string labels;
+        std::string help;
+        std::unique_ptr<T> metric;
+    };
+
+    static MetricsRegistry& instance() {
+        static MetricsRegistry registry;
+        return registry;
+    }
+
+    LatencyHistogram& histogram(const std::string& name, const std::string& labels = "",
+                                const std::string& help = "") {
+        return lookup(histograms_, name, labels, help);
+    }
+
+    Counter& counter(const std::string& name, const std::string& labels = "",
+                     const std::string& help = "") {
+        return lookup(counters_, name, labels, help);
+    }
+
+    Gauge& gauge(const std::string& name, const std::string& labels = "",
+                 const std::string& help = "") {
+        return lookup(gauges_, name, labels, help);
+    }
+
+    // 按注册顺序遍历，回调期间持有注册表锁，不要在回调中注册新指标
+    template <typename F>
+    void forEachHistogram(F&& func) const { forEach(histograms_, func); }
+
+    template <typename F>
+    void forEachCounter(F&& func) const { forEach(counters_, func); }
+
+    template <typename F>
+    void forEachGauge(F&& func) const { forEach(gauges_, func); }
+
+    void resetHistograms() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& entry : histograms_) {
+            entry.metric->reset();
+        }
+    }
+
+private:
+    MetricsRegistry() = default;
+
+    template <typename T>
+    T& lookup(std::vector<Entry<T>>& entries, const std::string& name, const std::string& labels,
+              const std::string& help) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& entry : entries) {
+            if (entry.name == name && entry.labels == labels) {
+                return *entry.metric;
+            }
+        }
+        entries.push_back(Entry<T>{name, labels, help, std::make_unique<T>()});
+        return *entries.back().metric;
+    }
+
+    template <typename T, typename F>
+    void forEach(const std::vector<Entry<T>>& entries, F& func) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& entry : entries) {
+            func(entry.name, entry.labels, entry.help, *entry.metric);
+        }
+    }
+
+    mutable std::mutex mutex_;
+    std::vector<Entry<LatencyHistogram>> histograms_;
+    std::vector<Entry<Counter>> counters_;
+    std::vector<Entry<Gauge>> gauges_;
+};
+
+// 各级耗时直方图(vps_stage_latency_seconds{stage="..."})
+inline LatencyHistogram& stageLatency(const char* stage) {
+    return MetricsRegistry::instance().histogram("vps_stage_latency_seconds",
+                                                 std::string("stage=\"") + stage + "\"",
+                                                 "Per-frame processing time of each pipeline stage");
+}
+
+#endif // METRICS_HPP
@@ -1,21 +1,24 @@
 /**
  * @file thread_pool.hpp
- * @brief 线程池实现 - 提供高效的多线程任务调度
+ * @brief 工作窃取线程池 - 流水线各级、批量计算和后台任务共用的调度器
  * @author pengchengkang
  * @date 2025-9-7
- * 
+ *
  * 功能描述：
- * - 支持动态任务提交和异步执行
- * - 自动管理工作线程生命周期
- * - 提供任务返回值获取机制
- * - 线程安全的任务队列管理
+ * - 每个工作线程拥有无锁双端队列(Chase-Lev)，本线程从底部压入/弹出，其他线程从顶部窃取
+ * - 非工作线程提交的任务进入全局注入队列
+ * - 两条优先级通道：HIGH(感知流水线)总是先于LOW(输出、LLM等后台任务)被取走
+ * - 任务对象内嵌小缓冲区存放可调用对象，节点按线程缓存复用，稳态提交不分配堆内存
+ * - parallelFor将区间切块并行执行，调用线程参与计算，func的首个异常在全部块结束后重新抛出
+ * - post()提交的任务抛出的异常记录错误日志后丢弃(submit()的异常经future返回)
+ * - 工作线程可绑定到指定CPU核心
+ * - submit()返回std::future，兼容原有接口(future共享状态需要一次分配)
  */
 
 #ifndef THREAD_POOL_HPP
 #define THREAD_POOL_HPP
 
 #include <vector>
-#include <queue>
 #include <memory>
 #include <thread>
 #include <mutex>
@@ -23,128 +26,507 @@
 #include <future>
 #include <functional>
 #include <stdexcept>
+#include <exception>
 #include <atomic>
+#include <type_traits>
+#include <utility>
+#include <new>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "logger.hpp"
+
+// 任务优先级通道
+enum class TaskPriority {
+    HIGH = 0,    // 感知流水线
+    LOW = 1      // 输出、LLM等后台任务
+};
+
+namespace thread_pool_detail {
+
+constexpr size_t kPriorities = 2;
+
+/**
+ * @brief 任务节点，可调用对象不超过kInlineSize字节时内嵌存放
+ */
+class TaskNode {
+public:
+    static constexpr size_t kInlineSize = 64;
+
+    template <typename F>
+    void emplace(F&& func) {
+        using Fn = typename std::decay<F>::type;
+        if (sizeof(Fn) <= kInlineSize && alignof(Fn) <= alignof(std::max_align_t)) {
+            new (storage_) Fn(std::forward<F>(func));
+            invoke_ = [](TaskNode& node) { (*reinterpret_cast<Fn*>(node.storage_))(); };
+            destroy_ = [](TaskNode& node) { reinterpret_cast<Fn*>(node.storage_)->~Fn(); };
+        } else {
+            // 过大的可调用对象退化为堆上存放
+            *reinterpret_cast<Fn**>(storage_) = new Fn(std::forward<F>(func));
+            invoke_ = [](TaskNode& node) { (**reinterpret_cast<Fn**>(node.storage_))(); };
+            destroy_ = [](TaskNode& node) { delete *reinterpret_cast<Fn**>(node.storage_); };
+        }
+    }
+
+    // 执行并销毁可调用对象，异常记录日志后不外泄到工作线程
+    void run() {
+        try {
+            invoke_(*this);
+        } catch (const std::exception& e) {
+            LOG_ERROR("Thread pool task failed: {}", e.what());
+        } catch (...) {
+            LOG_ERROR("Thread pool task failed with a non-standard exception");
+        }
+        destroy_(*this);
+    }
+
+    TaskNode* next = nullptr;   // 节点缓存的链表指针
+
+private:
+    alignas(std::max_align_t) unsigned char storage_[kInlineSize];
+    void (*invoke_)(TaskNode&) = nullptr;
+    void (*destroy_)(TaskNode&) = nullptr;
+};
+
+/**
+ * @brief 任务节点缓存：每线程一个本地链表，超出上限时整批交给全局链表，
+ * 本地为空时先从全局链表取一批，生产者和消费者不在同一线程时节点也能循环复用
+ */
+class NodeCache {
+public:
+    static TaskNode* acquire() {
+        Local& local = localCache();
+        if (!local.head) {
+            refill(local);
+        }
+        if (TaskNode* node = local.head) {
+            local.head = node->next;
+            local.count--;
+            return node;
+        }
+        return new TaskNode();
+    }
+
+    static void release(TaskNode* node) {
+        Local& local = localCache();
+        node->next = local.head;
+        local.head = node;
+        if (++local.count >= 2 * kBatch) {
+            spill(local);
+        }
+    }
+
+private:
+    static constexpr size_t kBatch = 64;
+    static constexpr size_t kGlobalLimit = 4096;
+
+    struct Global {
+        std::mutex mutex;
+        TaskNode* head = nullptr;
+        size_t count = 0;
+        ~Global() { freeList(head); }
+    };
+
+    struct Local {
+        TaskNode* head = nullptr;
+        size_t count = 0;
+        ~Local() { freeList(head); }
+    };
+
+    static Global& globalCache() {
+        static Global global;
+        return global;
+    }
+
+    static Local& localCache() {
+        thread_local Local local;
+        return local;
+    }
+
+    static void freeList(TaskNode* node) {
+        while (node) {
+            TaskNode* next = node->next;
+            delete node;
+            node = next;
+        }
+    }
+
+    // 本地链表的一半交给全局链表，全局链表满时释放
+    static void spill(Local& local) {
+        TaskNode* first = local.head;
+        TaskNode* last = first;
+        for (size_t i = 1; i < kBatch; ++i) {
+            last = last->next;
+        }
+        local.head = last->next;
+        local.count -= kBatch;
+        last->next = nullptr;
+
+        Global& global = globalCache();
+        {
+            std::lock_guard<std::mutex> lock(global.mutex);
+            if (global.count < kGlobalLimit) {
+                last->next = global.head;
+                global.head = first;
+                global.count += kBatch;
+                return;
+            }
+        }
+        freeList(first);
+    }
+
+    static void refill(Local& local) {
+        Global& global = globalCache();
+        std::lock_guard<std::mutex> lock(global.mutex);
+        for (size_t i = 0; i < kBatch && global.head; ++i) {
+            TaskNode* node = global.head;
+            global.head = node->next;
+            global.count--;
+            node->next = local.head;
+            local.head = node;
+            local.count++;
+        }
+    }
+};
+
+/**
+ * @brief Chase-Lev工作窃取双端队列(固定容量)
+ * push/pop只能由所属工作线程调用，steal可由任意线程调用
+ */
+class WorkStealingDeque {
+public:
+    static constexpr int64_t kCapacity = 1024;
+
+    WorkStealingDeque() : top_(0), bottom_(0) {
+        for (auto& slot : buffer_) {
+            slot.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    // 队列满时返回false，由调用方改投注入队列
+    bool push(TaskNode* node) {
+        const int64_t bottom = bottom_.load(std::memory_order_relaxed);
+        const int64_t top = top_.load(std::memory_order_acquire);
+        if (bottom - top >= kCapacity) {
+            return false;
+        }
+        buffer_[bottom & kMask].store(node, std::memory_order_relaxed);
+        bottom_.store(bottom + 1, std::memory_order_release);
+        return true;
+    }
+
+    TaskNode* pop() {
+        const int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+        // bottom写入与top读取须全序(seq_cst)，否则可能与窃取者同时取走最后一个元素
+        bottom_.store(bottom, std::memory_order_seq_cst);
+        int64_t top = top_.load(std::memory_order_seq_cst);
+
+        if (top > bottom) {
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        TaskNode* node = buffer_[bottom & kMask].load(std::memory_order_relaxed);
+        if (top == bottom) {
+            // 最后一个元素，与窃取者竞争
+            if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                              std::memory_order_relaxed)) {
+                node = nullptr;
+            }
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+        }
+        return node;
+    }
+
+    TaskNode* steal() {
+        int64_t top = top_.load(std::memory_order_seq_cst);
+        const int64_t bottom = bottom_.load(std::memory_order_seq_cst);
+        if (top >= bottom) {
+            return nullptr;
+        }
+        TaskNode* node = buffer_[top & kMask].load(std::memory_order_relaxed);
+        if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                          std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return node;
+    }
+
+    bool empty() const {
+        return bottom_.load(std::memory_order_relaxed) <= top_.load(std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr int64_t kMask = kCapacity - 1;
+
+    alignas(64) std::atomic<int64_t> top_;
+    alignas(64) std::atomic<int64_t> bottom_;
+    std::atomic<TaskNode*> buffer_[kCapacity];
+};
 
 /**
- * @brief 线程池类 - 管理多个工作线程执行异步任务
- * 使用生产者-消费者模式，支持任务的异步提交和执行
+ * @brief 注入队列：非工作线程提交的任务，按需扩容的环形缓冲区
+ */
+class InjectionQueue {
+public:
+    void push(TaskNode* node) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (size_ == ring_.size()) {
+            std::vector<TaskNode*> grown(std::max<size_t>(64, ring_.size() * 2));
+            for (size_t i = 0; i < size_; ++i) {
+                grown[i] = ring_[(head_ + i) % ring_.size()];
+            }
+            ring_.swap(grown);
+            head_ = 0;
+        }
+        ring_[(head_ + size_) % ring_.size()] = node;
+        size_++;
+        count_.store(size_, std::memory_order_release);
+    }
+
+    TaskNode* pop() {
+        if (count_.load(std::memory_order_acquire) == 0) {
+            return nullptr;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (size_ == 0) {
+            return nullptr;
+        }
+        TaskNode* node = ring_[head_];
+        head_ = (head_ + 1) % ring_.size();
+        size_--;
+        count_.store(size_, std::memory_order_release);
+        return node;
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<TaskNode*> ring_;
+    size_t head_ = 0;
+    size_t size_ = 0;
+    std::atomic<size_t> count_{0};
+};
+
+} // namespace thread_pool_detail
+
+/**
+ * @brief 工作窃取线程池
  */
 class ThreadPool {
 public:
     /**
      * @brief 构造函数，创建指定数量的工作线程
-     * @param num_threads 工作线程数量，默认为CPU核心数
+     * @param num_threads 工作线程数量，为0时取CPU核心数
+     * @param cpu_affinity 工作线程绑定的CPU核心，第i个线程绑定cpu_affinity[i % size]，为空时不绑定
      */
-    ThreadPool(size_t num_threads = std::thread::hardware_concurrency()) 
-        : stop_(false) {
-        for (size_t i = 0; i < num_threads; ++i) {
-            workers_.emplace_back([this] {
-                for (;;) {
-                    std::function<void()> task;
-                    
-                    {
-                        std::unique_lock<std::mutex> lock(queue_mutex_);
-                        condition_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
-                        
-                        if (stop_ && tasks_.empty()) {
-                            return;
-                        }
-                        
-                        task = std::move(tasks_.front());
-                        tasks_.pop();
-                    }
-                    
-                    task();
-                }
-            });
+    explicit ThreadPool(size_t num_threads = std::thread::hardware_concurrency(),
+                        std::vector<int> cpu_affinity = {})
+        : num_threads_(num_threads), cpu_affinity_(std::move(cpu_affinity)), stop_(true),
+          epoch_(0), sleepers_(0) {
+        start();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief 析构函数，执行完已提交的任务后停止所有线程
+     */
+    ~ThreadPool() {
+        stop();
+    }
+
+    /**
+     * @brief 进程共享的线程池，由configureShared()设置线程数和绑核
+     */
+    static ThreadPool& shared() {
+        static ThreadPool pool(0);
+        return pool;
+    }
+
+    /**
+     * @brief 重新配置共享线程池，须在没有任务运行时调用(如系统初始化阶段)
+     */
+    static void configureShared(size_t num_threads, const std::vector<int>& cpu_affinity = {}) {
+        ThreadPool& pool = shared();
+        if (!pool.stop_ && pool.num_threads_ == num_threads && pool.cpu_affinity_ == cpu_affinity) {
+            return;
         }
+        pool.stop();
+        pool.num_threads_ = num_threads;
+        pool.cpu_affinity_ = cpu_affinity;
+        pool.start();
     }
-    
+
+    /**
+     * @brief 提交无返回值的任务，不分配堆内存(可调用对象不超过64字节时)
+     * 在本池工作线程中调用时压入本线程队列，否则进入注入队列
+     */
+    template <class F>
+    void post(F&& func, TaskPriority priority = TaskPriority::HIGH) {
+        thread_pool_detail::TaskNode* node = thread_pool_detail::NodeCache::acquire();
+        node->emplace(std::forward<F>(func));
+        enqueue(node, priority);
+    }
+
     /**
      * @brief 提交任务到线程池
-     * @tparam F 函数类型
-     * @tparam Args 参数类型
      * @param f 要执行的函数
      * @param args 函数参数
      * @return std::future 用于获取任务执行结果
      */
-    template<class F, class... Args>
-    auto submit(F&& f, Args&&... args) 
-        -> std::future<typename std::result_of<F(Args...)>::type> {
-        using return_type = typename std::result_of<F(Args...)>::type;
-        
+    template <class F, class... Args>
+    auto submit(F&& f, Args&&... args)
+        -> std::future<std::invoke_result_t<F, Args...>> {
+        using return_type = std::invoke_result_t<F, Args...>;
+
+        if (stop_) {
+            throw std::runtime_error("submit on stopped ThreadPool");
+        }
+
         auto task = std::make_shared<std::packaged_task<return_type()>>(
-            std::bind(std::forward<F>(f), std::forward<Args>(args)...)
-        );
-        
-        std::future<return_type> res = task->get_future();
-        
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            
-            if (stop_) {
-                throw std::runtime_error("submit on stopped ThreadPool");
+            std::bind(std::forward<F>(f), std::forward<Args>(args)...));
+        std::future<return_type> result = task->get_future();
+        post([task]() { (*task)(); }, TaskPriority::HIGH);
+        return result;
+    }
+
+    /**
+     * @brief 并行执行func(chunk_begin, chunk_end)覆盖[begin, end)，返回时全部完成
+     * 区间按grain切块，块数不超过1或没有工作线程时在调用线程中直接执行；
+     * 调用线程参与计算，在工作线程中调用时等待期间继续执行其他任务
+     */
+    template <class F>
+    void parallelFor(size_t begin, size_t end, size_t grain, F&& func,
+                     TaskPriority priority = TaskPriority::HIGH) {
+        if (begin >= end) {
+            return;
+        }
+        grain = std::max<size_t>(1, grain);
+        const size_t chunks = (end - begin + grain - 1) / grain;
+        if (chunks <= 1 || workers_.empty()) {
+            func(begin, end);
+            return;
+        }
+
+        struct State {
+            std::atomic<size_t> next_chunk{0};
+            std::atomic<size_t> helpers{0};
+            std::mutex mutex;
+            std::condition_variable done;
+            std::exception_ptr error;   // 首个异常，受mutex保护
+        } state;
+
+        // 记录首个异常并放弃剩余的块
+        auto fail = [&state, chunks](std::exception_ptr error) {
+            state.next_chunk.store(chunks, std::memory_order_relaxed);
+            std::lock_guard<std::mutex> lock(state.mutex);
+            if (!state.error) {
+                state.error = std::move(error);
             }
-            
-            tasks_.emplace([task](){ (*task)(); });
+        };
+
+        // 不抛出异常：辅助任务总能走到递减，调用方不会在辅助任务仍引用栈帧时返回
+        auto run_chunks = [&]() noexcept {
+            try {
+                for (;;) {
+                    const size_t chunk = state.next_chunk.fetch_add(1, std::memory_order_relaxed);
+                    if (chunk >= chunks) {
+                        break;
+                    }
+                    const size_t chunk_begin = begin + chunk * grain;
+                    func(chunk_begin, std::min(end, chunk_begin + grain));
+                }
+            } catch (...) {
+                fail(std::current_exception());
+            }
+        };
+
+        // 辅助任务只引用调用栈上的state，调用方等待全部辅助任务退出后才返回
+        const size_t helpers = std::min(chunks - 1, workers_.size());
+        for (size_t i = 0; i < helpers; ++i) {
+            state.helpers.fetch_add(1, std::memory_order_relaxed);
+            try {
+                post([&state, &run_chunks]() {
+                    run_chunks();
+                    // 持锁递减，调用方拿到锁即说明辅助任务不再访问state
+                    std::lock_guard<std::mutex> lock(state.mutex);
+                    if (state.helpers.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                        state.done.notify_all();
+                    }
+                }, priority);
+            } catch (...) {
+                // 提交失败(节点分配失败)：该辅助任务不存在，剩余的块由已提交的任务和调用线程完成
+                state.helpers.fetch_sub(1, std::memory_order_relaxed);
+                break;
+            }
+        }
+
+        run_chunks();
+
+        if (currentWorker() >= 0) {
+            // 工作线程中等待时继续执行任务(通常先取回自己压入的辅助任务)，避免占住工作线程
+            while (state.helpers.load(std::memory_order_acquire) > 0) {
+                if (!runOneTask(static_cast<size_t>(currentWorker()))) {
+                    std::this_thread::yield();
+                }
+            }
+            std::lock_guard<std::mutex> lock(state.mutex);
+        } else {
+            std::unique_lock<std::mutex> lock(state.mutex);
+            state.done.wait(lock, [&state]() { return state.helpers.load(std::memory_order_acquire) == 0; });
+        }
+        if (state.error) {
+            std::rethrow_exception(state.error);
         }
-        
-        condition_.notify_one();
-        return res;
     }
-    
+
     /**
-     * @brief 停止线程池，等待所有任务完成
+     * @brief 停止线程池，等待已提交的任务全部完成
      */
     void stop() {
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            stop_ = true;
+        if (stop_.exchange(true)) {
+            return;
         }
-        
-        condition_.notify_all();
-        
-        for (std::thread &worker: workers_) {
+        wakeAll();
+
+        for (std::thread& worker : workers_) {
             if (worker.joinable()) {
                 worker.join();
             }
         }
-        
         workers_.clear();
+        queues_.clear();
     }
-    
+
     /**
-     * @brief 重新启动线程池
+     * @brief 按构造(或configureShared)时的线程数重新启动线程池
      */
     void start() {
-        if (stop_) {
-            stop_ = false;
-            // 重新创建工作线程
-            size_t num_threads = std::thread::hardware_concurrency();
-            for (size_t i = 0; i < num_threads; ++i) {
-                workers_.emplace_back([this] {
-                    for (;;) {
-                        std::function<void()> task;
-                        
-                        {
-                            std::unique_lock<std::mutex> lock(queue_mutex_);
-                            condition_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
-                            
-                            if (stop_ && tasks_.empty()) {
-                                return;
-                            }
-                            
-                            task = std::move(tasks_.front());
-                            tasks_.pop();
-                        }
-                        
-                        task();
-                    }
-                });
+        if (!stop_) {
+            return;
+        }
+        const size_t count = num_threads_ > 0 ? num_threads_
+                                              : std::max(1u, std::thread::hardware_concurrency());
+        queues_.clear();
+        for (size_t i = 0; i < count; ++i) {
+            queues_.push_back(std::make_unique<WorkerQueues>());
+        }
+
+        stop_ = false;
+        for (size_t i = 0; i < count; ++i) {
+            workers_.emplace_back(&ThreadPool::workerLoop, this, i);
+            if (!cpu_affinity_.empty()) {
+                pinThread(workers_.back(), cpu_affinity_[i % cpu_affinity_.size()]);
             }
         }
     }
-    
+
     /**
      * @brief 获取工作线程数量
      * @return size_t 线程数量
@@ -152,21 +534,145 @@ public:
     size_t size() const {
         return workers_.size();
     }
-    
+
     /**
-     * @brief 析构函数，自动停止所有线程
+     * @brief 当前线程是否为本池的工作线程
      */
-    ~ThreadPool() {
-        stop();
+    bool isWorkerThread() const {
+        return currentPool() == this;
     }
-    
+
 private:
+    using TaskNode = thread_pool_detail::TaskNode;
+    static constexpr size_t kPriorities = thread_pool_detail::kPriorities;
+
+    struct WorkerQueues {
+        thread_pool_detail::WorkStealingDeque deques[kPriorities];
+    };
+
+    size_t num_threads_;
+    std::vector<int> cpu_affinity_;
     std::vector<std::thread> workers_;
-    std::queue<std::function<void()>> tasks_;
-    
-    std::mutex queue_mutex_;
-    std::condition_variable condition_;
+    std::vector<std::unique_ptr<WorkerQueues>> queues_;
+    thread_pool_detail::InjectionQueue injection_[kPriorities];
+
     std::atomic<bool> stop_;
+    std::atomic<uint64_t> epoch_;       // 每次提交递增，用于判定休眠期间是否有新任务
+    std::atomic<int> sleepers_;
+    std::mutex sleep_mutex_;
+    std::condition_variable sleep_cv_;
+
+    static const ThreadPool*& currentPool() {
+        thread_local const ThreadPool* pool = nullptr;
+        return pool;
+    }
+
+    static int& currentIndex() {
+        thread_local int index = -1;
+        return index;
+    }
+
+    int currentWorker() const {
+        return currentPool() == this ? currentIndex() : -1;
+    }
+
+    void enqueue(TaskNode* node, TaskPriority priority) {
+        const size_t lane = static_cast<size_t>(priority);
+        const int worker = currentWorker();
+        if (worker < 0 || !queues_[worker]->deques[lane].push(node)) {
+            injection_[lane].push(node);
+        }
+
+        epoch_.fetch_add(1, std::memory_order_seq_cst);
+        if (sleepers_.load(std::memory_order_seq_cst) > 0) {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+            sleep_cv_.notify_one();
+        }
+    }
+
+    void wakeAll() {
+        epoch_.fetch_add(1, std::memory_order_seq_cst);
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        sleep_cv_.notify_all();
+    }
+
+    // 按优先级依次查找：本线程队列、注入队列、其他线程队列
+    TaskNode* findTask(size_t index) {
+        const size_t count = queues_.size();
+        for (size_t lane = 0; lane < kPriorities; ++lane) {
+            if (TaskNode* node = queues_[index]->deques[lane].pop()) {
+                return node;
+            }
+            if (TaskNode* node = injection_[lane].pop()) {
+                return node;
+            }
+            for (size_t offset = 1; offset < count; ++offset) {
+                if (TaskNode* node = queues_[(index + offset) % count]->deques[lane].steal()) {
+                    return node;
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    bool runOneTask(size_t index) {
+        TaskNode* node = findTask(index);
+        if (!node) {
+            return false;
+        }
+        node->run();
+        thread_pool_detail::NodeCache::release(node);
+        return true;
+    }
+
+    void workerLoop(size_t index) {
+        currentPool() = this;
+        currentIndex() = static_cast<int>(index);
+
+        constexpr int kSpinRounds = 64;
+        for (;;) {
+            const uint64_t seen = epoch_.load(std::memory_order_seq_cst);
+            if (runOneTask(index)) {
+                continue;
+            }
+
+            // 短暂自旋后休眠，休眠前再次确认没有新提交
+            bool found = false;
+            for (int spin = 0; spin < kSpinRounds && !found; ++spin) {
+                std::this_thread::yield();
+                found = runOneTask(index);
+            }
+            if (found) {
+                continue;
+            }
+            if (stop_) {
+                // 停止时所有队列均已取空才退出，保证已提交任务执行完毕
+                break;
+            }
+
+            std::unique_lock<std::mutex> lock(sleep_mutex_);
+            sleepers_.fetch_add(1, std::memory_order_seq_cst);
+            sleep_cv_.wait(lock, [this, seen]() {
+                return stop_ || epoch_.load(std::memory_order_seq_cst) != seen;
+            });
+            sleepers_.fetch_sub(1, std::memory_order_seq_cst);
+        }
+
+        currentPool() = nullptr;
+        currentIndex() = -1;
+    }
+
+    static void pinThread(std::thread& thread, int cpu) {
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#else
+        (void)thread;
+        (void)cpu;
+#endif
+    }
 };
 
 #endif // THREAD_POOL_HPP
@@ -0,0 +1,661 @@
+/**
+ * @file perception_bench.cpp
+ * @brief 性能基准程序
+ * @author pengchengkang
+ * @date 2025-9-16
+ *
+ * 功能描述：
+ * - 单模块基准：检测器(detect/preprocess/infer)、输出解码(后处理)、跟踪器(10/100/1000个目标)、
+ *   行为分析和结果处理，输入为固定随机种子生成的合成数据，结果可在不同版本之间直接比较
+ * - 回放基准：以录制的视频文件驱动完整系统，不限速(--rate 0)或按固定倍速回放，
+ *   统计墙钟吞吐量、采集到结果的延迟分位数和各级耗时
+ * - 分派基准：同一跟踪+分析(及检测，模型可用时)分别经运行时路径(接口虚函数、std::function串联、
+ *   按值返回、加锁回调)和编译期组合的StaticPipeline执行，对比每帧开销
+ * - 报告为JSON(--output)，每项包含迭代次数、吞吐量和mean/p50/p90/p99/max
+ *
+ * 用法：
+ *   PerceptionBench [config.json] [--video file] [--rate R] [--iterations N] [--warmup N]
+ *                   [--modules detector,decoder,tracker,analyzer,result,pipeline,replay] [--output report.json]
+ */
+
+#include "config/config.hpp"
+#include "interface/module_interface.hpp"
+#include "main/logger.hpp"
+#include "main/metrics.hpp"
+#include "vision/include/detection_decoder.hpp"
+#include "vision/include/static_pipeline.hpp"
+#include "vision/include/vehicle_perception_system.hpp"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <set>
+#include <sstream>
+#include <thread>
+
+namespace {
+
+constexpr uint32_t kSeed = 42;
+constexpr int kTrackCounts[] = {10, 100, 1000};
+
+// 命令行选项
+struct BenchOptions {
+    std::string config_path = "configs/default.json";
+    std::string video;                       // 回放用视频文件，为空时跳过回放基准
+    float rate = 0.0f;                       // 回放倍速，0为不限速
+    int iterations = 200;                    // 每项计时迭代次数
+    int warmup = 20;                         // 预热迭代次数(不计时)
+    std::string output = "bench_report.json";
+    std::set<std::string> modules = {"detector", "decoder", "tracker", "analyzer", "result", "pipeline", "replay"};
+};
+
+// 一项基准的结果
+struct BenchResult {
+    std::string name;
+    json params = json::object();
+    std::vector<double> samples_ms;          // 每次迭代耗时
+    double wall_s = 0.0;                     // 计时区间总墙钟时间
+    double items_per_iteration = 1.0;        // 每次迭代处理的条目数(帧、目标等)
+    std::string skipped;                     // 非空时为跳过原因
+    json extra = json::object();
+
+    json toJson() const {
+        json j = {{"name", name}, {"params", params}};
+        if (!skipped.empty()) {
+            j["skipped"] = skipped;
+            return j;
+        }
+        std::vector<double> sorted = samples_ms;
+        std::sort(sorted.begin(), sorted.end());
+        auto quantile = [&sorted](double q) {
+            if (sorted.empty()) return 0.0;
+            size_t rank = static_cast<size_t>(q * static_cast<double>(sorted.size() - 1) + 0.5);
+            return sorted[std::min(rank, sorted.size() - 1)];
+        };
+        double sum = 0.0;
+        for (double v : sorted) sum += v;
+        const double iterations = static_cast<double>(samples_ms.size());
+        j["iterations"] = samples_ms.size();
+        j["wall_s"] = wall_s;
+        j["throughput_per_s"] = wall_s > 0.0 ? iterations / wall_s : 0.0;
+        j["items_per_s"] = wall_s > 0.0 ? iterations * items_per_iteration / wall_s : 0.0;
+        j["latency_ms"] = {
+            {"mean", iterations > 0 ? sum / iterations : 0.0},
+            {"p50", quantile(0.5)},
+            {"p90", quantile(0.9)},
+            {"p99", quantile(0.99)},
+            {"max", sorted.empty() ? 0.0 : sorted.back()}
+        };
+        j.update(extra);
+        return j;
+    }
+};
+
+/**
+ * @brief 先预热，再逐次计时执行body(iteration)
+ */
+template <typename Body>
+BenchResult measure(const std::string& name, json params, const BenchOptions& options, Body&& body) {
+    BenchResult result;
+    result.name = name;
+    result.params = std::move(params);
+    for (int i = 0; i < options.warmup; ++i) {
+        body(i);
+    }
+    result.samples_ms.reserve(options.iterations);
+    const auto wall_start = std::chrono::steady_clock::now();
+    for (int i = 0; i < options.iterations; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        body(options.warmup + i);
+        const auto end = std::chrono::steady_clock::now();
+        result.samples_ms.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    result.wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+    return result;
+}
+
+BenchResult skipped(const std::string& name, json params, const std::string& reason) {
+    BenchResult result;
+    result.name = name;
+    result.params = std::move(params);
+    result.skipped = reason;
+    return result;
+}
+
+/**
+ * @brief 合成场景：固定数量的目标在画面内匀速运动，碰到边界反弹，检测框带少量抖动
+ */
+class SyntheticScene {
+public:
+    SyntheticScene(int count, const cv::Size& frame_size, uint32_t seed = kSeed)
+        : frame_size_(frame_size), rng_(seed) {
+        std::uniform_real_distribution<float> x(0.0f, frame_size.width - 40.0f);
+        std::uniform_real_distribution<float> y(0.0f, frame_size.height - 80.0f);
+        std::uniform_real_distribution<float> v(-4.0f, 4.0f);
+        std::uniform_real_distribution<float> size(0.5f, 1.5f);
+        const int classes[] = {0, 1, 2, 3};
+        for (int i = 0; i < count; ++i) {
+            Object object;
+            object.box = cv::Rect2f(x(rng_), y(rng_), 20.0f * size(rng_), 40.0f * size(rng_));
+            object.velocity = cv::Point2f(v(rng_), v(rng_));
+            object.class_index = classes[i % 4];
+            objects_.push_back(object);
+        }
+    }
+
+    // 生成下一帧的检测结果
+    const std::vector<Detection>& next(uint64_t timestamp) {
+        std::normal_distribution<float> jitter(0.0f, 0.5f);
+        detections_.clear();
+        for (auto& object : objects_) {
+            object.box.x += object.velocity.x;
+            object.box.y += object.velocity.y;
+            if (object.box.x < 0 || object.box.x + object.box.width > frame_size_.width) {
+                object.velocity.x = -object.velocity.x;
+            }
+            if (object.box.y < 0 || object.box.y + object.box.height > frame_size_.height) {
+                object.velocity.y = -object.velocity.y;
+            }
+            Detection det;
+            det.class_index = object.class_index;
+            det.class_id = static_cast<ObjectClass>(object.class_index);
+            det.confidence = 0.8f;
+            det.bbox = cv::Rect2f(object.box.x + jitter(rng_), object.box.y + jitter(rng_),
+                                  object.box.width, object.box.height);
+            det.center = cv::Point2f(det.bbox.x + det.bbox.width / 2, det.bbox.y + det.bbox.height / 2);
+            det.area = det.bbox.area();
+            det.aspect_ratio = det.bbox.width / det.bbox.height;
+            det.timestamp = timestamp;
+            detections_.push_back(det);
+        }
+        return detections_;
+    }
+
+private:
+    struct Object {
+        cv::Rect2f box;
+        cv::Point2f velocity;
+        int class_index = 0;
+    };
+
+    cv::Size frame_size_;
+    std::mt19937 rng_;
+    std::vector<Object> objects_;
+    std::vector<Detection> detections_;
+};
+
+// 固定种子的噪声图像
+cv::Mat syntheticFrame(const cv::Size& size) {
+    cv::Mat frame(size, CV_8UC3);
+    cv::theRNG().state = kSeed;
+    cv::randu(frame, cv::Scalar::all(0), cv::Scalar::all(255));
+    return frame;
+}
+
+cv::Size frameSize(const SystemConfig& config) {
+    return cv::Size(std::max(64, config.video.width), std::max(64, config.video.height));
+}
+
+void benchDetector(const SystemConfig& config, const BenchOptions& options, std::vector<BenchResult>& results) {
+    const json params = {{"model", config.detector.model_path}, {"backend", config.detector.backend},
+                         {"precision", config.detector.precision}};
+    auto detector = IObjectDetector::create();
+    if (!detector || !detector->initialize(config.detector)) {
+        results.push_back(skipped("detector.detect", params, "detector initialization failed"));
+        return;
+    }
+    const cv::Mat frame = syntheticFrame(frameSize(config));
+
+    results.push_back(measure("detector.detect", params, options, [&](int) { detector->detect(frame); }));
+    results.push_back(measure("detector.preprocess", params, options, [&](int) { detector->preprocess(frame); }));
+
+    const DetectorInput input = detector->preprocess(frame);
+    results.push_back(measure("detector.infer", params, options, [&](int) { detector->infer(input); }));
+}
+
+void benchDecoder(const SystemConfig& config, const BenchOptions& options, std::vector<BenchResult>& results) {
+    // YOLOv8风格输出[4+nc, anchors]：大部分锚点低分，少量锚点围绕若干目标高分，触发NMS
+    const int num_classes = 80;
+    const cv::Size input_size(config.detector.input_width, config.detector.input_height);
+    const int anchors = (input_size.width / 8) * (input_size.height / 8) +
+                        (input_size.width / 16) * (input_size.height / 16) +
+                        (input_size.width / 32) * (input_size.height / 32);
+    if (anchors <= 0) {
+        results.push_back(skipped("detector.postprocess", json::object(), "invalid detector input size"));
+        return;
+    }
+
+    for (int objects : {10, 100}) {
+        cv::Mat output(4 + num_classes, anchors, CV_32F);
+        std::mt19937 rng(kSeed);
+        std::uniform_real_distribution<float> low(0.0f, 0.2f);
+        std::uniform_real_distribution<float> pos(0.0f, 1.0f);
+        for (int a = 0; a < anchors; ++a) {
+            output.at<float>(0, a) = pos(rng) * input_size.width;
+            output.at<float>(1, a) = pos(rng) * input_size.height;
+            output.at<float>(2, a) = 10.0f + pos(rng) * 60.0f;
+            output.at<float>(3, a) = 10.0f + pos(rng) * 120.0f;
+            for (int c = 0; c < num_classes; ++c) {
+                output.at<float>(4 + c, a) = low(rng);
+            }
+        }
+        // 每个目标约10个重叠候选框
+        for (int o = 0; o < objects; ++o) {
+            const float cx = pos(rng) * input_size.width;
+            const float cy = pos(rng) * input_size.height;
+            for (int k = 0; k < 10; ++k) {
+                const int a = static_cast<int>(rng() % static_cast<uint32_t>(anchors));
+                output.at<float>(0, a) = cx + k;
+                output.at<float>(1, a) = cy + k;
+                output.at<float>(2, a) = 40.0f;
+                output.at<float>(3, a) = 80.0f;
+                output.at<float>(4 + o % num_classes, a) = 0.6f + 0.03f * k;
+            }
+        }
+
+        DetectionDecoder decoder;
+        decoder.configure("yolov8", input_size, config.detector.confidence_threshold, config.detector.nms_threshold);
+        BoxTransform transform;
+        transform.image_size = frameSize(config);
+        transform.scale_x = static_cast<float>(input_size.width) / transform.image_size.width;
+        transform.scale_y = static_cast<float>(input_size.height) / transform.image_size.height;
+        const std::vector<cv::Mat> outputs = {output};
+
+        size_t boxes = 0;
+        auto result = measure("detector.postprocess", {{"anchors", anchors}, {"objects", objects}}, options,
+                              [&](int) { boxes = decoder.decode(outputs, transform).size(); });
+        result.extra["detections"] = boxes;
+        results.push_back(std::move(result));
+    }
+}
+
+void benchTracker(const SystemConfig& config, const BenchOptions& options, std::vector<BenchResult>& results) {
+    for (const std::string type : {"simple", "sort"}) {
+        for (int count : kTrackCounts) {
+            auto tracker = IObjectTracker::create(type);
+            if (!tracker || !tracker->initialize(config.tracker)) {
+                results.push_back(skipped("tracker.update", {{"type", type}, {"tracks", count}},
+                                          "tracker initialization failed"));
+                continue;
+            }
+            SyntheticScene scene(count, frameSize(config));
+            size_t confirmed = 0;
+            auto result = measure("tracker.update", {{"type", type}, {"tracks", count}}, options, [&](int i) {
+                auto snapshot = tracker->update(scene.next(static_cast<uint64_t>(i) * 33), static_cast<uint64_t>(i) * 33);
+                confirmed = snapshot ? snapshot->count : 0;
+            });
+            result.items_per_iteration = count;
+            result.extra["confirmed_tracks"] = confirmed;
+            results.push_back(std::move(result));
+        }
+    }
+}
+
+void benchAnalyzer(const SystemConfig& config, const BenchOptions& options, std::vector<BenchResult>& results) {
+    for (int count : kTrackCounts) {
+        auto analyzer = IBehaviorAnalyzer::create();
+        auto tracker = IObjectTracker::create("sort");
+        if (!analyzer || !analyzer->initialize(config.behavior, config.camera, config.vehicle) ||
+            !tracker || !tracker->initialize(config.tracker)) {
+            results.push_back(skipped("analyzer.analyze", {{"tracks", count}}, "module initialization failed"));
+            continue;
+        }
+        tracker->setTrajectoryLength(config.behavior.trajectory_history_length);
+        SyntheticScene scene(count, frameSize(config));
+
+        // 跟踪不计入分析耗时：预先生成全部帧的快照
+        std::vector<TrackSnapshotHandle> snapshots;
+        const int frames = options.warmup + options.iterations;
+        snapshots.reserve(frames);
+        for (int i = 0; i < frames; ++i) {
+            const uint64_t timestamp = static_cast<uint64_t>(i) * 33;
+            auto snapshot = tracker->update(scene.next(timestamp), timestamp);
+            // 拷贝一份，跟踪器会复用已释放的快照
+            snapshots.push_back(std::make_shared<const TrackSnapshot>(*snapshot));
+        }
+
+        size_t behaviors = 0;
+        auto result = measure("analyzer.analyze", {{"tracks", count}}, options, [&](int i) {
+            behaviors = analyzer->analyze(snapshots[static_cast<size_t>(i)]->view()).size();
+        });
+        result.items_per_iteration = count;
+        result.extra["behaviors"] = behaviors;
+        results.push_back(std::move(result));
+    }
+}
+
+void benchResultProcessor(const SystemConfig& config, const BenchOptions& options,
+                          std::vector<BenchResult>& results) {
+    const std::string formats[] = {"json", "ndjson", "binary"};
+    for (const auto& format : formats) {
+        SystemConfig::OutputConfig output = config.output;
+        output.save_video = false;
+        output.save_results = true;
+        output.results_format = format;
+        output.results_path = "bench_output/results_" + format + "/";
+        const json params = {{"format", format}, {"results", 50}};
+
+        auto processor = IResultProcessor::create();
+        if (!processor || !processor->initialize(output)) {
+            results.push_back(skipped("result.process", params, "result processor initialization failed"));
+            continue;
+        }
+
+        std::vector<BehaviorAnalysis> frame_results(50);
+        for (size_t i = 0; i < frame_results.size(); ++i) {
+            frame_results[i].track_id = static_cast<int>(i);
+            frame_results[i].behavior_name = "walking";
+            frame_results[i].risk_description = "pedestrian ahead";
+            frame_results[i].distance_to_vehicle = 5.0f + i;
+        }
+        const cv::Mat frame = syntheticFrame(frameSize(config));
+
+        // process()只入队，另测包含写盘在内的排空时间
+        auto result = measure("result.process", params, options, [&](int i) {
+            processor->process(frame_results, frame, nullptr, static_cast<uint64_t>(i) * 33);
+        });
+        const auto flush_start = std::chrono::steady_clock::now();
+        processor->flush();
+        const double flush_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - flush_start).count();
+        result.items_per_iteration = static_cast<double>(frame_results.size());
+        result.extra["flush_s"] = flush_s;
+        result.extra["end_to_end_frames_per_s"] =
+            static_cast<double>(options.warmup + options.iterations) / (result.wall_s + flush_s);
+        results.push_back(std::move(result));
+    }
+}
+
+/**
+ * @brief 运行时路径的一帧：与VehiclePerceptionSystem相同，每帧新建上下文，各级结果按值写入
+ */
+struct DynamicFrame {
+    uint64_t timestamp = 0;
+    std::vector<Detection> detections;
+    TrackSnapshotHandle tracks;
+    std::vector<BehaviorAnalysis> behaviors;
+};
+
+/**
+ * @brief 运行时路径：按配置创建的接口模块，各级以std::function串联，结果回调在互斥量下调用
+ * @param detector 为空时检测结果取自scene
+ */
+BenchResult measureDynamicPath(const std::string& name, const json& params, const SystemConfig& config,
+                               const BenchOptions& options, IObjectDetector* detector, SyntheticScene& scene) {
+    auto tracker = IObjectTracker::create("sort");
+    auto analyzer = IBehaviorAnalyzer::create();
+    if (!tracker || !tracker->initialize(config.tracker) ||
+        !analyzer || !analyzer->initialize(config.behavior, config.camera, config.vehicle)) {
+        return skipped(name, params, "module initialization failed");
+    }
+    tracker->setTrajectoryLength(config.behavior.trajectory_history_length);
+
+    const cv::Mat image = syntheticFrame(frameSize(config));
+    std::mutex callback_mutex;
+    size_t behaviors = 0;
+    std::function<void(const std::vector<BehaviorAnalysis>&)> callback =
+        [&behaviors](const std::vector<BehaviorAnalysis>& results) { behaviors = results.size(); };
+
+    std::vector<std::function<void(DynamicFrame&)>> stages;
+    if (detector) {
+        stages.push_back([&](DynamicFrame& frame) { frame.detections = detector->infer(detector->preprocess(image)); });
+    } else {
+        stages.push_back([&](DynamicFrame& frame) { frame.detections = scene.next(frame.timestamp); });
+    }
+    stages.push_back([&](DynamicFrame& frame) { frame.tracks = tracker->update(frame.detections, image, frame.timestamp); });
+    stages.push_back([&](DynamicFrame& frame) { frame.behaviors = analyzer->analyze(frame.tracks->view()); });
+    stages.push_back([&](DynamicFrame& frame) {
+        std::lock_guard<std::mutex> lock(callback_mutex);
+        callback(frame.behaviors);
+    });
+
+    auto result = measure(name, params, options, [&](int i) {
+        DynamicFrame frame;
+        frame.timestamp = static_cast<uint64_t>(i) * 33;
+        for (const auto& stage : stages) {
+            stage(frame);
+        }
+    });
+    result.extra["behaviors"] = behaviors;
+    return result;
+}
+
+/**
+ * @brief 静态路径：编译期组合的StaticPipeline，输出缓冲区跨帧复用
+ * @param scene 非空时检测结果取自scene并只调用track()，否则调用process()检测
+ */
+template <typename Pipeline>
+BenchResult measureStaticPath(const std::string& name, const json& params, const SystemConfig& config,
+                              const BenchOptions& options, SyntheticScene* scene) {
+    auto pipeline = Pipeline::create(config);
+    if (!pipeline) {
+        return skipped(name, params, "module initialization failed");
+    }
+
+    const cv::Mat image = syntheticFrame(frameSize(config));
+    size_t behaviors = 0;
+    pipeline->onResult().set([&behaviors](const typename Pipeline::Frame& frame) { behaviors = frame.behaviors.size(); });
+
+    typename Pipeline::Frame frame;
+    auto result = measure(name, params, options, [&](int i) {
+        const uint64_t timestamp = static_cast<uint64_t>(i) * 33;
+        if (scene) {
+            frame.detections = scene->next(timestamp);
+            pipeline->track(image, timestamp, frame);
+        } else {
+            pipeline->process(image, timestamp, frame);
+        }
+    });
+    result.extra["behaviors"] = behaviors;
+    return result;
+}
+
+void benchPipeline(const SystemConfig& config, const BenchOptions& options, std::vector<BenchResult>& results) {
+    using TrackingPipeline = StaticPipeline<ExternalDetectorStage, SortTrackerStage, AnalyzerStage>;
+
+    // 跟踪+分析：合成检测结果，两条路径使用同一随机种子的场景
+    for (int count : kTrackCounts) {
+        for (const std::string path : {"dynamic", "static"}) {
+            const json params = {{"path", path}, {"tracks", count}};
+            SyntheticScene scene(count, frameSize(config));
+            auto result = path == "dynamic"
+                ? measureDynamicPath("pipeline.track", params, config, options, nullptr, scene)
+                : measureStaticPath<TrackingPipeline>("pipeline.track", params, config, options, &scene);
+            result.items_per_iteration = count;
+            results.push_back(std::move(result));
+        }
+    }
+
+    // 检测+跟踪+分析：需要可加载的检测模型
+    auto detector = IObjectDetector::create();
+    if (!detector || !detector->initialize(config.detector)) {
+        for (const std::string path : {"dynamic", "static"}) {
+            results.push_back(skipped("pipeline.process", {{"path", path}}, "detector initialization failed"));
+        }
+        return;
+    }
+    SyntheticScene scene(0, frameSize(config));
+    results.push_back(measureDynamicPath("pipeline.process", {{"path", "dynamic"}}, config, options,
+                                         detector.get(), scene));
+    detector.reset();
+    results.push_back(measureStaticPath<DefaultStaticPipeline>("pipeline.process", {{"path", "static"}},
+                                                               config, options, nullptr));
+}
+
+// 直方图快照转为毫秒分位数
+json latencyJson(const HistogramSnapshot& snapshot) {
+    return {
+        {"count", snapshot.count},
+        {"mean", snapshot.mean() / 1000.0},
+        {"p50", snapshot.quantile(0.5) / 1000.0},
+        {"p90", snapshot.quantile(0.9) / 1000.0},
+        {"p99", snapshot.quantile(0.99) / 1000.0},
+        {"max", static_cast<double>(snapshot.max_us) / 1000.0}
+    };
+}
+
+void benchReplay(SystemConfig config, const BenchOptions& options, std::vector<BenchResult>& results) {
+    const json params = {{"video", options.video}, {"rate", options.rate}};
+    if (options.video.empty()) {
+        results.push_back(skipped("replay", params, "no --video given"));
+        return;
+    }
+
+    config.video.source = options.video;
+    config.video.playback_rate = options.rate;
+    config.streams.clear();
+    config.metrics.enable = true;
+    config.metrics.prometheus_port = 0;
+    config.metrics.log_interval_ms = 0;
+    config.output.save_video = false;
+    config.output.results_path = "bench_output/replay/";
+    config.llm.enable = false;
+
+    VehiclePerceptionSystem system;
+    if (!system.initialize(config) || !system.start()) {
+        results.push_back(skipped("replay", params, "system failed to start"));
+        return;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    while (!system.inputFinished() && system.getState() == SystemState::RUNNING) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    system.stop();
+    const double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    auto& registry = MetricsRegistry::instance();
+    const uint64_t frames = registry.counter("vps_frames_output_total").value();
+    const SystemPerformance stats = system.getPerformanceStats();
+
+    BenchResult result;
+    result.name = "replay";
+    result.params = params;
+    result.wall_s = wall_s;
+    result.extra["frames"] = frames;
+    result.extra["frames_dropped"] = stats.frames_dropped;
+    result.extra["fps"] = wall_s > 0.0 ? static_cast<double>(frames) / wall_s : 0.0;
+    result.extra["capture_to_result_ms"] = latencyJson(registry.histogram("vps_capture_to_result_seconds").snapshot());
+    json stages = json::object();
+    for (const char* stage : {"decode", "preprocess", "inference", "postprocess", "track", "analyze", "output"}) {
+        stages[stage] = latencyJson(stageLatency(stage).snapshot());
+    }
+    result.extra["stages_ms"] = stages;
+    results.push_back(std::move(result));
+}
+
+bool parseOptions(int argc, char* argv[], BenchOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                throw std::invalid_argument("missing value for " + arg);
+            }
+            return argv[++i];
+        };
+        if (arg == "--video") {
+            options.video = value();
+        } else if (arg == "--rate") {
+            options.rate = std::stof(value());
+        } else if (arg == "--iterations") {
+            options.iterations = std::max(1, std::stoi(value()));
+        } else if (arg == "--warmup") {
+            options.warmup = std::max(0, std::stoi(value()));
+        } else if (arg == "--output") {
+            options.output = value();
+        } else if (arg == "--modules") {
+            options.modules.clear();
+            std::stringstream list(value());
+            std::string module;
+            while (std::getline(list, module, ',')) {
+                options.modules.insert(module);
+            }
+        } else if (!arg.empty() && arg[0] != '-') {
+            options.config_path = arg;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+void printResult(const json& result) {
+    std::cout << std::left << std::setw(22) << result["name"].get<std::string>() << std::setw(36)
+              << result["params"].dump();
+    if (result.contains("skipped")) {
+        std::cout << "skipped: " << result["skipped"].get<std::string>() << std::endl;
+        return;
+    }
+    std::cout << std::fixed << std::setprecision(3);
+    if (result.contains("latency_ms")) {
+        const auto& latency = result["latency_ms"];
+        std::cout << "p50 " << latency["p50"].get<double>() << "ms  p99 " << latency["p99"].get<double>()
+                  << "ms  " << result["throughput_per_s"].get<double>() << "/s";
+    } else if (result.contains("fps")) {
+        std::cout << result["fps"].get<double>() << " fps  capture_to_result p99 "
+                  << result["capture_to_result_ms"]["p99"].get<double>() << "ms";
+    }
+    std::cout << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    try {
+        if (!parseOptions(argc, argv, options)) {
+            std::cerr << "Usage: PerceptionBench [config.json] [--video file] [--rate R] [--iterations N] "
+                         "[--warmup N] [--modules detector,decoder,tracker,analyzer,result,pipeline,replay] "
+                         "[--output report.json]" << std::endl;
+            return 1;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Invalid arguments: " << e.what() << std::endl;
+        return 1;
+    }
+
+    SystemConfig config;
+    if (!config.loadFromFile(options.config_path)) {
+        std::cerr << "Failed to load config file: " << options.config_path << std::endl;
+        return 1;
+    }
+    Logger::initialize("logs/", LogLevel::WARN, false);
+
+    std::vector<BenchResult> results;
+    auto enabled = [&options](const char* module) { return options.modules.count(module) > 0; };
+    if (enabled("detector")) benchDetector(config, options, results);
+    if (enabled("decoder")) benchDecoder(config, options, results);
+    if (enabled("tracker")) benchTracker(config, options, results);
+    if (enabled("analyzer")) benchAnalyzer(config, options, results);
+    if (enabled("result")) benchResultProcessor(config, options, results);
+    if (enabled("pipeline")) benchPipeline(config, options, results);
+    if (enabled("replay")) benchReplay(config, options, results);
+
+    json report;
+    report["schema"] = "perception-bench/1";
+    report["generated_at"] = static_cast<int64_t>(std::time(nullptr));
+    report["host"] = {{"hardware_concurrency", std::thread::hardware_concurrency()},
+                      {"compiler", __VERSION__},
+                      {"opencv", CV_VERSION}};
+    report["options"] = {{"config", options.config_path}, {"iterations", options.iterations},
+                         {"warmup", options.warmup}, {"seed", kSeed}};
+    report["results"] = json::array();
+    for (const auto& result : results) {
+        report["results"].push_back(result.toJson());
+        printResult(report["results"].back());
+    }
+
+    const std::filesystem::path output(options.output);
+    if (output.has_parent_path()) {
+        std::filesystem::create_directories(output.parent_path());
+    }
+    std::ofstream file(output);
+    file << report.dump(2) << std::endl;
+    std::cout << "Report written to " << options.output << std::endl;
+    Logger::getInstance().flush();
+    return 0;
+}
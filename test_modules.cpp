@@ -8,15 +8,67 @@
  * - 测试各个模块的基本功能
  * - 验证配置文件加载
  * - 检查模块接口的正确性
- * - 提供单元测试功能
+ * - 提供单元测试功能：数据关联(分配最优性与网格门控)、轨迹槽位与快照复用(稳态无分配)、
+ *   地面投影测距与碰撞时间、LLM增强(异步提交与LRU缓存)、
+ *   二进制结果日志(索引链读取与截断后扫描恢复)
+ * - 任一检查失败时以非零状态退出
  */
 
 #include "config/config.hpp"
 #include "interface/module_interface.hpp"
 #include "main/logger.hpp"
+#include "vision/include/track_assignment.hpp"
+#include "vision/include/track_store.hpp"
+#include "vision/include/ground_plane.hpp"
+#include "vision/include/result_log.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <new>
+#include <random>
+#include <thread>
 #include <opencv2/opencv.hpp>
 
+// 失败的检查数
+int g_failures = 0;
+
+// 堆分配计数，只统计开启计数的线程上的operator new
+thread_local bool t_count_allocations = false;
+thread_local size_t t_allocations = 0;
+
+void* operator new(std::size_t size) {
+    if (t_count_allocations) {
+        ++t_allocations;
+    }
+    if (void* pointer = std::malloc(size > 0 ? size : 1)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+void check(bool condition, const std::string& description) {
+    if (condition) {
+        std::cout << "✓ " << description << std::endl;
+    } else {
+        std::cout << "✗ " << description << std::endl;
+        ++g_failures;
+    }
+}
+
 void testConfigLoading() {
     std::cout << "\n=== 测试配置文件加载 ===" << std::endl;
     
@@ -60,13 +112,13 @@ void testDataStructures() {
     det.bbox = cv::Rect2f(100, 100, 50, 80);
     det.confidence = 0.85f;
     det.class_id = ObjectClass::PEDESTRIAN;
-    det.class_name = "pedestrian";
+    det.class_index = 0;
     
     std::cout << "✓ Detection结构测试通过" << std::endl;
     std::cout << "  - 边界框: (" << det.bbox.x << ", " << det.bbox.y 
               << ", " << det.bbox.width << ", " << det.bbox.height << ")" << std::endl;
     std::cout << "  - 置信度: " << det.confidence << std::endl;
-    std::cout << "  - 类别: " << det.class_name << std::endl;
+    std::cout << "  - 类别: " << det.className() << std::endl;
     
     // 测试TrackedObject结构
     TrackedObject track;
@@ -127,6 +179,496 @@ void testLogger() {
     std::cout << "✓ 日志系统测试完成（请检查控制台输出）" << std::endl;
 }
 
+void testTrackAssignment() {
+    std::cout << "\n=== 测试数据关联 ===" << std::endl;
+    
+    // 最优分配：先最大化匹配数，再最小化总代价；小规模随机稀疏矩阵与穷举结果比较
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> size(1, 5);
+    std::uniform_real_distribution<float> cost(0.0f, 1.0f);
+    std::bernoulli_distribution present(0.5);
+    LinearAssignment assignment;
+    int mismatches = 0;
+    const int trials = 500;
+    for (int trial = 0; trial < trials; ++trial) {
+        const int rows = size(rng);
+        const int cols = size(rng);
+        std::vector<float> matrix(rows * cols, -1.0f);   // 负值为无候选边
+        std::vector<AssignmentEdge> edges;
+        for (int r = 0; r < rows; ++r) {
+            for (int c = 0; c < cols; ++c) {
+                if (present(rng)) {
+                    matrix[r * cols + c] = cost(rng);
+                    edges.push_back({r, c, matrix[r * cols + c]});
+                }
+            }
+        }
+        
+        std::vector<std::pair<int, int>> matches;
+        assignment.solve(rows, cols, edges, matches);
+        int count = 0;
+        double total = 0.0;
+        std::vector<uint8_t> row_used(rows, 0), col_used(cols, 0);
+        bool valid = true;
+        for (const auto& match : matches) {
+            const float c = matrix[match.first * cols + match.second];
+            valid = valid && c >= 0.0f && !row_used[match.first] && !col_used[match.second];
+            row_used[match.first] = col_used[match.second] = 1;
+            ++count;
+            total += c;
+        }
+        
+        // 穷举：每行选一个未用的列或不匹配
+        int best_count = 0;
+        double best_total = 0.0;
+        std::vector<uint8_t> used(cols, 0);
+        std::function<void(int, int, double)> search = [&](int r, int n, double sum) {
+            if (r == rows) {
+                if (n > best_count || (n == best_count && sum < best_total)) {
+                    best_count = n;
+                    best_total = sum;
+                }
+                return;
+            }
+            search(r + 1, n, sum);
+            for (int c = 0; c < cols; ++c) {
+                if (!used[c] && matrix[r * cols + c] >= 0.0f) {
+                    used[c] = 1;
+                    search(r + 1, n + 1, sum + matrix[r * cols + c]);
+                    used[c] = 0;
+                }
+            }
+        };
+        search(0, 0, 0.0);
+        
+        if (!valid || count != best_count || std::abs(total - best_total) > 1e-4) {
+            ++mismatches;
+        }
+    }
+    check(mismatches == 0, "LinearAssignment与穷举最优解一致(" + std::to_string(trials) + "组随机矩阵，不一致" +
+                           std::to_string(mismatches) + "组)");
+    
+    // 网格门控：与查询框相交的检测全部返回且不重复，远处的检测不返回
+    std::vector<cv::Rect2f> boxes;
+    std::uniform_real_distribution<float> position(0.0f, 400.0f);
+    std::uniform_real_distribution<float> extent(10.0f, 60.0f);
+    for (int i = 0; i < 200; ++i) {
+        boxes.emplace_back(position(rng), position(rng), extent(rng), extent(rng));
+    }
+    const int far_index = static_cast<int>(boxes.size());
+    boxes.emplace_back(5000.0f, 5000.0f, 30.0f, 30.0f);
+    
+    SpatialGrid grid;
+    grid.build(boxes);
+    bool complete = true;
+    bool unique = true;
+    bool far_excluded = true;
+    std::vector<int> candidates;
+    for (int q = 0; q < 100; ++q) {
+        const cv::Rect2f query(position(rng), position(rng), extent(rng), extent(rng));
+        candidates.clear();
+        grid.query(query, candidates);
+        std::vector<int> sorted = candidates;
+        std::sort(sorted.begin(), sorted.end());
+        unique = unique && std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end();
+        far_excluded = far_excluded && !std::binary_search(sorted.begin(), sorted.end(), far_index);
+        for (int i = 0; i < static_cast<int>(boxes.size()); ++i) {
+            if (boxIoU(query, boxes[i]) > 0.0f && !std::binary_search(sorted.begin(), sorted.end(), i)) {
+                complete = false;
+            }
+        }
+    }
+    check(complete, "SpatialGrid不漏掉任何相交的检测框");
+    check(unique, "SpatialGrid查询结果不重复");
+    check(far_excluded, "SpatialGrid不返回远处网格中的检测框");
+}
+
+void testTrackStore() {
+    std::cout << "\n=== 测试轨迹槽位与快照复用 ===" << std::endl;
+    
+    // 释放的槽位被复用，轨迹重置为默认状态但保留缓冲区容量
+    TrackStore store;
+    store.reset(8);
+    const int first = store.allocate();
+    const int second = store.allocate();
+    store[first].track_id = 7;
+    store[first].age = 12;
+    for (int i = 0; i < 5; ++i) {
+        store[first].trajectory.push_back(cv::Point2f(static_cast<float>(i), 0.0f));
+    }
+    store.release(first);
+    check(store.active().size() == 1 && store.active()[0] == second, "释放后只剩另一条活动轨迹");
+    
+    const int reused = store.allocate();
+    const TrackedObject& track = store[reused];
+    check(reused == first && store.slotCount() == 2, "新轨迹复用释放的槽位，槽位总数不增长");
+    check(track.track_id == -1 && track.age == 0 && track.trajectory.empty(), "复用的槽位重置为默认状态");
+    check(track.trajectory.capacity() == 8, "复用的槽位保留轨迹缓冲区容量");
+    
+    store.clear();
+    check(store.active().empty() && store.slotCount() == 2, "clear()释放全部槽位，保留槽位内存");
+    
+    // 下游持有的快照不被复用，释放后原快照被取回且count清零
+    TrackSnapshotPool pool;
+    std::shared_ptr<TrackSnapshot> building = pool.acquire();
+    TrackSnapshotPool::append(*building, store[second]);
+    TrackSnapshotHandle held = building;
+    building.reset();
+    const TrackSnapshot* held_pointer = held.get();
+    
+    std::shared_ptr<TrackSnapshot> other = pool.acquire();
+    check(other.get() != held_pointer, "下游持有的快照不被复用");
+    other.reset();
+    held.reset();
+    
+    std::shared_ptr<TrackSnapshot> recycled = pool.acquire();
+    check(recycled.get() == held_pointer && recycled->count == 0, "释放的快照被复用且count清零");
+    check(recycled->tracks.size() == 1, "复用的快照保留轨迹元素内存");
+    recycled.reset();
+    
+    // 预热后稳态update()不分配堆内存：目标数不变、快照句柄每帧释放
+    const int object_count = 16;
+    std::vector<Detection> detections(object_count);
+    for (const std::string type : {"simple", "sort"}) {
+        auto tracker = IObjectTracker::create(type);
+        SystemConfig::TrackerConfig config;
+        config.type = type;
+        config.use_appearance = false;
+        if (!tracker || !tracker->initialize(config)) {
+            check(false, type + "跟踪器初始化");
+            continue;
+        }
+        
+        size_t allocations = 0;
+        size_t confirmed = 0;
+        for (int frame = 0; frame < 150; ++frame) {
+            for (int i = 0; i < object_count; ++i) {
+                Detection& detection = detections[i];
+                detection.id = i;
+                detection.class_id = ObjectClass::PEDESTRIAN;
+                detection.confidence = 0.9f;
+                detection.bbox = cv::Rect2f(40.0f + 100.0f * (i % 8) + 0.5f * frame,
+                                            60.0f + 150.0f * (i / 8), 60.0f, 40.0f);
+                detection.center = cv::Point2f(detection.bbox.x + 30.0f, detection.bbox.y + 20.0f);
+                detection.area = detection.bbox.area();
+                detection.aspect_ratio = 1.5f;
+            }
+            const uint64_t timestamp = static_cast<uint64_t>(frame) * 33;
+            // 前100帧预热(轨迹确认、轨迹缓冲区填满、快照池与关联缓冲区到达稳态容量)
+            const bool counted = frame >= 100;
+            t_allocations = 0;
+            t_count_allocations = counted;
+            TrackSnapshotHandle snapshot = tracker->update(detections, timestamp);
+            confirmed = snapshot ? snapshot->count : 0;
+            snapshot.reset();
+            t_count_allocations = false;
+            if (counted) {
+                allocations += t_allocations;
+            }
+        }
+        check(confirmed == static_cast<size_t>(object_count), type + "跟踪器确认全部目标");
+        check(allocations == 0, type + "跟踪器稳态update()不分配堆内存(" + std::to_string(allocations) + "次)");
+    }
+}
+
+// 平面路面上图像行y(像素中心坐标)对应的地面距离，双精度闭式解
+double groundDistance(const CameraParams& camera, double fy, double y, double max_distance) {
+    const double depression = camera.pitch * CV_PI / 180.0 + std::atan((y - camera.cy) / fy);
+    if (depression <= 0.0) {
+        return max_distance;
+    }
+    return std::min(max_distance, camera.height / std::tan(depression));
+}
+
+void testGroundPlane() {
+    std::cout << "\n=== 测试地面投影测距 ===" << std::endl;
+    
+    CameraParams camera;
+    camera.fy = 1000.0f;
+    camera.cy = 360.0f;
+    camera.height = 1.5f;
+    camera.pitch = 2.0f;
+    const float max_distance = 80.0f;
+    
+    GroundPlaneModel model;
+    check(model.initialize(camera, max_distance) && model.valid(), "地面模型初始化");
+    
+    // 每行查表值与该行中心的闭式解一致
+    double max_error = 0.0;
+    for (size_t row = 0; row < model.rows(); ++row) {
+        const double expected = groundDistance(camera, camera.fy, row + 0.5, max_distance);
+        const double actual = model.distanceAtRow(row + 0.5f);
+        max_error = std::max(max_error, std::abs(actual - expected) / expected);
+    }
+    check(max_error < 1e-4, "逐行查表距离与闭式解一致(最大相对误差" + std::to_string(max_error) + ")");
+    check(model.distanceAtRow(0.0f) == max_distance, "地平线以上的行取最大距离");
+    check(model.distanceAtRow(model.rows() - 1.0f) < 1.0f && model.distanceAtRow(1e5f) < 1.0f,
+          "查找表延伸到1米以内，更靠下的行按最后一行处理");
+    
+    // 已知距离反投影到图像行，查表误差不超过一行的量化
+    bool within_row = true;
+    for (double distance : {5.0, 10.0, 20.0, 40.0}) {
+        const double y = camera.cy + camera.fy * std::tan(std::atan(camera.height / distance) - camera.pitch * CV_PI / 180.0);
+        const double nearer = groundDistance(camera, camera.fy, y + 1.0, max_distance);
+        const double farther = groundDistance(camera, camera.fy, y - 1.0, max_distance);
+        const double actual = model.distanceAtRow(static_cast<float>(y));
+        within_row = within_row && actual >= nearer && actual <= farther;
+    }
+    check(within_row, "已知距离的查表结果在一行量化误差以内");
+    
+    // fy未标定时由垂直视场角推算
+    CameraParams by_fov = camera;
+    by_fov.fy = 0.0f;
+    by_fov.fov_v = 2.0f * std::atan(camera.cy / camera.fy) * 180.0f / static_cast<float>(CV_PI);
+    GroundPlaneModel fov_model;
+    fov_model.initialize(by_fov, max_distance);
+    check(fov_model.rows() == model.rows() &&
+          std::abs(fov_model.distanceAtRow(600.0f) - model.distanceAtRow(600.0f)) < 1e-3f,
+          "由垂直视场角推算fy与直接给定fy结果一致");
+    
+    CameraParams uncalibrated;
+    uncalibrated.cy = 360.0f;
+    check(!GroundPlaneModel().initialize(uncalibrated, max_distance), "缺少焦距和视场角时初始化失败");
+}
+
+void testCollisionTime() {
+    std::cout << "\n=== 测试碰撞时间(α-β距离滤波) ===" << std::endl;
+    
+    // bbox测距模型的距离随框高连续变化(1000 / (高 + 1))，不引入逐行量化噪声
+    auto analyzer = IBehaviorAnalyzer::create();
+    SystemConfig::BehaviorConfig config;
+    config.distance_model = "bbox";
+    CameraParams camera;
+    VehicleParams vehicle;
+    check(analyzer && analyzer->initialize(config, camera, vehicle), "行为分析器初始化");
+    if (!analyzer) {
+        return;
+    }
+    
+    // 两个匀速目标：一个以5米/秒接近，一个以3米/秒远离，每33毫秒一帧
+    const float approach_speed = 5.0f;
+    const float recede_speed = 3.0f;
+    std::vector<TrackedObject> tracks(2);
+    tracks[0].track_id = 1;
+    tracks[1].track_id = 2;
+    float approaching_ttc = 0.0f;
+    float approaching_distance = 0.0f;
+    float receding_ttc = 0.0f;
+    for (int frame = 0; frame <= 120; ++frame) {
+        const uint64_t timestamp = 1000 + static_cast<uint64_t>(frame) * 33;
+        const float t = frame * 0.033f;
+        const float distances[2] = {45.0f - approach_speed * t, 15.0f + recede_speed * t};
+        for (int i = 0; i < 2; ++i) {
+            TrackedObject& track = tracks[i];
+            track.detection.class_id = ObjectClass::PEDESTRIAN;
+            track.detection.bbox = cv::Rect2f(100.0f + 200.0f * i, 300.0f, 40.0f, 1000.0f / distances[i] - 1.0f);
+            track.detection.center = cv::Point2f(track.detection.bbox.x + 20.0f, 320.0f);
+            track.trajectory.push_back(track.detection.center);
+            track.age = frame + 1;
+            track.last_updated = timestamp;
+        }
+        const std::vector<BehaviorAnalysis> results = analyzer->analyze(TrackView(tracks));
+        if (results.size() == 2) {
+            approaching_distance = results[0].distance_to_vehicle;
+            approaching_ttc = results[0].time_to_collision;
+            receding_ttc = results[1].time_to_collision;
+        }
+    }
+    
+    // 匀速输入下α-β滤波无稳态滞后，碰撞时间收敛到距离 / 接近速度
+    const float expected = approaching_distance / approach_speed;
+    check(std::abs(approaching_ttc - expected) < expected * 0.02f,
+          "匀速接近目标的碰撞时间" + std::to_string(approaching_ttc) + "秒(期望" + std::to_string(expected) + "秒)");
+    check(receding_ttc < 0.0f, "远离目标无碰撞时间");
+}
+
+// 行为分析结果，track_id与视频流组成LLM缓存键
+BehaviorAnalysis makeAnalysis(int stream_id, int track_id) {
+    BehaviorAnalysis analysis;
+    analysis.stream_id = stream_id;
+    analysis.track_id = track_id;
+    analysis.behavior = BehaviorType::PEDESTRIAN_WALKING;
+    analysis.behavior_name = "pedestrian_walking";
+    analysis.risk_level = RiskLevel::MEDIUM_RISK;
+    analysis.distance_to_vehicle = 12.0f;
+    return analysis;
+}
+
+// 反复调用enhanceAnalysis直到全部结果附带LLM文本，超时返回false
+bool waitForLLMText(ILLMEnhancer& enhancer, std::vector<BehaviorAnalysis> analysis) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (std::chrono::steady_clock::now() < deadline) {
+        for (auto& result : analysis) {
+            result.llm_analysis.clear();
+        }
+        enhancer.enhanceAnalysis(analysis, TrackView());
+        if (std::all_of(analysis.begin(), analysis.end(),
+                        [](const BehaviorAnalysis& result) { return !result.llm_analysis.empty(); })) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+}
+
+void testLLMEnhancer() {
+    std::cout << "\n=== 测试LLM增强(异步提交与LRU缓存) ===" << std::endl;
+    
+    // 缓存2条；每个视频流只有第一帧到期提交请求(最小间隔远大于测试时长)
+    SystemConfig::LLMConfig config;
+    config.enable = true;
+    config.analysis_interval = 1;
+    config.min_interval_ms = 60000;
+    config.cache_size = 2;
+    auto enhancer = ILLMEnhancer::create();
+    check(enhancer && enhancer->initialize(config), "LLM增强器初始化");
+    if (!enhancer) {
+        return;
+    }
+    
+    // 帧处理路径不等待回复：未命中缓存的结果原样返回，请求交给后台线程
+    std::vector<BehaviorAnalysis> first = {makeAnalysis(0, 1), makeAnalysis(0, 2)};
+    const auto start = std::chrono::steady_clock::now();
+    enhancer->enhanceAnalysis(first, TrackView());
+    const double elapsed_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    check(first[0].llm_analysis.empty() && first[1].llm_analysis.empty(), "首帧未命中缓存，不等待LLM回复");
+    check(elapsed_ms < 50.0, "enhanceAnalysis不阻塞帧处理路径(" + std::to_string(elapsed_ms) + "ms)");
+    
+    // 后台回复写入缓存后，之后的帧命中缓存附带文本
+    check(waitForLLMText(*enhancer, first), "回复写入缓存后命中，结果附带LLM文本");
+    
+    // 访问轨迹1使其成为最近使用，视频流1的新条目写入后应淘汰轨迹2
+    std::vector<BehaviorAnalysis> touched = {makeAnalysis(0, 1)};
+    enhancer->enhanceAnalysis(touched, TrackView());
+    check(!touched[0].llm_analysis.empty(), "已缓存目标命中");
+    check(waitForLLMText(*enhancer, {makeAnalysis(1, 3)}), "另一视频流的请求独立调度并写入缓存");
+    
+    std::vector<BehaviorAnalysis> after = {makeAnalysis(0, 1), makeAnalysis(0, 2)};
+    enhancer->enhanceAnalysis(after, TrackView());
+    check(!after[0].llm_analysis.empty(), "最近使用的条目保留");
+    check(after[1].llm_analysis.empty(), "超出容量时淘汰最久未使用的条目");
+}
+
+// 第frame帧的日志内容：每帧两个目标，轨迹1的LLM文本每帧不同，轨迹2的LLM文本不变
+std::vector<BehaviorAnalysis> makeLogFrame(int frame) {
+    std::vector<BehaviorAnalysis> results(2);
+    for (int i = 0; i < 2; ++i) {
+        BehaviorAnalysis& result = results[i];
+        result.track_id = i + 1;
+        result.behavior_name = i == 0 ? "pedestrian_walking" : "non_motor_moving";
+        result.risk_description = frame % 3 == 0 ? "高风险" : "低风险";
+        result.llm_analysis = i == 0 ? "frame " + std::to_string(frame) + " track 1" : "keep distance from track 2";
+        result.distance_to_vehicle = 10.0f + frame;
+        result.timestamp = 1000 + static_cast<uint64_t>(frame) * 33;
+    }
+    return results;
+}
+
+// 检查reader中的帧数、按时间戳定位和解码后的字符串
+bool checkLogFrames(const ResultLogReader& reader, size_t expected_frames) {
+    if (reader.frameCount() != expected_frames) {
+        return false;
+    }
+    for (size_t i = 0; i < expected_frames; ++i) {
+        const uint64_t timestamp = 1000 + i * 33;
+        if (reader.seek(timestamp) != i || reader.seek(timestamp - 1) != i) {
+            return false;
+        }
+        const ResultLogReader::Frame frame = reader.frame(i);
+        const std::vector<BehaviorAnalysis> expected = makeLogFrame(static_cast<int>(i));
+        if (frame.timestamp != timestamp || frame.count != expected.size()) {
+            return false;
+        }
+        for (size_t j = 0; j < frame.count; ++j) {
+            const BehaviorAnalysis decoded = reader.decode(frame.records[j]);
+            if (decoded.track_id != expected[j].track_id ||
+                decoded.behavior_name != expected[j].behavior_name ||
+                decoded.risk_description != expected[j].risk_description ||
+                decoded.llm_analysis != expected[j].llm_analysis) {
+                return false;
+            }
+        }
+    }
+    return reader.seek(1000 + expected_frames * 33) == expected_frames;
+}
+
+void testResultLog() {
+    std::cout << "\n=== 测试二进制结果日志 ===" << std::endl;
+    
+    const int frame_count = 40;
+    std::string encoded;
+    ResultLogWriter writer;
+    writer.begin(encoded, 8);
+    for (int frame = 0; frame < frame_count; ++frame) {
+        writer.appendFrame(encoded, makeLogFrame(frame), 1000 + static_cast<uint64_t>(frame) * 33);
+    }
+    writer.finish(encoded);
+    
+    // 逐块记录每个帧块的结束偏移，截断点之前写完的帧应全部可读
+    std::vector<size_t> frame_ends;
+    for (size_t offset = sizeof(result_log::FileHeader); offset + sizeof(result_log::ChunkHeader) <= encoded.size();) {
+        result_log::ChunkHeader header;
+        std::memcpy(&header, encoded.data() + offset, sizeof(header));
+        offset += sizeof(header) + header.size;
+        if (header.type == result_log::kChunkFrame) {
+            frame_ends.push_back(offset);
+        }
+    }
+    check(frame_ends.size() == static_cast<size_t>(frame_count), "编码结果包含全部帧块");
+    
+    // 低基数字段整个文件只写一次，LLM文本只在索引段(8帧)内去重
+    auto occurrences = [&](const std::string& text) {
+        size_t count = 0;
+        for (size_t pos = encoded.find(text); pos != std::string::npos; pos = encoded.find(text, pos + 1)) {
+            ++count;
+        }
+        return count;
+    };
+    check(occurrences("pedestrian_walking") == 1 && occurrences("高风险") == 1, "行为名称和风险描述整个文件只写一次");
+    check(occurrences("keep distance from track 2") == frame_count / 8, "重复的LLM文本每个索引段写一次");
+    
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "test_modules_result_log.bin";
+    auto writeFile = [&](size_t size) {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(encoded.data(), static_cast<std::streamsize>(encoded.size()));
+        file.close();
+        std::filesystem::resize_file(path, size);
+    };
+    
+    // 正常关闭的文件沿索引链读取
+    writeFile(encoded.size());
+    ResultLogReader reader;
+    check(reader.open(path.string()) && checkLogFrames(reader, frame_count),
+          "完整文件：帧数、seek()和解码字符串正确");
+    reader.close();
+    
+    // 任意位置截断(含块中间和块边界)后逐块扫描，只保留写完的帧
+    std::vector<size_t> cuts = {sizeof(result_log::FileHeader), frame_ends[0], frame_ends[0] - 1,
+                                frame_ends[17] + 3, frame_ends[frame_count - 1],
+                                encoded.size() - 1};
+    std::mt19937 rng(18);
+    std::uniform_int_distribution<size_t> position(sizeof(result_log::FileHeader), encoded.size() - 1);
+    for (int i = 0; i < 20; ++i) {
+        cuts.push_back(position(rng));
+    }
+    bool recovered = true;
+    for (size_t cut : cuts) {
+        const size_t expected = static_cast<size_t>(
+            std::upper_bound(frame_ends.begin(), frame_ends.end(), cut) - frame_ends.begin());
+        writeFile(cut);
+        if (!reader.open(path.string()) || !checkLogFrames(reader, expected)) {
+            std::cout << "  截断于" << cut << "字节时恢复失败(期望" << expected << "帧，读到"
+                      << reader.frameCount() << "帧)" << std::endl;
+            recovered = false;
+        }
+        reader.close();
+    }
+    check(recovered, "截断文件：写完的帧全部可读，帧数、seek()和解码字符串正确");
+    
+    std::filesystem::remove(path);
+}
+
 int main(int /* argc */, char* /* argv */[]) {
     std::cout << "=== 车辆感知系统模块测试程序 ===" << std::endl;
     std::cout << "OpenCV版本: " << CV_VERSION << std::endl;
@@ -138,8 +680,18 @@ int main(int /* argc */, char* /* argv */[]) {
         testDataStructures();
         testOpenCVIntegration();
         testLogger();
+        testTrackAssignment();
+        testTrackStore();
+        testGroundPlane();
+        testCollisionTime();
+        testLLMEnhancer();
+        testResultLog();
         
         std::cout << "\n=== 测试总结 ===" << std::endl;
+        if (g_failures > 0) {
+            std::cout << "✗ " << g_failures << "项检查失败" << std::endl;
+            return 1;
+        }
         std::cout << "✓ 所有基础模块测试完成" << std::endl;
         std::cout << "✓ 系统架构验证通过" << std::endl;
         std::cout << "✓ 可以进行进一步的集成测试" << std::endl;
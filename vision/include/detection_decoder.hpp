@@ -0,0 +1,91 @@
+/**
+ * @file detection_decoder.hpp
+ * @brief YOLO系列网络输出解码与NMS
+ * @author pengchengkang
+ * @date 2025-9-10
+ *
+ * 根据DetectorConfig::model_type选择输出格式：
+ * - yolov8 / yolo11：[4+nc, anchors] 转置布局，无objectness
+ * - yolov5 / yolov7：[anchors, 5+nc] 行布局，坐标为输入像素
+ * - darknet / yolov3 / yolov4：同行布局，坐标为归一化值(OpenCV DNN Darknet输出)
+ *
+ * 性能要点：
+ * - 类别分数按行SIMD比较取最大值(AVX/SSE2/NEON，其余平台标量)，不逐anchor构造cv::Mat
+ * - 低于置信度阈值的anchor在生成候选框前被剔除
+ * - 按类别分段做NMS，只比较同类框
+ * - 所有中间缓冲区为成员变量，容量稳定后每帧不再分配内存
+ */
+#ifndef DETECTION_DECODER_HPP
+#define DETECTION_DECODER_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <opencv2/opencv.hpp>
+
+// 网络输入坐标到原图坐标的映射：image = (net - pad) / scale
+struct BoxTransform {
+    float scale_x = 1.0f;
+    float scale_y = 1.0f;
+    float pad_x = 0.0f;
+    float pad_y = 0.0f;
+    cv::Size image_size;           // 原图尺寸(用于裁剪)
+};
+
+// 解码后的候选框(原图坐标)
+struct DecodedBox {
+    float x1 = 0.0f;
+    float y1 = 0.0f;
+    float x2 = 0.0f;
+    float y2 = 0.0f;
+    float score = 0.0f;
+    int class_index = 0;
+};
+
+// YOLO输出解码器，非线程安全，每个检测器独占一个
+class DetectionDecoder {
+public:
+    enum class Layout {
+        YOLOV8,    // [4+nc, anchors]
+        YOLOV5,    // [anchors, 5+nc]，输入像素坐标
+        DARKNET    // [anchors, 5+nc]，归一化坐标
+    };
+
+    DetectionDecoder();
+
+    // 按模型类型配置解码器
+    void configure(const std::string& model_type, const cv::Size& input_size,
+                   float confidence_threshold, float nms_threshold, int max_detections = 300);
+
+    // 解码一张图像的全部输出张量(二维视图)，返回按分数降序排列的结果
+    // 返回的引用在下一次decode前有效
+    const std::vector<DecodedBox>& decode(const std::vector<cv::Mat>& outputs, const BoxTransform& transform);
+
+    Layout layout() const { return layout_; }
+
+    // 解析模型类型字符串
+    static Layout parseLayout(const std::string& model_type);
+
+private:
+    Layout layout_;
+    cv::Size input_size_;
+    float confidence_threshold_;
+    float nms_threshold_;
+    int max_detections_;
+
+    // 复用的中间缓冲区
+    std::vector<float> best_score_;
+    std::vector<int> best_class_;
+    std::vector<DecodedBox> candidates_;
+    std::vector<uint8_t> suppressed_;
+    std::vector<DecodedBox> results_;
+
+    void decodeChannelMajor(const cv::Mat& output, const BoxTransform& transform);
+    void decodeRowMajor(const cv::Mat& output, const BoxTransform& transform, bool has_objectness,
+                        bool normalized);
+    void addCandidate(float cx, float cy, float w, float h, float score, int class_index,
+                      const BoxTransform& transform);
+    void nonMaximumSuppression();
+};
+
+#endif // DETECTION_DECODER_HPP
@@ -0,0 +1,96 @@
+/**
+ * @file detection_scheduler.hpp
+ * @brief 自适应检测调度 - 按耗时预算隔帧检测、ROI裁剪和风险触发的检测提频
+ * @author pengchengkang
+ * @date 2025-9-16
+ *
+ * 每路视频独立决定每一帧的检测方式(DetectionMode)：
+ * - 检测间隔由最近检测耗时(预处理+推理的滑动平均)与scheduler.latency_budget_ms之比决定，
+ *   使平均每帧检测耗时不超过预算，上限为max_detect_interval；场景平静时至少为calm_detect_interval
+ * - 间隔内的帧不检测(SKIP)，跟踪器调用predictTracks()按运动模型外推
+ * - 需要检测的帧在已有轨迹周围(按roi_margin扩展)与道路区域的外接矩形内检测(ROI)，
+ *   每full_frame_interval次检测做一次全图检测以发现新目标
+ * - 任一行为分析结果达到risk_level时，之后risk_hold_frames帧内每帧全图检测
+ * 是否检测只由帧的采集序号和当前间隔决定(序号为间隔的整数倍时检测，有风险时每帧检测)，
+ * 预处理级多线程乱序执行时结果不变。
+ */
+#ifndef DETECTION_SCHEDULER_HPP
+#define DETECTION_SCHEDULER_HPP
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+#include "config.hpp"
+#include "data_structs.hpp"
+#include "metrics.hpp"
+
+class DetectionScheduler {
+public:
+    // 一帧的检测方式，roi仅在ROI模式下有效(帧坐标)
+    struct Decision {
+        DetectionMode mode = DetectionMode::FULL;
+        cv::Rect roi;
+    };
+
+    DetectionScheduler() = default;
+    DetectionScheduler(const DetectionScheduler&) = delete;
+    DetectionScheduler& operator=(const DetectionScheduler&) = delete;
+
+    // 按配置重置各路状态
+    void configure(const SystemConfig::SchedulerConfig& config, size_t stream_count);
+
+    bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 决定一帧的检测方式(预处理级调用，线程安全)
+     * @param stream_id 视频流编号
+     * @param frame_index 帧的采集序号
+     * @param frame_size 帧尺寸
+     */
+    Decision decide(int stream_id, uint64_t frame_index, const cv::Size& frame_size);
+
+    // 一帧检测(预处理+推理)的耗时，用于计算检测间隔
+    void observeCost(float detect_ms);
+
+    // 跟踪结果(帧坐标)，用于生成之后的检测ROI
+    void observeTracks(int stream_id, TrackView tracks);
+
+    // 一帧行为分析结果，达到风险等级时提高检测频率
+    void observeRisk(int stream_id, uint64_t frame_index, const std::vector<BehaviorAnalysis>& behaviors);
+
+    // 当前检测间隔(帧)
+    int detectInterval(int stream_id) const;
+
+    size_t streamCount() const;
+
+private:
+    struct StreamState {
+        bool started = false;                // 是否已检测过(首帧总是检测)
+        int detections_since_full = 0;       // 上次全图检测之后的ROI检测次数
+        uint64_t risk_until = 0;             // 在此帧序号之前每帧全图检测
+        bool risk_active = false;
+        bool calm = false;                   // 最近一帧无目标或全部安全
+        int interval = 1;                    // 最近一次决策的检测间隔
+        cv::Size frame_size;                 // 最近一次决策时的帧尺寸
+        cv::Rect roi;                        // 轨迹周围与道路区域的外接矩形
+    };
+
+    int budgetInterval() const;
+    void record(DetectionMode mode);
+
+    SystemConfig::SchedulerConfig config_;   // 受mutex_保护，热重载时由configure()改写
+    mutable std::mutex mutex_;
+    // config_.enable/enable_roi的副本，供加锁前的快速判断
+    std::atomic<bool> enabled_{false};
+    std::atomic<bool> roi_enabled_{false};
+    std::vector<StreamState> streams_;
+    float cost_ms_ = 0.0f;                   // 检测耗时滑动平均，0为尚无样本
+
+    Counter* full_frames_ = nullptr;
+    Counter* roi_frames_ = nullptr;
+    Counter* skipped_frames_ = nullptr;
+};
+
+#endif // DETECTION_SCHEDULER_HPP
@@ -0,0 +1,228 @@
+/**
+ * @file frame_pipeline.hpp
+ * @brief 多级帧处理流水线定义
+ * @author pengchengkang
+ * @date 2025-9-8
+ *
+ * 本文件定义了帧处理流水线FramePipeline。流水线由若干级组成，
+ * 典型配置为：解码(视频线程) → 预处理 → 推理 → 跟踪 → 分析 → 输出。
+ *
+ * 设计要点：
+ * - 每一级拥有有界输入队列，由共享工作窃取线程池中的排空任务处理，不占用专属线程
+ * - 下游队列满时上游暂停出队，下游取走帧后再唤醒上游，形成背压
+ * - 级的线程数为并发上限；流水线级使用HIGH优先级，输出级使用LOW优先级
+ * - 入口队列可配置丢帧策略，实时流过载时丢弃过期帧，保证端到端延迟有界
+ * - 无状态的级(如预处理)可以配置多个线程并行执行
+ * - 有状态的级(如跟踪)标记为有序级，只使用单线程，并按帧序号严格顺序处理
+ * - 帧序号在第一级出队时分配，保证连续无空洞，下游据此恢复顺序
+ * - 不同级可同时处理不同的帧，使GPU推理与CPU跟踪、绘制相互重叠
+ * - 批量级(如推理)一次取出多帧，凑满batch或到达等待上限后整体处理；凑批期间不占用工作线程，
+ *   由后续入队或截止时间定时器重新投递排空任务
+ * - 帧以池化缓冲区句柄流转，各级只传递引用，不复制像素
+ * - 多路视频流共享一条流水线，帧携带stream_id，批量推理可跨流凑批
+ * - 帧携带追踪上下文(采集序号、采集时间)，并记录在各级的进出时刻，用于端到端延迟归因
+ */
+#ifndef FRAME_PIPELINE_HPP
+#define FRAME_PIPELINE_HPP
+
+#include <memory>
+#include <vector>
+#include <map>
+#include <string>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <exception>
+#include <array>
+#include <thread>
+
+#include "data_structs.hpp"
+#include "bounded_queue.hpp"
+#include "frame_pool.hpp"
+#include "thread_pool.hpp"
+
+class IObjectDetector;
+
+// 帧在某一级的进出时刻(traceClockMicros)，0为未经过
+struct StageSpan {
+    uint64_t enter_us = 0;
+    uint64_t exit_us = 0;
+};
+
+// 流水线中流转的帧上下文，各级在其上累积处理结果
+struct FrameContext {
+    static constexpr size_t kMaxStages = 8;         // 记录进出时刻的最大级数
+
+    uint64_t sequence = 0;                          // 帧序号(流水线内连续递增)
+    uint64_t timestamp = 0;                         // 采集时间戳(毫秒)
+    int stream_id = 0;                              // 视频流编号(多路模式)
+    FrameTrace trace;                               // 追踪上下文(采集序号、采集时间)
+    std::chrono::steady_clock::time_point ingest_time; // 进入流水线的时间
+    std::array<StageSpan, kMaxStages> spans{};      // 各级进出时刻，下标为级序号
+    cv::Mat frame;                                  // 原始帧(主机内存，池化时为frame_buffer->image)
+    FrameHandle frame_buffer;                       // 池化帧缓冲区，须声明在frame之后(移动赋值时先释放frame)
+    cv::cuda::GpuMat gpu_frame;                     // 原始帧(显存，GPU解码时有效)
+    DetectionMode detect_mode = DetectionMode::FULL; // 检测方式(自适应调度)
+    cv::Rect detect_roi;                            // ROI模式下的检测区域(帧坐标)
+    std::shared_ptr<IObjectDetector> detector;      // 预处理本帧的检测器，热替换时在途帧仍由它推理
+    DetectorInput input;                            // 检测器输入
+    std::vector<DetectorInput> tile_inputs;         // 切片推理的各切片输入
+    std::vector<cv::Rect> tile_rects;               // 各切片在帧中的区域
+    std::vector<Detection> detections;              // 检测结果
+    TrackSnapshotHandle tracked_objects;            // 跟踪结果快照
+    std::vector<BehaviorAnalysis> behaviors;        // 行为分析结果
+    float preprocess_ms = 0.0f;                     // 预处理耗时(毫秒)
+    float detection_ms = 0.0f;                      // 推理耗时(毫秒)
+    float tracking_ms = 0.0f;                       // 跟踪耗时(毫秒)
+    float analysis_ms = 0.0f;                       // 分析耗时(毫秒)
+
+    FrameContext() = default;
+    FrameContext(FrameContext&&) = default;
+    FrameContext& operator=(FrameContext&&) = default;
+
+    // 先释放对缓冲区像素的引用，缓冲区归还时才能判定为空闲
+    ~FrameContext() { frame.release(); }
+};
+
+// 帧处理流水线
+class FramePipeline {
+public:
+    using StageFunction = std::function<void(FrameContext&)>;
+    using BatchStageFunction = std::function<void(std::vector<FrameContext>&)>;
+    using ErrorCallback = std::function<void(const std::string&, const std::exception&)>;
+    using CompletionCallback = std::function<void(const FrameContext&)>;
+
+    // 流水线级选项
+    struct StageOptions {
+        std::string name;          // 级名称(用于日志)
+        size_t threads = 1;        // 最大并发任务数
+        size_t queue_depth = 4;    // 输入队列深度
+        bool ordered = true;       // 是否要求按帧序号顺序处理(有序级强制单线程)
+        OverflowPolicy overflow = OverflowPolicy::BLOCK; // 输入队列满时的处理策略
+        size_t batch_size = 1;     // 批量级每批最多帧数
+        int max_batch_wait_ms = 5; // 批量级凑批最长等待时间(毫秒)
+        TaskPriority priority = TaskPriority::HIGH; // 线程池任务优先级
+    };
+
+    // pool为执行各级任务的线程池，须比流水线存活更久
+    explicit FramePipeline(ThreadPool& pool = ThreadPool::shared());
+    ~FramePipeline();
+
+    // 禁止拷贝
+    FramePipeline(const FramePipeline&) = delete;
+    FramePipeline& operator=(const FramePipeline&) = delete;
+
+    // 追加一级，只能在start()之前调用
+    void addStage(const StageOptions& options, StageFunction func);
+
+    // 追加一个批量级，每次以按序号排列的一批帧调用func，只能在start()之前调用
+    void addBatchStage(const StageOptions& options, BatchStageFunction func);
+
+    // 设置级内异常回调
+    void setErrorCallback(ErrorCallback callback);
+
+    // 设置帧离开最后一级后的回调(此时各级进出时刻已完整)，只能在start()之前调用
+    void setCompletionCallback(CompletionCallback callback);
+
+    // 启动流水线
+    bool start();
+
+    // 停止流水线，已入队的帧会被处理完
+    void stop();
+
+    // 提交一帧，第一级队列满时按其溢出策略阻塞或丢帧
+    bool submit(const cv::Mat& frame, uint64_t timestamp, int stream_id = 0);
+
+    // 提交一帧池化缓冲区，帧随上下文一起释放后归还缓冲池
+    bool submit(const FrameHandle& frame, int stream_id = 0);
+
+    // 提交一帧显存中的图像(GPU解码路径)
+    bool submit(const cv::cuda::GpuMat& frame, const FrameTrace& trace, int stream_id = 0);
+
+    // 是否正在运行
+    bool isRunning() const;
+
+    // 级数量
+    size_t stageCount() const;
+
+    // 获取指定级名称
+    const std::string& stageName(size_t index) const;
+
+    // 获取指定级当前队列长度
+    size_t queueSize(size_t index) const;
+    
+    // 自启动以来提交的帧数
+    uint64_t submittedFrames() const;
+    
+    // 自启动以来因队列溢出丢弃的帧数
+    uint64_t droppedFrames() const;
+
+private:
+    struct Stage {
+        size_t index = 0;                           // 级序号
+        StageOptions options;
+        StageFunction func;
+        BatchStageFunction batch_func;              // 非空时为批量级
+        std::unique_ptr<BoundedQueue<FrameContext>> queue;
+        size_t active = 0;                          // 正在运行的排空任务数，受schedule_mutex_保护
+        bool needs_reorder = false;                 // 上游为多线程级时需要重排
+        std::mutex reorder_mutex;
+        std::map<uint64_t, FrameContext> pending;   // 等待前序帧的乱序帧
+        uint64_t next_sequence = 0;                 // 下一个应放行的帧序号
+        // 批量级凑批截止时间，未凑批时为默认值；与定时器标记一起受schedule_mutex_保护
+        std::chrono::steady_clock::time_point batch_deadline;
+        bool batch_timer_fired = false;             // 本次截止时间已由定时器处理
+    };
+
+    ThreadPool& pool_;
+    std::vector<std::unique_ptr<Stage>> stages_;
+    ErrorCallback error_callback_;
+    CompletionCallback completion_callback_;
+    std::atomic<bool> running_;
+    std::atomic<uint64_t> submitted_frames_;
+    std::mutex schedule_mutex_;
+    std::condition_variable idle_cv_;
+    std::thread batch_timer_;                       // 凑批截止时间定时器，有需要等待的批量级时启动
+    std::condition_variable batch_timer_cv_;        // 与schedule_mutex_配合使用
+    bool batch_timer_running_ = false;              // 受schedule_mutex_保护
+
+    // 有待处理的帧且未达并发上限时，向线程池投递一个排空任务
+    void kick(size_t index);
+
+    // 投递排空任务，调用方已为其增加并发计数
+    void postDrain(size_t index);
+
+    // 调用方持有schedule_mutex_，判断是否可以再投递一个排空任务
+    bool canSchedule(size_t index);
+
+    // 调用方持有schedule_mutex_，批量级是否已凑满一批或到达截止时间；凑批开始时设置截止时间
+    bool batchReady(Stage& stage, std::chrono::steady_clock::time_point now);
+
+    // 定时器线程：到达截止时间时投递凑不满的批量级
+    void batchTimerLoop();
+
+    // 下游队列是否还有空位(最后一级总是有)
+    bool hasRoomDownstream(size_t index) const;
+
+    // 排空任务：处理若干帧后让出工作线程
+    void drain(size_t index);
+
+    // 批量级排空任务
+    void drainBatch(size_t index);
+
+    // 排空任务退出：减少并发计数，仍有帧待处理时重新投递
+    void finishDrain(size_t index);
+
+    // 执行级函数并处理异常
+    void runStage(Stage& stage, FrameContext& context);
+
+    // 帧离开本级：送入下一级，最后一级时调用完成回调
+    void complete(size_t index, FrameContext&& context);
+
+    // 将帧送入指定级，必要时按序号重排
+    void forward(size_t index, FrameContext&& context);
+};
+
+#endif // FRAME_PIPELINE_HPP
@@ -0,0 +1,73 @@
+/**
+ * @file frame_tracer.hpp
+ * @brief 逐帧延迟追踪 - 抽样帧的采集、排队和各级处理时刻写出为Chrome trace
+ * @author pengchengkang
+ * @date 2025-9-16
+ *
+ * 每路视频按采集序号每trace.sample_interval帧抽取一帧，帧离开流水线最后一级时记录：
+ * - 一个从采集到输出完成的异步区间(cat=frame)，参数中带帧序号、媒体时间和端到端延迟
+ * - 采集到进入流水线的等待(capture轨道)
+ * - 每一级的排队等待(cat=queue)和处理耗时(cat=stage)，各级一条轨道
+ * 每路视频为一个进程，时间以追踪器打开时刻为零点(微秒)。
+ * 输出为Trace Event的JSON数组格式，可直接拖入chrome://tracing或ui.perfetto.dev；
+ * 数组在close()时才闭合，异常退出时文件缺少结尾的]，两者都能容忍。
+ */
+#ifndef FRAME_TRACER_HPP
+#define FRAME_TRACER_HPP
+
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "config.hpp"
+#include "frame_pipeline.hpp"
+
+class FrameTracer {
+public:
+    FrameTracer() = default;
+    ~FrameTracer();
+    FrameTracer(const FrameTracer&) = delete;
+    FrameTracer& operator=(const FrameTracer&) = delete;
+
+    /**
+     * @brief 打开输出文件并写入轨道名称
+     * @param config 追踪配置
+     * @param stage_names 流水线各级名称(按级序号)
+     * @param stream_names 各路视频名称(按stream_id)
+     */
+    bool open(const SystemConfig::TraceConfig& config, const std::vector<std::string>& stage_names,
+              const std::vector<std::string>& stream_names);
+
+    // 帧是否被抽中
+    bool sampled(const FrameContext& context) const;
+
+    // 记录一帧(未抽中的帧直接返回)，线程安全
+    void record(const FrameContext& context);
+
+    // 把已缓存的事件写入文件
+    void flush();
+
+    // 闭合JSON数组并关闭文件
+    void close();
+
+    // 已记录的帧数
+    size_t tracedFrames() const;
+
+private:
+    void appendEvent(const std::string& event);
+    void writeBuffer();
+    double relative(uint64_t micros) const;
+
+    SystemConfig::TraceConfig config_;
+    std::vector<std::string> stage_names_;
+
+    mutable std::mutex mutex_;
+    std::ofstream file_;
+    std::string buffer_;
+    bool first_event_ = true;
+    uint64_t origin_us_ = 0;
+    size_t traced_frames_ = 0;
+};
+
+#endif // FRAME_TRACER_HPP
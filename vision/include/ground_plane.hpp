@@ -0,0 +1,44 @@
+/**
+ * @file ground_plane.hpp
+ * @brief 地面投影测距 - 按图像行预计算目标距离查找表
+ * @author pengchengkang
+ * @date 2025-9-15
+ *
+ * 假设路面为平面、相机安装高度和俯仰角已知，目标框底边所在图像行v对应的
+ * 视线俯角为 pitch + atan((v - cy) / fy)，地面纵向距离为 height / tan(俯角)。
+ * 初始化时对每个整数行预先计算距离，运行时测距只需一次查表。
+ * 地平线以上的行取最大距离；表一直延伸到距离小于1米的行，更靠下的行按最后一行处理。
+ */
+#ifndef GROUND_PLANE_HPP
+#define GROUND_PLANE_HPP
+
+#include <vector>
+#include "config.hpp"
+
+class GroundPlaneModel {
+public:
+    /**
+     * @brief 根据相机几何生成查找表
+     * fy未标定时由垂直视场角和主点推算：fy = cy / tan(fov_v / 2)
+     * @param camera 相机参数(height、pitch、fy/fov_v、cy)
+     * @param max_distance 距离上限(米)
+     * @return bool 相机参数不足以确定投影时返回false
+     */
+    bool initialize(const CameraParams& camera, float max_distance);
+
+    bool valid() const { return !lut_.empty(); }
+
+    // 目标框底边位于图像行y时的地面距离(米)
+    float distanceAtRow(float y) const {
+        int row = static_cast<int>(y);
+        row = row < 0 ? 0 : (row >= static_cast<int>(lut_.size()) ? static_cast<int>(lut_.size()) - 1 : row);
+        return lut_[row];
+    }
+
+    size_t rows() const { return lut_.size(); }
+
+private:
+    std::vector<float> lut_;
+};
+
+#endif // GROUND_PLANE_HPP
@@ -0,0 +1,54 @@
+/**
+ * @file inference_backend.hpp
+ * @brief 推理后端抽象 - 将网络执行与检测器的预处理/后处理解耦
+ * @author pengchengkang
+ * @date 2025-9-9
+ *
+ * 检测器只负责生成NCHW输入张量和解析输出张量，网络的加载与执行由推理后端完成：
+ * - OpenCV DNN：支持ONNX/TensorFlow/Darknet，CUDA可用时支持FP16
+ * - TensorRT：加载序列化引擎，或从ONNX构建FP16/INT8引擎并缓存到磁盘(HAVE_TENSORRT)
+ * - ONNX Runtime：无GPU时的CPU推理后端(HAVE_ONNXRUNTIME)
+ *
+ * 后端的输出统一为cv::Mat张量列表，形状与OpenCV DNN一致，便于复用后处理代码。
+ */
+#ifndef INFERENCE_BACKEND_HPP
+#define INFERENCE_BACKEND_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+#include "config.hpp"
+
+// 推理后端接口
+class IInferenceBackend {
+public:
+    virtual ~IInferenceBackend() = default;
+
+    // 加载模型并按配置准备执行环境
+    virtual bool initialize(const SystemConfig::DetectorConfig& config) = 0;
+
+    // 执行一次前向推理，blob为NxCxHxW，outputs第0维为batch
+    // 失败时抛出异常(cv::Exception或std::runtime_error)
+    virtual void forward(const cv::Mat& blob, std::vector<cv::Mat>& outputs) = 0;
+
+    // 单次forward支持的最大batch
+    virtual int maxBatchSize() const = 0;
+
+    // 后端名称(用于日志)
+    virtual std::string name() const = 0;
+
+    // 按配置和模型格式创建后端
+    static std::unique_ptr<IInferenceBackend> create(const SystemConfig::DetectorConfig& config);
+};
+
+#ifdef HAVE_TENSORRT
+std::unique_ptr<IInferenceBackend> createTensorRTBackend();
+#endif
+
+#ifdef HAVE_ONNXRUNTIME
+std::unique_ptr<IInferenceBackend> createOnnxRuntimeBackend();
+#endif
+
+#endif // INFERENCE_BACKEND_HPP
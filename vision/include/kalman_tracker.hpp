@@ -0,0 +1,75 @@
+/**
+ * @file kalman_tracker.hpp
+ * @brief 基于卡尔曼滤波的SORT/DeepSORT跟踪器
+ * @author pengchengkang
+ * @date 2025-9-13
+ *
+ * 运动模型为(cx, cy, w, h)的恒速模型。过程噪声和观测噪声都是对角阵，
+ * 状态转移只把每个量与自身速度耦合，协方差始终按轴分块对角，
+ * 因此8维滤波器等价于4个独立的二维(位置, 速度)滤波器。
+ *
+ * KalmanBoxFilterBank按结构数组(SoA)存储所有轨迹的状态：每个轴的位置、速度和
+ * 2x2协方差各占一条连续数组，predict()对全部轨迹做无分支的逐元素运算，可被编译器向量化。
+ * 滤波器下标即TrackStore的槽位下标，空闲槽位照常预测(结果在复用时被init()覆盖)。
+ *
+ * 跟踪器通过IObjectTracker::create(type)按名称创建：
+ * - "sort"：卡尔曼预测 + IOU最优分配
+ * - "deepsort"：在此基础上对每帧全部检测批量提取ReID特征(一次前向)，
+ *   先以马氏距离门控、外观余弦距离为代价匹配确认轨迹，再对剩余轨迹做IOU匹配
+ */
+#ifndef KALMAN_TRACKER_HPP
+#define KALMAN_TRACKER_HPP
+
+#include <memory>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+#include "module_interface.hpp"
+
+// 所有轨迹的恒速卡尔曼滤波器，下标与轨迹槽位一致
+class KalmanBoxFilterBank {
+public:
+    size_t size() const { return pos_[0].size(); }
+
+    void clear();
+
+    // 扩展到至少n个滤波器(只增不减)
+    void reserveSlots(size_t n);
+
+    // 以观测框初始化下标index的滤波器
+    void init(size_t index, const cv::Rect2f& box);
+
+    // 全部滤波器前进一帧
+    void predict();
+
+    // 用观测框更新下标index的滤波器
+    void update(size_t index, const cv::Rect2f& box);
+
+    // 当前状态对应的边界框
+    cv::Rect2f box(size_t index) const;
+
+    // 中心点速度(像素/帧)
+    cv::Point2f velocity(size_t index) const;
+
+    // 观测框与预测状态的马氏距离平方(4自由度)
+    float gatingDistance(size_t index, const cv::Rect2f& box) const;
+
+    // 中心点马氏距离不超过threshold时检测框可能覆盖的区域，用于网格查询
+    cv::Rect2f gatingRegion(size_t index, float threshold) const;
+
+private:
+    enum Axis { kCenterX = 0, kCenterY, kWidth, kHeight, kAxes };
+
+    std::vector<float> pos_[kAxes];
+    std::vector<float> vel_[kAxes];
+    std::vector<float> p00_[kAxes];   // 位置方差
+    std::vector<float> p01_[kAxes];   // 位置-速度协方差
+    std::vector<float> p11_[kAxes];   // 速度方差
+
+    static void measure(const cv::Rect2f& box, float z[kAxes]);
+};
+
+std::unique_ptr<IObjectTracker> createSortTracker();
+std::unique_ptr<IObjectTracker> createDeepSortTracker();
+
+#endif // KALMAN_TRACKER_HPP
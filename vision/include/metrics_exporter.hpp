@@ -0,0 +1,112 @@
+/**
+ * @file metrics_exporter.hpp
+ * @brief 指标导出 - 资源采样、Prometheus文本端点和JSON快照
+ * @author pengchengkang
+ * @date 2025-9-16
+ *
+ * 后台线程每metrics.interval_ms执行一次：
+ * - 调用采集回调(由系统填充队列深度等瞬时值)
+ * - 采样进程CPU使用率、常驻内存和GPU使用率(Linux /proc与sysfs，无法获取时为-1)
+ * - 对所有直方图取快照并与上次相减，得到区间内的均值、p50/p90/p99/p999和最大值
+ * - 写出JSON快照(先写临时文件再改名，读取方不会看到半个文件)
+ * 启用prometheus_port时另起一个线程响应GET /metrics(Prometheus文本格式)和GET /metrics.json。
+ */
+#ifndef METRICS_EXPORTER_HPP
+#define METRICS_EXPORTER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "config.hpp"
+#include "metrics.hpp"
+
+// 最近一个采样区间的指标摘要
+struct MetricsSummary {
+    struct Latency {
+        std::string name;          // 指标名
+        std::string labels;        // 标签
+        uint64_t count = 0;        // 区间内样本数
+        double mean_ms = 0.0;
+        double p50_ms = 0.0;
+        double p90_ms = 0.0;
+        double p99_ms = 0.0;
+        double p999_ms = 0.0;
+        double max_ms = 0.0;       // 自启动以来的最大值
+    };
+
+    double interval_s = 0.0;       // 区间长度(秒)
+    double fps = 0.0;              // 区间内完成输出的帧率(墙钟)
+    double cpu_percent = -1.0;     // 进程CPU使用率(100为占满一个核心)
+    double gpu_percent = -1.0;     // GPU使用率
+    double rss_mb = 0.0;           // 进程常驻内存(MB)
+    std::vector<Latency> latencies;
+
+    // 按指标名和标签查找，没有时返回nullptr
+    const Latency* find(const std::string& name, const std::string& labels) const;
+};
+
+class MetricsExporter {
+public:
+    using Collector = std::function<void()>;
+
+    MetricsExporter() = default;
+    ~MetricsExporter();
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+    /**
+     * @brief 启动采样线程和(可选的)HTTP端点
+     * @param config 指标配置
+     * @param collector 每次采样前调用，用于刷新瞬时值
+     */
+    bool start(const SystemConfig::MetricsConfig& config, Collector collector);
+
+    void stop();
+
+    // 最近一个区间的摘要
+    MetricsSummary summary() const;
+
+    // Prometheus文本格式(0.0.4)
+    std::string renderPrometheus() const;
+
+    // JSON快照
+    std::string renderJson() const;
+
+private:
+    void sampleLoop();
+    void serveLoop();
+    void sample();
+    void sampleResources(MetricsSummary& summary);
+    void logSummary(const MetricsSummary& summary) const;
+    void writeSnapshot() const;
+    void handleConnection(int client) const;
+
+    SystemConfig::MetricsConfig config_;
+    Collector collector_;
+
+    std::thread sample_thread_;
+    std::thread serve_thread_;
+    std::atomic<bool> running_{false};
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+    int listen_fd_ = -1;
+
+    // 区间统计状态(仅采样线程访问)
+    std::map<std::string, HistogramSnapshot> previous_;
+    uint64_t previous_frames_ = 0;
+    double previous_cpu_seconds_ = -1.0;
+    std::chrono::steady_clock::time_point previous_time_;
+    std::chrono::steady_clock::time_point last_log_;
+
+    mutable std::mutex summary_mutex_;
+    MetricsSummary summary_;
+};
+
+#endif // METRICS_EXPORTER_HPP
@@ -0,0 +1,169 @@
+/**
+ * @file result_log.hpp
+ * @brief 二进制结果日志 - 定长记录的写入编码和基于mmap的读取
+ * @author pengchengkang
+ * @date 2025-9-16
+ *
+ * 文件由16字节文件头和一串块组成，每块以8字节块头(类型, 负载字节数)开始：
+ * - FRAME：帧头(时间戳, 记录数) + 若干定长的ResultLogRecord
+ * - STRING：字符串表条目(编号, 长度, 内容)，首次出现时写在引用它的帧之前。
+ *   编号在整个文件内唯一；行为名称和风险描述整个文件只写一次，LLM文本是自由文本，
+ *   只在同一索引段内去重，每个索引块之后重新写入，写入端的字符串表不随文件增长
+ * - INDEX：每index_interval帧一个索引块，包含上一索引块偏移、
+ *   本段各帧的(时间戳, 偏移)和本段新增字符串块的偏移
+ * - TRAILER：正常关闭时写在文件末尾，指向最后一个索引块
+ *
+ * 文件只追加写入，任意时刻截断后已写完的块仍可读取。读取方有TRAILER时只沿索引链
+ * 访问索引块和字符串块，不解析帧数据；没有TRAILER(异常退出)时逐块扫描块头。
+ * 所有整数按主机字节序(小端)存储。
+ */
+#ifndef RESULT_LOG_HPP
+#define RESULT_LOG_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "data_structs.hpp"
+
+namespace result_log {
+
+constexpr char kMagic[4] = {'V', 'P', 'S', 'R'};
+constexpr uint32_t kVersion = 1;
+
+enum ChunkType : uint32_t {
+    kChunkFrame = 1,
+    kChunkString = 2,
+    kChunkIndex = 3,
+    kChunkTrailer = 4
+};
+
+struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t reserved;
+};
+
+struct ChunkHeader {
+    uint32_t type;
+    uint32_t size;      // 负载字节数，不含块头
+};
+
+struct FrameHeader {
+    uint64_t timestamp;
+    uint32_t count;
+    uint32_t reserved;
+};
+
+struct IndexEntry {
+    uint64_t timestamp;
+    uint64_t offset;    // 帧块(块头)在文件中的偏移
+};
+
+// 索引块负载：本结构之后依次为frame_count个IndexEntry和string_count个uint64偏移
+struct IndexHeader {
+    uint64_t prev_offset;   // 上一索引块偏移，0表示没有
+    uint32_t frame_count;
+    uint32_t string_count;
+};
+
+} // namespace result_log
+
+// 定长的行为分析记录，字符串以字符串表编号引用(0为空串)
+struct ResultLogRecord {
+    int32_t track_id;
+    int32_t stream_id;
+    uint8_t behavior;
+    uint8_t risk_level;
+    uint16_t reserved;
+    float confidence;
+    float location_x;
+    float location_y;
+    float distance_to_vehicle;
+    float time_to_collision;
+    uint64_t timestamp;
+    uint32_t behavior_name_id;
+    uint32_t risk_description_id;
+    uint32_t llm_analysis_id;
+    uint32_t reserved2;
+};
+static_assert(sizeof(ResultLogRecord) == 56, "ResultLogRecord layout changed");
+
+// 写入编码器：把帧编码后追加到调用方的缓冲区，调用方按顺序写入文件
+class ResultLogWriter {
+public:
+    // 开始新文件，写入文件头
+    void begin(std::string& out, int index_interval);
+
+    // 编码一帧结果
+    void appendFrame(std::string& out, const std::vector<BehaviorAnalysis>& results, uint64_t timestamp);
+
+    // 写入剩余索引和TRAILER
+    void finish(std::string& out);
+
+private:
+    uint32_t intern(std::string& out, const std::string& text,
+                    std::unordered_map<std::string, uint32_t>& table);
+    void appendChunk(std::string& out, uint32_t type, const void* payload, size_t size);
+    void appendIndex(std::string& out);
+
+    std::unordered_map<std::string, uint32_t> strings_;         // 低基数字段(行为名称、风险描述)，整个文件有效
+    std::unordered_map<std::string, uint32_t> segment_strings_; // LLM文本，每个索引块之后清空
+    uint32_t next_string_id_ = 1;
+    std::vector<result_log::IndexEntry> pending_frames_;
+    std::vector<uint64_t> pending_strings_;
+    std::vector<ResultLogRecord> records_;
+    std::string scratch_;
+    uint64_t offset_ = 0;           // 已编码的总字节数，即下一块的文件偏移
+    uint64_t last_index_ = 0;
+    size_t index_interval_ = 256;
+};
+
+// 基于mmap的只读访问，按帧下标或时间戳定位
+class ResultLogReader {
+public:
+    // 一帧结果的视图，指针指向映射内存
+    struct Frame {
+        uint64_t timestamp = 0;
+        const ResultLogRecord* records = nullptr;
+        size_t count = 0;
+
+        const ResultLogRecord* begin() const { return records; }
+        const ResultLogRecord* end() const { return records + count; }
+    };
+
+    ResultLogReader() = default;
+    ~ResultLogReader();
+    ResultLogReader(const ResultLogReader&) = delete;
+    ResultLogReader& operator=(const ResultLogReader&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return data_ != nullptr; }
+
+    size_t frameCount() const { return frames_.size(); }
+    Frame frame(size_t index) const;
+
+    // 第一个时间戳不小于timestamp的帧下标，没有时返回frameCount()
+    size_t seek(uint64_t timestamp) const;
+
+    // 字符串表查找，未知编号返回空串
+    std::string string(uint32_t id) const;
+
+    // 解码为BehaviorAnalysis
+    BehaviorAnalysis decode(const ResultLogRecord& record) const;
+
+private:
+    bool loadFromIndex(uint64_t last_index);
+    void loadByScan();
+    bool readChunk(uint64_t offset, result_log::ChunkHeader& header) const;
+    void addString(uint64_t offset);
+
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    std::vector<result_log::IndexEntry> frames_;
+    std::unordered_map<uint32_t, std::pair<const char*, uint32_t>> strings_;
+};
+
+#endif // RESULT_LOG_HPP
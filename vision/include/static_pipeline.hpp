@@ -0,0 +1,270 @@
+/**
+ * @file static_pipeline.hpp
+ * @brief 编译期组合的感知流水线 - 模块集合在构建时确定的固定部署使用
+ * @author pengchengkang
+ * @date 2025-9-16
+ *
+ * VehiclePerceptionSystem在运行时按配置经I*::create()创建模块，每一级都是虚函数调用，
+ * 结果以新vector按值返回。模块集合在构建时已知时，StaticPipeline<Detector, Tracker, Analyzer>
+ * 以模板参数组合具体级类型：
+ * - 级调用是静态分派(非虚，可内联到级的入口)，级之间不经过std::function
+ * - 检测、轨迹和行为结果写入调用方持有的StaticPipeline::Frame，缓冲区跨帧复用
+ * - 结果回调放在CallbackSlot中，调用不加锁
+ *
+ * 具体级类型(DetectorStage等)以不透明指针持有模块实现类，成员函数在各模块的源文件中
+ * 以限定名调用实现类，实现类仍只对其源文件可见。Dynamic*Stage以同样的接口包装运行时工厂，
+ * 两者可以任意组合，也用于与静态路径对比(见perception_bench.cpp的pipeline.dispatch)。
+ *
+ * 级类型需要提供的接口：
+ * - 检测级: initialize(DetectorConfig) / preprocess(cv::Mat) / infer(DetectorInput, std::vector<Detection>&)
+ * - 跟踪级: initialize(TrackerConfig) / setTrajectoryLength(int) /
+ *           update(detections, frame, timestamp) / predictTracks(timestamp)
+ * - 分析级: initialize(BehaviorConfig, CameraParams, VehicleParams) / analyze(TrackView, std::vector<BehaviorAnalysis>&)
+ *
+ * StaticPipeline不是线程安全的，与动态路径中推理、跟踪和分析级一样须在单一线程上按帧顺序调用。
+ */
+#ifndef STATIC_PIPELINE_HPP
+#define STATIC_PIPELINE_HPP
+
+#include <memory>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+#include "config.hpp"
+#include "data_structs.hpp"
+#include "module_interface.hpp"
+#include "callback_slot.hpp"
+
+// 模块实现类，定义在各自的源文件中
+class ObjectDetector;
+class SortTracker;
+class ObjectTracker;
+class BehaviorAnalyzer;
+
+/**
+ * @brief 检测级：ObjectDetector(object_detector.cpp)
+ */
+class DetectorStage {
+public:
+    DetectorStage();
+    ~DetectorStage();
+    DetectorStage(DetectorStage&&) noexcept;
+    DetectorStage& operator=(DetectorStage&&) noexcept;
+
+    bool initialize(const SystemConfig::DetectorConfig& config);
+    DetectorInput preprocess(const cv::Mat& image) const;
+    void infer(const DetectorInput& input, std::vector<Detection>& detections);
+
+private:
+    std::unique_ptr<ObjectDetector> impl_;
+};
+
+/**
+ * @brief 跟踪级：SORT卡尔曼跟踪器(kalman_tracker.cpp)，忽略TrackerConfig::type
+ */
+class SortTrackerStage {
+public:
+    SortTrackerStage();
+    ~SortTrackerStage();
+    SortTrackerStage(SortTrackerStage&&) noexcept;
+    SortTrackerStage& operator=(SortTrackerStage&&) noexcept;
+
+    bool initialize(const SystemConfig::TrackerConfig& config);
+    void setTrajectoryLength(int length);
+    TrackSnapshotHandle update(const std::vector<Detection>& detections, const cv::Mat& frame, uint64_t timestamp);
+    TrackSnapshotHandle predictTracks(uint64_t timestamp);
+
+private:
+    std::unique_ptr<SortTracker> impl_;
+};
+
+/**
+ * @brief 跟踪级：简化SORT跟踪器(object_tracker.cpp)，忽略TrackerConfig::type
+ */
+class SimpleTrackerStage {
+public:
+    SimpleTrackerStage();
+    ~SimpleTrackerStage();
+    SimpleTrackerStage(SimpleTrackerStage&&) noexcept;
+    SimpleTrackerStage& operator=(SimpleTrackerStage&&) noexcept;
+
+    bool initialize(const SystemConfig::TrackerConfig& config);
+    void setTrajectoryLength(int length);
+    TrackSnapshotHandle update(const std::vector<Detection>& detections, const cv::Mat& frame, uint64_t timestamp);
+    TrackSnapshotHandle predictTracks(uint64_t timestamp);
+
+private:
+    std::unique_ptr<ObjectTracker> impl_;
+};
+
+/**
+ * @brief 分析级：BehaviorAnalyzer(behavior_analyzer.cpp)，结果写入复用的输出缓冲区
+ */
+class AnalyzerStage {
+public:
+    AnalyzerStage();
+    ~AnalyzerStage();
+    AnalyzerStage(AnalyzerStage&&) noexcept;
+    AnalyzerStage& operator=(AnalyzerStage&&) noexcept;
+
+    bool initialize(const SystemConfig::BehaviorConfig& config, const CameraParams& camera_params,
+                    const VehicleParams& vehicle_params);
+    void analyze(TrackView tracked_objects, std::vector<BehaviorAnalysis>& results);
+
+private:
+    std::unique_ptr<BehaviorAnalyzer> impl_;
+};
+
+/**
+ * @brief 检测级：检测结果由调用方填入Frame::detections(外部检测器或回放)，只调用track()/predict()
+ */
+class ExternalDetectorStage {
+public:
+    bool initialize(const SystemConfig::DetectorConfig& /*config*/) { return true; }
+    DetectorInput preprocess(const cv::Mat& /*image*/) const { return {}; }
+    void infer(const DetectorInput& /*input*/, std::vector<Detection>& /*detections*/) {}
+};
+
+/**
+ * @brief 检测级：经IObjectDetector::create()创建，虚函数调用
+ */
+class DynamicDetectorStage {
+public:
+    bool initialize(const SystemConfig::DetectorConfig& config) {
+        impl_ = IObjectDetector::create();
+        return impl_ && impl_->initialize(config);
+    }
+    DetectorInput preprocess(const cv::Mat& image) const { return impl_->preprocess(image); }
+    void infer(const DetectorInput& input, std::vector<Detection>& detections) {
+        detections = impl_->infer(input);
+    }
+
+private:
+    std::unique_ptr<IObjectDetector> impl_;
+};
+
+/**
+ * @brief 跟踪级：按TrackerConfig::type经IObjectTracker::create()创建，虚函数调用
+ */
+class DynamicTrackerStage {
+public:
+    bool initialize(const SystemConfig::TrackerConfig& config) {
+        impl_ = IObjectTracker::create(config.type);
+        return impl_ && impl_->initialize(config);
+    }
+    void setTrajectoryLength(int length) { impl_->setTrajectoryLength(length); }
+    TrackSnapshotHandle update(const std::vector<Detection>& detections, const cv::Mat& frame, uint64_t timestamp) {
+        return impl_->update(detections, frame, timestamp);
+    }
+    TrackSnapshotHandle predictTracks(uint64_t timestamp) { return impl_->predictTracks(timestamp); }
+
+private:
+    std::unique_ptr<IObjectTracker> impl_;
+};
+
+/**
+ * @brief 分析级：经IBehaviorAnalyzer::create()创建，虚函数调用
+ */
+class DynamicAnalyzerStage {
+public:
+    bool initialize(const SystemConfig::BehaviorConfig& config, const CameraParams& camera_params,
+                    const VehicleParams& vehicle_params) {
+        impl_ = IBehaviorAnalyzer::create();
+        return impl_ && impl_->initialize(config, camera_params, vehicle_params);
+    }
+    void analyze(TrackView tracked_objects, std::vector<BehaviorAnalysis>& results) {
+        results = impl_->analyze(tracked_objects);
+    }
+
+private:
+    std::unique_ptr<IBehaviorAnalyzer> impl_;
+};
+
+/**
+ * @brief 编译期组合的检测-跟踪-分析流水线
+ */
+template <typename Detector, typename Tracker, typename Analyzer>
+class StaticPipeline {
+public:
+    // 一帧的各级输出，由调用方持有并跨帧复用
+    struct Frame {
+        std::vector<Detection> detections;
+        TrackSnapshotHandle tracks;
+        std::vector<BehaviorAnalysis> behaviors;
+    };
+
+    using ResultCallback = CallbackSlot<void(const Frame&)>;
+
+    /**
+     * @brief 创建并初始化各级
+     * @return std::unique_ptr<StaticPipeline> 任一级初始化失败时返回nullptr
+     */
+    static std::unique_ptr<StaticPipeline> create(const SystemConfig& config) {
+        auto pipeline = std::make_unique<StaticPipeline>();
+        if (!pipeline->detector_.initialize(config.detector) ||
+            !pipeline->tracker_.initialize(config.tracker) ||
+            !pipeline->analyzer_.initialize(config.behavior, config.camera, config.vehicle)) {
+            return nullptr;
+        }
+        pipeline->tracker_.setTrajectoryLength(config.behavior.trajectory_history_length);
+        return pipeline;
+    }
+
+    /**
+     * @brief 检测、跟踪并分析一帧
+     * @param image 帧图像
+     * @param timestamp 帧时间戳(毫秒)
+     * @param frame 输出，各级缓冲区原地覆盖
+     */
+    void process(const cv::Mat& image, uint64_t timestamp, Frame& frame) {
+        detector_.infer(detector_.preprocess(image), frame.detections);
+        track(image, timestamp, frame);
+    }
+
+    /**
+     * @brief 以frame.detections中已有的检测结果(如外部检测器或回放)跟踪并分析一帧
+     */
+    void track(const cv::Mat& image, uint64_t timestamp, Frame& frame) {
+        frame.tracks = tracker_.update(frame.detections, image, timestamp);
+        finish(frame);
+    }
+
+    /**
+     * @brief 不检测的中间帧：轨迹按运动模型外推后分析
+     */
+    void predict(uint64_t timestamp, Frame& frame) {
+        frame.detections.clear();
+        frame.tracks = tracker_.predictTracks(timestamp);
+        finish(frame);
+    }
+
+    // 每帧结果回调
+    ResultCallback& onResult() { return on_result_; }
+
+    Detector& detector() { return detector_; }
+    Tracker& tracker() { return tracker_; }
+    Analyzer& analyzer() { return analyzer_; }
+
+private:
+    void finish(Frame& frame) {
+        if (frame.tracks) {
+            analyzer_.analyze(frame.tracks->view(), frame.behaviors);
+        } else {
+            frame.behaviors.clear();
+        }
+        on_result_(frame);
+    }
+
+    Detector detector_;
+    Tracker tracker_;
+    Analyzer analyzer_;
+    ResultCallback on_result_;
+};
+
+// 默认固定部署：YOLO检测 + SORT跟踪 + 行为分析
+using DefaultStaticPipeline = StaticPipeline<DetectorStage, SortTrackerStage, AnalyzerStage>;
+
+// 运行时按配置创建模块的同构流水线
+using DynamicPipeline = StaticPipeline<DynamicDetectorStage, DynamicTrackerStage, DynamicAnalyzerStage>;
+
+#endif // STATIC_PIPELINE_HPP
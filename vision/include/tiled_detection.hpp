@@ -0,0 +1,59 @@
+/**
+ * @file tiled_detection.hpp
+ * @brief 切片推理 - 高分辨率帧按原分辨率切片检测远处小目标，并跨切片合并结果
+ * @author pengchengkang
+ * @date 2025-9-16
+ *
+ * 整帧缩放到网络输入尺寸时，远处的行人、动物只剩几个像素。启用detector.tiling后：
+ * - 在[tile_band_top, tile_band_bottom]水平带内按tile_width×tile_height、tile_overlap重叠
+ *   均匀铺设切片，切片以接近原分辨率送入网络
+ * - 可选的粗检测(tile_coarse_pass)照常整帧缩放，覆盖近处大目标
+ * - 一帧的粗检测和全部切片拼成一个batch执行一次前向(模型需支持动态batch，否则逐张推理)
+ * - 结果平移回帧坐标后按类别做跨切片NMS，度量为交集占较小框的比例，
+ *   被切片边界截断的小框在越过该边界的相邻切片中完整出现，直接丢弃；
+ *   相邻切片本帧未执行(ROI模式下只执行与ROI相交的切片)时保留
+ * 帧不大于网络输入时切片不能提高分辨率，只做粗检测。
+ */
+#ifndef TILED_DETECTION_HPP
+#define TILED_DETECTION_HPP
+
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+#include "config.hpp"
+#include "data_structs.hpp"
+
+class TiledDetection {
+public:
+    // 一次推理的结果及其在帧中的区域(空区域为整帧)
+    struct Part {
+        std::vector<Detection> detections;
+        cv::Rect region;
+        bool tile = false;            // 是否为切片(粗检测为false)
+    };
+
+    void configure(const SystemConfig::DetectorConfig& config);
+
+    bool enabled() const { return enabled_; }
+
+    // 是否另做整帧(或ROI)粗检测
+    bool coarsePass() const { return coarse_pass_; }
+
+    // 帧尺寸对应的切片区域，帧不大于网络输入时为空(只读，可并发调用)
+    std::vector<cv::Rect> layout(const cv::Size& frame_size) const;
+
+    // 各部分结果平移到帧坐标并跨切片合并，返回按置信度降序排列的结果
+    std::vector<Detection> merge(std::vector<Part>& parts) const;
+
+private:
+    bool enabled_ = false;
+    bool coarse_pass_ = true;
+    cv::Size input_size_;
+    cv::Size tile_size_;
+    float overlap_ = 0.2f;
+    float band_top_ = 0.3f;
+    float band_bottom_ = 0.7f;
+    float merge_threshold_ = 0.6f;
+};
+
+#endif // TILED_DETECTION_HPP
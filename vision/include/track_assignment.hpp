@@ -0,0 +1,94 @@
+/**
+ * @file track_assignment.hpp
+ * @brief 轨迹与检测的空间门控和最优分配
+ * @author pengchengkang
+ * @date 2025-9-12
+ *
+ * 数据关联分为两步：
+ * - SpatialGrid：检测框按均匀网格分桶，每条轨迹只与相邻网格中的检测计算IOU，
+ *   生成稀疏的候选边，避免T×D的稠密IOU矩阵
+ * - LinearAssignment：在候选边上求最小代价完全分配(Hungarian/Jonker-Volgenant最短增广路)。
+ *   候选边先按连通分量拆分，拥挤场景中也只在互相重叠的小团内求解，
+ *   每个分量使用连续存储的稠密代价矩阵
+ *
+ * 所有中间缓冲区均为成员变量，容量稳定后每帧不再分配内存。非线程安全。
+ */
+#ifndef TRACK_ASSIGNMENT_HPP
+#define TRACK_ASSIGNMENT_HPP
+
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <opencv2/opencv.hpp>
+
+// 分配问题中的一条候选边(行=轨迹，列=检测)
+struct AssignmentEdge {
+    int row = 0;
+    int col = 0;
+    float cost = 0.0f;
+};
+
+// 两个边界框的交并比
+float boxIoU(const cv::Rect2f& a, const cv::Rect2f& b);
+
+// 均匀网格空间索引，用于门控轨迹与检测的候选对
+class SpatialGrid {
+public:
+    // 以检测框构建网格，单元尺寸取检测框平均尺寸
+    void build(const std::vector<cv::Rect2f>& boxes);
+
+    // 查询与box所在网格相交的元素下标，结果追加到out(去重)
+    void query(const cv::Rect2f& box, std::vector<int>& out);
+
+private:
+    float origin_x_ = 0.0f;
+    float origin_y_ = 0.0f;
+    float cell_size_ = 1.0f;
+    int cols_ = 0;
+    int rows_ = 0;
+    std::vector<int> cell_start_;     // CSR：每个单元在cell_items_中的起始位置
+    std::vector<int> cell_items_;
+    std::vector<int> cell_fill_;
+    std::vector<uint32_t> visit_stamp_;
+    uint32_t stamp_ = 0;
+
+    void cellRange(const cv::Rect2f& box, int& c0, int& r0, int& c1, int& r1) const;
+};
+
+// 稀疏候选边上的最小代价分配
+class LinearAssignment {
+public:
+    /**
+     * @brief 求解分配问题
+     * @param rows 行数(轨迹数)
+     * @param cols 列数(检测数)
+     * @param edges 候选边，不在其中的行列对不可分配
+     * @param matches 输出匹配(row, col)，按行升序
+     */
+    void solve(int rows, int cols, const std::vector<AssignmentEdge>& edges,
+               std::vector<std::pair<int, int>>& matches);
+
+private:
+    // 并查集，节点0..rows-1为行，rows..rows+cols-1为列
+    std::vector<int> parent_;
+    std::vector<int> edge_order_;
+    std::vector<int> edge_root_;
+    std::vector<int> local_row_;
+    std::vector<int> local_col_;
+    std::vector<int> row_ids_;
+    std::vector<int> col_ids_;
+
+    // 稠密子问题缓冲区
+    std::vector<double> cost_;        // 双精度，避免不可行代价吞掉有效代价的精度
+    std::vector<double> u_;
+    std::vector<double> v_;
+    std::vector<double> min_v_;
+    std::vector<int> p_;
+    std::vector<int> way_;
+    std::vector<uint8_t> used_;
+
+    int find(int x);
+    void solveDense(int n, int m, bool transposed, std::vector<std::pair<int, int>>& matches);
+};
+
+#endif // TRACK_ASSIGNMENT_HPP
@@ -0,0 +1,140 @@
+/**
+ * @file track_store.hpp
+ * @brief 轨迹槽位存储和结果快照池 - 稳态运行时跟踪不分配堆内存
+ * @author pengchengkang
+ * @date 2025-9-14
+ *
+ * - TrackStore：轨迹存放在稳定的槽位中，删除的槽位进入空闲链表供新轨迹复用，
+ *   槽位连同其轨迹环形缓冲区一起复用；槽位下标在轨迹生命周期内不变，
+ *   可直接作为滤波器、特征库等并行数组的下标
+ * - TrackSnapshotPool：跟踪器把确认轨迹拷贝到快照中发布给下游，
+ *   下游释放句柄后快照回到池中复用
+ *
+ * 两者均非线程安全，只在跟踪线程中使用；快照句柄可跨线程传递。
+ */
+#ifndef TRACK_STORE_HPP
+#define TRACK_STORE_HPP
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include "data_structs.hpp"
+
+// 槽位化的轨迹存储
+class TrackStore {
+public:
+    // 清空并设置新轨迹的轨迹点容量
+    void reset(size_t trajectory_capacity) {
+        trajectory_capacity_ = trajectory_capacity > 0 ? trajectory_capacity : 1;
+        slots_.clear();
+        active_.clear();
+        active_pos_.clear();
+        free_.clear();
+    }
+
+    // 释放全部轨迹，保留槽位内存
+    void clear() {
+        for (int slot : active_) {
+            active_pos_[slot] = -1;
+            free_.push_back(slot);
+        }
+        active_.clear();
+    }
+
+    // 分配槽位(优先复用空闲槽位)，返回的轨迹已重置为默认状态
+    int allocate() {
+        int slot;
+        if (!free_.empty()) {
+            slot = free_.back();
+            free_.pop_back();
+        } else {
+            slot = static_cast<int>(slots_.size());
+            slots_.emplace_back();
+            active_pos_.push_back(-1);
+        }
+
+        // 保留轨迹缓冲区，只重置其余字段
+        TrackedObject& track = slots_[slot];
+        TrajectoryBuffer trajectory = std::move(track.trajectory);
+        track = TrackedObject();
+        track.trajectory = std::move(trajectory);
+        if (track.trajectory.capacity() != trajectory_capacity_) {
+            track.trajectory.reset(trajectory_capacity_);
+        } else {
+            track.trajectory.clear();
+        }
+
+        active_pos_[slot] = static_cast<int>(active_.size());
+        active_.push_back(slot);
+        return slot;
+    }
+
+    // 释放槽位
+    void release(int slot) {
+        const int pos = active_pos_[slot];
+        const int last = active_.back();
+        active_[pos] = last;
+        active_pos_[last] = pos;
+        active_.pop_back();
+        active_pos_[slot] = -1;
+        free_.push_back(slot);
+    }
+
+    TrackedObject& operator[](int slot) { return slots_[slot]; }
+    const TrackedObject& operator[](int slot) const { return slots_[slot]; }
+
+    // 活动槽位下标(顺序不固定)
+    const std::vector<int>& active() const { return active_; }
+
+    // 槽位总数(含空闲槽位)，并行数组按此大小分配
+    size_t slotCount() const { return slots_.size(); }
+
+    size_t trajectoryCapacity() const { return trajectory_capacity_; }
+
+private:
+    std::vector<TrackedObject> slots_;
+    std::vector<int> active_;
+    std::vector<int> active_pos_;   // 槽位在active_中的位置，空闲为-1
+    std::vector<int> free_;
+    size_t trajectory_capacity_ = TrajectoryBuffer::kDefaultCapacity;
+};
+
+// 跟踪结果快照池
+class TrackSnapshotPool {
+public:
+    /**
+     * @brief 取一个下游不再持有的快照(count已清零)，池中没有时新建
+     * 快照数量由流水线中同时在途的帧数决定，预热后不再增长
+     */
+    std::shared_ptr<TrackSnapshot> acquire() {
+        for (auto& snapshot : pool_) {
+            if (snapshot.use_count() == 1) {
+                // 与下游释放句柄时的引用计数递减同步，确保其读取已完成
+                std::atomic_thread_fence(std::memory_order_acquire);
+                snapshot->count = 0;
+                return snapshot;
+            }
+        }
+        pool_.push_back(std::make_shared<TrackSnapshot>());
+        return pool_.back();
+    }
+
+    // 把轨迹追加到快照，复用已有元素的内存
+    static void append(TrackSnapshot& snapshot, const TrackedObject& track) {
+        if (snapshot.count < snapshot.tracks.size()) {
+            snapshot.tracks[snapshot.count] = track;
+        } else {
+            snapshot.tracks.push_back(track);
+        }
+        snapshot.count++;
+    }
+
+    void clear() {
+        pool_.clear();
+    }
+
+private:
+    std::vector<std::shared_ptr<TrackSnapshot>> pool_;
+};
+
+#endif // TRACK_STORE_HPP
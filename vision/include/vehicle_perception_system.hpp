@@ -8,7 +8,7 @@
  * 视频处理、目标检测、目标跟踪、行为分析和结果处理等功能的综合性感知系统。
  * 
  * 主要功能：
- * 1. 视频流处理：支持多种视频源输入，包括摄像头、视频文件等
+ * 1. 视频流处理：支持多种视频源输入，包括摄像头、视频文件等，支持多路相机
  * 2. 目标检测：实时检测车辆、行人、非机动车等目标
  * 3. 目标跟踪：对检测到的目标进行持续跟踪，维护目标轨迹
  * 4. 行为分析：分析目标行为模式，评估风险等级
@@ -17,7 +17,7 @@
  * 
  * 系统特点：
  * - 模块化设计，各功能模块松耦合
- * - 支持多线程处理，提高系统效率
+ * - 多级流水线处理，推理与跟踪、输出重叠执行，有状态模块按帧序处理
  * - 提供完整的生命周期管理
  * - 支持动态配置更新
  * - 提供丰富的回调接口
@@ -31,14 +31,22 @@
 #include <functional>
 #include <string>
 #include <atomic>
+#include <chrono>
 #include <mutex>
 #include <condition_variable>
+#include <optional>
+#include <thread>
 
 #include "config.hpp"
 #include "data_structs.hpp"
 #include "module_interface.hpp"
 #include "logger.hpp"
-#include "thread_pool.hpp"
+#include "callback_slot.hpp"
+#include "frame_pipeline.hpp"
+#include "metrics_exporter.hpp"
+#include "frame_tracer.hpp"
+#include "detection_scheduler.hpp"
+#include "tiled_detection.hpp"
 
 // 系统状态枚举
 enum class SystemState {
@@ -51,14 +59,31 @@ enum class SystemState {
 
 // 系统性能统计
 struct SystemPerformance {
-    float fps;                       // 帧率
-    float detection_time_ms;         // 检测时间(毫秒)
-    float tracking_time_ms;          // 跟踪时间(毫秒)
-    float analysis_time_ms;          // 分析时间(毫秒)
-    float total_latency_ms;          // 总延迟(毫秒)
-    float cpu_usage;                 // CPU使用率(%)
-    float gpu_usage;                 // GPU使用率(%)
+    float fps;                       // 帧率(墙钟吞吐量)
+    float detection_time_ms;         // 检测时间(毫秒，区间均值，含预处理和后处理)
+    float tracking_time_ms;          // 跟踪时间(毫秒，区间均值)
+    float analysis_time_ms;          // 分析时间(毫秒，区间均值)
+    float total_latency_ms;          // 采集到结果的延迟(毫秒，区间均值)
+    float latency_p50_ms;            // 采集到结果的延迟p50(毫秒)
+    float latency_p99_ms;            // 采集到结果的延迟p99(毫秒)
+    float latency_max_ms;            // 采集到结果的最大延迟(毫秒)
+    float detection_p99_ms;          // 推理耗时p99(毫秒)
+    float cpu_usage;                 // CPU使用率(%，100为占满一个核心，无法获取时为-1)
+    float gpu_usage;                 // GPU使用率(%，无法获取时为-1)
     size_t memory_usage_mb;          // 内存使用(MB)
+    uint64_t frames_submitted;       // 提交到流水线的帧数
+    uint64_t frames_dropped;         // 因过载丢弃的帧数
+};
+
+// 启动各阶段耗时(毫秒)，检测器加载与视频源初始化并行，modules_ms为两者的墙钟耗时
+struct StartupTimings {
+    float detector_load_ms = 0.0f;   // 加载检测器(含引擎缓存读取或构建)
+    float warmup_ms = 0.0f;          // 预热推理
+    float streams_ms = 0.0f;         // 打开视频源并初始化跟踪、分析和输出模块
+    float modules_ms = 0.0f;         // 全部模块初始化
+    float pipeline_ms = 0.0f;        // 构建流水线
+    float initialize_ms = 0.0f;      // initialize()总耗时
+    float first_result_ms = -1.0f;   // initialize()开始到第一帧结果输出，尚未输出时为-1
 };
 
 // 系统主类
@@ -95,12 +120,28 @@ public:
     // 获取系统配置
     const SystemConfig& getConfig() const;
     
-    // 更新系统配置
+    /**
+     * @brief 更新系统配置
+     *
+     * 按变化范围选择最小的生效方式：
+     * - 只有检测、跟踪的阈值、max_age/min_hits和行为判定阈值变化时，发布参数快照，
+     *   各级在下一帧开始前应用，不重新初始化，轨迹和视频源不受影响
+     * - 检测模型相关参数变化时在后台线程构建并预热新检测器，完成后在帧边界替换，
+     *   替换前已预处理的帧仍由旧检测器推理；构建失败时保留旧检测器
+     * - 其他变化(视频源、流水线、输出、跟踪器类型等)停止视频源并重建全部模块
+     * @return 配置是否被接受(后台重建的结果见日志)
+     */
     bool updateConfig(const SystemConfig& config);
     
-    // 获取最后一帧的分析结果
+    // 获取最后一帧的分析结果(多路模式下为各路最后一帧结果的合并，按stream_id区分)
     std::vector<BehaviorAnalysis> getLastResults() const;
     
+    // 视频流数量
+    size_t streamCount() const;
+    
+    // 所有视频源是否均为文件且已读完(回放结束，调用stop()即可处理完剩余帧)
+    bool inputFinished() const;
+    
     // 注册结果回调函数
     void registerResultCallback(
         std::function<void(const std::vector<BehaviorAnalysis>&)> callback);
@@ -112,6 +153,9 @@ public:
     // 获取系统性能统计
     SystemPerformance getPerformanceStats() const;
     
+    // 获取最近一次initialize()的各阶段耗时
+    StartupTimings getStartupTimings() const;
+    
     // 重置系统
     bool reset();
     
@@ -122,29 +166,76 @@ private:
     // 系统状态
     std::atomic<SystemState> state_;
     
-    // 核心模块
-    std::unique_ptr<IVideoProcessor> video_processor_;
-    std::unique_ptr<IObjectDetector> object_detector_;
-    std::unique_ptr<IObjectTracker> object_tracker_;
-    std::unique_ptr<IBehaviorAnalyzer> behavior_analyzer_;
-    std::unique_ptr<IResultProcessor> result_processor_;
+    // 单路视频流的模块，跟踪、分析和输出状态按流隔离
+    struct Stream {
+        int id = 0;
+        std::string name;
+        std::unique_ptr<IVideoProcessor> video_processor;
+        std::unique_ptr<IObjectTracker> object_tracker;
+        std::unique_ptr<IBehaviorAnalyzer> behavior_analyzer;
+        std::unique_ptr<IResultProcessor> result_processor;
+        std::vector<BehaviorAnalysis> last_results;   // 受results_mutex_保护
+        uint64_t tracker_tuning = 0;                  // 跟踪器已应用的参数快照版本(跟踪级访问)
+        uint64_t analyzer_tuning = 0;                 // 分析器已应用的参数快照版本(分析级访问)
+    };
+    
+    // 无需重新初始化即可生效的参数，以不可变快照发布
+    struct LiveTuning {
+        uint64_t generation = 0;
+        float confidence_threshold = 0.0f;
+        float nms_threshold = 0.0f;
+        int max_age = 0;
+        int min_hits = 0;
+        float iou_threshold = 0.0f;
+        SystemConfig::BehaviorConfig behavior;
+    };
+    
+    // 核心模块，检测器和LLM增强器由所有视频流共享
+    std::vector<std::unique_ptr<Stream>> streams_;
+    std::shared_ptr<IObjectDetector> object_detector_;   // 经std::atomic_load/atomic_store访问，可热替换
     std::unique_ptr<ILLMEnhancer> llm_enhancer_;
     
-    // 线程池
-    std::unique_ptr<ThreadPool> thread_pool_;
+    // 帧处理流水线
+    std::unique_ptr<FramePipeline> pipeline_;
+    mutable std::mutex pipeline_mutex_;   // 保护pipeline_的替换，供指标采集线程读取
     
-    // 回调函数
-    std::function<void(const std::vector<BehaviorAnalysis>&)> result_callback_;
-    std::function<void(SystemState)> state_callback_;
-    mutable std::mutex callback_mutex_;
+    // 指标采样与导出
+    std::unique_ptr<MetricsExporter> metrics_exporter_;
     
-    // 最后结果缓存
-    std::vector<BehaviorAnalysis> last_results_;
-    mutable std::mutex results_mutex_;
+    // 抽样帧延迟追踪(trace.enable时创建)
+    std::unique_ptr<FrameTracer> frame_tracer_;
+    
+    // 自适应检测调度(scheduler配置)，决定每帧全图检测、ROI检测或只做跟踪外推
+    DetectionScheduler detection_scheduler_;
+    
+    // 切片推理(detector.tiling)的切片布局和跨切片合并
+    TiledDetection tiled_detection_;
+    
+    // 在线参数快照，版本号先于快照读取，未变化时各级只做一次原子读
+    std::shared_ptr<const LiveTuning> tuning_;
+    std::atomic<uint64_t> tuning_generation_{0};
+    uint64_t detector_tuning_ = 0;                   // 检测器已应用的快照版本(推理级访问)
+    std::weak_ptr<IObjectDetector> tuned_detector_;  // 已应用快照的检测器(推理级访问)
+    
+    // 后台重建检测器，重建期间到达的新配置在当前重建完成后处理
+    std::thread reload_thread_;
+    std::mutex reload_mutex_;
+    std::optional<SystemConfig::DetectorConfig> pending_detector_;   // 受reload_mutex_保护
+    cv::Size reload_frame_size_;                                     // 预热帧尺寸，受reload_mutex_保护
+    bool reload_active_ = false;                                     // 受reload_mutex_保护
     
-    // 性能统计
-    SystemPerformance performance_stats_;
-    mutable std::mutex performance_mutex_;
+    // 启动耗时，first_result_ms由输出级在第一帧结果时记录
+    StartupTimings startup_timings_;
+    std::chrono::steady_clock::time_point startup_begin_;
+    std::atomic<bool> first_result_pending_{false};
+    std::atomic<float> first_result_ms_{-1.0f};
+    
+    // 回调函数(原子指针发布，输出级每帧调用不加锁)
+    CallbackSlot<void(const std::vector<BehaviorAnalysis>&)> result_callback_;
+    CallbackSlot<void(SystemState)> state_callback_;
+    
+    // 最后结果缓存(见Stream::last_results)
+    mutable std::mutex results_mutex_;
     
     // 控制标志
     std::atomic<bool> running_;
@@ -152,8 +243,16 @@ private:
     std::condition_variable pause_cv_;
     std::mutex pause_mutex_;
     
-    // 处理帧的函数
-    void processFrame(const cv::Mat& frame, uint64_t timestamp);
+    // 流水线各级处理函数
+    void preprocessStage(FrameContext& context);
+    void inferenceStage(FrameContext& context);
+    void inferenceBatchStage(std::vector<FrameContext>& batch);
+    
+    // 一组帧的粗检测和切片输入拼成一批推理，结果合并回各帧
+    void detectFrames(FrameContext* const* frames, size_t count);
+    void trackStage(FrameContext& context);
+    void analyzeStage(FrameContext& context);
+    void outputStage(FrameContext& context);
     
     // 更新系统状态
     void setState(SystemState new_state);
@@ -161,12 +260,37 @@ private:
     // 初始化模块
     bool initializeModules();
     
+    // 初始化一路视频流
+    bool initializeStream(Stream& stream, const SystemConfig::StreamConfig& stream_config, bool multi_stream);
+    
+    // 启动/停止所有视频源
+    bool startVideo();
+    void stopVideo();
+    
+    // 按配置构建流水线
+    void buildPipeline();
+    
+    // 从config_发布在线参数快照
+    void publishTuning();
+    
+    // 快照版本比applied新时返回最新快照并更新applied，否则返回空
+    std::shared_ptr<const LiveTuning> pendingTuning(uint64_t& applied) const;
+    
+    // 在后台构建新检测器并在帧边界替换
+    void reloadDetector(const SystemConfig::DetectorConfig& config);
+    void reloadLoop();
+    
+    // 等待进行中的后台重建结束，丢弃尚未开始的重建
+    void joinReload();
+    
     // 重置性能统计
     void resetPerformanceStats();
     
-    // 更新性能统计
-    void updatePerformanceStats(float detection_ms, float tracking_ms, 
-                               float analysis_ms, float total_ms);
+    // 启动指标采样与导出
+    void startMetrics();
+    
+    // 记录一帧的各级耗时和端到端延迟
+    void updatePerformanceStats(const FrameContext& context);
 };
 
 #endif // VEHICLE_PERCEPTION_SYSTEM_HPP
@@ -0,0 +1,57 @@
+/**
+ * @file video_encoder.hpp
+ * @brief 输出视频编码器 - 优先使用硬件H.264编码，不可用时回退到软件编码
+ * @author pengchengkang
+ * @date 2025-9-16
+ *
+ * 编码模式(output.video_encoder)：
+ * - auto：依次尝试NVENC、VAAPI、FFmpeg硬件编码，最后软件编码
+ * - nvenc：GStreamer nvh264enc(独立显卡)或nvv4l2h264enc(Jetson)
+ * - vaapi：GStreamer vaapih264enc，其次FFmpeg VAAPI
+ * - cpu：FFmpeg软件H.264，编码器缺失时使用MPEG-4
+ * 输入为主机内存中的BGR帧。
+ */
+#ifndef VIDEO_ENCODER_HPP
+#define VIDEO_ENCODER_HPP
+
+#include <string>
+#include <opencv2/opencv.hpp>
+
+class VideoEncoder {
+public:
+    VideoEncoder() = default;
+    ~VideoEncoder() { close(); }
+    VideoEncoder(const VideoEncoder&) = delete;
+    VideoEncoder& operator=(const VideoEncoder&) = delete;
+
+    /**
+     * @brief 打开输出文件
+     * @param path 输出文件路径(.mp4)
+     * @param size 帧尺寸
+     * @param fps 帧率
+     * @param mode 编码模式: auto, nvenc, vaapi, cpu
+     * @param bitrate_kbps 硬件编码码率(kbps)
+     */
+    bool open(const std::string& path, const cv::Size& size, double fps,
+              const std::string& mode, int bitrate_kbps);
+
+    void write(const cv::Mat& frame);
+    void close();
+
+    bool isOpened() const { return writer_.isOpened(); }
+
+    // 实际使用的编码器名称(用于日志)
+    const std::string& name() const { return name_; }
+
+private:
+    bool openGStreamer(const std::string& encoder_chain, const char* name);
+    bool openFfmpeg(int fourcc, int acceleration, const char* name);
+
+    cv::VideoWriter writer_;
+    std::string name_;
+    std::string path_;
+    cv::Size size_;
+    double fps_ = 30.0;
+};
+
+#endif // VIDEO_ENCODER_HPP
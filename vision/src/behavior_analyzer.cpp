@@ -3,36 +3,133 @@
  * @brief 行为分析模块实现 - 目标行为识别和风险评估
  * @author pengchengkang
  * @date 2025-9-7
- * 
+ *
  * 功能描述：
  * - 分析行人、非机动车和动物的行为模式
  * - 基于运动特征进行行为分类
  * - 实时风险等级评估和碰撞时间预测
  * - 支持多种危险行为的检测和预警
+ *
+ * 每条轨迹的运动特征(最近三段航向、转向角、加速度)随新轨迹点增量更新，O(1)；
+ * 每帧先把全部轨迹的特征收集到连续数组，再在无分支循环中统一求碰撞时间、
+ * 行为类别和风险等级，最后一次性生成结果(目标较多时在共享线程池中分块并行生成)。
+ *
+ * 测距：ground_plane模式按相机几何预计算的逐行查找表由目标框底边查距离，
+ * bbox模式按框高反比估算。碰撞时间由α-β滤波跟踪的距离变化率(按真实时间戳)求得。
  */
 
 #include "module_interface.hpp"
+#include "static_pipeline.hpp"
+#include "ground_plane.hpp"
 #include "logger.hpp"
+#include "thread_pool.hpp"
 #include <opencv2/opencv.hpp>
 #include <cmath>
+#include <unordered_map>
+
+namespace {
+
+// 运动类别分组
+enum MotionGroup : uint8_t {
+    kGroupPedestrian = 0,
+    kGroupNonMotor,
+    kGroupAnimal,
+    kGroupOther
+};
+
+// 未知类别的行为编码(结果中记为PEDESTRIAN_STANDING/"unknown")
+constexpr int kUnknownBehavior = static_cast<int>(BehaviorType::ANIMAL_ENTERING_ROAD) + 1;
+constexpr int kBehaviorCodes = kUnknownBehavior + 1;
+
+// 并行生成结果的分块大小，目标数不超过该值时在当前线程直接执行
+constexpr size_t kResultGrain = 128;
+
+// 按行为编码索引的名称、置信度和是否属于危险行为
+const char* const kBehaviorNames[kBehaviorCodes] = {
+    "standing", "walking", "running", "crossing", "loitering",
+    "stopped", "moving", "speeding", "sudden_brake", "sudden_turn", "reversing",
+    "stationary", "moving", "entering_road",
+    "unknown"
+};
+const float kBehaviorConfidence[kBehaviorCodes] = {
+    0.9f, 0.8f, 0.8f, 0.7f, 0.5f,
+    0.9f, 0.8f, 0.8f, 0.7f, 0.6f, 0.5f,
+    0.9f, 0.8f, 0.7f,
+    0.5f
+};
+const uint8_t kBehaviorRisky[kBehaviorCodes] = {
+    0, 0, 1, 1, 0,
+    0, 0, 1, 1, 1, 0,
+    0, 0, 1,
+    0
+};
+
+constexpr float kRadToDeg = 180.0f / static_cast<float>(CV_PI);
+
+// 距离α-β滤波增益
+constexpr float kRangeAlpha = 0.5f;
+constexpr float kRangeBeta = 0.1f;
+
+// 接近速度低于此值(米/秒)时认为无碰撞风险
+constexpr float kMinClosingSpeed = 0.1f;
+
+// 两个航向角(度)之间的夹角，范围[0, 180]
+inline float headingDifference(float a, float b) {
+    float d = std::fmod(std::abs(a - b), 360.0f);
+    return d > 180.0f ? 360.0f - d : d;
+}
+
+} // namespace
 
 /**
  * @brief 行为分析器实现类
  * 基于轨迹分析和运动模式识别的行为分析系统
  */
-class BehaviorAnalyzer : public IBehaviorAnalyzer {
+class BehaviorAnalyzer final : public IBehaviorAnalyzer {
 private:
+    // 单条轨迹的增量运动特征
+    struct MotionState {
+        int age = -1;                 // 最近一次更新时的轨迹年龄，用于识别新轨迹点
+        float headings[3] = {0, 0, 0}; // 最近三段的航向(度)，环形存储
+        int heading_count = 0;
+        int heading_next = 0;
+        uint64_t frame = 0;           // 最近一次出现的分析帧序号
+        
+        float range = 0.0f;           // 滤波后的距离(米)
+        float range_rate = 0.0f;      // 距离变化率(米/秒，负值为接近)
+        uint64_t range_timestamp = 0; // 最近一次距离观测的时间戳(毫秒)
+        bool has_range = false;
+    };
+
     SystemConfig::BehaviorConfig config_;
     CameraParams camera_params_;
     VehicleParams vehicle_params_;
     float vehicle_speed_kmh_;
-    
+    GroundPlaneModel ground_plane_;
+    bool use_ground_plane_;
+
+    std::unordered_map<int, MotionState> motion_;
+    uint64_t frame_index_;
+
+    // 每帧按轨迹排列的特征和结果(结构数组)
+    std::vector<uint8_t> group_;
+    std::vector<float> speed_;
+    std::vector<float> accel_;
+    std::vector<float> turn_;
+    std::vector<uint8_t> crossing_;
+    std::vector<float> distance_;
+    std::vector<float> range_;
+    std::vector<float> closing_;
+    std::vector<float> ttc_;
+    std::vector<int> behavior_;
+    std::vector<int> risk_;
+
 public:
     /**
      * @brief 构造函数，初始化行为分析器
      */
-    BehaviorAnalyzer() : vehicle_speed_kmh_(0.0f) {}
-    
+    BehaviorAnalyzer() : vehicle_speed_kmh_(0.0f), use_ground_plane_(false), frame_index_(0) {}
+
     /**
      * @brief 初始化行为分析器
      * @param config 行为分析配置参数
@@ -46,232 +143,287 @@ public:
         config_ = config;
         camera_params_ = camera_params;
         vehicle_params_ = vehicle_params;
-        
+        motion_.clear();
+        frame_index_ = 0;
+
+        use_ground_plane_ = false;
+        if (config.distance_model == "ground_plane") {
+            use_ground_plane_ = ground_plane_.initialize(camera_params, config.max_distance);
+            if (use_ground_plane_) {
+                LOG_INFO("Ground-plane distance model: {} rows (camera height {}m, pitch {}deg)",
+                         ground_plane_.rows(), camera_params.height, camera_params.pitch);
+            } else {
+                LOG_WARN("Camera parameters insufficient for ground-plane model (need height and fy or fov_v/cy), using bbox model");
+            }
+        }
+
         LOG_INFO("Behavior analyzer initialized successfully");
-        LOG_INFO("High risk distance: {}m, Collision TTC: {}s", 
+        LOG_INFO("High risk distance: {}m, Collision TTC: {}s",
                 config.high_risk_distance, config.collision_risk_ttc);
-        
+
         return true;
     }
-    
+
     /**
      * @brief 分析跟踪目标的行为模式
      * @param tracked_objects 跟踪目标列表
      * @return std::vector<BehaviorAnalysis> 行为分析结果列表
      */
-    std::vector<BehaviorAnalysis> analyze(const std::vector<TrackedObject>& tracked_objects) override {
+    std::vector<BehaviorAnalysis> analyze(TrackView tracked_objects) override {
         std::vector<BehaviorAnalysis> results;
-        results.reserve(tracked_objects.size());
-        
-        for (const auto& obj : tracked_objects) {
-            BehaviorAnalysis analysis = analyzeObject(obj);
-            results.push_back(analysis);
-        }
-        
+        analyze(tracked_objects, results);
         return results;
     }
-    
+
+    /**
+     * @brief 分析跟踪目标的行为模式，结果写入复用的缓冲区(字符串容量跨帧保留)
+     * @param tracked_objects 跟踪目标列表
+     * @param results 输出，调整为与tracked_objects等长并逐项覆盖
+     */
+    void analyze(TrackView tracked_objects, std::vector<BehaviorAnalysis>& results) {
+        const size_t n = tracked_objects.size();
+        frame_index_++;
+
+        gatherFeatures(tracked_objects);
+        evaluate(n);
+
+        results.resize(n);
+        ThreadPool::shared().parallelFor(0, n, kResultGrain, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const TrackedObject& obj = tracked_objects[i];
+                BehaviorAnalysis& analysis = results[i];
+                const int code = behavior_[i];
+                analysis.track_id = obj.track_id;
+                analysis.location = obj.detection.center;
+                analysis.timestamp = obj.last_updated;
+                analysis.distance_to_vehicle = distance_[i];
+                analysis.time_to_collision = ttc_[i];
+                analysis.behavior = code == kUnknownBehavior ? BehaviorType::PEDESTRIAN_STANDING
+                                                             : static_cast<BehaviorType>(code);
+                analysis.behavior_name = kBehaviorNames[code];
+                analysis.confidence = kBehaviorConfidence[code];
+                analysis.risk_level = static_cast<RiskLevel>(risk_[i]);
+                analysis.risk_description = getRiskDescription(analysis.risk_level);
+                // 以下字段由下游填写，复用的缓冲区中须清除上一帧的值
+                analysis.llm_analysis.clear();
+                analysis.stream_id = 0;
+                analysis.trace = FrameTrace();
+            }
+        });
+
+        pruneMotionStates();
+    }
+
+    void setThresholds(const SystemConfig::BehaviorConfig& config) override {
+        // 测距上限和测距模型影响地面距离表，只能经initialize()修改
+        config_.high_risk_distance = config.high_risk_distance;
+        config_.collision_risk_ttc = config.collision_risk_ttc;
+        config_.pedestrian_running_threshold = config.pedestrian_running_threshold;
+        config_.non_motor_speeding_threshold = config.non_motor_speeding_threshold;
+    }
+
     void setVehicleSpeed(float speed_kmh) override {
         vehicle_speed_kmh_ = speed_kmh;
     }
-    
+
     float getVehicleSpeed() const override {
         return vehicle_speed_kmh_;
     }
-    
+
 private:
     /**
-     * @brief 分析单个目标的行为
-     * @param obj 跟踪目标对象
-     * @return BehaviorAnalysis 行为分析结果
+     * @brief 收集每条轨迹的特征，新轨迹点到达时增量更新航向窗口
      */
-    BehaviorAnalysis analyzeObject(const TrackedObject& obj) {
-        BehaviorAnalysis analysis;
-        analysis.track_id = obj.track_id;
-        analysis.location = obj.detection.center;
-        analysis.timestamp = obj.last_updated;
-        
-        // 估算距离（简化计算）
-        analysis.distance_to_vehicle = estimateDistance(obj.detection.bbox);
-        
-        // 根据目标类别分析行为
-        switch (obj.detection.class_id) {
-            case ObjectClass::PEDESTRIAN:
-                analysis = analyzePedestrianBehavior(obj, analysis);
-                break;
-            case ObjectClass::CYCLIST:
-            case ObjectClass::MOTORCYCLIST:
-            case ObjectClass::BICYCLE:
-            case ObjectClass::MOTORCYCLE:
-            case ObjectClass::TRICYCLE:
-                analysis = analyzeNonMotorBehavior(obj, analysis);
-                break;
-            case ObjectClass::ANIMAL:
-                analysis = analyzeAnimalBehavior(obj, analysis);
-                break;
-            default:
-                analysis.behavior = BehaviorType::PEDESTRIAN_STANDING;
-                analysis.behavior_name = "unknown";
-                analysis.confidence = 0.5f;
-                break;
+    void gatherFeatures(TrackView tracked_objects) {
+        const size_t n = tracked_objects.size();
+        group_.resize(n);
+        speed_.resize(n);
+        accel_.resize(n);
+        turn_.resize(n);
+        crossing_.resize(n);
+        distance_.resize(n);
+        range_.resize(n);
+        closing_.resize(n);
+
+        for (size_t i = 0; i < n; ++i) {
+            const TrackedObject& obj = tracked_objects[i];
+            const TrajectoryBuffer& trajectory = obj.trajectory;
+            MotionState& state = motion_[obj.track_id];
+            state.frame = frame_index_;
+            if (state.age != obj.age) {
+                updateHeadings(state, trajectory, obj.age - state.age);
+                state.age = obj.age;
+            }
+
+            group_[i] = motionGroup(obj.detection.class_id);
+            speed_[i] = obj.speed;   // 像素/帧转换为实际速度需要标定
+
+            // 每个新观测更新一次距离滤波
+            const float distance = estimateDistance(obj.detection.bbox);
+            distance_[i] = distance;
+            if (!state.has_range || state.range_timestamp != obj.last_updated) {
+                updateRange(state, distance, obj.last_updated);
+            }
+            range_[i] = state.range;
+            closing_[i] = -state.range_rate;
+
+            // 急刹车：加速度突变
+            accel_[i] = trajectory.size() >= 3 ? cv::norm(obj.acceleration) : 0.0f;
+
+            // 突然转向：最近一段与两段之前的航向夹角
+            turn_[i] = (trajectory.size() >= 5 && state.heading_count == 3)
+                ? headingDifference(state.headings[(state.heading_next + 2) % 3],
+                                    state.headings[state.heading_next])
+                : 0.0f;
+
+            // 横穿马路：轨迹窗口内以水平位移为主
+            crossing_[i] = 0;
+            if (trajectory.size() >= 3) {
+                const cv::Point2f movement = trajectory.back() - trajectory.front();
+                const float horizontal_movement = std::abs(movement.x);
+                const float vertical_movement = std::abs(movement.y);
+                crossing_[i] = horizontal_movement > vertical_movement * 2 && horizontal_movement > 20;
+            }
         }
-        
-        // 评估风险等级
-        analysis.risk_level = assessRiskLevel(obj, analysis);
-        analysis.risk_description = getRiskDescription(analysis.risk_level);
-        
-        // 计算碰撞时间
-        analysis.time_to_collision = calculateTimeToCollision(obj);
-        
-        return analysis;
     }
-    
+
     /**
-     * @brief 分析行人行为模式
-     * @param obj 跟踪目标对象
-     * @param analysis 初始分析结果
-     * @return BehaviorAnalysis 更新后的分析结果
+     * @brief 追加最近steps段的航向(新轨迹或跳帧时从轨迹尾部重建，最多3段)
      */
-    BehaviorAnalysis analyzePedestrianBehavior(const TrackedObject& obj, BehaviorAnalysis analysis) {
-        float speed_ms = obj.speed; // 像素/帧转换为实际速度需要标定
-        
-        if (speed_ms < 0.5f) {
-            analysis.behavior = BehaviorType::PEDESTRIAN_STANDING;
-            analysis.behavior_name = "standing";
-            analysis.confidence = 0.9f;
-        } else if (speed_ms < config_.pedestrian_running_threshold) {
-            analysis.behavior = BehaviorType::PEDESTRIAN_WALKING;
-            analysis.behavior_name = "walking";
-            analysis.confidence = 0.8f;
-        } else {
-            analysis.behavior = BehaviorType::PEDESTRIAN_RUNNING;
-            analysis.behavior_name = "running";
-            analysis.confidence = 0.8f;
+    void updateHeadings(MotionState& state, const TrajectoryBuffer& trajectory, int steps) {
+        const int segments = static_cast<int>(trajectory.size()) - 1;
+        if (state.age < 0 || steps <= 0 || steps > 3) {
+            state.heading_count = 0;
+            state.heading_next = 0;
+            steps = 3;
         }
-        
-        // 检测横穿马路行为
-        if (obj.trajectory.size() >= 3) {
-            cv::Point2f movement = obj.trajectory.back() - obj.trajectory.front();
-            float horizontal_movement = std::abs(movement.x);
-            float vertical_movement = std::abs(movement.y);
-            
-            if (horizontal_movement > vertical_movement * 2 && horizontal_movement > 20) {
-                analysis.behavior = BehaviorType::PEDESTRIAN_CROSSING;
-                analysis.behavior_name = "crossing";
-                analysis.confidence = 0.7f;
-            }
+        steps = std::min(steps, segments);
+        for (int k = steps; k >= 1; --k) {
+            const cv::Point2f movement = trajectory[segments - k + 1] - trajectory[segments - k];
+            state.headings[state.heading_next] = std::atan2(movement.y, movement.x) * kRadToDeg;
+            state.heading_next = (state.heading_next + 1) % 3;
+            state.heading_count = std::min(state.heading_count + 1, 3);
         }
-        
-        return analysis;
     }
-    
-    BehaviorAnalysis analyzeNonMotorBehavior(const TrackedObject& obj, BehaviorAnalysis analysis) {
-        float speed_ms = obj.speed;
-        
-        if (speed_ms < 0.5f) {
-            analysis.behavior = BehaviorType::NON_MOTOR_STOPPED;
-            analysis.behavior_name = "stopped";
-            analysis.confidence = 0.9f;
-        } else if (speed_ms < config_.non_motor_speeding_threshold) {
-            analysis.behavior = BehaviorType::NON_MOTOR_MOVING;
-            analysis.behavior_name = "moving";
-            analysis.confidence = 0.8f;
-        } else {
-            analysis.behavior = BehaviorType::NON_MOTOR_SPEEDING;
-            analysis.behavior_name = "speeding";
-            analysis.confidence = 0.8f;
+
+    /**
+     * @brief α-β滤波跟踪距离和距离变化率，dt取相邻观测的真实时间差
+     */
+    static void updateRange(MotionState& state, float distance, uint64_t timestamp) {
+        if (!state.has_range || timestamp <= state.range_timestamp) {
+            state.range = distance;
+            state.range_rate = 0.0f;
+            state.range_timestamp = timestamp;
+            state.has_range = true;
+            return;
         }
-        
-        // 检测急刹车
-        if (obj.trajectory.size() >= 3) {
-            float deceleration = cv::norm(obj.acceleration);
-            if (deceleration > 5.0f) {
-                analysis.behavior = BehaviorType::NON_MOTOR_SUDEN_BRAKE;
-                analysis.behavior_name = "sudden_brake";
-                analysis.confidence = 0.7f;
-            }
+        const float dt = (timestamp - state.range_timestamp) * 0.001f;
+        const float predicted = state.range + state.range_rate * dt;
+        const float residual = distance - predicted;
+        state.range = predicted + kRangeAlpha * residual;
+        state.range_rate += kRangeBeta * residual / dt;
+        state.range_timestamp = timestamp;
+    }
+
+    /**
+     * @brief 对全部轨迹统一计算碰撞时间、行为和风险，循环体无分支
+     */
+    void evaluate(size_t n) {
+        ttc_.resize(n);
+        behavior_.resize(n);
+        risk_.resize(n);
+
+        const float running = config_.pedestrian_running_threshold;
+        const float speeding = config_.non_motor_speeding_threshold;
+        const float high_risk = config_.high_risk_distance;
+        const float ttc_limit = config_.collision_risk_ttc;
+
+        const float* speed = speed_.data();
+        const float* distance = distance_.data();
+        const float* range = range_.data();
+        const float* closing = closing_.data();
+        float* ttc = ttc_.data();
+
+        // 碰撞时间：距离 / 接近速度，远离或静止时为-1
+        for (size_t i = 0; i < n; ++i) {
+            const float c = closing[i];
+            ttc[i] = c > kMinClosingSpeed ? range[i] / std::max(c, kMinClosingSpeed) : -1.0f;
         }
-        
-        // 检测突然转向
-        if (obj.trajectory.size() >= 5) {
-            std::vector<float> directions;
-            for (int i = 1; i < obj.trajectory.size(); ++i) {
-                cv::Point2f movement = obj.trajectory[i] - obj.trajectory[i-1];
-                float direction = std::atan2(movement.y, movement.x) * 180.0f / CV_PI;
-                directions.push_back(direction);
-            }
-            
-            if (directions.size() >= 3) {
-                float direction_change = std::abs(directions.back() - directions[directions.size()-3]);
-                if (direction_change > 45.0f) {
-                    analysis.behavior = BehaviorType::NON_MOTOR_SUDEN_TURN;
-                    analysis.behavior_name = "sudden_turn";
-                    analysis.confidence = 0.6f;
-                }
-            }
+
+        // 行为分类与风险等级
+        for (size_t i = 0; i < n; ++i) {
+            const float s = speed[i];
+            const int pedestrian = crossing_[i] ? static_cast<int>(BehaviorType::PEDESTRIAN_CROSSING)
+                : (s < 0.5f ? static_cast<int>(BehaviorType::PEDESTRIAN_STANDING)
+                   : (s < running ? static_cast<int>(BehaviorType::PEDESTRIAN_WALKING)
+                      : static_cast<int>(BehaviorType::PEDESTRIAN_RUNNING)));
+            const int non_motor = turn_[i] > 45.0f ? static_cast<int>(BehaviorType::NON_MOTOR_SUDEN_TURN)
+                : (accel_[i] > 5.0f ? static_cast<int>(BehaviorType::NON_MOTOR_SUDEN_BRAKE)
+                   : (s < 0.5f ? static_cast<int>(BehaviorType::NON_MOTOR_STOPPED)
+                      : (s < speeding ? static_cast<int>(BehaviorType::NON_MOTOR_MOVING)
+                         : static_cast<int>(BehaviorType::NON_MOTOR_SPEEDING))));
+            const int animal = s < 0.5f ? static_cast<int>(BehaviorType::ANIMAL_STATIONARY)
+                : (distance[i] < high_risk ? static_cast<int>(BehaviorType::ANIMAL_ENTERING_ROAD)
+                   : static_cast<int>(BehaviorType::ANIMAL_MOVING));
+            const uint8_t g = group_[i];
+            const int code = g == kGroupPedestrian ? pedestrian
+                : (g == kGroupNonMotor ? non_motor : (g == kGroupAnimal ? animal : kUnknownBehavior));
+            behavior_[i] = code;
+
+            // 距离优先，其次碰撞时间，最后按行为评估
+            const float d = distance[i];
+            const float t = ttc[i];
+            const int by_behavior = kBehaviorRisky[code] ? static_cast<int>(RiskLevel::MEDIUM_RISK)
+                                                         : static_cast<int>(RiskLevel::LOW_RISK);
+            const int by_ttc = (t > 0.0f && t < ttc_limit) ? static_cast<int>(RiskLevel::HIGH_RISK)
+                : ((t > 0.0f && t < ttc_limit * 2) ? static_cast<int>(RiskLevel::MEDIUM_RISK) : by_behavior);
+            risk_[i] = d < 5.0f ? static_cast<int>(RiskLevel::CRITICAL_RISK)
+                : (d < high_risk ? static_cast<int>(RiskLevel::HIGH_RISK)
+                   : (d < high_risk * 2 ? static_cast<int>(RiskLevel::MEDIUM_RISK) : by_ttc));
         }
-        
-        return analysis;
     }
-    
-    BehaviorAnalysis analyzeAnimalBehavior(const TrackedObject& obj, BehaviorAnalysis analysis) {
-        float speed_ms = obj.speed;
-        
-        if (speed_ms < 0.5f) {
-            analysis.behavior = BehaviorType::ANIMAL_STATIONARY;
-            analysis.behavior_name = "stationary";
-            analysis.confidence = 0.9f;
-        } else {
-            analysis.behavior = BehaviorType::ANIMAL_MOVING;
-            analysis.behavior_name = "moving";
-            analysis.confidence = 0.8f;
-            
-            // 检测是否闯入道路
-            if (analysis.distance_to_vehicle < config_.high_risk_distance) {
-                analysis.behavior = BehaviorType::ANIMAL_ENTERING_ROAD;
-                analysis.behavior_name = "entering_road";
-                analysis.confidence = 0.7f;
+
+    // 删除本帧未出现的轨迹状态(确认轨迹只有在被跟踪器删除后才会从结果中消失)
+    void pruneMotionStates() {
+        for (auto it = motion_.begin(); it != motion_.end();) {
+            if (it->second.frame != frame_index_) {
+                it = motion_.erase(it);
+            } else {
+                ++it;
             }
         }
-        
-        return analysis;
     }
-    
-    RiskLevel assessRiskLevel(const TrackedObject& obj, const BehaviorAnalysis& analysis) {
-        float distance = analysis.distance_to_vehicle;
-        float ttc = analysis.time_to_collision;
-        
-        // 基于距离的风险评估
-        if (distance < 5.0f) {
-            return RiskLevel::CRITICAL_RISK;
-        } else if (distance < config_.high_risk_distance) {
-            return RiskLevel::HIGH_RISK;
-        } else if (distance < config_.high_risk_distance * 2) {
-            return RiskLevel::MEDIUM_RISK;
-        }
-        
-        // 基于碰撞时间的风险评估
-        if (ttc > 0 && ttc < config_.collision_risk_ttc) {
-            return RiskLevel::HIGH_RISK;
-        } else if (ttc > 0 && ttc < config_.collision_risk_ttc * 2) {
-            return RiskLevel::MEDIUM_RISK;
+
+    /**
+     * @brief 估算目标距离(米)
+     * ground_plane模式查框底边所在行的距离表；否则按框高反比估算(未标定时的近似)
+     */
+    float estimateDistance(const cv::Rect2f& bbox) const {
+        if (use_ground_plane_) {
+            return ground_plane_.distanceAtRow(bbox.y + bbox.height);
         }
-        
-        // 基于行为的风险评估
-        switch (analysis.behavior) {
-            case BehaviorType::PEDESTRIAN_RUNNING:
-            case BehaviorType::PEDESTRIAN_CROSSING:
-            case BehaviorType::NON_MOTOR_SPEEDING:
-            case BehaviorType::NON_MOTOR_SUDEN_BRAKE:
-            case BehaviorType::NON_MOTOR_SUDEN_TURN:
-            case BehaviorType::ANIMAL_ENTERING_ROAD:
-                return RiskLevel::MEDIUM_RISK;
+        float estimated_distance = 1000.0f / (bbox.height + 1.0f);
+        return std::max(1.0f, std::min(config_.max_distance, estimated_distance));
+    }
+
+    static uint8_t motionGroup(ObjectClass class_id) {
+        switch (class_id) {
+            case ObjectClass::PEDESTRIAN:
+                return kGroupPedestrian;
+            case ObjectClass::CYCLIST:
+            case ObjectClass::MOTORCYCLIST:
+            case ObjectClass::BICYCLE:
+            case ObjectClass::MOTORCYCLE:
+            case ObjectClass::TRICYCLE:
+                return kGroupNonMotor;
+            case ObjectClass::ANIMAL:
+                return kGroupAnimal;
             default:
-                return RiskLevel::LOW_RISK;
+                return kGroupOther;
         }
     }
-    
-    std::string getRiskDescription(RiskLevel risk) {
+
+    static const char* getRiskDescription(RiskLevel risk) {
         switch (risk) {
             case RiskLevel::SAFE: return "Safe";
             case RiskLevel::LOW_RISK: return "Low risk";
@@ -281,52 +433,23 @@ private:
             default: return "Unknown risk";
         }
     }
-    
-    /**
-     * @brief 估算目标距离
-     * @param bbox 目标边界框
-     * @return float 估算距离（米）
-     */
-    float estimateDistance(const cv::Rect2f& bbox) {
-        // 简化的距离估算，基于边界框大小
-        // 实际应用中需要相机标定和更精确的计算
-        float bbox_height = bbox.height;
-        float estimated_distance = 1000.0f / (bbox_height + 1.0f); // 简单的反比例关系
-        return std::max(1.0f, std::min(50.0f, estimated_distance));
-    }
-    
-    /**
-     * @brief 计算碰撞时间（TTC）
-     * @param obj 跟踪目标对象
-     * @return float 碰撞时间（秒），-1表示无碰撞风险
-     */
-    float calculateTimeToCollision(const TrackedObject& obj) {
-        if (obj.speed <= 0.1f || vehicle_speed_kmh_ <= 0.1f) {
-            return -1.0f; // 无碰撞风险
-        }
-        
-        // 简化的TTC计算
-        float distance = estimateDistance(obj.detection.bbox);
-        float relative_speed = vehicle_speed_kmh_ / 3.6f; // 转换为m/s
-        
-        // 考虑目标的运动方向
-        float approach_speed = relative_speed;
-        if (obj.direction > -45 && obj.direction < 45) {
-            // 目标向右移动，可能远离
-            approach_speed -= obj.speed * 0.1f; // 简化转换
-        } else if (obj.direction > 135 || obj.direction < -135) {
-            // 目标向左移动，可能接近
-            approach_speed += obj.speed * 0.1f;
-        }
-        
-        if (approach_speed <= 0) {
-            return -1.0f;
-        }
-        
-        return distance / approach_speed;
-    }
 };
 
+AnalyzerStage::AnalyzerStage() = default;
+AnalyzerStage::~AnalyzerStage() = default;
+AnalyzerStage::AnalyzerStage(AnalyzerStage&&) noexcept = default;
+AnalyzerStage& AnalyzerStage::operator=(AnalyzerStage&&) noexcept = default;
+
+bool AnalyzerStage::initialize(const SystemConfig::BehaviorConfig& config, const CameraParams& camera_params,
+                               const VehicleParams& vehicle_params) {
+    impl_ = std::make_unique<BehaviorAnalyzer>();
+    return impl_->initialize(config, camera_params, vehicle_params);
+}
+
+void AnalyzerStage::analyze(TrackView tracked_objects, std::vector<BehaviorAnalysis>& results) {
+    impl_->analyze(tracked_objects, results);
+}
+
 // 实现工厂函数
 std::unique_ptr<IBehaviorAnalyzer> IBehaviorAnalyzer::create() {
     return std::make_unique<BehaviorAnalyzer>();
@@ -0,0 +1,294 @@
+/**
+ * @file detection_decoder.cpp
+ * @brief YOLO系列网络输出解码与NMS实现
+ * @author pengchengkang
+ * @date 2025-9-10
+ *
+ * 转置布局[4+nc, anchors]中同一类别的分数是连续的一行，因此argmax按行进行：
+ * 对每个类别行，用SIMD一次比较多个anchor，更新各anchor的最大分数和类别。
+ * 这样访存完全顺序，且不需要为每个anchor构造临时矩阵。
+ */
+#include "detection_decoder.hpp"
+#include "logger.hpp"
+#include <algorithm>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+/**
+ * @brief 用一行类别分数更新每个anchor的最大分数和类别
+ * @param scores 类别cls的分数行(长度n)
+ * @param cls 类别下标
+ * @param n anchor数量
+ * @param best 各anchor当前最大分数
+ * @param best_class 各anchor当前最大分数对应的类别
+ */
+void updateArgmax(const float* scores, int cls, int n, float* best, int* best_class) {
+    int i = 0;
+#if defined(__AVX__)
+    const __m256 cls_vec = _mm256_castsi256_ps(_mm256_set1_epi32(cls));
+    for (; i + 8 <= n; i += 8) {
+        __m256 s = _mm256_loadu_ps(scores + i);
+        __m256 b = _mm256_loadu_ps(best + i);
+        __m256 mask = _mm256_cmp_ps(s, b, _CMP_GT_OQ);
+        _mm256_storeu_ps(best + i, _mm256_blendv_ps(b, s, mask));
+        __m256 c = _mm256_loadu_ps(reinterpret_cast<const float*>(best_class + i));
+        _mm256_storeu_ps(reinterpret_cast<float*>(best_class + i), _mm256_blendv_ps(c, cls_vec, mask));
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    const __m128i cls_vec = _mm_set1_epi32(cls);
+    for (; i + 4 <= n; i += 4) {
+        __m128 s = _mm_loadu_ps(scores + i);
+        __m128 b = _mm_loadu_ps(best + i);
+        __m128 mask = _mm_cmpgt_ps(s, b);
+        _mm_storeu_ps(best + i, _mm_or_ps(_mm_and_ps(mask, s), _mm_andnot_ps(mask, b)));
+        __m128i imask = _mm_castps_si128(mask);
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(best_class + i));
+        c = _mm_or_si128(_mm_and_si128(imask, cls_vec), _mm_andnot_si128(imask, c));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(best_class + i), c);
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    const int32x4_t cls_vec = vdupq_n_s32(cls);
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t s = vld1q_f32(scores + i);
+        float32x4_t b = vld1q_f32(best + i);
+        uint32x4_t mask = vcgtq_f32(s, b);
+        vst1q_f32(best + i, vbslq_f32(mask, s, b));
+        int32x4_t c = vld1q_s32(best_class + i);
+        vst1q_s32(best_class + i, vbslq_s32(mask, cls_vec, c));
+    }
+#endif
+    for (; i < n; ++i) {
+        if (scores[i] > best[i]) {
+            best[i] = scores[i];
+            best_class[i] = cls;
+        }
+    }
+}
+
+// 连续分数的argmax(行布局)
+inline int argmaxRow(const float* scores, int n, float& max_score) {
+    int best = 0;
+    float value = scores[0];
+    for (int i = 1; i < n; ++i) {
+        if (scores[i] > value) {
+            value = scores[i];
+            best = i;
+        }
+    }
+    max_score = value;
+    return best;
+}
+
+inline float iou(const DecodedBox& a, const DecodedBox& b) {
+    float ix1 = std::max(a.x1, b.x1);
+    float iy1 = std::max(a.y1, b.y1);
+    float ix2 = std::min(a.x2, b.x2);
+    float iy2 = std::min(a.y2, b.y2);
+    float iw = std::max(0.0f, ix2 - ix1);
+    float ih = std::max(0.0f, iy2 - iy1);
+    float inter = iw * ih;
+    float area_a = (a.x2 - a.x1) * (a.y2 - a.y1);
+    float area_b = (b.x2 - b.x1) * (b.y2 - b.y1);
+    float uni = area_a + area_b - inter;
+    return uni > 0.0f ? inter / uni : 0.0f;
+}
+
+} // namespace
+
+DetectionDecoder::DetectionDecoder()
+    : layout_(Layout::YOLOV8), input_size_(640, 640),
+      confidence_threshold_(0.5f), nms_threshold_(0.45f), max_detections_(300) {}
+
+DetectionDecoder::Layout DetectionDecoder::parseLayout(const std::string& model_type) {
+    std::string type = model_type;
+    std::transform(type.begin(), type.end(), type.begin(), ::tolower);
+
+    if (type == "yolov8" || type == "yolov9" || type == "yolo11" || type == "yolov11") {
+        return Layout::YOLOV8;
+    }
+    if (type == "yolov5" || type == "yolov7") {
+        return Layout::YOLOV5;
+    }
+    if (type == "darknet" || type == "yolov3" || type == "yolov4") {
+        return Layout::DARKNET;
+    }
+
+    LOG_WARN("Unknown model type {}, assuming yolov8 output layout", model_type);
+    return Layout::YOLOV8;
+}
+
+void DetectionDecoder::configure(const std::string& model_type, const cv::Size& input_size,
+                                 float confidence_threshold, float nms_threshold, int max_detections) {
+    layout_ = parseLayout(model_type);
+    input_size_ = input_size;
+    confidence_threshold_ = confidence_threshold;
+    nms_threshold_ = nms_threshold;
+    max_detections_ = std::max(1, max_detections);
+    results_.reserve(max_detections_);
+}
+
+const std::vector<DecodedBox>& DetectionDecoder::decode(const std::vector<cv::Mat>& outputs,
+                                                        const BoxTransform& transform) {
+    candidates_.clear();
+
+    for (const auto& output : outputs) {
+        if (output.empty() || output.type() != CV_32F) {
+            continue;
+        }
+        switch (layout_) {
+            case Layout::YOLOV8:
+                // 部分导出工具会把输出转置为[anchors, 4+nc]
+                if (output.rows < output.cols) {
+                    decodeChannelMajor(output, transform);
+                } else {
+                    decodeRowMajor(output, transform, false, false);
+                }
+                break;
+            case Layout::YOLOV5:
+                decodeRowMajor(output, transform, true, false);
+                break;
+            case Layout::DARKNET:
+                decodeRowMajor(output, transform, true, true);
+                break;
+        }
+    }
+
+    nonMaximumSuppression();
+    return results_;
+}
+
+void DetectionDecoder::decodeChannelMajor(const cv::Mat& output, const BoxTransform& transform) {
+    const int attrs = output.rows;
+    const int anchors = output.cols;
+    const int num_classes = attrs - 4;
+    if (num_classes <= 0) {
+        return;
+    }
+
+    const cv::Mat data = output.isContinuous() ? output : output.clone();
+    const float* base = data.ptr<float>();
+
+    best_score_.assign(anchors, 0.0f);
+    best_class_.assign(anchors, 0);
+    for (int c = 0; c < num_classes; ++c) {
+        updateArgmax(base + static_cast<size_t>(4 + c) * anchors, c, anchors,
+                     best_score_.data(), best_class_.data());
+    }
+
+    const float* cx = base;
+    const float* cy = base + anchors;
+    const float* w = base + 2 * static_cast<size_t>(anchors);
+    const float* h = base + 3 * static_cast<size_t>(anchors);
+    for (int i = 0; i < anchors; ++i) {
+        if (best_score_[i] < confidence_threshold_) {
+            continue;
+        }
+        addCandidate(cx[i], cy[i], w[i], h[i], best_score_[i], best_class_[i], transform);
+    }
+}
+
+void DetectionDecoder::decodeRowMajor(const cv::Mat& output, const BoxTransform& transform,
+                                      bool has_objectness, bool normalized) {
+    const int offset = has_objectness ? 5 : 4;
+    const int num_classes = output.cols - offset;
+    if (num_classes <= 0) {
+        return;
+    }
+
+    const float sx = normalized ? static_cast<float>(input_size_.width) : 1.0f;
+    const float sy = normalized ? static_cast<float>(input_size_.height) : 1.0f;
+
+    for (int i = 0; i < output.rows; ++i) {
+        const float* row = output.ptr<float>(i);
+
+        // objectness低于阈值时最终分数不可能达到阈值，直接跳过
+        float objectness = has_objectness ? row[4] : 1.0f;
+        if (objectness < confidence_threshold_) {
+            continue;
+        }
+
+        float class_score = 0.0f;
+        int class_index = argmaxRow(row + offset, num_classes, class_score);
+        float score = objectness * class_score;
+        if (score < confidence_threshold_) {
+            continue;
+        }
+
+        addCandidate(row[0] * sx, row[1] * sy, row[2] * sx, row[3] * sy, score, class_index, transform);
+    }
+}
+
+void DetectionDecoder::addCandidate(float cx, float cy, float w, float h, float score, int class_index,
+                                    const BoxTransform& transform) {
+    DecodedBox box;
+    box.x1 = ((cx - 0.5f * w) - transform.pad_x) / transform.scale_x;
+    box.y1 = ((cy - 0.5f * h) - transform.pad_y) / transform.scale_y;
+    box.x2 = ((cx + 0.5f * w) - transform.pad_x) / transform.scale_x;
+    box.y2 = ((cy + 0.5f * h) - transform.pad_y) / transform.scale_y;
+
+    if (transform.image_size.width > 0 && transform.image_size.height > 0) {
+        const float max_x = static_cast<float>(transform.image_size.width);
+        const float max_y = static_cast<float>(transform.image_size.height);
+        box.x1 = std::min(std::max(box.x1, 0.0f), max_x);
+        box.y1 = std::min(std::max(box.y1, 0.0f), max_y);
+        box.x2 = std::min(std::max(box.x2, 0.0f), max_x);
+        box.y2 = std::min(std::max(box.y2, 0.0f), max_y);
+    }
+    if (box.x2 <= box.x1 || box.y2 <= box.y1) {
+        return;
+    }
+
+    box.score = score;
+    box.class_index = class_index;
+    candidates_.push_back(box);
+}
+
+void DetectionDecoder::nonMaximumSuppression() {
+    results_.clear();
+    if (candidates_.empty()) {
+        return;
+    }
+
+    // 按类别分段、段内按分数降序，NMS只在同类框之间进行
+    std::sort(candidates_.begin(), candidates_.end(), [](const DecodedBox& a, const DecodedBox& b) {
+        return a.class_index != b.class_index ? a.class_index < b.class_index : a.score > b.score;
+    });
+    suppressed_.assign(candidates_.size(), 0);
+
+    const size_t n = candidates_.size();
+    size_t begin = 0;
+    while (begin < n) {
+        size_t end = begin;
+        while (end < n && candidates_[end].class_index == candidates_[begin].class_index) {
+            ++end;
+        }
+        for (size_t i = begin; i < end; ++i) {
+            if (suppressed_[i]) {
+                continue;
+            }
+            results_.push_back(candidates_[i]);
+            for (size_t j = i + 1; j < end; ++j) {
+                if (!suppressed_[j] && iou(candidates_[i], candidates_[j]) > nms_threshold_) {
+                    suppressed_[j] = 1;
+                }
+            }
+        }
+        begin = end;
+    }
+
+    // 合并各类别结果，保留分数最高的max_detections个
+    std::sort(results_.begin(), results_.end(), [](const DecodedBox& a, const DecodedBox& b) {
+        return a.score > b.score;
+    });
+    if (results_.size() > static_cast<size_t>(max_detections_)) {
+        results_.resize(max_detections_);
+    }
+}
@@ -0,0 +1,179 @@
+/**
+ * @file detection_scheduler.cpp
+ * @brief 自适应检测调度实现
+ * @author pengchengkang
+ * @date 2025-9-16
+ */
+#include "detection_scheduler.hpp"
+#include "logger.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// 检测耗时滑动平均的权重
+constexpr float kCostSmoothing = 0.1f;
+
+} // namespace
+
+void DetectionScheduler::configure(const SystemConfig::SchedulerConfig& config, size_t stream_count) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    config_ = config;
+    enabled_.store(config.enable, std::memory_order_relaxed);
+    roi_enabled_.store(config.enable && config.enable_roi, std::memory_order_relaxed);
+    streams_.assign(std::max<size_t>(1, stream_count), StreamState());
+    cost_ms_ = 0.0f;
+
+    auto& registry = MetricsRegistry::instance();
+    const char* help = "Frames by detection mode chosen by the adaptive scheduler";
+    full_frames_ = &registry.counter("vps_detection_frames_total", "mode=\"full\"", help);
+    roi_frames_ = &registry.counter("vps_detection_frames_total", "mode=\"roi\"", help);
+    skipped_frames_ = &registry.counter("vps_detection_frames_total", "mode=\"skip\"", help);
+
+    if (config_.enable) {
+        LOG_INFO("Adaptive detection enabled: budget {}ms, interval <= {}, ROI {}",
+                 config_.latency_budget_ms, config_.max_detect_interval, config_.enable_roi ? "on" : "off");
+    }
+}
+
+DetectionScheduler::Decision DetectionScheduler::decide(int stream_id, uint64_t frame_index,
+                                                        const cv::Size& frame_size) {
+    Decision decision;
+    if (!enabled_.load(std::memory_order_relaxed)) {
+        return decision;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!config_.enable) {
+        return decision;
+    }
+    StreamState& state = streams_.at(static_cast<size_t>(stream_id));
+    state.frame_size = frame_size;
+
+    const bool risk = state.risk_active && frame_index < state.risk_until;
+    int interval = 1;
+    if (!risk) {
+        interval = budgetInterval();
+        if (state.calm) {
+            interval = std::max(interval, config_.calm_detect_interval);
+        }
+        interval = std::clamp(interval, 1, std::max(1, config_.max_detect_interval));
+    }
+    state.interval = interval;
+
+    // 只由帧序号决定是否检测(序号为间隔的整数倍)，与各帧到达预处理级的先后无关；
+    // 间隔变化时到下一次检测的距离不超过新间隔
+    if (state.started && interval > 1 && frame_index % static_cast<uint64_t>(interval) != 0) {
+        decision.mode = DetectionMode::SKIP;
+        record(decision.mode);
+        return decision;
+    }
+    state.started = true;
+
+    // 有风险时不裁剪，画面任何位置的新目标都要尽快发现
+    const double frame_area = static_cast<double>(frame_size.area());
+    const bool use_roi = config_.enable_roi && !risk && state.roi.area() > 0 && frame_area > 0 &&
+                         state.detections_since_full + 1 < std::max(1, config_.full_frame_interval) &&
+                         state.roi.area() <= config_.roi_max_area * frame_area;
+    if (use_roi) {
+        ++state.detections_since_full;
+        decision.mode = DetectionMode::ROI;
+        decision.roi = state.roi & cv::Rect(0, 0, frame_size.width, frame_size.height);
+    } else {
+        state.detections_since_full = 0;
+        decision.mode = DetectionMode::FULL;
+    }
+    record(decision.mode);
+    return decision;
+}
+
+void DetectionScheduler::observeCost(float detect_ms) {
+    if (!enabled_.load(std::memory_order_relaxed) || detect_ms <= 0.0f) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    cost_ms_ = cost_ms_ <= 0.0f ? detect_ms : cost_ms_ + kCostSmoothing * (detect_ms - cost_ms_);
+}
+
+void DetectionScheduler::observeTracks(int stream_id, TrackView tracks) {
+    if (!roi_enabled_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    StreamState& state = streams_.at(static_cast<size_t>(stream_id));
+    const cv::Size frame_size = state.frame_size;
+    if (frame_size.area() <= 0) {
+        return;
+    }
+
+    // 道路区域与每条轨迹扩展后的框取外接矩形
+    const auto& corridor = config_.road_corridor;
+    float x0 = corridor.x * frame_size.width;
+    float y0 = corridor.y * frame_size.height;
+    float x1 = (corridor.x + corridor.width) * frame_size.width;
+    float y1 = (corridor.y + corridor.height) * frame_size.height;
+    const float margin = std::max(0.0f, config_.roi_margin);
+    for (const auto& track : tracks) {
+        const cv::Rect2f& box = track.detection.bbox;
+        x0 = std::min(x0, box.x - box.width * margin);
+        y0 = std::min(y0, box.y - box.height * margin);
+        x1 = std::max(x1, box.x + box.width * (1.0f + margin));
+        y1 = std::max(y1, box.y + box.height * (1.0f + margin));
+    }
+    const cv::Rect bounds(0, 0, frame_size.width, frame_size.height);
+    state.roi = cv::Rect(cv::Point(static_cast<int>(std::floor(x0)), static_cast<int>(std::floor(y0))),
+                         cv::Point(static_cast<int>(std::ceil(x1)), static_cast<int>(std::ceil(y1)))) &
+                bounds;
+}
+
+void DetectionScheduler::observeRisk(int stream_id, uint64_t frame_index,
+                                     const std::vector<BehaviorAnalysis>& behaviors) {
+    if (!enabled_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    RiskLevel max_risk = RiskLevel::SAFE;
+    for (const auto& behavior : behaviors) {
+        max_risk = std::max(max_risk, behavior.risk_level);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    StreamState& state = streams_.at(static_cast<size_t>(stream_id));
+    state.calm = max_risk == RiskLevel::SAFE;
+    if (static_cast<int>(max_risk) >= config_.risk_level) {
+        if (!state.risk_active || frame_index >= state.risk_until) {
+            LOG_DEBUG("Stream {} risk level {} at frame {}, detecting every frame", stream_id,
+                      static_cast<int>(max_risk), frame_index);
+        }
+        state.risk_active = true;
+        state.risk_until = frame_index + static_cast<uint64_t>(std::max(0, config_.risk_hold_frames)) + 1;
+    }
+}
+
+int DetectionScheduler::detectInterval(int stream_id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (static_cast<size_t>(stream_id) >= streams_.size()) {
+        return 1;
+    }
+    return streams_[static_cast<size_t>(stream_id)].interval;
+}
+
+size_t DetectionScheduler::streamCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return streams_.size();
+}
+
+int DetectionScheduler::budgetInterval() const {
+    if (config_.latency_budget_ms <= 0.0f || cost_ms_ <= 0.0f) {
+        return 1;
+    }
+    return static_cast<int>(std::ceil(cost_ms_ / config_.latency_budget_ms));
+}
+
+void DetectionScheduler::record(DetectionMode mode) {
+    switch (mode) {
+        case DetectionMode::FULL: full_frames_->add(); break;
+        case DetectionMode::ROI: roi_frames_->add(); break;
+        case DetectionMode::SKIP: skipped_frames_->add(); break;
+    }
+}
@@ -0,0 +1,550 @@
+/**
+ * @file frame_pipeline.cpp
+ * @brief 多级帧处理流水线实现
+ * @author pengchengkang
+ * @date 2025-9-8
+ *
+ * 实现要点：
+ * - 第一级出队时在队列锁内分配帧序号，因此序号与入队顺序一致且连续
+ * - 多线程级的输出可能乱序，下游有序级通过重排缓冲按序号放行
+ * - 帧入队后投递排空任务，任务每次最多处理kDrainBudget帧后让出工作线程，
+ *   退出时若仍有帧待处理则重新投递，不会丢失唤醒
+ * - 下游队列(含重排缓冲)达到深度时上游不再出队；下游每取走一帧就唤醒上游
+ * - 停止时关闭入口队列，逐级等待队列取空且任务全部退出，已入队的帧全部处理完毕
+ * - 批量级排队帧不足一批时不出队，记下截止时间后退出排空任务；此后每次入队重新检查，
+ *   到达截止时间仍未凑满时由定时器线程投递排空任务，处理已排队的帧。工作线程从不等待凑批
+ */
+#include "frame_pipeline.hpp"
+#include "logger.hpp"
+#include <algorithm>
+
+namespace {
+
+// 每个排空任务最多处理的帧数，处理完后让出工作线程给其他级和其他任务
+constexpr size_t kDrainBudget = 8;
+
+} // namespace
+
+FramePipeline::FramePipeline(ThreadPool& pool) : pool_(pool), running_(false), submitted_frames_(0) {}
+
+FramePipeline::~FramePipeline() {
+    stop();
+}
+
+void FramePipeline::addStage(const StageOptions& options, StageFunction func) {
+    if (running_) {
+        LOG_WARN("Cannot add stage {} while pipeline is running", options.name);
+        return;
+    }
+
+    auto stage = std::make_unique<Stage>();
+    stage->index = stages_.size();
+    stage->options = options;
+    stage->func = std::move(func);
+
+    if (stage->options.threads == 0) {
+        stage->options.threads = 1;
+    }
+    if (stage->options.ordered && stage->options.threads > 1) {
+        LOG_WARN("Ordered stage {} forced to a single thread", options.name);
+        stage->options.threads = 1;
+    }
+
+    stage->queue = std::make_unique<BoundedQueue<FrameContext>>(stage->options.queue_depth,
+                                                                stage->options.overflow);
+    stages_.push_back(std::move(stage));
+}
+
+void FramePipeline::addBatchStage(const StageOptions& options, BatchStageFunction func) {
+    if (running_) {
+        LOG_WARN("Cannot add stage {} while pipeline is running", options.name);
+        return;
+    }
+
+    StageOptions batch_options = options;
+    if (batch_options.batch_size == 0) {
+        batch_options.batch_size = 1;
+    }
+    if (batch_options.max_batch_wait_ms < 0) {
+        batch_options.max_batch_wait_ms = 0;
+    }
+    // 队列至少能容纳一批，否则永远凑不满
+    if (batch_options.queue_depth < batch_options.batch_size) {
+        batch_options.queue_depth = batch_options.batch_size;
+    }
+
+    addStage(batch_options, nullptr);
+    stages_.back()->batch_func = std::move(func);
+}
+
+void FramePipeline::setErrorCallback(ErrorCallback callback) {
+    error_callback_ = std::move(callback);
+}
+
+void FramePipeline::setCompletionCallback(CompletionCallback callback) {
+    completion_callback_ = std::move(callback);
+}
+
+bool FramePipeline::start() {
+    if (running_) {
+        return true;
+    }
+    if (stages_.empty()) {
+        LOG_ERROR("Cannot start pipeline without stages");
+        return false;
+    }
+
+    for (size_t i = 0; i < stages_.size(); ++i) {
+        Stage& stage = *stages_[i];
+        if (i > 0) {
+            // 下游空位检查与入队之间有竞争，上游每个并发任务最多多送一批，
+            // 内部队列预留这部分容量，入队不会阻塞工作线程
+            const Stage& upstream = *stages_[i - 1];
+            const size_t slack = upstream.options.threads *
+                                 (upstream.batch_func ? upstream.options.batch_size : 1);
+            stage.queue = std::make_unique<BoundedQueue<FrameContext>>(
+                stage.options.queue_depth + slack, stage.options.overflow);
+        } else {
+            stage.queue->reopen();
+        }
+        stage.active = 0;
+        stage.pending.clear();
+        stage.next_sequence = 0;
+        stage.needs_reorder = stage.options.ordered && i > 0 &&
+                              stages_[i - 1]->options.threads > 1;
+    }
+
+    submitted_frames_ = 0;
+    running_ = true;
+
+    const bool needs_timer = std::any_of(stages_.begin(), stages_.end(), [](const std::unique_ptr<Stage>& stage) {
+        return stage->batch_func && stage->options.batch_size > 1 && stage->options.max_batch_wait_ms > 0;
+    });
+    if (needs_timer) {
+        {
+            std::lock_guard<std::mutex> lock(schedule_mutex_);
+            for (auto& stage : stages_) {
+                stage->batch_deadline = std::chrono::steady_clock::time_point();
+                stage->batch_timer_fired = false;
+            }
+            batch_timer_running_ = true;
+        }
+        batch_timer_ = std::thread(&FramePipeline::batchTimerLoop, this);
+    }
+    for (const auto& stage : stages_) {
+        LOG_INFO("Pipeline stage {} started: threads={}, depth={}, ordered={}, batch={}, priority={}",
+                stage->options.name, stage->options.threads, stage->options.queue_depth,
+                stage->options.ordered, stage->batch_func ? stage->options.batch_size : 1,
+                stage->options.priority == TaskPriority::HIGH ? "high" : "low");
+    }
+    LOG_INFO("Pipeline running on thread pool with {} workers", pool_.size());
+
+    return true;
+}
+
+void FramePipeline::stop() {
+    if (!running_) {
+        return;
+    }
+    running_ = false;
+
+    // 入口关闭后不再有新帧；逐级等待：上一级任务全部退出后，它的所有输出都已进入下一级
+    stages_.front()->queue->close();
+    for (size_t i = 0; i < stages_.size(); ++i) {
+        Stage& stage = *stages_[i];
+        {
+            std::unique_lock<std::mutex> lock(schedule_mutex_);
+            while (stage.active > 0 || stage.queue->size() > 0) {
+                if (stage.active == 0 && canSchedule(i)) {
+                    stage.active++;
+                    postDrain(i);
+                }
+                idle_cv_.wait_for(lock, std::chrono::milliseconds(50));
+            }
+        }
+
+        if (i + 1 < stages_.size()) {
+            Stage& next = *stages_[i + 1];
+            {
+                std::lock_guard<std::mutex> lock(next.reorder_mutex);
+                if (!next.pending.empty()) {
+                    LOG_WARN("Pipeline stage {} flushing {} out-of-order frames",
+                            next.options.name, next.pending.size());
+                    for (auto& item : next.pending) {
+                        next.queue->push(std::move(item.second));
+                    }
+                    next.pending.clear();
+                }
+            }
+            kick(i + 1);
+        }
+    }
+
+    if (batch_timer_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(schedule_mutex_);
+            batch_timer_running_ = false;
+        }
+        batch_timer_cv_.notify_all();
+        batch_timer_.join();
+    }
+
+    for (auto& stage : stages_) {
+        stage->queue->close();
+    }
+    LOG_INFO("Pipeline stopped");
+}
+
+bool FramePipeline::submit(const cv::Mat& frame, uint64_t timestamp, int stream_id) {
+    if (!running_ || stages_.empty()) {
+        return false;
+    }
+
+    FrameContext context;
+    context.stream_id = stream_id;
+    context.frame = frame;
+    context.timestamp = timestamp;
+    context.ingest_time = std::chrono::steady_clock::now();
+
+    submitted_frames_++;
+    if (!stages_.front()->queue->push(std::move(context))) {
+        return false;
+    }
+    kick(0);
+    return true;
+}
+
+bool FramePipeline::submit(const FrameHandle& frame, int stream_id) {
+    if (!running_ || stages_.empty() || !frame) {
+        return false;
+    }
+
+    frame->stream_id = stream_id;
+
+    FrameContext context;
+    context.stream_id = stream_id;
+    context.frame_buffer = frame;
+    context.frame = frame->image;
+    context.timestamp = frame->timestamp;
+    context.trace.frame_id = frame->sequence;
+    context.trace.capture_time_us = frame->capture_time_us;
+    context.trace.media_time_ms = frame->media_time_ms;
+    context.trace.stale = frame->stale;
+    context.ingest_time = std::chrono::steady_clock::now();
+
+    submitted_frames_++;
+    if (!stages_.front()->queue->push(std::move(context))) {
+        return false;
+    }
+    kick(0);
+    return true;
+}
+
+bool FramePipeline::submit(const cv::cuda::GpuMat& frame, const FrameTrace& trace, int stream_id) {
+    if (!running_ || stages_.empty()) {
+        return false;
+    }
+
+    FrameContext context;
+    context.stream_id = stream_id;
+    context.gpu_frame = frame;
+    context.timestamp = trace.capture_time_us / 1000;
+    context.trace = trace;
+    context.ingest_time = std::chrono::steady_clock::now();
+
+    submitted_frames_++;
+    if (!stages_.front()->queue->push(std::move(context))) {
+        return false;
+    }
+    kick(0);
+    return true;
+}
+
+bool FramePipeline::isRunning() const {
+    return running_;
+}
+
+size_t FramePipeline::stageCount() const {
+    return stages_.size();
+}
+
+const std::string& FramePipeline::stageName(size_t index) const {
+    return stages_.at(index)->options.name;
+}
+
+size_t FramePipeline::queueSize(size_t index) const {
+    return stages_.at(index)->queue->size();
+}
+
+uint64_t FramePipeline::submittedFrames() const {
+    return submitted_frames_;
+}
+
+uint64_t FramePipeline::droppedFrames() const {
+    uint64_t dropped = 0;
+    for (const auto& stage : stages_) {
+        dropped += stage->queue->droppedCount();
+    }
+    return dropped;
+}
+
+void FramePipeline::kick(size_t index) {
+    Stage& stage = *stages_[index];
+    {
+        std::lock_guard<std::mutex> lock(schedule_mutex_);
+        if (!canSchedule(index)) {
+            return;
+        }
+        stage.active++;
+    }
+    postDrain(index);
+}
+
+void FramePipeline::postDrain(size_t index) {
+    Stage& stage = *stages_[index];
+    if (stage.batch_func) {
+        pool_.post([this, index]() { drainBatch(index); }, stage.options.priority);
+    } else {
+        pool_.post([this, index]() { drain(index); }, stage.options.priority);
+    }
+}
+
+bool FramePipeline::canSchedule(size_t index) {
+    Stage& stage = *stages_[index];
+    return stage.active < stage.options.threads && stage.queue->size() > 0 &&
+           hasRoomDownstream(index) && batchReady(stage, std::chrono::steady_clock::now());
+}
+
+bool FramePipeline::batchReady(Stage& stage, std::chrono::steady_clock::time_point now) {
+    if (!stage.batch_func) {
+        return true;
+    }
+    const size_t queued = stage.queue->size();
+    if (queued == 0) {
+        return false;
+    }
+    // 入口已关闭(停止中)时只处理已排队的帧
+    if (queued >= stage.options.batch_size || !running_ || stage.options.max_batch_wait_ms <= 0) {
+        return true;
+    }
+    if (stage.batch_deadline == std::chrono::steady_clock::time_point()) {
+        stage.batch_deadline = now + std::chrono::milliseconds(stage.options.max_batch_wait_ms);
+        stage.batch_timer_fired = false;
+        batch_timer_cv_.notify_one();
+        return false;
+    }
+    return now >= stage.batch_deadline;
+}
+
+void FramePipeline::batchTimerLoop() {
+    std::unique_lock<std::mutex> lock(schedule_mutex_);
+    while (batch_timer_running_) {
+        const auto now = std::chrono::steady_clock::now();
+        auto wake = std::chrono::steady_clock::time_point::max();
+        for (size_t i = 0; i < stages_.size(); ++i) {
+            Stage& stage = *stages_[i];
+            if (stage.batch_deadline == std::chrono::steady_clock::time_point() || stage.batch_timer_fired) {
+                continue;
+            }
+            if (now < stage.batch_deadline) {
+                wake = std::min(wake, stage.batch_deadline);
+                continue;
+            }
+            // 每个截止时间只处理一次；此时无法投递(并发上限或背压)时，
+            // 截止时间已过，由正在运行的排空任务退出时或下游腾出空位时投递
+            stage.batch_timer_fired = true;
+            if (canSchedule(i)) {
+                stage.active++;
+                postDrain(i);
+            }
+        }
+        if (wake == std::chrono::steady_clock::time_point::max()) {
+            batch_timer_cv_.wait(lock);
+        } else {
+            batch_timer_cv_.wait_until(lock, wake);
+        }
+    }
+}
+
+bool FramePipeline::hasRoomDownstream(size_t index) const {
+    if (index + 1 >= stages_.size()) {
+        return true;
+    }
+    Stage& next = *stages_[index + 1];
+    size_t queued = next.queue->size();
+    if (next.needs_reorder) {
+        std::lock_guard<std::mutex> lock(next.reorder_mutex);
+        queued += next.pending.size();
+    }
+    return queued < next.options.queue_depth;
+}
+
+void FramePipeline::drain(size_t index) {
+    Stage& stage = *stages_[index];
+    const bool is_first = (index == 0);
+
+    uint64_t ticket = 0;
+    for (size_t n = 0; n < kDrainBudget && hasRoomDownstream(index); ++n) {
+        FrameContext context;
+        if (!stage.queue->tryPop(context, is_first ? &ticket : nullptr)) {
+            break;
+        }
+        if (is_first) {
+            context.sequence = ticket;
+        } else {
+            // 本级腾出了空位，唤醒因背压暂停的上游
+            kick(index - 1);
+        }
+
+        runStage(stage, context);
+        complete(index, std::move(context));
+    }
+
+    finishDrain(index);
+}
+
+void FramePipeline::drainBatch(size_t index) {
+    Stage& stage = *stages_[index];
+    const bool is_first = (index == 0);
+
+    std::vector<FrameContext> batch;
+    batch.reserve(stage.options.batch_size);
+    uint64_t ticket = 0;
+
+    for (size_t n = 0; n < kDrainBudget && hasRoomDownstream(index); ++n) {
+        // 凑不满一批且未到截止时间时退出，由后续入队或定时器重新投递
+        {
+            std::lock_guard<std::mutex> lock(schedule_mutex_);
+            if (!batchReady(stage, std::chrono::steady_clock::now())) {
+                break;
+            }
+            stage.batch_deadline = std::chrono::steady_clock::time_point();
+        }
+
+        // 只取已排队的帧，不等待
+        while (batch.size() < stage.options.batch_size) {
+            FrameContext context;
+            if (!stage.queue->tryPop(context, is_first ? &ticket : nullptr)) {
+                break;
+            }
+            if (is_first) {
+                context.sequence = ticket;
+            }
+            batch.push_back(std::move(context));
+        }
+        if (batch.empty()) {
+            break;
+        }
+        if (!is_first) {
+            kick(index - 1);
+        }
+
+        const bool traced = index < FrameContext::kMaxStages;
+        if (traced) {
+            const uint64_t enter_us = traceClockMicros();
+            for (auto& item : batch) {
+                item.spans[index].enter_us = enter_us;
+            }
+        }
+        try {
+            stage.batch_func(batch);
+        } catch (const std::exception& e) {
+            // 出错的一批仍然继续向下游传递
+            LOG_ERROR("Pipeline stage {} failed on batch starting at frame {}: {}",
+                     stage.options.name, batch.front().sequence, e.what());
+            if (error_callback_) {
+                error_callback_(stage.options.name, e);
+            }
+        }
+
+        const uint64_t exit_us = traced ? traceClockMicros() : 0;
+        for (auto& item : batch) {
+            if (traced) {
+                item.spans[index].exit_us = exit_us;
+            }
+            complete(index, std::move(item));
+        }
+        batch.clear();
+    }
+
+    finishDrain(index);
+}
+
+void FramePipeline::finishDrain(size_t index) {
+    Stage& stage = *stages_[index];
+    std::unique_lock<std::mutex> lock(schedule_mutex_);
+    stage.active--;
+    // 退出前重新检查：期间入队或下游腾出空位的唤醒可能因并发上限被忽略
+    const bool again = canSchedule(index);
+    if (again) {
+        stage.active++;
+    }
+    idle_cv_.notify_all();
+    lock.unlock();
+
+    if (again) {
+        postDrain(index);
+    }
+}
+
+void FramePipeline::runStage(Stage& stage, FrameContext& context) {
+    const bool traced = stage.index < FrameContext::kMaxStages;
+    if (traced) {
+        context.spans[stage.index].enter_us = traceClockMicros();
+    }
+    try {
+        stage.func(context);
+    } catch (const std::exception& e) {
+        // 出错的帧仍然继续向下游传递，避免有序级因缺帧而阻塞
+        LOG_ERROR("Pipeline stage {} failed on frame {}: {}",
+                 stage.options.name, context.sequence, e.what());
+        if (error_callback_) {
+            error_callback_(stage.options.name, e);
+        }
+    }
+    if (traced) {
+        context.spans[stage.index].exit_us = traceClockMicros();
+    }
+}
+
+void FramePipeline::complete(size_t index, FrameContext&& context) {
+    if (index + 1 < stages_.size()) {
+        forward(index + 1, std::move(context));
+    } else if (completion_callback_) {
+        try {
+            completion_callback_(context);
+        } catch (const std::exception& e) {
+            LOG_ERROR("Pipeline completion callback failed on frame {}: {}", context.sequence, e.what());
+        }
+    }
+}
+
+void FramePipeline::forward(size_t index, FrameContext&& context) {
+    Stage& stage = *stages_[index];
+
+    if (!stage.needs_reorder) {
+        stage.queue->push(std::move(context));
+        kick(index);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(stage.reorder_mutex);
+        if (context.sequence != stage.next_sequence) {
+            stage.pending.emplace(context.sequence, std::move(context));
+            return;
+        }
+
+        stage.queue->push(std::move(context));
+        stage.next_sequence++;
+
+        // 放行已就绪的后续帧
+        auto it = stage.pending.begin();
+        while (it != stage.pending.end() && it->first == stage.next_sequence) {
+            stage.queue->push(std::move(it->second));
+            stage.next_sequence++;
+            it = stage.pending.erase(it);
+        }
+    }
+    kick(index);
+}
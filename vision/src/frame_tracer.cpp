@@ -0,0 +1,224 @@
+/**
+ * @file frame_tracer.cpp
+ * @brief 逐帧延迟追踪实现
+ * @author pengchengkang
+ * @date 2025-9-16
+ */
+#include "frame_tracer.hpp"
+#include "logger.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+
+namespace {
+
+constexpr size_t kFlushBytes = 64 * 1024;
+
+// JSON字符串转义(名称来自配置，只需处理引号、反斜杠和控制字符)
+std::string quote(const std::string& text) {
+    std::string out = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        } else {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+std::string number(double value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.3f", value);
+    return buffer;
+}
+
+// 完整事件(ph=X)
+std::string completeEvent(const std::string& name, const char* category, int pid, size_t tid,
+                          double ts, double dur, const std::string& args = std::string()) {
+    std::string event = "{\"name\":" + quote(name) + ",\"cat\":\"" + category + "\",\"ph\":\"X\",\"pid\":" +
+                        std::to_string(pid) + ",\"tid\":" + std::to_string(tid) + ",\"ts\":" + number(ts) +
+                        ",\"dur\":" + number(dur < 0.0 ? 0.0 : dur);
+    if (!args.empty()) {
+        event += ",\"args\":{" + args + "}";
+    }
+    return event + "}";
+}
+
+// 元数据事件(进程/线程名称和排序)
+std::string metadataEvent(const char* name, int pid, size_t tid, const std::string& args) {
+    return "{\"name\":\"" + std::string(name) + "\",\"ph\":\"M\",\"pid\":" + std::to_string(pid) +
+           ",\"tid\":" + std::to_string(tid) + ",\"args\":{" + args + "}}";
+}
+
+} // namespace
+
+FrameTracer::~FrameTracer() {
+    close();
+}
+
+bool FrameTracer::open(const SystemConfig::TraceConfig& config, const std::vector<std::string>& stage_names,
+                       const std::vector<std::string>& stream_names) {
+    close();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    config_ = config;
+    config_.sample_interval = std::max(1, config_.sample_interval);
+    stage_names_ = stage_names;
+    if (stage_names_.size() > FrameContext::kMaxStages) {
+        LOG_WARN("Frame trace records only the first {} of {} stages", FrameContext::kMaxStages,
+                 stage_names_.size());
+        stage_names_.resize(FrameContext::kMaxStages);
+    }
+
+    const std::filesystem::path path(config_.output_path);
+    std::error_code error;
+    if (path.has_parent_path()) {
+        std::filesystem::create_directories(path.parent_path(), error);
+    }
+    file_.open(path, std::ios::trunc);
+    if (!file_.is_open()) {
+        LOG_ERROR("Failed to open frame trace file {}", config_.output_path);
+        return false;
+    }
+
+    buffer_ = "[\n";
+    first_event_ = true;
+    traced_frames_ = 0;
+    origin_us_ = traceClockMicros();
+
+    // 每路视频一个进程，tid 0为采集，其余按级序号排列
+    for (size_t stream = 0; stream < stream_names.size(); ++stream) {
+        const int pid = static_cast<int>(stream) + 1;
+        appendEvent(metadataEvent("process_name", pid, 0,
+                                  "\"name\":" + quote("stream " + std::to_string(stream) + " " + stream_names[stream])));
+        appendEvent(metadataEvent("process_sort_index", pid, 0, "\"sort_index\":" + std::to_string(pid)));
+        appendEvent(metadataEvent("thread_name", pid, 0, "\"name\":\"capture\""));
+        for (size_t i = 0; i < stage_names_.size(); ++i) {
+            appendEvent(metadataEvent("thread_name", pid, i + 1, "\"name\":" + quote(stage_names_[i])));
+            appendEvent(metadataEvent("thread_sort_index", pid, i + 1, "\"sort_index\":" + std::to_string(i + 1)));
+        }
+    }
+    writeBuffer();
+
+    LOG_INFO("Tracing every {} frames per stream to {}", config_.sample_interval, config_.output_path);
+    return true;
+}
+
+bool FrameTracer::sampled(const FrameContext& context) const {
+    // 没有采集序号的帧(直接提交的cv::Mat)按流水线序号抽样
+    const uint64_t id = context.trace.frame_id > 0 ? context.trace.frame_id : context.sequence + 1;
+    return id % static_cast<uint64_t>(config_.sample_interval) == 0;
+}
+
+void FrameTracer::record(const FrameContext& context) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!file_.is_open() || !sampled(context)) {
+        return;
+    }
+    if (traced_frames_ >= static_cast<size_t>(std::max(0, config_.max_frames))) {
+        return;
+    }
+    if (++traced_frames_ == static_cast<size_t>(config_.max_frames)) {
+        LOG_INFO("Frame trace reached {} frames, recording stopped", config_.max_frames);
+    }
+
+    const int pid = context.stream_id + 1;
+    const uint64_t ingest_us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        context.ingest_time.time_since_epoch()).count());
+    const uint64_t capture_us = context.trace.capture_time_us > 0 ? context.trace.capture_time_us : ingest_us;
+
+    // 本帧离开最后一级的时刻
+    uint64_t done_us = ingest_us;
+    for (size_t i = 0; i < stage_names_.size(); ++i) {
+        done_us = std::max(done_us, context.spans[i].exit_us);
+    }
+
+    const std::string frame_name = "frame " + std::to_string(context.trace.frame_id);
+    const std::string args = "\"frame_id\":" + std::to_string(context.trace.frame_id) +
+                             ",\"sequence\":" + std::to_string(context.sequence) +
+                             ",\"media_time_ms\":" + number(context.trace.media_time_ms) +
+                             ",\"capture_to_result_ms\":" +
+                             number(static_cast<double>(done_us - std::min(done_us, capture_us)) / 1000.0);
+
+    // 帧的整体区间以异步事件表示，不与各级轨道上的区间嵌套
+    const std::string id = std::to_string(pid) + "-" + std::to_string(context.sequence);
+    appendEvent("{\"name\":" + quote(frame_name) + ",\"cat\":\"frame\",\"ph\":\"b\",\"id\":\"" + id +
+                "\",\"pid\":" + std::to_string(pid) + ",\"tid\":0,\"ts\":" + number(relative(capture_us)) +
+                ",\"args\":{" + args + "}}");
+    appendEvent("{\"name\":" + quote(frame_name) + ",\"cat\":\"frame\",\"ph\":\"e\",\"id\":\"" + id +
+                "\",\"pid\":" + std::to_string(pid) + ",\"tid\":0,\"ts\":" + number(relative(done_us)) + "}");
+
+    if (ingest_us > capture_us) {
+        appendEvent(completeEvent("capture to ingest", "queue", pid, 0, relative(capture_us),
+                                  static_cast<double>(ingest_us - capture_us)));
+    }
+
+    // 各级排队和处理区间
+    uint64_t previous_exit = ingest_us;
+    for (size_t i = 0; i < stage_names_.size(); ++i) {
+        const StageSpan& span = context.spans[i];
+        if (span.enter_us == 0) {
+            continue;
+        }
+        if (span.enter_us > previous_exit) {
+            appendEvent(completeEvent(stage_names_[i] + " queue", "queue", pid, i + 1, relative(previous_exit),
+                                      static_cast<double>(span.enter_us - previous_exit)));
+        }
+        appendEvent(completeEvent(stage_names_[i], "stage", pid, i + 1, relative(span.enter_us),
+                                  static_cast<double>(span.exit_us - std::min(span.exit_us, span.enter_us)),
+                                  "\"frame_id\":" + std::to_string(context.trace.frame_id)));
+        previous_exit = std::max(previous_exit, span.exit_us);
+    }
+
+    if (buffer_.size() >= kFlushBytes) {
+        writeBuffer();
+    }
+}
+
+void FrameTracer::flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_.is_open()) {
+        writeBuffer();
+        file_.flush();
+    }
+}
+
+void FrameTracer::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!file_.is_open()) {
+        return;
+    }
+    buffer_ += "\n]\n";
+    writeBuffer();
+    file_.close();
+    LOG_INFO("Frame trace closed with {} frames: {}", traced_frames_, config_.output_path);
+}
+
+size_t FrameTracer::tracedFrames() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return traced_frames_;
+}
+
+void FrameTracer::appendEvent(const std::string& event) {
+    if (!first_event_) {
+        buffer_ += ",\n";
+    }
+    first_event_ = false;
+    buffer_ += event;
+}
+
+void FrameTracer::writeBuffer() {
+    file_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    buffer_.clear();
+}
+
+double FrameTracer::relative(uint64_t micros) const {
+    return static_cast<double>(static_cast<int64_t>(micros - origin_us_));
+}
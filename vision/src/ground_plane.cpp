@@ -0,0 +1,49 @@
+/**
+ * @file ground_plane.cpp
+ * @brief 地面投影测距查找表实现
+ * @author pengchengkang
+ * @date 2025-9-15
+ */
+#include "ground_plane.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// 查找表行数上限，防止参数异常时无限延伸
+constexpr int kMaxRows = 8192;
+
+// 查找表终止的最近距离(米)
+constexpr float kMinDistance = 1.0f;
+
+constexpr float kDegToRad = static_cast<float>(CV_PI) / 180.0f;
+
+} // namespace
+
+bool GroundPlaneModel::initialize(const CameraParams& camera, float max_distance) {
+    lut_.clear();
+
+    float fy = camera.fy;
+    if (fy <= 0.0f && camera.fov_v > 0.0f && camera.cy > 0.0f) {
+        fy = camera.cy / std::tan(camera.fov_v * 0.5f * kDegToRad);
+    }
+    if (fy <= 0.0f || camera.height <= 0.0f || max_distance <= 0.0f) {
+        return false;
+    }
+
+    const float pitch = camera.pitch * kDegToRad;
+    for (int row = 0; row < kMaxRows; ++row) {
+        const float depression = pitch + std::atan((row + 0.5f - camera.cy) / fy);
+        float distance = max_distance;
+        if (depression >= static_cast<float>(CV_PI) * 0.5f) {
+            distance = 0.0f;
+        } else if (depression > 0.0f) {
+            distance = std::min(max_distance, camera.height / std::tan(depression));
+        }
+        lut_.push_back(distance);
+        if (distance < kMinDistance) {
+            break;
+        }
+    }
+    return true;
+}
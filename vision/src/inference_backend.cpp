@@ -0,0 +1,163 @@
+/**
+ * @file inference_backend.cpp
+ * @brief 推理后端工厂与OpenCV DNN后端实现
+ * @author pengchengkang
+ * @date 2025-9-9
+ *
+ * 后端选择规则(backend = "auto")：
+ * - .engine/.plan 序列化引擎 → TensorRT
+ * - .onnx 且编译了TensorRT并有可用GPU → TensorRT(按precision构建引擎)
+ * - .onnx 且无GPU、编译了ONNX Runtime → ONNX Runtime
+ * - 其余情况 → OpenCV DNN
+ */
+#include "inference_backend.hpp"
+#include "logger.hpp"
+#include <opencv2/dnn.hpp>
+#include <algorithm>
+#include <filesystem>
+
+namespace {
+
+std::string lowerExtension(const std::string& path) {
+    std::string ext = std::filesystem::path(path).extension().string();
+    if (!ext.empty() && ext[0] == '.') {
+        ext = ext.substr(1);
+    }
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    return ext;
+}
+
+bool hasCudaDevice() {
+    try {
+        return cv::cuda::getCudaEnabledDeviceCount() > 0;
+    } catch (const cv::Exception&) {
+        return false;
+    }
+}
+
+} // namespace
+
+/**
+ * @brief OpenCV DNN推理后端
+ * 支持ONNX、TensorFlow、Darknet模型，CUDA可用时按precision选择FP32/FP16目标
+ */
+class OpenCVDnnBackend : public IInferenceBackend {
+private:
+    cv::dnn::Net net_;
+    std::vector<std::string> output_names_;
+
+public:
+    bool initialize(const SystemConfig::DetectorConfig& config) override {
+        std::string ext = lowerExtension(config.model_path);
+
+        if (ext == "onnx") {
+            net_ = cv::dnn::readNetFromONNX(config.model_path);
+        } else if (ext == "pb") {
+            net_ = cv::dnn::readNetFromTensorflow(config.model_path);
+        } else if (ext == "weights") {
+            // YOLO Darknet格式需要配置文件
+            std::filesystem::path cfg_path(config.model_path);
+            cfg_path.replace_extension(".cfg");
+            if (!std::filesystem::exists(cfg_path)) {
+                LOG_ERROR("YOLO config file not found: {}", cfg_path.string());
+                return false;
+            }
+            net_ = cv::dnn::readNetFromDarknet(cfg_path.string(), config.model_path);
+        } else {
+            LOG_ERROR("Unsupported model format for OpenCV DNN: {}", ext);
+            return false;
+        }
+
+        if (net_.empty()) {
+            LOG_ERROR("Failed to load model: {}", config.model_path);
+            return false;
+        }
+
+        // 设置计算后端
+        if (hasCudaDevice()) {
+            net_.setPreferableBackend(cv::dnn::DNN_BACKEND_CUDA);
+            if (config.precision == "fp16" || config.precision == "int8") {
+                net_.setPreferableTarget(cv::dnn::DNN_TARGET_CUDA_FP16);
+                LOG_INFO("Using CUDA FP16 target for inference");
+            } else {
+                net_.setPreferableTarget(cv::dnn::DNN_TARGET_CUDA);
+                LOG_INFO("Using CUDA backend for inference");
+            }
+            if (config.precision == "int8") {
+                LOG_WARN("OpenCV DNN does not support INT8, using FP16 instead");
+            }
+        } else {
+            net_.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
+            net_.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+            LOG_INFO("Using CPU backend for inference");
+            if (config.precision != "fp32") {
+                LOG_WARN("Precision {} is not available on CPU, using fp32", config.precision);
+            }
+        }
+
+        // 获取输出层名称
+        output_names_ = net_.getUnconnectedOutLayersNames();
+        return true;
+    }
+
+    void forward(const cv::Mat& blob, std::vector<cv::Mat>& outputs) override {
+        net_.setInput(blob);
+        net_.forward(outputs, output_names_);
+    }
+
+    int maxBatchSize() const override {
+        // OpenCV DNN按输入形状重新分配，batch上限取决于模型本身，失败时由调用方回退
+        return 64;
+    }
+
+    std::string name() const override {
+        return "opencv";
+    }
+};
+
+std::unique_ptr<IInferenceBackend> IInferenceBackend::create(const SystemConfig::DetectorConfig& config) {
+    std::string backend = config.backend;
+    std::transform(backend.begin(), backend.end(), backend.begin(), ::tolower);
+    const std::string ext = lowerExtension(config.model_path);
+
+    if (backend == "auto") {
+        if (ext == "engine" || ext == "plan") {
+            backend = "tensorrt";
+        } else if (ext == "onnx") {
+#if defined(HAVE_TENSORRT)
+            backend = hasCudaDevice() ? "tensorrt" : "";
+#endif
+#if defined(HAVE_ONNXRUNTIME)
+            if (backend != "tensorrt") {
+                backend = "onnxruntime";
+            }
+#endif
+        }
+        if (backend == "auto" || backend.empty()) {
+            backend = "opencv";
+        }
+    }
+
+    if (backend == "tensorrt") {
+#ifdef HAVE_TENSORRT
+        return createTensorRTBackend();
+#else
+        LOG_ERROR("TensorRT backend requested but not compiled in (ENABLE_TENSORRT=OFF)");
+        return nullptr;
+#endif
+    }
+    if (backend == "onnxruntime") {
+#ifdef HAVE_ONNXRUNTIME
+        return createOnnxRuntimeBackend();
+#else
+        LOG_ERROR("ONNX Runtime backend requested but not compiled in (ENABLE_ONNXRUNTIME=OFF)");
+        return nullptr;
+#endif
+    }
+    if (backend == "opencv") {
+        return std::make_unique<OpenCVDnnBackend>();
+    }
+
+    LOG_ERROR("Unknown inference backend: {}", config.backend);
+    return nullptr;
+}
@@ -0,0 +1,715 @@
+/**
+ * @file kalman_tracker.cpp
+ * @brief SORT/DeepSORT跟踪器实现
+ * @author pengchengkang
+ * @date 2025-9-13
+ */
+#include "kalman_tracker.hpp"
+#include "track_assignment.hpp"
+#include "track_store.hpp"
+#include "static_pipeline.hpp"
+#include "inference_backend.hpp"
+#include "logger.hpp"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+
+namespace {
+
+// 噪声标准差与框尺寸成比例(DeepSORT默认值)
+constexpr float kStdWeightPosition = 1.0f / 20.0f;
+constexpr float kStdWeightVelocity = 1.0f / 160.0f;
+
+// 4自由度卡方分布95%分位数，马氏距离门限
+constexpr float kChi2Gate = 9.4877f;
+
+// ReID单次前向的最大batch
+constexpr int kReidMaxBatch = 32;
+
+inline float square(float v) {
+    return v * v;
+}
+
+} // namespace
+
+// ==================== KalmanBoxFilterBank ====================
+
+void KalmanBoxFilterBank::measure(const cv::Rect2f& box, float z[kAxes]) {
+    z[kCenterX] = box.x + box.width * 0.5f;
+    z[kCenterY] = box.y + box.height * 0.5f;
+    z[kWidth] = box.width;
+    z[kHeight] = box.height;
+}
+
+void KalmanBoxFilterBank::clear() {
+    for (int k = 0; k < kAxes; ++k) {
+        pos_[k].clear();
+        vel_[k].clear();
+        p00_[k].clear();
+        p01_[k].clear();
+        p11_[k].clear();
+    }
+}
+
+void KalmanBoxFilterBank::reserveSlots(size_t n) {
+    if (n <= size()) {
+        return;
+    }
+    for (int k = 0; k < kAxes; ++k) {
+        pos_[k].resize(n, 1.0f);
+        vel_[k].resize(n, 0.0f);
+        p00_[k].resize(n, 1.0f);
+        p01_[k].resize(n, 0.0f);
+        p11_[k].resize(n, 1.0f);
+    }
+}
+
+void KalmanBoxFilterBank::init(size_t index, const cv::Rect2f& box) {
+    float z[kAxes];
+    measure(box, z);
+    for (int k = 0; k < kAxes; ++k) {
+        // x/w轴噪声按宽度缩放，y/h轴按高度缩放
+        const float scale = std::max(1.0f, z[kWidth + (k & 1)]);
+        pos_[k][index] = z[k];
+        vel_[k][index] = 0.0f;
+        p00_[k][index] = square(2.0f * kStdWeightPosition * scale);
+        p01_[k][index] = 0.0f;
+        p11_[k][index] = square(10.0f * kStdWeightVelocity * scale);
+    }
+}
+
+void KalmanBoxFilterBank::predict() {
+    const size_t n = size();
+    for (int k = 0; k < kAxes; ++k) {
+        float* x = pos_[k].data();
+        float* v = vel_[k].data();
+        float* p00 = p00_[k].data();
+        float* p01 = p01_[k].data();
+        float* p11 = p11_[k].data();
+        const float* ref = pos_[kWidth + (k & 1)].data();
+
+        // F = [1 1; 0 1]，P' = F·P·F^T + Q
+        for (size_t i = 0; i < n; ++i) {
+            const float scale = std::max(1.0f, ref[i]);
+            const float q_pos = square(kStdWeightPosition * scale);
+            const float q_vel = square(kStdWeightVelocity * scale);
+            const float a = p00[i];
+            const float b = p01[i];
+            const float c = p11[i];
+            x[i] += v[i];
+            p00[i] = a + 2.0f * b + c + q_pos;
+            p01[i] = b + c;
+            p11[i] = c + q_vel;
+        }
+    }
+}
+
+void KalmanBoxFilterBank::update(size_t index, const cv::Rect2f& box) {
+    float z[kAxes];
+    measure(box, z);
+    for (int k = 0; k < kAxes; ++k) {
+        const float r = square(kStdWeightPosition * std::max(1.0f, z[kWidth + (k & 1)]));
+        const float a = p00_[k][index];
+        const float b = p01_[k][index];
+        const float s = a + r;
+        const float gain_pos = a / s;
+        const float gain_vel = b / s;
+        const float innovation = z[k] - pos_[k][index];
+        pos_[k][index] += gain_pos * innovation;
+        vel_[k][index] += gain_vel * innovation;
+        p00_[k][index] = (1.0f - gain_pos) * a;
+        p01_[k][index] = (1.0f - gain_pos) * b;
+        p11_[k][index] -= gain_vel * b;
+    }
+}
+
+cv::Rect2f KalmanBoxFilterBank::box(size_t index) const {
+    const float w = std::max(1.0f, pos_[kWidth][index]);
+    const float h = std::max(1.0f, pos_[kHeight][index]);
+    return cv::Rect2f(pos_[kCenterX][index] - w * 0.5f, pos_[kCenterY][index] - h * 0.5f, w, h);
+}
+
+cv::Point2f KalmanBoxFilterBank::velocity(size_t index) const {
+    return cv::Point2f(vel_[kCenterX][index], vel_[kCenterY][index]);
+}
+
+float KalmanBoxFilterBank::gatingDistance(size_t index, const cv::Rect2f& box) const {
+    float z[kAxes];
+    measure(box, z);
+    float distance = 0.0f;
+    for (int k = 0; k < kAxes; ++k) {
+        const float r = square(kStdWeightPosition * std::max(1.0f, pos_[kWidth + (k & 1)][index]));
+        distance += square(z[k] - pos_[k][index]) / (p00_[k][index] + r);
+    }
+    return distance;
+}
+
+cv::Rect2f KalmanBoxFilterBank::gatingRegion(size_t index, float threshold) const {
+    const cv::Rect2f predicted = box(index);
+    const float rx = square(kStdWeightPosition * std::max(1.0f, pos_[kWidth][index]));
+    const float ry = square(kStdWeightPosition * std::max(1.0f, pos_[kHeight][index]));
+    const float dx = std::sqrt(threshold * (p00_[kCenterX][index] + rx));
+    const float dy = std::sqrt(threshold * (p00_[kCenterY][index] + ry));
+    return cv::Rect2f(predicted.x - dx, predicted.y - dy, predicted.width + 2.0f * dx, predicted.height + 2.0f * dy);
+}
+
+// ==================== SortTracker ====================
+
+/**
+ * @brief 卡尔曼SORT跟踪器
+ * 轨迹存放在TrackStore槽位中，filters_和派生类的并行数组均以槽位下标访问
+ */
+class SortTracker : public IObjectTracker {
+protected:
+    SystemConfig::TrackerConfig config_;
+    KalmanBoxFilterBank filters_;
+    TrackStore store_;
+    TrackSnapshotPool snapshots_;
+    int next_track_id_ = 1;
+    size_t trajectory_length_ = TrajectoryBuffer::kDefaultCapacity;
+
+    // 数据关联复用的缓冲区
+    SpatialGrid grid_;
+    LinearAssignment assignment_;
+    std::vector<cv::Rect2f> boxes_;
+    std::vector<int> candidates_;
+    std::vector<AssignmentEdge> edges_;
+    std::vector<std::pair<int, int>> local_matches_;
+    std::vector<std::pair<int, int>> matches_;   // (轨迹槽位, 检测下标)
+    std::vector<uint8_t> track_matched_;         // 按槽位下标
+    std::vector<uint8_t> detection_matched_;
+    std::vector<int> rows_;
+    std::vector<int> cols_;
+
+public:
+    bool initialize(const SystemConfig::TrackerConfig& config) override {
+        config_ = config;
+        reset();
+        LOG_INFO("Kalman SORT tracker initialized (max_age: {}, min_hits: {}, IOU threshold: {})",
+                 config.max_age, config.min_hits, config.iou_threshold);
+        return true;
+    }
+
+    TrackSnapshotHandle update(const std::vector<Detection>& detections, uint64_t timestamp) override {
+        return update(detections, cv::Mat(), timestamp);
+    }
+
+    TrackSnapshotHandle update(const std::vector<Detection>& detections, const cv::Mat& frame,
+                               uint64_t timestamp) override {
+        predict(true);
+        prepare(detections, frame);
+
+        matches_.clear();
+        track_matched_.assign(store_.slotCount(), 0);
+        detection_matched_.assign(detections.size(), 0);
+        associate(detections);
+
+        for (const auto& match : matches_) {
+            updateTrack(match.first, detections[match.second], timestamp);
+            onTrackMatched(match.first, match.second);
+        }
+        for (int d = 0; d < static_cast<int>(detections.size()); ++d) {
+            if (!detection_matched_[d]) {
+                onTrackCreated(createTrack(detections[d], timestamp), d);
+            }
+        }
+        removeExpiredTracks();
+        return publishSnapshot();
+    }
+
+    TrackSnapshotHandle predictTracks(uint64_t /*timestamp*/) override {
+        // 协方差照常增长，下一次检测时门控范围随之放宽
+        predict(false);
+        return publishSnapshot();
+    }
+
+    std::vector<TrackedObject> getTracks() const override {
+        std::vector<TrackedObject> tracks;
+        tracks.reserve(store_.active().size());
+        for (int slot : store_.active()) {
+            tracks.push_back(store_[slot]);
+        }
+        return tracks;
+    }
+
+    void reset() override {
+        store_.reset(trajectory_length_);
+        filters_.clear();
+        next_track_id_ = 1;
+        onReset();
+    }
+
+    void setMaxAge(int max_age) override {
+        config_.max_age = max_age;
+    }
+
+    void setMinHits(int min_hits) override {
+        config_.min_hits = min_hits;
+    }
+
+    void setIouThreshold(float threshold) override {
+        config_.iou_threshold = threshold;
+    }
+
+    void setTrajectoryLength(int length) override {
+        trajectory_length_ = static_cast<size_t>(std::max(1, length));
+        if (store_.active().empty()) {
+            store_.reset(trajectory_length_);
+        }
+    }
+
+protected:
+    // 关联前的准备(DeepSORT在此提取外观特征)
+    virtual void prepare(const std::vector<Detection>& /*detections*/, const cv::Mat& /*frame*/) {}
+
+    // 填充matches_并标记track_matched_/detection_matched_
+    virtual void associate(const std::vector<Detection>& detections) {
+        rows_.assign(store_.active().begin(), store_.active().end());
+        cols_.clear();
+        for (int d = 0; d < static_cast<int>(detections.size()); ++d) {
+            cols_.push_back(d);
+        }
+        matchByIoU(rows_, cols_, detections);
+    }
+
+    virtual void onTrackMatched(int /*slot*/, int /*detection*/) {}
+    virtual void onTrackCreated(int /*slot*/, int /*detection*/) {}
+    virtual void onReset() {}
+
+    /**
+     * @brief 在给定轨迹和检测子集上做IOU门控的最优分配
+     * @param rows 参与匹配的轨迹槽位
+     * @param cols 参与匹配的检测下标
+     */
+    void matchByIoU(const std::vector<int>& rows, const std::vector<int>& cols,
+                    const std::vector<Detection>& detections) {
+        if (rows.empty() || cols.empty()) {
+            return;
+        }
+        boxes_.clear();
+        for (int d : cols) {
+            boxes_.push_back(detections[d].bbox);
+        }
+        grid_.build(boxes_);
+
+        edges_.clear();
+        for (int r = 0; r < static_cast<int>(rows.size()); ++r) {
+            const cv::Rect2f& predicted = store_[rows[r]].detection.bbox;
+            candidates_.clear();
+            grid_.query(predicted, candidates_);
+            for (int c : candidates_) {
+                const float iou = boxIoU(predicted, boxes_[c]);
+                if (iou > config_.iou_threshold) {
+                    edges_.push_back({r, c, 1.0f - iou});
+                }
+            }
+        }
+        solveAndRecord(rows, cols);
+    }
+
+    // 求解edges_上的分配，局部下标映射回槽位/检测下标后写入matches_
+    void solveAndRecord(const std::vector<int>& rows, const std::vector<int>& cols) {
+        assignment_.solve(static_cast<int>(rows.size()), static_cast<int>(cols.size()), edges_, local_matches_);
+        for (const auto& match : local_matches_) {
+            const int slot = rows[match.first];
+            const int d = cols[match.second];
+            matches_.emplace_back(slot, d);
+            track_matched_[slot] = 1;
+            detection_matched_[d] = 1;
+        }
+    }
+
+private:
+    // count_miss为false时是隔帧检测的中间帧，不计为漏检
+    void predict(bool count_miss) {
+        filters_.predict();
+        for (int slot : store_.active()) {
+            TrackedObject& track = store_[slot];
+            track.detection.bbox = filters_.box(slot);
+            track.detection.center = cv::Point2f(track.detection.bbox.x + track.detection.bbox.width * 0.5f,
+                                                 track.detection.bbox.y + track.detection.bbox.height * 0.5f);
+            if (count_miss) {
+                track.consecutive_misses++;
+            }
+        }
+    }
+
+    TrackSnapshotHandle publishSnapshot() {
+        std::shared_ptr<TrackSnapshot> snapshot = snapshots_.acquire();
+        for (int slot : store_.active()) {
+            if (store_[slot].is_confirmed) {
+                TrackSnapshotPool::append(*snapshot, store_[slot]);
+            }
+        }
+        return snapshot;
+    }
+
+    void updateTrack(int slot, const Detection& detection, uint64_t timestamp) {
+        filters_.update(slot, detection.bbox);
+
+        TrackedObject& track = store_[slot];
+        track.detection = detection;
+        track.detection.bbox = filters_.box(slot);
+        track.detection.center = cv::Point2f(track.detection.bbox.x + track.detection.bbox.width * 0.5f,
+                                             track.detection.bbox.y + track.detection.bbox.height * 0.5f);
+        track.last_updated = timestamp;
+        track.consecutive_misses = 0;
+        track.age++;
+        track.trajectory.push_back(track.detection.center);
+
+        // 速度取滤波器估计，比相邻两帧位置差更平滑
+        const cv::Point2f new_velocity = filters_.velocity(slot);
+        track.acceleration = new_velocity - track.velocity;
+        track.velocity = new_velocity;
+        track.speed = cv::norm(track.velocity);
+        if (track.speed > 0.1f) {
+            track.direction = std::atan2(track.velocity.y, track.velocity.x) * 180.0f / CV_PI;
+        }
+
+        if (!track.is_confirmed && track.age >= config_.min_hits) {
+            track.is_confirmed = true;
+            LOG_DEBUG("Track {} confirmed", track.track_id);
+        }
+    }
+
+    int createTrack(const Detection& detection, uint64_t timestamp) {
+        const int slot = store_.allocate();
+        filters_.reserveSlots(store_.slotCount());
+        filters_.init(slot, detection.bbox);
+
+        TrackedObject& track = store_[slot];
+        track.track_id = next_track_id_++;
+        track.detection = detection;
+        track.trajectory.push_back(detection.center);
+        track.age = 1;
+        track.first_seen = timestamp;
+        track.last_updated = timestamp;
+        LOG_DEBUG("Created new track {}", track.track_id);
+        return slot;
+    }
+
+    void removeExpiredTracks() {
+        // 倒序遍历：release()把末尾元素换到当前位置，该元素已检查过
+        const std::vector<int>& active = store_.active();
+        for (size_t i = active.size(); i-- > 0;) {
+            const int slot = active[i];
+            if (store_[slot].consecutive_misses > config_.max_age) {
+                LOG_DEBUG("Removed expired track {}", store_[slot].track_id);
+                store_.release(slot);
+            }
+        }
+    }
+};
+
+// ==================== DeepSortTracker ====================
+
+/**
+ * @brief DeepSORT跟踪器
+ * 每帧把全部检测的图像块拼成一个NCHW批次做一次ReID前向；每条轨迹保存固定容量的
+ * 特征库(环形覆盖)，外观代价取检测特征与库中特征的最小余弦距离。
+ * ReID模型不可用时退化为SORT。
+ */
+class DeepSortTracker : public SortTracker {
+private:
+    // 单条轨迹的特征库，features为gallery_size×dim的连续存储
+    struct FeatureGallery {
+        std::vector<float> features;
+        int count = 0;
+        int next = 0;
+    };
+
+    std::unique_ptr<IInferenceBackend> reid_;
+    int embedding_dim_ = 0;
+    std::vector<FeatureGallery> galleries_;   // 按槽位下标
+
+    // 当前帧检测的特征(已L2归一化)，detections.size()×dim
+    std::vector<float> embeddings_;
+    std::vector<uint8_t> embedding_valid_;
+
+    // ReID输入缓冲区
+    cv::Mat blob_storage_;
+    cv::Mat resized_;
+    std::vector<cv::Mat> outputs_;
+    std::vector<int> crop_detections_;
+    std::vector<cv::Rect> crop_rois_;
+
+public:
+    bool initialize(const SystemConfig::TrackerConfig& config) override {
+        SortTracker::initialize(config);
+        reid_.reset();
+        embedding_dim_ = 0;
+
+        if (!config.use_appearance) {
+            LOG_INFO("DeepSORT appearance matching disabled, running as SORT");
+            return true;
+        }
+        if (!std::filesystem::exists(config.reid_model_path)) {
+            LOG_WARN("ReID model not found: {}, running as SORT", config.reid_model_path);
+            return true;
+        }
+
+        // ReID网络复用检测器的推理后端，按后端最大batch一次处理整帧检测
+        SystemConfig::DetectorConfig reid_config;
+        reid_config.model_path = config.reid_model_path;
+        reid_config.input_width = config.reid_input_width;
+        reid_config.input_height = config.reid_input_height;
+        reid_config.batch_size = kReidMaxBatch;
+        reid_config.letterbox = false;
+        reid_ = IInferenceBackend::create(reid_config);
+        if (!reid_ || !reid_->initialize(reid_config)) {
+            LOG_WARN("Failed to load ReID model {}, running as SORT", config.reid_model_path);
+            reid_.reset();
+            return true;
+        }
+
+        const int max_batch = std::max(1, std::min(kReidMaxBatch, reid_->maxBatchSize()));
+        blob_storage_.create(1, max_batch * 3 * config.reid_input_width * config.reid_input_height, CV_32F);
+        LOG_INFO("DeepSORT ReID model loaded: {} ({} backend, batch {}, gallery {})",
+                 config.reid_model_path, reid_->name(), max_batch, config.gallery_size);
+        return true;
+    }
+
+    bool needsFrame() const override {
+        return reid_ != nullptr;
+    }
+
+protected:
+    void prepare(const std::vector<Detection>& detections, const cv::Mat& frame) override {
+        embedding_valid_.assign(detections.size(), 0);
+        if (!reid_ || frame.type() != CV_8UC3 || detections.empty()) {
+            return;
+        }
+
+        const cv::Rect bounds(0, 0, frame.cols, frame.rows);
+        crop_detections_.clear();
+        crop_rois_.clear();
+        for (int d = 0; d < static_cast<int>(detections.size()); ++d) {
+            const cv::Rect2f& b = detections[d].bbox;
+            cv::Rect roi = cv::Rect(cvRound(b.x), cvRound(b.y), cvRound(b.width), cvRound(b.height)) & bounds;
+            if (roi.width >= 2 && roi.height >= 2) {
+                crop_detections_.push_back(d);
+                crop_rois_.push_back(roi);
+            }
+        }
+
+        const int max_batch = std::max(1, std::min(kReidMaxBatch, reid_->maxBatchSize()));
+        const int count = static_cast<int>(crop_detections_.size());
+        for (int begin = 0; begin < count; begin += max_batch) {
+            const int n = std::min(max_batch, count - begin);
+            if (!runReid(frame, begin, n, detections.size())) {
+                return;
+            }
+        }
+    }
+
+    void associate(const std::vector<Detection>& detections) override {
+        if (!reid_) {
+            SortTracker::associate(detections);
+            return;
+        }
+
+        // 第一级：确认轨迹，马氏距离门控，外观余弦距离为代价
+        rows_.clear();
+        cols_.clear();
+        for (int slot : store_.active()) {
+            if (store_[slot].is_confirmed && galleries_[slot].count > 0) {
+                rows_.push_back(slot);
+            }
+        }
+        for (int d = 0; d < static_cast<int>(detections.size()); ++d) {
+            cols_.push_back(d);
+        }
+        if (!rows_.empty() && !cols_.empty()) {
+            boxes_.clear();
+            for (const auto& detection : detections) {
+                boxes_.push_back(detection.bbox);
+            }
+            grid_.build(boxes_);
+
+            edges_.clear();
+            for (int r = 0; r < static_cast<int>(rows_.size()); ++r) {
+                const int slot = rows_[r];
+                candidates_.clear();
+                grid_.query(filters_.gatingRegion(slot, kChi2Gate), candidates_);
+                for (int d : candidates_) {
+                    if (!embedding_valid_[d] || filters_.gatingDistance(slot, boxes_[d]) > kChi2Gate) {
+                        continue;
+                    }
+                    const float distance = appearanceDistance(slot, d);
+                    if (distance <= config_.max_cosine_distance) {
+                        edges_.push_back({r, d, distance});
+                    }
+                }
+            }
+            solveAndRecord(rows_, cols_);
+        }
+
+        // 第二级：未确认轨迹和上一帧刚匹配过的轨迹，用IOU匹配剩余检测
+        rows_.clear();
+        cols_.clear();
+        for (int slot : store_.active()) {
+            const TrackedObject& track = store_[slot];
+            if (!track_matched_[slot] && (!track.is_confirmed || track.consecutive_misses <= 1)) {
+                rows_.push_back(slot);
+            }
+        }
+        for (int d = 0; d < static_cast<int>(detections.size()); ++d) {
+            if (!detection_matched_[d]) {
+                cols_.push_back(d);
+            }
+        }
+        matchByIoU(rows_, cols_, detections);
+    }
+
+    void onTrackMatched(int slot, int detection) override {
+        addFeature(galleries_[slot], detection);
+    }
+
+    void onTrackCreated(int slot, int detection) override {
+        // 特征库随槽位复用，只在槽位数增长时分配
+        if (galleries_.size() < store_.slotCount()) {
+            galleries_.resize(store_.slotCount());
+        }
+        galleries_[slot].count = 0;
+        galleries_[slot].next = 0;
+        addFeature(galleries_[slot], detection);
+    }
+
+    void onReset() override {
+        galleries_.clear();
+    }
+
+private:
+    /**
+     * @brief 对crop_detections_[begin, begin+n)做一次批量ReID前向
+     * 输入按常见ReID模型约定：RGB、拉伸到固定尺寸、ImageNet均值方差归一化
+     */
+    bool runReid(const cv::Mat& frame, int begin, int n, size_t detection_count) {
+        const int width = config_.reid_input_width;
+        const int height = config_.reid_input_height;
+        const size_t plane = static_cast<size_t>(width) * height;
+        static const float kMean[3] = {0.485f, 0.456f, 0.406f};
+        static const float kInvStd[3] = {1.0f / 0.229f, 1.0f / 0.224f, 1.0f / 0.225f};
+
+        const int dims[] = {n, 3, height, width};
+        cv::Mat blob(4, dims, CV_32F, blob_storage_.ptr<float>());
+        for (int i = 0; i < n; ++i) {
+            cv::resize(frame(crop_rois_[begin + i]), resized_, cv::Size(width, height), 0, 0, cv::INTER_LINEAR);
+            float* base = blob.ptr<float>() + static_cast<size_t>(i) * 3 * plane;
+            for (int y = 0; y < height; ++y) {
+                const uchar* px = resized_.ptr<uchar>(y);
+                float* r = base + static_cast<size_t>(y) * width;
+                float* g = r + plane;
+                float* b = g + plane;
+                for (int x = 0; x < width; ++x) {
+                    r[x] = (px[3 * x + 2] * (1.0f / 255.0f) - kMean[0]) * kInvStd[0];
+                    g[x] = (px[3 * x + 1] * (1.0f / 255.0f) - kMean[1]) * kInvStd[1];
+                    b[x] = (px[3 * x] * (1.0f / 255.0f) - kMean[2]) * kInvStd[2];
+                }
+            }
+        }
+
+        try {
+            reid_->forward(blob, outputs_);
+        } catch (const std::exception& e) {
+            LOG_WARN("ReID inference failed: {}", e.what());
+            return false;
+        }
+        if (outputs_.empty() || outputs_[0].total() % n != 0) {
+            LOG_WARN("Unexpected ReID output shape");
+            return false;
+        }
+
+        const int dim = static_cast<int>(outputs_[0].total() / n);
+        if (dim != embedding_dim_) {
+            // 特征维度只在首次推理时确定，之前的特征库作废
+            embedding_dim_ = dim;
+            for (auto& gallery : galleries_) {
+                gallery.count = 0;
+                gallery.next = 0;
+                gallery.features.clear();
+            }
+        }
+        embeddings_.resize(detection_count * dim);
+
+        const float* out = outputs_[0].ptr<float>();
+        for (int i = 0; i < n; ++i) {
+            const int d = crop_detections_[begin + i];
+            const float* src = out + static_cast<size_t>(i) * dim;
+            float norm = 0.0f;
+            for (int k = 0; k < dim; ++k) {
+                norm += src[k] * src[k];
+            }
+            if (norm <= 0.0f) {
+                continue;
+            }
+            const float inv = 1.0f / std::sqrt(norm);
+            float* dst = embeddings_.data() + static_cast<size_t>(d) * dim;
+            for (int k = 0; k < dim; ++k) {
+                dst[k] = src[k] * inv;
+            }
+            embedding_valid_[d] = 1;
+        }
+        return true;
+    }
+
+    void addFeature(FeatureGallery& gallery, int detection) {
+        if (detection >= static_cast<int>(embedding_valid_.size()) || !embedding_valid_[detection]) {
+            return;
+        }
+        const int capacity = std::max(1, config_.gallery_size);
+        gallery.features.resize(static_cast<size_t>(capacity) * embedding_dim_);
+        const float* src = embeddings_.data() + static_cast<size_t>(detection) * embedding_dim_;
+        std::copy(src, src + embedding_dim_, gallery.features.data() + static_cast<size_t>(gallery.next) * embedding_dim_);
+        gallery.next = (gallery.next + 1) % capacity;
+        gallery.count = std::min(gallery.count + 1, capacity);
+    }
+
+    // 检测特征与轨迹特征库的最小余弦距离
+    float appearanceDistance(int slot, int detection) const {
+        const FeatureGallery& gallery = galleries_[slot];
+        const float* query = embeddings_.data() + static_cast<size_t>(detection) * embedding_dim_;
+        float best = -1.0f;
+        for (int i = 0; i < gallery.count; ++i) {
+            const float* feature = gallery.features.data() + static_cast<size_t>(i) * embedding_dim_;
+            float dot = 0.0f;
+            for (int k = 0; k < embedding_dim_; ++k) {
+                dot += query[k] * feature[k];
+            }
+            best = std::max(best, dot);
+        }
+        return 1.0f - best;
+    }
+};
+
+SortTrackerStage::SortTrackerStage() = default;
+SortTrackerStage::~SortTrackerStage() = default;
+SortTrackerStage::SortTrackerStage(SortTrackerStage&&) noexcept = default;
+SortTrackerStage& SortTrackerStage::operator=(SortTrackerStage&&) noexcept = default;
+
+// SortTracker有派生类(DeepSortTracker)，以限定名调用使其静态分派
+bool SortTrackerStage::initialize(const SystemConfig::TrackerConfig& config) {
+    impl_ = std::make_unique<SortTracker>();
+    return impl_->SortTracker::initialize(config);
+}
+
+void SortTrackerStage::setTrajectoryLength(int length) {
+    impl_->SortTracker::setTrajectoryLength(length);
+}
+
+TrackSnapshotHandle SortTrackerStage::update(const std::vector<Detection>& detections, const cv::Mat& frame,
+                                             uint64_t timestamp) {
+    return impl_->SortTracker::update(detections, frame, timestamp);
+}
+
+TrackSnapshotHandle SortTrackerStage::predictTracks(uint64_t timestamp) {
+    return impl_->SortTracker::predictTracks(timestamp);
+}
+
+std::unique_ptr<IObjectTracker> createSortTracker() {
+    return std::make_unique<SortTracker>();
+}
+
+std::unique_ptr<IObjectTracker> createDeepSortTracker() {
+    return std::make_unique<DeepSortTracker>();
+}
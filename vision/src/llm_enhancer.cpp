@@ -3,17 +3,62 @@
  * @brief LLM增强模块实现 - 基于大语言模型的行为分析增强
  * @author pengchengkang
  * @date 2025-9-7
- * 
+ *
  * 功能描述：
  * - 使用大语言模型对基础行为分析结果进行增强
  * - 提供更详细的行为描述和风险评估建议
  * - 支持多种LLM服务接口和自定义分析策略
  * - 可配置的分析间隔和结果缓存机制
+ *
+ * 异步模型：
+ * - enhanceAnalysis()在帧处理路径上只做缓存查找和调度判断，从不等待LLM
+ * - 每个视频流按帧间隔和最小时间间隔调度，到期且场景中有未缓存的目标时，
+ *   把整个场景打包成一个请求放入有界队列(满时丢弃最旧请求)
+ * - 后台线程对每个场景构造一条提示词，回复按目标拆分后以
+ *   (视频流, track_id, 行为, 风险等级)为键写入LRU缓存，之后的帧命中缓存即附带LLM文本
  */
 
 #include "module_interface.hpp"
+#include "bounded_queue.hpp"
 #include "logger.hpp"
 #include <nlohmann/json.hpp>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <sstream>
+#include <unordered_map>
+
+namespace {
+
+// 场景中的单个目标
+struct SceneObject {
+    uint64_t key = 0;
+    int track_id = -1;
+    std::string class_name;
+    std::string behavior_name;
+    RiskLevel risk_level = RiskLevel::SAFE;
+    float distance = 0.0f;
+    float time_to_collision = -1.0f;
+};
+
+// 一次LLM请求：同一视频流同一帧的全部目标
+struct SceneRequest {
+    int stream_id = 0;
+    float vehicle_speed_kmh = 0.0f;
+    std::vector<SceneObject> objects;
+};
+
+// 缓存键：视频流16位 | track_id 32位 | 行为8位 | 风险等级8位
+uint64_t cacheKey(const BehaviorAnalysis& analysis) {
+    return (static_cast<uint64_t>(analysis.stream_id & 0xFFFF) << 48) |
+           (static_cast<uint64_t>(static_cast<uint32_t>(analysis.track_id)) << 16) |
+           (static_cast<uint64_t>(static_cast<uint8_t>(analysis.behavior)) << 8) |
+           static_cast<uint64_t>(static_cast<uint8_t>(analysis.risk_level));
+}
+
+} // namespace
 
 /**
  * @brief LLM增强器实现类
@@ -21,102 +66,326 @@
  */
 class LLMEnhancer : public ILLMEnhancer {
 private:
+    // 视频流的请求调度状态
+    struct StreamSchedule {
+        int frames_since_request = 0;
+        std::chrono::steady_clock::time_point last_request;
+        bool requested = false;
+    };
+
+    struct CacheEntry {
+        std::string text;
+        uint64_t last_used = 0;
+    };
+
     SystemConfig::LLMConfig config_;
-    float vehicle_speed_kmh_;
-    
+    std::atomic<float> vehicle_speed_kmh_;
+
+    // 帧处理路径的调度状态
+    std::unordered_map<int, StreamSchedule> schedules_;
+    std::mutex schedule_mutex_;
+
+    // 结果缓存，由后台线程写入、帧处理路径读取
+    std::unordered_map<uint64_t, CacheEntry> cache_;
+    uint64_t cache_clock_ = 0;
+    std::mutex cache_mutex_;
+
+    std::unique_ptr<BoundedQueue<SceneRequest>> requests_;
+    std::thread worker_;
+
+    std::atomic<uint64_t> submitted_{0};
+    std::atomic<uint64_t> completed_{0};
+
 public:
     /**
      * @brief 构造函数，初始化LLM增强器
      */
     LLMEnhancer() : vehicle_speed_kmh_(0.0f) {}
-    
+
+    ~LLMEnhancer() override {
+        shutdown();
+    }
+
     /**
      * @brief 初始化LLM增强器
      * @param config LLM配置参数
      * @return bool 初始化是否成功
      */
     bool initialize(const SystemConfig::LLMConfig& config) override {
+        shutdown();
         config_ = config;
-        
+
         if (!config.enable) {
             LOG_INFO("LLM enhancer disabled");
             return true;
         }
-        
-        LOG_INFO("LLM enhancer initialized (mock implementation)");
-        LOG_INFO("Server: {}, Analysis interval: {} frames", 
-                config.server_address, config.analysis_interval);
-        
+
+        {
+            std::lock_guard<std::mutex> lock(cache_mutex_);
+            cache_.clear();
+            cache_.reserve(static_cast<size_t>(std::max(1, config_.cache_size)) + 1);
+        }
+        {
+            std::lock_guard<std::mutex> lock(schedule_mutex_);
+            schedules_.clear();
+        }
+
+        requests_ = std::make_unique<BoundedQueue<SceneRequest>>(
+            static_cast<size_t>(std::max(1, config_.queue_size)), OverflowPolicy::DROP_OLDEST);
+        worker_ = std::thread(&LLMEnhancer::workerLoop, this);
+
+        LOG_INFO("LLM enhancer initialized (mock implementation, async)");
+        LOG_INFO("Server: {}, Analysis interval: {} frames / {} ms, queue: {}, cache: {}",
+                config_.server_address, config_.analysis_interval, config_.min_interval_ms,
+                config_.queue_size, config_.cache_size);
+
         return true;
     }
-    
+
     /**
-     * @brief 使用LLM增强行为分析结果
-     * @param basic_analysis 基础行为分析结果
+     * @brief 为分析结果附带已缓存的LLM文本，按调度提交场景请求，不阻塞
+     * @param analysis 行为分析结果（原地更新llm_analysis字段）
      * @param tracked_objects 跟踪目标列表
-     * @return std::vector<BehaviorAnalysis> 增强后的分析结果
      */
-    std::vector<BehaviorAnalysis> enhanceAnalysis(
-        const std::vector<BehaviorAnalysis>& basic_analysis,
-        const std::vector<TrackedObject>& tracked_objects) override {
-        
-        if (!config_.enable) {
-            return basic_analysis;
-        }
-        
-        // 简化的LLM增强实现（实际应用中需要调用真实的LLM服务）
-        std::vector<BehaviorAnalysis> enhanced_results = basic_analysis;
-        
-        for (auto& result : enhanced_results) {
-            // 模拟LLM分析结果
-            result.llm_analysis = generateMockLLMAnalysis(result);
-        }
-        
-        LOG_DEBUG("Enhanced {} behavior analysis results with LLM", enhanced_results.size());
-        return enhanced_results;
+    void enhanceAnalysis(std::vector<BehaviorAnalysis>& analysis,
+                         TrackView tracked_objects) override {
+
+        if (!config_.enable || !requests_ || analysis.empty()) {
+            return;
+        }
+
+        // 命中缓存的结果直接附带文本，并记录是否有尚未分析过的目标
+        bool has_uncached = false;
+        {
+            std::lock_guard<std::mutex> lock(cache_mutex_);
+            for (auto& result : analysis) {
+                auto it = cache_.find(cacheKey(result));
+                if (it != cache_.end()) {
+                    it->second.last_used = ++cache_clock_;
+                    result.llm_analysis = it->second.text;
+                } else {
+                    has_uncached = true;
+                }
+            }
+        }
+
+        if (requestDue(analysis.front().stream_id, has_uncached)) {
+            submitScene(analysis, tracked_objects);
+        }
     }
-    
+
     /**
      * @brief 设置车辆速度
      * @param speed_kmh 车辆速度（公里/小时）
      */
     void setVehicleSpeed(float speed_kmh) override {
-        vehicle_speed_kmh_ = speed_kmh;
+        vehicle_speed_kmh_.store(speed_kmh, std::memory_order_relaxed);
     }
-    
+
 private:
+    /**
+     * @brief 停止后台线程，丢弃未处理的请求
+     */
+    void shutdown() {
+        if (requests_) {
+            requests_->close();
+        }
+        if (worker_.joinable()) {
+            worker_.join();
+            LOG_INFO("LLM enhancer stopped: {} scenes submitted, {} completed, {} dropped",
+                     submitted_.load(), completed_.load(), requests_->droppedCount());
+        }
+        requests_.reset();
+    }
+
+    /**
+     * @brief 判断视频流是否到了提交下一个场景请求的时间
+     * 距上次请求至少analysis_interval帧且至少min_interval_ms毫秒，且场景中有未缓存的目标
+     */
+    bool requestDue(int stream_id, bool has_uncached) {
+        std::lock_guard<std::mutex> lock(schedule_mutex_);
+        StreamSchedule& schedule = schedules_[stream_id];
+        schedule.frames_since_request++;
+        if (!has_uncached) {
+            return false;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (schedule.requested) {
+            if (schedule.frames_since_request < config_.analysis_interval) {
+                return false;
+            }
+            auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                now - schedule.last_request).count();
+            if (elapsed_ms < config_.min_interval_ms) {
+                return false;
+            }
+        }
+
+        schedule.frames_since_request = 0;
+        schedule.last_request = now;
+        schedule.requested = true;
+        return true;
+    }
+
+    /**
+     * @brief 把当前场景打包成一个请求放入队列，队列满时丢弃最旧的请求
+     */
+    void submitScene(const std::vector<BehaviorAnalysis>& analysis, TrackView tracked_objects) {
+        SceneRequest request;
+        request.stream_id = analysis.front().stream_id;
+        request.vehicle_speed_kmh = vehicle_speed_kmh_.load(std::memory_order_relaxed);
+        request.objects.reserve(analysis.size());
+
+        for (const auto& result : analysis) {
+            SceneObject object;
+            object.key = cacheKey(result);
+            object.track_id = result.track_id;
+            object.behavior_name = result.behavior_name;
+            object.risk_level = result.risk_level;
+            object.distance = result.distance_to_vehicle;
+            object.time_to_collision = result.time_to_collision;
+            for (const auto& track : tracked_objects) {
+                if (track.track_id == result.track_id) {
+                    object.class_name = track.detection.className();
+                    break;
+                }
+            }
+            request.objects.push_back(std::move(object));
+        }
+
+        requests_->push(std::move(request));
+        submitted_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 后台线程：逐个处理场景请求并写入缓存
+     */
+    void workerLoop() {
+        SceneRequest request;
+        while (requests_->pop(request)) {
+            std::string prompt = buildScenePrompt(request);
+            std::string response = queryModel(prompt, request);
+            storeResponse(request, response);
+            completed_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief 为整个场景构造一条提示词，每个目标一行
+     */
+    std::string buildScenePrompt(const SceneRequest& request) const {
+        std::ostringstream prompt;
+        prompt << "You are a driving assistant. Ego vehicle speed: "
+               << static_cast<int>(request.vehicle_speed_kmh) << " km/h. "
+               << "For each object below, reply with one line '<id>: <advice>'.\n";
+        for (const auto& object : request.objects) {
+            prompt << object.track_id << ": "
+                   << (object.class_name.empty() ? "object" : object.class_name)
+                   << ", behavior " << object.behavior_name
+                   << ", risk " << static_cast<int>(object.risk_level)
+                   << ", distance " << static_cast<int>(object.distance) << "m";
+            if (object.time_to_collision > 0.0f) {
+                prompt << ", ttc " << object.time_to_collision << "s";
+            }
+            prompt << "\n";
+        }
+        return prompt.str();
+    }
+
+    /**
+     * @brief 发送提示词并返回回复文本（当前为模拟实现，实际应用中向server_address发起请求）
+     */
+    std::string queryModel(const std::string& prompt, const SceneRequest& request) const {
+        LOG_DEBUG("LLM prompt for stream {} ({} objects):\n{}", request.stream_id,
+                  request.objects.size(), prompt);
+
+        std::string response;
+        for (const auto& object : request.objects) {
+            response += std::to_string(object.track_id) + ": " + generateMockLLMAnalysis(object) + "\n";
+        }
+        return response;
+    }
+
+    /**
+     * @brief 按"<id>: <text>"逐行拆分回复并写入缓存，超出容量时淘汰最久未使用的条目
+     */
+    void storeResponse(const SceneRequest& request, const std::string& response) {
+        std::unordered_map<int, std::string> texts;
+        std::istringstream lines(response);
+        std::string line;
+        while (std::getline(lines, line)) {
+            size_t colon = line.find(':');
+            if (colon == std::string::npos) {
+                continue;
+            }
+            try {
+                int track_id = std::stoi(line.substr(0, colon));
+                size_t start = line.find_first_not_of(' ', colon + 1);
+                texts[track_id] = start == std::string::npos ? std::string() : line.substr(start);
+            } catch (const std::exception&) {
+                continue;
+            }
+        }
+
+        const size_t capacity = static_cast<size_t>(std::max(1, config_.cache_size));
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        for (const auto& object : request.objects) {
+            auto it = texts.find(object.track_id);
+            if (it == texts.end() || it->second.empty()) {
+                continue;
+            }
+            CacheEntry& entry = cache_[object.key];
+            entry.text = it->second;
+            entry.last_used = ++cache_clock_;
+        }
+
+        while (cache_.size() > capacity) {
+            auto oldest = cache_.begin();
+            for (auto it = cache_.begin(); it != cache_.end(); ++it) {
+                if (it->second.last_used < oldest->second.last_used) {
+                    oldest = it;
+                }
+            }
+            cache_.erase(oldest);
+        }
+
+        LOG_DEBUG("LLM scene for stream {} answered, {} objects, cache size {}",
+                  request.stream_id, texts.size(), cache_.size());
+    }
+
     /**
      * @brief 生成模拟的LLM分析文本
-     * @param analysis 行为分析结果
+     * @param object 场景中的目标
      * @return std::string LLM生成的分析文本
      */
-    std::string generateMockLLMAnalysis(const BehaviorAnalysis& analysis) {
+    static std::string generateMockLLMAnalysis(const SceneObject& object) {
         // 模拟LLM生成的分析文本
         std::string llm_text;
-        
-        switch (analysis.risk_level) {
+
+        switch (object.risk_level) {
             case RiskLevel::CRITICAL_RISK:
                 llm_text = "URGENT: Object detected at critical distance. Immediate attention required. "
                           "Consider emergency braking or evasive maneuvers.";
                 break;
             case RiskLevel::HIGH_RISK:
-                llm_text = "HIGH ALERT: Object showing " + analysis.behavior_name + 
-                          " behavior at " + std::to_string(static_cast<int>(analysis.distance_to_vehicle)) + 
+                llm_text = "HIGH ALERT: Object showing " + object.behavior_name +
+                          " behavior at " + std::to_string(static_cast<int>(object.distance)) +
                           "m distance. Monitor closely and prepare for potential action.";
                 break;
             case RiskLevel::MEDIUM_RISK:
-                llm_text = "CAUTION: Object exhibiting " + analysis.behavior_name + 
+                llm_text = "CAUTION: Object exhibiting " + object.behavior_name +
                           " behavior. Maintain awareness and adjust speed if necessary.";
                 break;
             case RiskLevel::LOW_RISK:
-                llm_text = "NOTICE: Object detected with " + analysis.behavior_name + 
+                llm_text = "NOTICE: Object detected with " + object.behavior_name +
                           " behavior. Continue normal operation with standard vigilance.";
                 break;
             default:
                 llm_text = "Object detected. No immediate risk identified.";
                 break;
         }
-        
+
         return llm_text;
     }
 };
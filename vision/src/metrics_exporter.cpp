@@ -0,0 +1,479 @@
+/**
+ * @file metrics_exporter.cpp
+ * @brief 指标导出实现
+ * @author pengchengkang
+ * @date 2025-9-16
+ */
+#include "metrics_exporter.hpp"
+#include "logger.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+// Prometheus直方图的桶边界(秒)，由细粒度直方图累加得到
+constexpr double kBucketBounds[] = {0.0005, 0.001, 0.002, 0.005, 0.01, 0.02, 0.033, 0.05,
+                                    0.1, 0.2, 0.5, 1.0, 2.0, 5.0};
+
+struct Quantile {
+    const char* label;
+    double q;
+};
+constexpr Quantile kQuantiles[] = {{"0.5", 0.5}, {"0.9", 0.9}, {"0.99", 0.99}, {"0.999", 0.999}};
+
+std::string key(const std::string& name, const std::string& labels) {
+    return name + "{" + labels + "}";
+}
+
+// 拼接标签，labels可为空
+std::string joinLabels(const std::string& labels, const std::string& extra) {
+    if (labels.empty()) return extra;
+    if (extra.empty()) return labels;
+    return labels + "," + extra;
+}
+
+std::string formatValue(double value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+    return buffer;
+}
+
+// 保留一位小数，用于日志摘要
+double round1(double value) {
+    return std::round(value * 10.0) / 10.0;
+}
+
+// 进程累计CPU时间(秒)，/proc/self/stat第14、15字段(utime, stime)
+double readProcessCpuSeconds() {
+    std::ifstream stat("/proc/self/stat");
+    std::string content;
+    if (!std::getline(stat, content)) {
+        return -1.0;
+    }
+    // 进程名可能含空格，从右括号之后开始解析
+    const size_t paren = content.rfind(')');
+    if (paren == std::string::npos) {
+        return -1.0;
+    }
+    std::istringstream fields(content.substr(paren + 2));
+    std::string field;
+    unsigned long long utime = 0, stime = 0;
+    for (int index = 3; fields >> field; ++index) {
+        if (index == 14) utime = std::stoull(field);
+        if (index == 15) {
+            stime = std::stoull(field);
+            break;
+        }
+    }
+    const long ticks = sysconf(_SC_CLK_TCK);
+    return ticks > 0 ? static_cast<double>(utime + stime) / static_cast<double>(ticks) : -1.0;
+}
+
+// 进程常驻内存(字节)，/proc/self/statm第2字段(页数)
+double readRssBytes() {
+    std::ifstream statm("/proc/self/statm");
+    unsigned long long size = 0, resident = 0;
+    if (!(statm >> size >> resident)) {
+        return 0.0;
+    }
+    return static_cast<double>(resident) * static_cast<double>(sysconf(_SC_PAGESIZE));
+}
+
+// GPU使用率(%)：Jetson的gpu.0/load为千分比，AMD/Intel的drm为百分比；无法获取时为-1
+double readGpuPercent() {
+    static const struct {
+        const char* path;
+        double scale;
+    } kSources[] = {
+        {"/sys/devices/gpu.0/load", 0.1},
+        {"/sys/devices/platform/gpu.0/load", 0.1},
+        {"/sys/class/drm/card0/device/gpu_busy_percent", 1.0},
+    };
+    for (const auto& source : kSources) {
+        std::ifstream file(source.path);
+        double value = 0.0;
+        if (file >> value) {
+            return value * source.scale;
+        }
+    }
+    return -1.0;
+}
+
+} // namespace
+
+const MetricsSummary::Latency* MetricsSummary::find(const std::string& name, const std::string& labels) const {
+    for (const auto& latency : latencies) {
+        if (latency.name == name && latency.labels == labels) {
+            return &latency;
+        }
+    }
+    return nullptr;
+}
+
+MetricsExporter::~MetricsExporter() {
+    stop();
+}
+
+bool MetricsExporter::start(const SystemConfig::MetricsConfig& config, Collector collector) {
+    stop();
+    config_ = config;
+    config_.interval_ms = std::max(100, config_.interval_ms);
+    collector_ = std::move(collector);
+
+    previous_.clear();
+    previous_frames_ = MetricsRegistry::instance().counter("vps_frames_output_total").value();
+    previous_cpu_seconds_ = readProcessCpuSeconds();
+    previous_time_ = std::chrono::steady_clock::now();
+    last_log_ = previous_time_;
+
+    if (config_.prometheus_port > 0) {
+        listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(config_.prometheus_port));
+        const int reuse = 1;
+        if (listen_fd_ < 0 ||
+            setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) != 0 ||
+            inet_pton(AF_INET, config_.bind_address.c_str(), &address.sin_addr) != 1 ||
+            bind(listen_fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            listen(listen_fd_, 8) != 0) {
+            LOG_ERROR("Failed to listen for metrics on {}:{}: {}", config_.bind_address,
+                      config_.prometheus_port, std::strerror(errno));
+            if (listen_fd_ >= 0) {
+                close(listen_fd_);
+                listen_fd_ = -1;
+            }
+        }
+    }
+
+    running_ = true;
+    sample_thread_ = std::thread(&MetricsExporter::sampleLoop, this);
+    if (listen_fd_ >= 0) {
+        serve_thread_ = std::thread(&MetricsExporter::serveLoop, this);
+        LOG_INFO("Metrics endpoint: http://{}:{}/metrics", config_.bind_address, config_.prometheus_port);
+    }
+    return true;
+}
+
+void MetricsExporter::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+    }
+    wake_cv_.notify_all();
+    if (sample_thread_.joinable()) {
+        sample_thread_.join();
+    }
+    if (serve_thread_.joinable()) {
+        serve_thread_.join();
+    }
+    if (listen_fd_ >= 0) {
+        close(listen_fd_);
+        listen_fd_ = -1;
+    }
+}
+
+MetricsSummary MetricsExporter::summary() const {
+    std::lock_guard<std::mutex> lock(summary_mutex_);
+    return summary_;
+}
+
+void MetricsExporter::sampleLoop() {
+    const auto interval = std::chrono::milliseconds(config_.interval_ms);
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    while (running_) {
+        wake_cv_.wait_for(lock, interval, [this]() { return !running_; });
+        lock.unlock();
+        sample();
+        lock.lock();
+    }
+}
+
+void MetricsExporter::sample() {
+    if (collector_) {
+        collector_();
+    }
+
+    auto& registry = MetricsRegistry::instance();
+    const auto now = std::chrono::steady_clock::now();
+    MetricsSummary summary;
+    summary.interval_s = std::chrono::duration<double>(now - previous_time_).count();
+
+    // 墙钟吞吐量
+    const uint64_t frames = registry.counter("vps_frames_output_total").value();
+    if (summary.interval_s > 0.0) {
+        summary.fps = static_cast<double>(frames - std::min(frames, previous_frames_)) / summary.interval_s;
+    }
+    previous_frames_ = frames;
+
+    sampleResources(summary);
+    previous_time_ = now;
+
+    // 区间内的延迟分布
+    registry.forEachHistogram([&](const std::string& name, const std::string& labels, const std::string&,
+                                  const LatencyHistogram& histogram) {
+        HistogramSnapshot current = histogram.snapshot();
+        HistogramSnapshot& previous = previous_[key(name, labels)];
+        HistogramSnapshot window = current.since(previous);
+
+        MetricsSummary::Latency latency;
+        latency.name = name;
+        latency.labels = labels;
+        latency.count = window.count;
+        latency.mean_ms = window.mean() / 1000.0;
+        latency.p50_ms = window.quantile(0.5) / 1000.0;
+        latency.p90_ms = window.quantile(0.9) / 1000.0;
+        latency.p99_ms = window.quantile(0.99) / 1000.0;
+        latency.p999_ms = window.quantile(0.999) / 1000.0;
+        latency.max_ms = static_cast<double>(current.max_us) / 1000.0;
+        summary.latencies.push_back(std::move(latency));
+
+        previous = std::move(current);
+    });
+
+    registry.gauge("vps_throughput_fps", "", "Frames completed per second over the last interval").set(summary.fps);
+    {
+        std::lock_guard<std::mutex> lock(summary_mutex_);
+        summary_ = summary;
+    }
+
+    if (!config_.snapshot_path.empty()) {
+        writeSnapshot();
+    }
+    if (config_.log_interval_ms > 0 &&
+        now - last_log_ >= std::chrono::milliseconds(config_.log_interval_ms)) {
+        last_log_ = now;
+        logSummary(summary);
+    }
+}
+
+void MetricsExporter::sampleResources(MetricsSummary& summary) {
+    auto& registry = MetricsRegistry::instance();
+
+    const double cpu_seconds = readProcessCpuSeconds();
+    if (cpu_seconds >= 0.0 && previous_cpu_seconds_ >= 0.0 && summary.interval_s > 0.0) {
+        summary.cpu_percent = 100.0 * (cpu_seconds - previous_cpu_seconds_) / summary.interval_s;
+    }
+    previous_cpu_seconds_ = cpu_seconds;
+    summary.rss_mb = readRssBytes() / (1024.0 * 1024.0);
+    summary.gpu_percent = readGpuPercent();
+
+    registry.gauge("vps_process_cpu_percent", "", "Process CPU usage, 100 per fully used core")
+        .set(summary.cpu_percent);
+    registry.gauge("vps_process_resident_memory_bytes", "", "Process resident set size")
+        .set(summary.rss_mb * 1024.0 * 1024.0);
+    registry.gauge("vps_gpu_utilization_percent", "", "GPU utilization, -1 when unavailable")
+        .set(summary.gpu_percent);
+}
+
+void MetricsExporter::logSummary(const MetricsSummary& summary) const {
+    const auto* capture = summary.find("vps_capture_to_result_seconds", "");
+    const auto* inference = summary.find("vps_stage_latency_seconds", "stage=\"inference\"");
+    LOG_INFO("Metrics: fps={} cpu={}% gpu={}% rss={}MB capture_to_result p50={}ms p99={}ms max={}ms, inference p99={}ms",
+             round1(summary.fps), round1(summary.cpu_percent), round1(summary.gpu_percent), round1(summary.rss_mb),
+             capture ? round1(capture->p50_ms) : 0.0, capture ? round1(capture->p99_ms) : 0.0,
+             capture ? round1(capture->max_ms) : 0.0, inference ? round1(inference->p99_ms) : 0.0);
+}
+
+std::string MetricsExporter::renderPrometheus() const {
+    auto& registry = MetricsRegistry::instance();
+    const MetricsSummary window = summary();
+
+    // 同名指标需要连续输出，HELP/TYPE只写一次
+    std::map<std::string, std::pair<std::string, std::string>> families;   // 名称 -> (头部, 数据行)
+    std::vector<std::string> order;
+    auto family = [&](const std::string& name, const std::string& help, const char* type) -> std::string& {
+        auto it = families.find(name);
+        if (it == families.end()) {
+            order.push_back(name);
+            it = families.emplace(name, std::make_pair("# HELP " + name + " " + (help.empty() ? name : help) +
+                                                           "\n# TYPE " + name + " " + type + "\n",
+                                                       std::string())).first;
+        }
+        return it->second.second;
+    };
+
+    registry.forEachHistogram([&](const std::string& name, const std::string& labels, const std::string& help,
+                                  const LatencyHistogram& histogram) {
+        const HistogramSnapshot snap = histogram.snapshot();
+        std::string& lines = family(name, help, "histogram");
+        uint64_t cumulative = 0;
+        size_t bucket = 0;
+        for (double bound : kBucketBounds) {
+            const uint64_t bound_us = static_cast<uint64_t>(bound * 1e6);
+            while (bucket < snap.buckets.size() && LatencyHistogram::bucketUpperBound(bucket) <= bound_us) {
+                cumulative += snap.buckets[bucket++];
+            }
+            lines += name + "_bucket{" + joinLabels(labels, "le=\"" + formatValue(bound) + "\"") + "} " +
+                     std::to_string(cumulative) + "\n";
+        }
+        lines += name + "_bucket{" + joinLabels(labels, "le=\"+Inf\"") + "} " + std::to_string(snap.count) + "\n";
+        lines += name + "_sum" + (labels.empty() ? "" : "{" + labels + "}") + " " +
+                 formatValue(static_cast<double>(snap.sum_us) / 1e6) + "\n";
+        lines += name + "_count" + (labels.empty() ? "" : "{" + labels + "}") + " " +
+                 std::to_string(snap.count) + "\n";
+
+        // 最近区间的分位数
+        if (const auto* latency = window.find(name, labels)) {
+            const double values[] = {latency->p50_ms, latency->p90_ms, latency->p99_ms, latency->p999_ms};
+            std::string& quantiles = family(name + "_window_quantile",
+                                            "Quantiles of " + name + " over the last sampling interval", "gauge");
+            for (size_t i = 0; i < sizeof(kQuantiles) / sizeof(kQuantiles[0]); ++i) {
+                quantiles += name + "_window_quantile{" +
+                             joinLabels(labels, std::string("quantile=\"") + kQuantiles[i].label + "\"") + "} " +
+                             formatValue(values[i] / 1000.0) + "\n";
+            }
+        }
+    });
+
+    registry.forEachCounter([&](const std::string& name, const std::string& labels, const std::string& help,
+                                const Counter& counter) {
+        family(name, help, "counter") += name + (labels.empty() ? "" : "{" + labels + "}") + " " +
+                                         std::to_string(counter.value()) + "\n";
+    });
+
+    registry.forEachGauge([&](const std::string& name, const std::string& labels, const std::string& help,
+                              const Gauge& gauge) {
+        family(name, help, "gauge") += name + (labels.empty() ? "" : "{" + labels + "}") + " " +
+                                       formatValue(gauge.value()) + "\n";
+    });
+
+    std::string out;
+    for (const auto& name : order) {
+        const auto& entry = families.at(name);
+        out += entry.first;
+        out += entry.second;
+    }
+    return out;
+}
+
+std::string MetricsExporter::renderJson() const {
+    auto& registry = MetricsRegistry::instance();
+    const MetricsSummary window = summary();
+
+    json j;
+    j["timestamp_ms"] = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    j["interval_s"] = window.interval_s;
+    j["fps"] = window.fps;
+    j["cpu_percent"] = window.cpu_percent;
+    j["gpu_percent"] = window.gpu_percent;
+    j["rss_mb"] = window.rss_mb;
+
+    json latencies = json::array();
+    for (const auto& latency : window.latencies) {
+        latencies.push_back({
+            {"name", latency.name},
+            {"labels", latency.labels},
+            {"count", latency.count},
+            {"mean_ms", latency.mean_ms},
+            {"p50_ms", latency.p50_ms},
+            {"p90_ms", latency.p90_ms},
+            {"p99_ms", latency.p99_ms},
+            {"p999_ms", latency.p999_ms},
+            {"max_ms", latency.max_ms}
+        });
+    }
+    j["latencies"] = latencies;
+
+    json counters = json::object();
+    registry.forEachCounter([&](const std::string& name, const std::string& labels, const std::string&,
+                                const Counter& counter) {
+        counters[key(name, labels)] = counter.value();
+    });
+    j["counters"] = counters;
+
+    json gauges = json::object();
+    registry.forEachGauge([&](const std::string& name, const std::string& labels, const std::string&,
+                              const Gauge& gauge) {
+        gauges[key(name, labels)] = gauge.value();
+    });
+    j["gauges"] = gauges;
+
+    return j.dump(2);
+}
+
+void MetricsExporter::writeSnapshot() const {
+    const std::filesystem::path path(config_.snapshot_path);
+    std::error_code error;
+    if (path.has_parent_path()) {
+        std::filesystem::create_directories(path.parent_path(), error);
+    }
+    const std::filesystem::path temp = path.string() + ".tmp";
+    {
+        std::ofstream file(temp, std::ios::trunc);
+        if (!file.is_open()) {
+            LOG_WARN("Failed to write metrics snapshot {}", temp.string());
+            return;
+        }
+        file << renderJson() << "\n";
+    }
+    std::filesystem::rename(temp, path, error);
+}
+
+void MetricsExporter::serveLoop() {
+    while (running_) {
+        pollfd descriptor{listen_fd_, POLLIN, 0};
+        // 定时返回以便检查停止标志
+        if (poll(&descriptor, 1, 200) <= 0 || !(descriptor.revents & POLLIN)) {
+            continue;
+        }
+        const int client = accept(listen_fd_, nullptr, nullptr);
+        if (client < 0) {
+            continue;
+        }
+        handleConnection(client);
+        close(client);
+    }
+}
+
+void MetricsExporter::handleConnection(int client) const {
+    timeval timeout{1, 0};
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    char request[2048];
+    const ssize_t received = recv(client, request, sizeof(request) - 1, 0);
+    if (received <= 0) {
+        return;
+    }
+    request[received] = '\0';
+
+    std::string status = "200 OK";
+    std::string content_type = "text/plain; version=0.0.4; charset=utf-8";
+    std::string body;
+    if (std::strncmp(request, "GET /metrics.json", 17) == 0) {
+        content_type = "application/json";
+        body = renderJson();
+    } else if (std::strncmp(request, "GET /metrics", 12) == 0) {
+        body = renderPrometheus();
+    } else {
+        status = "404 Not Found";
+        body = "not found\n";
+    }
+
+    std::string response = "HTTP/1.1 " + status + "\r\nContent-Type: " + content_type +
+                           "\r\nContent-Length: " + std::to_string(body.size()) +
+                           "\r\nConnection: close\r\n\r\n" + body;
+    size_t sent = 0;
+    while (sent < response.size()) {
+        const ssize_t n = send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            break;
+        }
+        sent += static_cast<size_t>(n);
+    }
+}
@@ -5,54 +5,160 @@
  * @date 2025-9-7
  * 
  * 功能描述：
- * - 支持多种深度学习模型格式（ONNX、TensorFlow、Darknet）
- * - 提供GPU/CPU自适应推理加速
- * - 实现非极大值抑制和置信度过滤
- * - 支持批量检测和性能统计
+ * - 支持多种深度学习模型格式（ONNX、TensorFlow、Darknet、TensorRT引擎）
+ * - 推理由可插拔后端执行（OpenCV DNN / TensorRT / ONNX Runtime），按precision选择精度
+ * - 信箱缩放、BGR→RGB、归一化与HWC→CHW在一次遍历中完成(CUDA可用时在GPU上执行)
+ * - 网络输入缓冲区复用(CUDA可用时为锁页内存)，预处理每帧不再分配
+ * - 按model_type选择YOLO输出解码器，SIMD取类别最大值并按类别做NMS
+ * - 支持真正的N图批量推理(单次forward)和性能统计
  */
 
 #include "module_interface.hpp"
+#include "static_pipeline.hpp"
+#include "inference_backend.hpp"
+#include "detection_decoder.hpp"
 #include "logger.hpp"
+#include "metrics.hpp"
 #include <opencv2/dnn.hpp>
 #include <opencv2/opencv.hpp>
 #include <fstream>
 #include <algorithm>
 #include <filesystem>
 #include <chrono>
+#include <cstring>
+#include <cmath>
+#include <mutex>
+
+#if defined(HAVE_OPENCV_CUDAWARPING) && defined(HAVE_OPENCV_CUDAIMGPROC) && defined(HAVE_OPENCV_CUDAARITHM)
+#include <opencv2/cudawarping.hpp>
+#include <opencv2/cudaimgproc.hpp>
+#include <opencv2/cudaarithm.hpp>
+#define DETECTOR_CUDA_PREPROCESS 1
+#endif
+
+namespace {
+
+/**
+ * @brief 网络输入缓冲区复用池
+ * 预处理从池中租用1x3xHxW缓冲区，DetectorInput::buffer_lease释放时归还；
+ * CUDA可用时使用锁页内存，加快向GPU的拷贝
+ */
+class InputBufferPool : public std::enable_shared_from_this<InputBufferPool> {
+private:
+    struct Buffer {
+        cv::Mat blob;
+        cv::cuda::HostMem host;
+    };
+    
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<Buffer>> free_;
+    size_t allocated_ = 0;
+    size_t max_buffers_;
+    cv::Size input_size_;
+    bool pinned_ = false;
+    uint64_t generation_ = 0;
+    
+public:
+    explicit InputBufferPool(size_t max_buffers) : max_buffers_(max_buffers) {}
+    
+    /**
+     * @brief 按新的输入尺寸重置，已租出的缓冲区归还时直接丢弃
+     */
+    void reset(const cv::Size& input_size, bool pinned) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_.clear();
+        allocated_ = 0;
+        input_size_ = input_size;
+        pinned_ = pinned;
+        generation_++;
+    }
+    
+    /**
+     * @brief 租用一个输入缓冲区
+     * @param lease 输出，缓冲区租约
+     * @return cv::Mat 1x3xHxW张量，有效期与租约相同
+     */
+    cv::Mat acquire(std::shared_ptr<void>& lease) {
+        std::unique_ptr<Buffer> buffer;
+        uint64_t generation;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            generation = generation_;
+            if (!free_.empty()) {
+                buffer = std::move(free_.back());
+                free_.pop_back();
+            } else if (allocated_ < max_buffers_) {
+                buffer = allocate();
+                allocated_++;
+            }
+        }
+        
+        if (!buffer) {
+            // 池已耗尽(下游积压)，退化为普通分配
+            int dims[4] = {1, 3, input_size_.height, input_size_.width};
+            lease.reset();
+            return cv::Mat(4, dims, CV_32F);
+        }
+        
+        cv::Mat blob = buffer->blob;
+        auto self = shared_from_this();
+        lease = std::shared_ptr<void>(buffer.release(), [self, generation](void* ptr) {
+            self->release(std::unique_ptr<Buffer>(static_cast<Buffer*>(ptr)), generation);
+        });
+        return blob;
+    }
+    
+private:
+    std::unique_ptr<Buffer> allocate() const {
+        auto buffer = std::make_unique<Buffer>();
+        int dims[4] = {1, 3, input_size_.height, input_size_.width};
+        if (pinned_) {
+            buffer->host = cv::cuda::HostMem(1, 3 * input_size_.area(), CV_32F, cv::cuda::HostMem::PAGE_LOCKED);
+            buffer->blob = cv::Mat(4, dims, CV_32F, buffer->host.createMatHeader().data);
+        } else {
+            buffer->blob = cv::Mat(4, dims, CV_32F);
+        }
+        return buffer;
+    }
+    
+    void release(std::unique_ptr<Buffer> buffer, uint64_t generation) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (generation == generation_) {
+            free_.push_back(std::move(buffer));
+        }
+    }
+};
+
+} // namespace
 
 /**
  * @brief 目标检测器实现类
- * 基于OpenCV DNN模块实现的通用目标检测器，支持多种模型格式
+ * 负责预处理和后处理，网络执行委托给推理后端
  */
-class ObjectDetector : public IObjectDetector {
+class ObjectDetector final : public IObjectDetector {
 private:
-    cv::dnn::Net net_;
+    std::unique_ptr<IInferenceBackend> backend_;
     std::vector<std::string> class_names_;
     SystemConfig::DetectorConfig config_;
     DetectionPerformance perf_stats_;
+    std::chrono::steady_clock::time_point fps_window_start_;   // 帧率统计窗口起点
+    int fps_window_frames_ = 0;
     cv::Size input_size_;
-    std::vector<std::string> output_names_;
+    DetectionDecoder decoder_;    // 输出解码器(复用内部缓冲区)
+    std::shared_ptr<InputBufferPool> input_pool_; // 网络输入缓冲区复用池
+    bool use_gpu_preprocess_;     // 是否在GPU上预处理
+    cv::Mat batch_blob_;          // 复用的批量输入张量
+    bool batch_supported_;        // 模型是否支持batch>1(动态batch)
     
 public:
     /**
      * @brief 构造函数，初始化默认类别名称
      */
-    ObjectDetector() {
+    ObjectDetector()
+        : input_pool_(std::make_shared<InputBufferPool>(32)),
+          use_gpu_preprocess_(false), batch_supported_(true) {
         // 默认类别名称（COCO数据集的相关类别）
-        class_names_ = {
-            "person", "bicycle", "car", "motorcycle", "airplane", "bus", "train", "truck",
-            "boat", "traffic light", "fire hydrant", "stop sign", "parking meter", "bench",
-            "bird", "cat", "dog", "horse", "sheep", "cow", "elephant", "bear", "zebra",
-            "giraffe", "backpack", "umbrella", "handbag", "tie", "suitcase", "frisbee",
-            "skis", "snowboard", "sports ball", "kite", "baseball bat", "baseball glove",
-            "skateboard", "surfboard", "tennis racket", "bottle", "wine glass", "cup",
-            "fork", "knife", "spoon", "bowl", "banana", "apple", "sandwich", "orange",
-            "broccoli", "carrot", "hot dog", "pizza", "donut", "cake", "chair", "couch",
-            "potted plant", "bed", "dining table", "toilet", "tv", "laptop", "mouse",
-            "remote", "keyboard", "cell phone", "microwave", "oven", "toaster", "sink",
-            "refrigerator", "book", "clock", "vase", "scissors", "teddy bear", "hair drier",
-            "toothbrush"
-        };
+        class_names_.assign(std::begin(kDetectionClassNames), std::end(kDetectionClassNames));
     }
     
     /**
@@ -71,53 +177,30 @@ public:
                 return false;
             }
             
-            // 根据文件扩展名确定模型格式
-            std::string ext = config.model_path.substr(config.model_path.find_last_of(".") + 1);
-            std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+            decoder_.configure(config.model_type, input_size_,
+                               config.confidence_threshold, config.nms_threshold);
             
-            if (ext == "onnx") {
-                net_ = cv::dnn::readNetFromONNX(config.model_path);
-            } else if (ext == "pb") {
-                net_ = cv::dnn::readNetFromTensorflow(config.model_path);
-            } else if (ext == "weights") {
-                // YOLO Darknet格式需要配置文件
-                std::string cfg_path = config.model_path;
-                size_t pos = cfg_path.find_last_of(".");
-                if (pos != std::string::npos) {
-                    cfg_path = cfg_path.substr(0, pos) + ".cfg";
-                }
-                if (std::filesystem::exists(cfg_path)) {
-                    net_ = cv::dnn::readNetFromDarknet(cfg_path, config.model_path);
-                } else {
-                    LOG_ERROR("YOLO config file not found: {}", cfg_path);
-                    return false;
-                }
-            } else {
-                LOG_ERROR("Unsupported model format: {}", ext);
-                return false;
-            }
+            const bool has_cuda = cv::cuda::getCudaEnabledDeviceCount() > 0;
+            input_pool_->reset(input_size_, has_cuda);
+#ifdef DETECTOR_CUDA_PREPROCESS
+            use_gpu_preprocess_ = has_cuda;
+#else
+            use_gpu_preprocess_ = false;
+#endif
+            LOG_INFO("Preprocess: {} on {}", config.letterbox ? "letterbox" : "stretch",
+                    use_gpu_preprocess_ ? "GPU" : "CPU");
             
-            if (net_.empty()) {
+            // 按配置和模型格式选择推理后端
+            backend_ = IInferenceBackend::create(config);
+            if (!backend_ || !backend_->initialize(config)) {
                 LOG_ERROR("Failed to load model: {}", config.model_path);
+                backend_.reset();
                 return false;
             }
-            
-            // 设置计算后端
-            if (cv::cuda::getCudaEnabledDeviceCount() > 0) {
-                net_.setPreferableBackend(cv::dnn::DNN_BACKEND_CUDA);
-                net_.setPreferableTarget(cv::dnn::DNN_TARGET_CUDA);
-                LOG_INFO("Using CUDA backend for inference");
-            } else {
-                net_.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
-                net_.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
-                LOG_INFO("Using CPU backend for inference");
-            }
-            
-            // 获取输出层名称
-            output_names_ = net_.getUnconnectedOutLayersNames();
+            batch_supported_ = backend_->maxBatchSize() > 1;
             
             LOG_INFO("Object detector initialized successfully");
-            LOG_INFO("Model: {}", config.model_path);
+            LOG_INFO("Model: {} (backend={}, precision={})", config.model_path, backend_->name(), config.precision);
             LOG_INFO("Input size: {}x{}", config.input_width, config.input_height);
             LOG_INFO("Confidence threshold: {}", config.confidence_threshold);
             LOG_INFO("NMS threshold: {}", config.nms_threshold);
@@ -135,61 +218,194 @@ public:
      * @return std::vector<Detection> 检测结果列表
      */
     std::vector<Detection> detect(const cv::Mat& image) override {
-        if (net_.empty() || image.empty()) {
+        if (!backend_ || image.empty()) {
             return {};
         }
         
-        auto start_time = std::chrono::steady_clock::now();
+        return infer(preprocess(image));
+    }
+    
+    /**
+     * @brief 预处理图像，生成网络输入张量
+     * 信箱缩放(或拉伸)后，BGR→RGB、归一化和HWC→CHW在一次遍历中写入复用的输入缓冲区
+     * @param image 输入图像
+     * @return DetectorInput 网络输入及坐标映射参数(只读访问配置，可并发调用)
+     */
+    DetectorInput preprocess(const cv::Mat& image) const override {
+        DetectorInput input;
+        if (image.empty()) {
+            return input;
+        }
         
-        // 预处理
         auto preprocess_start = std::chrono::steady_clock::now();
-        cv::Mat blob;
-        cv::dnn::blobFromImage(image, blob, 1.0/255.0, input_size_, cv::Scalar(0,0,0), true, false);
-        net_.setInput(blob);
-        auto preprocess_end = std::chrono::steady_clock::now();
+        input.image_size = image.size();
+        computeTransform(image.size(), input);
+        input.blob = input_pool_->acquire(input.buffer_lease);
         
-        // 推理
-        auto inference_start = std::chrono::steady_clock::now();
-        std::vector<cv::Mat> outputs;
-        net_.forward(outputs, output_names_);
-        auto inference_end = std::chrono::steady_clock::now();
+#ifdef DETECTOR_CUDA_PREPROCESS
+        if (use_gpu_preprocess_ && image.type() == CV_8UC3) {
+            thread_local cv::cuda::GpuMat d_upload;
+            d_upload.upload(image);
+            letterboxGpu(d_upload, input);
+        } else {
+            letterboxCpu(image, input);
+        }
+#else
+        letterboxCpu(image, input);
+#endif
+        auto preprocess_end = std::chrono::steady_clock::now();
         
-        // 后处理
-        auto postprocess_start = std::chrono::steady_clock::now();
-        std::vector<Detection> detections = postprocess(outputs, image.size());
-        auto postprocess_end = std::chrono::steady_clock::now();
+        input.preprocess_time_ms = std::chrono::duration<float, std::milli>(preprocess_end - preprocess_start).count();
+        return input;
+    }
+    
+    /**
+     * @brief 预处理显存中的图像(GPU解码路径)
+     * @param image BGR三通道GpuMat
+     * @return DetectorInput 网络输入及坐标映射参数
+     */
+    DetectorInput preprocess(const cv::cuda::GpuMat& image) const override {
+#ifdef DETECTOR_CUDA_PREPROCESS
+        DetectorInput input;
+        if (image.empty()) {
+            return input;
+        }
         
-        // 更新性能统计
-        float preprocess_ms = std::chrono::duration<float, std::milli>(preprocess_end - preprocess_start).count();
-        float inference_ms = std::chrono::duration<float, std::milli>(inference_end - inference_start).count();
-        float postprocess_ms = std::chrono::duration<float, std::milli>(postprocess_end - postprocess_start).count();
+        auto preprocess_start = std::chrono::steady_clock::now();
+        input.image_size = image.size();
+        computeTransform(image.size(), input);
+        input.blob = input_pool_->acquire(input.buffer_lease);
+        letterboxGpu(image, input);
+        auto preprocess_end = std::chrono::steady_clock::now();
         
-        updatePerformanceStats(preprocess_ms, inference_ms, postprocess_ms);
+        input.preprocess_time_ms = std::chrono::duration<float, std::milli>(preprocess_end - preprocess_start).count();
+        return input;
+#else
+        // 未编译CUDA预处理时下载后走CPU路径
+        cv::Mat host;
+        image.download(host);
+        return preprocess(host);
+#endif
+    }
+    
+    /**
+     * @brief 对预处理后的输入执行推理和后处理
+     * @param input 网络输入
+     * @return std::vector<Detection> 检测结果列表
+     */
+    std::vector<Detection> infer(const DetectorInput& input) override {
+        if (!backend_ || input.blob.empty()) {
+            return {};
+        }
         
+        std::vector<Detection> detections =
+            std::move(runBatch(input.blob, {toTransform(input)}, input.preprocess_time_ms).front());
+        stampTrace(detections, input.trace);
         return detections;
     }
     
-    std::vector<std::vector<Detection>> detectBatch(const std::vector<cv::Mat>& images) override {
-        std::vector<std::vector<Detection>> results;
-        results.reserve(images.size());
+    /**
+     * @brief 对多个预处理结果执行一次批量推理
+     * @param inputs 网络输入列表(每个blob为1xCxHxW)
+     * @return std::vector<std::vector<Detection>> 与输入一一对应的检测结果
+     */
+    std::vector<std::vector<Detection>> inferBatch(const std::vector<DetectorInput>& inputs) override {
+        if (inputs.size() == 1) {
+            return {infer(inputs.front())};
+        }
+        if (backend_ && inputs.size() > static_cast<size_t>(backend_->maxBatchSize())) {
+            return inChunks(inputs, [this](const std::vector<DetectorInput>& chunk) { return inferBatch(chunk); });
+        }
         
-        for (const auto& image : images) {
-            results.push_back(detect(image));
+        std::vector<std::vector<Detection>> results(inputs.size());
+        if (!backend_ || inputs.empty()) {
+            return results;
+        }
+        
+        // 收集有效输入
+        std::vector<size_t> valid;
+        std::vector<BoxTransform> transforms;
+        float preprocess_ms = 0.0f;
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            if (!inputs[i].blob.empty()) {
+                valid.push_back(i);
+                transforms.push_back(toTransform(inputs[i]));
+                preprocess_ms += inputs[i].preprocess_time_ms;
+            }
+        }
+        if (valid.empty()) {
+            return results;
         }
         
+        if (!batch_supported_ || valid.size() == 1) {
+            for (size_t i : valid) {
+                results[i] = infer(inputs[i]);
+            }
+            return results;
+        }
+        
+        // 将各个1xCxHxW张量拼接为NxCxHxW，复用批量缓冲区
+        const cv::Mat& first = inputs[valid.front()].blob;
+        int batch_dims[4] = {static_cast<int>(valid.size()), first.size[1], first.size[2], first.size[3]};
+        batch_blob_.create(4, batch_dims, CV_32F);
+        const size_t image_elems = first.total();
+        for (size_t b = 0; b < valid.size(); ++b) {
+            const cv::Mat& blob = inputs[valid[b]].blob;
+            if (blob.total() != image_elems) {
+                LOG_WARN("Batch input shape mismatch, falling back to per-image inference");
+                for (size_t i : valid) {
+                    results[i] = infer(inputs[i]);
+                }
+                return results;
+            }
+            std::memcpy(batch_blob_.ptr<float>(static_cast<int>(b)), blob.ptr<float>(),
+                        image_elems * sizeof(float));
+        }
+        
+        auto batch_results = runBatchOrFallback(batch_blob_, transforms, preprocess_ms, [&]() {
+            std::vector<std::vector<Detection>> single;
+            for (size_t i : valid) {
+                single.push_back(infer(inputs[i]));
+            }
+            return single;
+        });
+        for (size_t b = 0; b < valid.size(); ++b) {
+            results[valid[b]] = std::move(batch_results[b]);
+            stampTrace(results[valid[b]], inputs[valid[b]].trace);
+        }
         return results;
     }
     
+    /**
+     * @brief 批量检测多张图像，预处理后拼批执行一次forward
+     * @param images 输入图像列表
+     * @return std::vector<std::vector<Detection>> 与输入一一对应的检测结果
+     */
+    std::vector<std::vector<Detection>> detectBatch(const std::vector<cv::Mat>& images) override {
+        if (!backend_ || images.empty()) {
+            return std::vector<std::vector<Detection>>(images.size());
+        }
+        
+        std::vector<DetectorInput> inputs;
+        inputs.reserve(images.size());
+        for (const auto& image : images) {
+            inputs.push_back(preprocess(image));
+        }
+        return inferBatch(inputs);
+    }
+    
     const std::vector<std::string>& getClassNames() const override {
         return class_names_;
     }
     
     void setConfidenceThreshold(float threshold) override {
         config_.confidence_threshold = threshold;
+        decoder_.configure(config_.model_type, input_size_, config_.confidence_threshold, config_.nms_threshold);
     }
     
     void setNmsThreshold(float threshold) override {
         config_.nms_threshold = threshold;
+        decoder_.configure(config_.model_type, input_size_, config_.confidence_threshold, config_.nms_threshold);
     }
     
     const DetectionPerformance& getPerformanceStats() const override {
@@ -198,68 +414,287 @@ public:
     
 private:
     /**
-     * @brief 后处理网络输出，生成最终检测结果
-     * @param outputs 网络输出张量列表
-     * @param image_size 原始图像尺寸
-     * @return std::vector<Detection> 处理后的检测结果
+     * @brief 计算原图到网络输入的缩放比例和填充偏移
+     * @param image_size 原图尺寸
+     * @param input 输出，写入scale_x/scale_y/pad_x/pad_y
+     */
+    void computeTransform(const cv::Size& image_size, DetectorInput& input) const {
+        if (config_.letterbox) {
+            float scale = std::min(static_cast<float>(input_size_.width) / image_size.width,
+                                   static_cast<float>(input_size_.height) / image_size.height);
+            int new_w = std::min(input_size_.width, static_cast<int>(std::round(image_size.width * scale)));
+            int new_h = std::min(input_size_.height, static_cast<int>(std::round(image_size.height * scale)));
+            input.scale_x = input.scale_y = scale;
+            input.pad_x = static_cast<float>((input_size_.width - new_w) / 2);
+            input.pad_y = static_cast<float>((input_size_.height - new_h) / 2);
+        } else {
+            input.scale_x = static_cast<float>(input_size_.width) / image_size.width;
+            input.scale_y = static_cast<float>(input_size_.height) / image_size.height;
+            input.pad_x = input.pad_y = 0.0f;
+        }
+    }
+    
+    /**
+     * @brief 缩放后图像在网络输入中的区域
+     */
+    cv::Rect contentRect(const DetectorInput& input) const {
+        if (!config_.letterbox) {
+            return cv::Rect(0, 0, input_size_.width, input_size_.height);
+        }
+        int new_w = std::min(input_size_.width, static_cast<int>(std::round(input.image_size.width * input.scale_x)));
+        int new_h = std::min(input_size_.height, static_cast<int>(std::round(input.image_size.height * input.scale_y)));
+        return cv::Rect(static_cast<int>(input.pad_x), static_cast<int>(input.pad_y), new_w, new_h);
+    }
+    
+    /**
+     * @brief 检测结果沿用来源帧的追踪上下文，时间戳取采集时刻而非后处理时刻
      */
-    std::vector<Detection> postprocess(const std::vector<cv::Mat>& outputs, const cv::Size& image_size) {
-        std::vector<int> class_ids;
-        std::vector<float> confidences;
-        std::vector<cv::Rect> boxes;
-        
-        // 解析网络输出
-        for (const auto& output : outputs) {
-            const float* data = (float*)output.data;
+    static void stampTrace(std::vector<Detection>& detections, const FrameTrace& trace) {
+        if (trace.capture_time_us == 0 && trace.frame_id == 0) {
+            return;
+        }
+        for (auto& det : detections) {
+            det.trace = trace;
+            if (trace.capture_time_us > 0) {
+                det.timestamp = trace.capture_time_us / 1000;
+            }
+        }
+    }
+    
+    static BoxTransform toTransform(const DetectorInput& input) {
+        BoxTransform transform;
+        transform.scale_x = input.scale_x;
+        transform.scale_y = input.scale_y;
+        transform.pad_x = input.pad_x;
+        transform.pad_y = input.pad_y;
+        transform.image_size = input.image_size;
+        return transform;
+    }
+    
+    /**
+     * @brief CPU信箱预处理：缩放后一次遍历完成通道重排、归一化和填充
+     * 中间缓冲区为线程局部变量，各预处理线程互不干扰且不重复分配
+     */
+    void letterboxCpu(const cv::Mat& image, DetectorInput& input) const {
+        thread_local cv::Mat bgr;
+        thread_local cv::Mat resized;
+        
+        const cv::Mat* src = &image;
+        if (image.channels() == 1) {
+            cv::cvtColor(image, bgr, cv::COLOR_GRAY2BGR);
+            src = &bgr;
+        } else if (image.channels() == 4) {
+            cv::cvtColor(image, bgr, cv::COLOR_BGRA2BGR);
+            src = &bgr;
+        }
+        if (src->depth() != CV_8U) {
+            src->convertTo(bgr, CV_8U);
+            src = &bgr;
+        }
+        
+        const cv::Rect roi = contentRect(input);
+        if (src->size() != roi.size()) {
+            cv::resize(*src, resized, roi.size(), 0, 0, cv::INTER_LINEAR);
+            src = &resized;
+        }
+        
+        const int width = input_size_.width;
+        const int height = input_size_.height;
+        const size_t plane = static_cast<size_t>(width) * height;
+        float* r_plane = input.blob.ptr<float>();
+        float* g_plane = r_plane + plane;
+        float* b_plane = g_plane + plane;
+        const float norm = 1.0f / 255.0f;
+        const float pad = config_.letterbox ? 114.0f / 255.0f : 0.0f;
+        
+        for (int y = 0; y < height; ++y) {
+            float* r = r_plane + static_cast<size_t>(y) * width;
+            float* g = g_plane + static_cast<size_t>(y) * width;
+            float* b = b_plane + static_cast<size_t>(y) * width;
             
-            for (int i = 0; i < output.rows; ++i) {
-                const float* row = data + i * output.cols;
-                
-                // 跳过边界框坐标
-                const float* scores = row + 5;
-                
-                cv::Point class_id_point;
-                double max_class_score;
-                cv::minMaxLoc(cv::Mat(1, class_names_.size(), CV_32F, (void*)scores), 
-                             0, &max_class_score, 0, &class_id_point);
-                
-                if (max_class_score > config_.confidence_threshold) {
-                    float center_x = row[0] * image_size.width;
-                    float center_y = row[1] * image_size.height;
-                    float width = row[2] * image_size.width;
-                    float height = row[3] * image_size.height;
-                    
-                    int left = static_cast<int>(center_x - width / 2);
-                    int top = static_cast<int>(center_y - height / 2);
-                    
-                    class_ids.push_back(class_id_point.x);
-                    confidences.push_back(static_cast<float>(max_class_score));
-                    boxes.push_back(cv::Rect(left, top, static_cast<int>(width), static_cast<int>(height)));
-                }
+            if (y < roi.y || y >= roi.y + roi.height) {
+                std::fill(r, r + width, pad);
+                std::fill(g, g + width, pad);
+                std::fill(b, b + width, pad);
+                continue;
+            }
+            
+            std::fill(r, r + roi.x, pad);
+            std::fill(g, g + roi.x, pad);
+            std::fill(b, b + roi.x, pad);
+            
+            const uchar* px = src->ptr<uchar>(y - roi.y);
+            for (int x = 0; x < roi.width; ++x) {
+                b[roi.x + x] = px[3 * x] * norm;
+                g[roi.x + x] = px[3 * x + 1] * norm;
+                r[roi.x + x] = px[3 * x + 2] * norm;
+            }
+            
+            std::fill(r + roi.x + roi.width, r + width, pad);
+            std::fill(g + roi.x + roi.width, g + width, pad);
+            std::fill(b + roi.x + roi.width, b + width, pad);
+        }
+    }
+    
+#ifdef DETECTOR_CUDA_PREPROCESS
+    /**
+     * @brief GPU信箱预处理：缩放、通道转换、归一化和平面拆分均在GPU上完成，
+     * 结果直接下载到锁页输入缓冲区
+     */
+    void letterboxGpu(const cv::cuda::GpuMat& d_src, DetectorInput& input) const {
+        thread_local cv::cuda::Stream stream;
+        thread_local cv::cuda::GpuMat d_resized, d_rgb, d_canvas, d_planar;
+        thread_local std::vector<cv::cuda::GpuMat> d_planes;
+        
+        const int width = input_size_.width;
+        const int height = input_size_.height;
+        const cv::Rect roi = contentRect(input);
+        const float pad = config_.letterbox ? 114.0f / 255.0f : 0.0f;
+        
+        cv::cuda::resize(d_src, d_resized, roi.size(), 0, 0, cv::INTER_LINEAR, stream);
+        cv::cuda::cvtColor(d_resized, d_rgb, cv::COLOR_BGR2RGB, 0, stream);
+        
+        d_canvas.create(height, width, CV_32FC3);
+        d_canvas.setTo(cv::Scalar::all(pad), stream);
+        cv::cuda::GpuMat d_content = d_canvas(roi);
+        d_rgb.convertTo(d_content, CV_32FC3, 1.0 / 255.0, stream);
+        
+        // 平面缓冲区的三个行区间即CHW的三个通道，split直接写入
+        if (d_planar.rows != 3 * height || d_planar.cols != width) {
+            d_planar.create(3 * height, width, CV_32F);
+            d_planes = {d_planar.rowRange(0, height),
+                        d_planar.rowRange(height, 2 * height),
+                        d_planar.rowRange(2 * height, 3 * height)};
+        }
+        cv::cuda::split(d_canvas, d_planes, stream);
+        
+        cv::Mat host_view(3 * height, width, CV_32F, input.blob.ptr<float>());
+        d_planar.download(host_view, stream);
+        stream.waitForCompletion();
+    }
+#endif
+    
+    /**
+     * @brief 对NCHW输入执行一次forward，并按图像拆分后处理
+     * @param blob 网络输入张量(N与transforms数量一致)
+     * @param transforms 每张图像的坐标映射参数
+     * @param preprocess_ms 整批预处理耗时(毫秒)
+     * @return std::vector<std::vector<Detection>> 每张图像的检测结果
+     */
+    std::vector<std::vector<Detection>> runBatch(const cv::Mat& blob,
+                                                 const std::vector<BoxTransform>& transforms,
+                                                 float preprocess_ms) {
+        const size_t batch = transforms.size();
+        
+        // 推理
+        auto inference_start = std::chrono::steady_clock::now();
+        std::vector<cv::Mat> outputs;
+        backend_->forward(blob, outputs);
+        auto inference_end = std::chrono::steady_clock::now();
+        
+        // 后处理：每个输出张量按batch维切片，不复制数据
+        auto postprocess_start = std::chrono::steady_clock::now();
+        std::vector<std::vector<Detection>> results(batch);
+        std::vector<cv::Mat> image_outputs(outputs.size());
+        for (size_t b = 0; b < batch; ++b) {
+            for (size_t k = 0; k < outputs.size(); ++k) {
+                image_outputs[k] = sliceBatch(outputs[k], static_cast<int>(b), static_cast<int>(batch));
             }
+            results[b] = postprocess(image_outputs, transforms[b]);
         }
+        auto postprocess_end = std::chrono::steady_clock::now();
+        
+        // 更新性能统计(按帧均摊)
+        float inference_ms = std::chrono::duration<float, std::milli>(inference_end - inference_start).count();
+        float postprocess_ms = std::chrono::duration<float, std::milli>(postprocess_end - postprocess_start).count();
+        updatePerformanceStats(preprocess_ms / batch, inference_ms / batch, postprocess_ms / batch,
+                               static_cast<int>(batch));
         
-        // 非极大值抑制
-        std::vector<int> indices;
-        cv::dnn::NMSBoxes(boxes, confidences, config_.confidence_threshold, config_.nms_threshold, indices);
+        return results;
+    }
+    
+    /**
+     * @brief 执行批量推理，模型不支持batch>1时回退为逐张推理并记住该结论
+     */
+    template<typename Fallback>
+    std::vector<std::vector<Detection>> runBatchOrFallback(const cv::Mat& blob,
+                                                           const std::vector<BoxTransform>& transforms,
+                                                           float preprocess_ms, Fallback fallback) {
+        try {
+            return runBatch(blob, transforms, preprocess_ms);
+        } catch (const std::exception& e) {
+            LOG_WARN("Batched inference failed, model may have a fixed batch size: {}", e.what());
+            LOG_WARN("Falling back to per-image inference");
+            batch_supported_ = false;
+            return fallback();
+        }
+    }
+    
+    /**
+     * @brief 按后端最大batch拆分输入，逐块处理后合并结果
+     */
+    template<typename Item, typename Func>
+    std::vector<std::vector<Detection>> inChunks(const std::vector<Item>& items, Func func) {
+        const size_t chunk_size = static_cast<size_t>(std::max(1, backend_->maxBatchSize()));
+        std::vector<std::vector<Detection>> results;
+        results.reserve(items.size());
+        for (size_t begin = 0; begin < items.size(); begin += chunk_size) {
+            size_t end = std::min(items.size(), begin + chunk_size);
+            auto chunk_results = func(std::vector<Item>(items.begin() + begin, items.begin() + end));
+            for (auto& r : chunk_results) {
+                results.push_back(std::move(r));
+            }
+        }
+        return results;
+    }
+    
+    /**
+     * @brief 从批量输出张量中取出第index张图像对应的二维视图
+     * @param output 网络输出，形如[N, rows, cols]或[rows, cols]
+     * @param index 图像在batch中的下标
+     * @param batch batch大小
+     * @return cv::Mat 共享数据的二维视图
+     */
+    static cv::Mat sliceBatch(const cv::Mat& output, int index, int batch) {
+        if (output.dims >= 3) {
+            return cv::Mat(output.size[1], output.size[2], CV_32F,
+                           const_cast<float*>(output.ptr<float>(index)));
+        }
+        if (batch <= 1) {
+            return output;
+        }
+        int rows_per_image = output.rows / batch;
+        return output.rowRange(index * rows_per_image, (index + 1) * rows_per_image);
+    }
+    
+    /**
+     * @brief 后处理网络输出，生成最终检测结果
+     * @param outputs 网络输出张量列表
+     * @param transform 网络坐标到原图坐标的映射
+     * @return std::vector<Detection> 处理后的检测结果
+     */
+    std::vector<Detection> postprocess(const std::vector<cv::Mat>& outputs, const BoxTransform& transform) {
+        const std::vector<DecodedBox>& boxes = decoder_.decode(outputs, transform);
         
         // 构建检测结果
         std::vector<Detection> detections;
-        detections.reserve(indices.size());
+        detections.reserve(boxes.size());
+        // 来源帧未知时(直接调用detect)以当前时间为准，流水线中由stampTrace改为采集时刻
+        const uint64_t timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
         
-        for (int idx : indices) {
+        for (const auto& box : boxes) {
             Detection det;
-            det.class_id = static_cast<ObjectClass>(class_ids[idx]);
-            det.class_name = (class_ids[idx] < class_names_.size()) ? class_names_[class_ids[idx]] : "unknown";
-            det.confidence = confidences[idx];
-            det.bbox = cv::Rect2f(boxes[idx]);
+            det.class_id = static_cast<ObjectClass>(box.class_index);
+            det.class_index = box.class_index;
+            det.confidence = box.score;
+            det.bbox = cv::Rect2f(box.x1, box.y1, box.x2 - box.x1, box.y2 - box.y1);
             det.center = cv::Point2f(det.bbox.x + det.bbox.width / 2, det.bbox.y + det.bbox.height / 2);
             det.area = det.bbox.width * det.bbox.height;
             det.aspect_ratio = det.bbox.width / det.bbox.height;
-            det.timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
-                std::chrono::steady_clock::now().time_since_epoch()).count();
+            det.timestamp = timestamp;
             
-            detections.push_back(det);
+            detections.push_back(std::move(det));
         }
         
         return detections;
@@ -270,23 +705,58 @@ private:
      * @param preprocess_ms 预处理耗时（毫秒）
      * @param inference_ms 推理耗时（毫秒）
      * @param postprocess_ms 后处理耗时（毫秒）
+     * @param frames 本次统计对应的帧数
      */
-    void updatePerformanceStats(float preprocess_ms, float inference_ms, float postprocess_ms) {
+    void updatePerformanceStats(float preprocess_ms, float inference_ms, float postprocess_ms, int frames = 1) {
         const float alpha = 0.1f; // 平滑因子
         
         perf_stats_.preprocess_time_ms = alpha * preprocess_ms + (1 - alpha) * perf_stats_.preprocess_time_ms;
         perf_stats_.inference_time_ms = alpha * inference_ms + (1 - alpha) * perf_stats_.inference_time_ms;
         perf_stats_.postprocess_time_ms = alpha * postprocess_ms + (1 - alpha) * perf_stats_.postprocess_time_ms;
         
-        perf_stats_.frame_count++;
+        // 分布统计：每帧记录一次均摊耗时
+        static LatencyHistogram& inference_latency = stageLatency("inference");
+        static LatencyHistogram& postprocess_latency = stageLatency("postprocess");
+        for (int i = 0; i < frames; ++i) {
+            inference_latency.recordMs(inference_ms);
+            postprocess_latency.recordMs(postprocess_ms);
+        }
+        
+        perf_stats_.frame_count += frames;
         
-        float total_time = preprocess_ms + inference_ms + postprocess_ms;
-        if (total_time > 0) {
-            perf_stats_.fps = alpha * (1000.0f / total_time) + (1 - alpha) * perf_stats_.fps;
+        // 帧率按墙钟吞吐量计算(至少间隔1秒更新一次)，而非由计算耗时反推
+        const auto now = std::chrono::steady_clock::now();
+        if (fps_window_start_ == std::chrono::steady_clock::time_point()) {
+            fps_window_start_ = now;
+        }
+        fps_window_frames_ += frames;
+        const float elapsed_s = std::chrono::duration<float>(now - fps_window_start_).count();
+        if (elapsed_s >= 1.0f) {
+            perf_stats_.fps = static_cast<float>(fps_window_frames_) / elapsed_s;
+            fps_window_frames_ = 0;
+            fps_window_start_ = now;
         }
     }
 };
 
+DetectorStage::DetectorStage() = default;
+DetectorStage::~DetectorStage() = default;
+DetectorStage::DetectorStage(DetectorStage&&) noexcept = default;
+DetectorStage& DetectorStage::operator=(DetectorStage&&) noexcept = default;
+
+bool DetectorStage::initialize(const SystemConfig::DetectorConfig& config) {
+    impl_ = std::make_unique<ObjectDetector>();
+    return impl_->initialize(config);
+}
+
+DetectorInput DetectorStage::preprocess(const cv::Mat& image) const {
+    return impl_->preprocess(image);
+}
+
+void DetectorStage::infer(const DetectorInput& input, std::vector<Detection>& detections) {
+    detections = impl_->infer(input);
+}
+
 // 实现工厂函数
 std::unique_ptr<IObjectDetector> IObjectDetector::create() {
     return std::make_unique<ObjectDetector>();
@@ -8,31 +8,47 @@
  * - 基于卡尔曼滤波器的多目标跟踪
  * - 支持目标的出现、消失和重新出现
  * - 提供运动预测和轨迹管理
- * - 实现IOU匹配和身份关联算法
+ * - 实现IOU匹配和身份关联算法：均匀网格门控候选对，候选边上求最优分配
+ * - 按TrackerConfig::type从注册表创建跟踪器(simple/sort/deepsort)
  */
 
 #include "module_interface.hpp"
+#include "track_assignment.hpp"
+#include "kalman_tracker.hpp"
+#include "track_store.hpp"
+#include "static_pipeline.hpp"
 #include "logger.hpp"
 #include <opencv2/opencv.hpp>
 #include <algorithm>
-#include <unordered_map>
+#include <cctype>
 
 /**
  * @brief 目标跟踪器实现类
- * 基于简化的SORT算法实现，支持多目标实时跟踪
+ * 基于简化的SORT算法实现，支持多目标实时跟踪。
+ * 轨迹存放在复用的槽位中，确认轨迹以快照发布，稳态运行时不分配堆内存
  */
-class ObjectTracker : public IObjectTracker {
+class ObjectTracker final : public IObjectTracker {
 private:
     SystemConfig::TrackerConfig config_;
-    std::vector<TrackedObject> tracks_;
+    TrackStore store_;
+    TrackSnapshotPool snapshots_;
     int next_track_id_;
-    std::unordered_map<int, int> track_ages_;
+    size_t trajectory_length_;
+    
+    // 数据关联复用的缓冲区
+    SpatialGrid detection_grid_;
+    LinearAssignment assignment_;
+    std::vector<cv::Rect2f> detection_boxes_;
+    std::vector<int> candidates_;
+    std::vector<AssignmentEdge> edges_;
+    std::vector<std::pair<int, int>> matches_;     // (active()下标, 检测下标)
+    std::vector<uint8_t> detection_matched_;
     
 public:
     /**
      * @brief 构造函数，初始化跟踪器状态
      */
-    ObjectTracker() : next_track_id_(1) {}
+    ObjectTracker() : next_track_id_(1), trajectory_length_(TrajectoryBuffer::kDefaultCapacity) {}
     
     /**
      * @brief 初始化目标跟踪器
@@ -41,9 +57,8 @@ public:
      */
     bool initialize(const SystemConfig::TrackerConfig& config) override {
         config_ = config;
-        tracks_.clear();
+        store_.reset(trajectory_length_);
         next_track_id_ = 1;
-        track_ages_.clear();
         
         LOG_INFO("Object tracker initialized successfully");
         LOG_INFO("Max age: {}, Min hits: {}, IOU threshold: {}", 
@@ -56,43 +71,51 @@ public:
      * @brief 更新跟踪状态，关联新检测结果
      * @param detections 当前帧的检测结果
      * @param timestamp 当前帧时间戳
-     * @return std::vector<TrackedObject> 更新后的跟踪目标列表
+     * @return TrackSnapshotHandle 确认轨迹的只读快照
      */
-    std::vector<TrackedObject> update(const std::vector<Detection>& detections, uint64_t timestamp) override {
+    TrackSnapshotHandle update(const std::vector<Detection>& detections, uint64_t timestamp) override {
         // 预测现有轨迹的新位置
-        predictTracks();
+        advanceTracks(true);
         
         // 将检测结果与现有轨迹关联
-        auto matches = associateDetections(detections);
+        associateDetections(detections);
         
         // 更新匹配的轨迹
-        updateMatchedTracks(matches.first, detections, timestamp);
+        updateMatchedTracks(detections, timestamp);
         
         // 为未匹配的检测创建新轨迹
-        createNewTracks(matches.second, detections, timestamp);
+        createNewTracks(detections, timestamp);
         
         // 移除过期的轨迹
         removeExpiredTracks();
         
-        // 返回确认的轨迹
-        std::vector<TrackedObject> confirmed_tracks;
-        for (const auto& track : tracks_) {
-            if (track.is_confirmed) {
-                confirmed_tracks.push_back(track);
-            }
-        }
-        
-        return confirmed_tracks;
+        // 发布确认的轨迹
+        return publishSnapshot();
+    }
+    
+    /**
+     * @brief 不做关联，按线性运动模型把轨迹外推一帧
+     * @param timestamp 当前帧时间戳(轨迹点只来自检测，外推帧不写入轨迹)
+     * @return TrackSnapshotHandle 确认轨迹的只读快照
+     */
+    TrackSnapshotHandle predictTracks(uint64_t timestamp) override {
+        (void)timestamp;
+        advanceTracks(false);
+        return publishSnapshot();
     }
     
     std::vector<TrackedObject> getTracks() const override {
-        return tracks_;
+        std::vector<TrackedObject> tracks;
+        tracks.reserve(store_.active().size());
+        for (int slot : store_.active()) {
+            tracks.push_back(store_[slot]);
+        }
+        return tracks;
     }
     
     void reset() override {
-        tracks_.clear();
+        store_.reset(trajectory_length_);
         next_track_id_ = 1;
-        track_ages_.clear();
         LOG_INFO("Object tracker reset");
     }
     
@@ -104,16 +127,29 @@ public:
         config_.min_hits = min_hits;
     }
     
+    void setIouThreshold(float threshold) override {
+        config_.iou_threshold = threshold;
+    }
+    
+    void setTrajectoryLength(int length) override {
+        trajectory_length_ = static_cast<size_t>(std::max(1, length));
+        if (store_.active().empty()) {
+            store_.reset(trajectory_length_);
+        }
+    }
+    
 private:
     /**
      * @brief 预测现有跟踪目标的下一帧位置
-     * 基于线性运动模型进行简单预测
+     * 基于线性运动模型进行简单预测，从当前位置出发，连续外推时逐帧前进
+     * @param count_miss 是否计为一次漏检(关联前的预测为true，隔帧外推为false)
      */
-    void predictTracks() {
-        for (auto& track : tracks_) {
+    void advanceTracks(bool count_miss) {
+        for (int slot : store_.active()) {
+            TrackedObject& track = store_[slot];
             // 简单的线性预测
             if (track.trajectory.size() >= 2) {
-                cv::Point2f last_pos = track.trajectory.back();
+                cv::Point2f last_pos = track.detection.center;
                 cv::Point2f predicted_pos = last_pos + track.velocity;
                 
                 // 更新边界框位置
@@ -122,80 +158,73 @@ private:
                 track.detection.center = predicted_pos;
             }
             
-            track.consecutive_misses++;
+            if (count_miss) {
+                track.consecutive_misses++;
+            }
         }
     }
     
+    // 发布确认的轨迹
+    TrackSnapshotHandle publishSnapshot() {
+        std::shared_ptr<TrackSnapshot> snapshot = snapshots_.acquire();
+        for (int slot : store_.active()) {
+            if (store_[slot].is_confirmed) {
+                TrackSnapshotPool::append(*snapshot, store_[slot]);
+            }
+        }
+        return snapshot;
+    }
+    
     /**
      * @brief 将检测结果与现有跟踪进行关联
+     * 结果写入matches_(行为store_.active()中的位置)和detection_matched_
      * @param detections 当前帧检测结果
-     * @return 匹配结果和未匹配检测的索引
      */
-    std::pair<std::vector<std::pair<int, int>>, std::vector<int>> 
-    associateDetections(const std::vector<Detection>& detections) {
-        std::vector<std::pair<int, int>> matches;
-        std::vector<int> unmatched_detections;
+    void associateDetections(const std::vector<Detection>& detections) {
+        matches_.clear();
+        detection_matched_.assign(detections.size(), 0);
         
-        if (tracks_.empty()) {
-            // 如果没有现有轨迹，所有检测都是未匹配的
-            for (int i = 0; i < detections.size(); ++i) {
-                unmatched_detections.push_back(i);
-            }
-            return {matches, unmatched_detections};
+        // 如果没有现有轨迹，所有检测都是未匹配的
+        const std::vector<int>& active = store_.active();
+        if (active.empty()) {
+            return;
         }
         
-        // 计算IOU矩阵
-        std::vector<std::vector<float>> iou_matrix(tracks_.size(), std::vector<float>(detections.size(), 0.0f));
-        
-        for (int t = 0; t < tracks_.size(); ++t) {
-            for (int d = 0; d < detections.size(); ++d) {
-                iou_matrix[t][d] = calculateIOU(tracks_[t].detection.bbox, detections[d].bbox);
-            }
+        // 检测框放入均匀网格，每条轨迹只与相邻网格内的检测计算IOU
+        detection_boxes_.clear();
+        for (const auto& detection : detections) {
+            detection_boxes_.push_back(detection.bbox);
         }
+        detection_grid_.build(detection_boxes_);
         
-        // 简单的贪心匹配算法
-        std::vector<bool> track_matched(tracks_.size(), false);
-        std::vector<bool> detection_matched(detections.size(), false);
-        
-        for (int t = 0; t < tracks_.size(); ++t) {
-            if (track_matched[t]) continue;
-            
-            int best_detection = -1;
-            float best_iou = config_.iou_threshold;
-            
-            for (int d = 0; d < detections.size(); ++d) {
-                if (detection_matched[d]) continue;
-                
-                if (iou_matrix[t][d] > best_iou) {
-                    best_iou = iou_matrix[t][d];
-                    best_detection = d;
+        edges_.clear();
+        for (int t = 0; t < active.size(); ++t) {
+            const cv::Rect2f& predicted = store_[active[t]].detection.bbox;
+            candidates_.clear();
+            detection_grid_.query(predicted, candidates_);
+            for (int d : candidates_) {
+                float iou = calculateIOU(predicted, detection_boxes_[d]);
+                if (iou > config_.iou_threshold) {
+                    edges_.push_back({t, d, 1.0f - iou});
                 }
             }
-            
-            if (best_detection != -1) {
-                matches.push_back({t, best_detection});
-                track_matched[t] = true;
-                detection_matched[best_detection] = true;
-            }
         }
         
-        // 收集未匹配的检测
-        for (int d = 0; d < detections.size(); ++d) {
-            if (!detection_matched[d]) {
-                unmatched_detections.push_back(d);
-            }
-        }
+        // 最小化总代价(1-IOU)的最优分配，避免贪心匹配在拥挤场景中抢占错误检测
+        assignment_.solve(static_cast<int>(active.size()), static_cast<int>(detections.size()), edges_, matches_);
         
-        return {matches, unmatched_detections};
+        // 标记已匹配的检测
+        for (const auto& match : matches_) {
+            detection_matched_[match.second] = 1;
+        }
     }
     
-    void updateMatchedTracks(const std::vector<std::pair<int, int>>& matches, 
-                           const std::vector<Detection>& detections, uint64_t timestamp) {
-        for (const auto& match : matches) {
-            int track_idx = match.first;
+    void updateMatchedTracks(const std::vector<Detection>& detections, uint64_t timestamp) {
+        const std::vector<int>& active = store_.active();
+        for (const auto& match : matches_) {
             int detection_idx = match.second;
             
-            TrackedObject& track = tracks_[track_idx];
+            TrackedObject& track = store_[active[match.first]];
             const Detection& detection = detections[detection_idx];
             
             // 更新检测信息
@@ -204,14 +233,9 @@ private:
             track.consecutive_misses = 0;
             track.age++;
             
-            // 更新轨迹
+            // 更新轨迹(环形缓冲区写满后覆盖最旧的点)
             track.trajectory.push_back(detection.center);
             
-            // 限制轨迹长度
-            if (track.trajectory.size() > 50) {
-                track.trajectory.erase(track.trajectory.begin());
-            }
-            
             // 计算速度和加速度
             if (track.trajectory.size() >= 2) {
                 cv::Point2f current_pos = track.trajectory.back();
@@ -236,12 +260,15 @@ private:
         }
     }
     
-    void createNewTracks(const std::vector<int>& unmatched_detections, 
-                        const std::vector<Detection>& detections, uint64_t timestamp) {
-        for (int detection_idx : unmatched_detections) {
+    void createNewTracks(const std::vector<Detection>& detections, uint64_t timestamp) {
+        for (int detection_idx = 0; detection_idx < detections.size(); ++detection_idx) {
+            if (detection_matched_[detection_idx]) {
+                continue;
+            }
             const Detection& detection = detections[detection_idx];
             
-            TrackedObject new_track;
+            // 槽位复用时保留轨迹缓冲区的内存
+            TrackedObject& new_track = store_[store_.allocate()];
             new_track.track_id = next_track_id_++;
             new_track.detection = detection;
             new_track.trajectory.push_back(detection.center);
@@ -255,23 +282,20 @@ private:
             new_track.first_seen = timestamp;
             new_track.last_updated = timestamp;
             
-            tracks_.push_back(new_track);
             LOG_DEBUG("Created new track {}", new_track.track_id);
         }
     }
     
     void removeExpiredTracks() {
-        tracks_.erase(
-            std::remove_if(tracks_.begin(), tracks_.end(),
-                [this](const TrackedObject& track) {
-                    bool should_remove = track.consecutive_misses > config_.max_age;
-                    if (should_remove) {
-                        LOG_DEBUG("Removed expired track {}", track.track_id);
-                    }
-                    return should_remove;
-                }),
-            tracks_.end()
-        );
+        // 倒序遍历：release()把末尾元素换到当前位置，该元素已检查过
+        const std::vector<int>& active = store_.active();
+        for (size_t i = active.size(); i-- > 0;) {
+            const int slot = active[i];
+            if (store_[slot].consecutive_misses > config_.max_age) {
+                LOG_DEBUG("Removed expired track {}", store_[slot].track_id);
+                store_.release(slot);
+            }
+        }
     }
     
     /**
@@ -299,7 +323,63 @@ private:
     }
 };
 
+SimpleTrackerStage::SimpleTrackerStage() = default;
+SimpleTrackerStage::~SimpleTrackerStage() = default;
+SimpleTrackerStage::SimpleTrackerStage(SimpleTrackerStage&&) noexcept = default;
+SimpleTrackerStage& SimpleTrackerStage::operator=(SimpleTrackerStage&&) noexcept = default;
+
+bool SimpleTrackerStage::initialize(const SystemConfig::TrackerConfig& config) {
+    impl_ = std::make_unique<ObjectTracker>();
+    return impl_->initialize(config);
+}
+
+void SimpleTrackerStage::setTrajectoryLength(int length) {
+    impl_->setTrajectoryLength(length);
+}
+
+TrackSnapshotHandle SimpleTrackerStage::update(const std::vector<Detection>& detections, const cv::Mat& frame,
+                                               uint64_t timestamp) {
+    (void)frame;   // 简化跟踪器不使用外观特征
+    return impl_->update(detections, timestamp);
+}
+
+TrackSnapshotHandle SimpleTrackerStage::predictTracks(uint64_t timestamp) {
+    return impl_->predictTracks(timestamp);
+}
+
+namespace {
+
+std::unique_ptr<IObjectTracker> createSimpleTracker() {
+    return std::make_unique<ObjectTracker>();
+}
+
+// 跟踪器注册表，按类型名创建
+struct TrackerRegistryEntry {
+    const char* type;
+    std::unique_ptr<IObjectTracker> (*create)();
+};
+
+const TrackerRegistryEntry kTrackerRegistry[] = {
+    {"simple", createSimpleTracker},
+    {"sort", createSortTracker},
+    {"deepsort", createDeepSortTracker},
+};
+
+} // namespace
+
 // 实现工厂函数
 std::unique_ptr<IObjectTracker> IObjectTracker::create() {
-    return std::make_unique<ObjectTracker>();
+    return createSimpleTracker();
+}
+
+std::unique_ptr<IObjectTracker> IObjectTracker::create(const std::string& type) {
+    std::string name = type;
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    for (const auto& entry : kTrackerRegistry) {
+        if (name == entry.type) {
+            return entry.create();
+        }
+    }
+    LOG_WARN("Unknown tracker type: {}, using simple tracker", type);
+    return createSimpleTracker();
 }
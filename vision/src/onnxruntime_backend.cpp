@@ -0,0 +1,119 @@
+/**
+ * @file onnxruntime_backend.cpp
+ * @brief ONNX Runtime推理后端实现(仅在ENABLE_ONNXRUNTIME=ON时编译)
+ * @author pengchengkang
+ * @date 2025-9-9
+ *
+ * 功能描述：
+ * - 无GPU或未编译TensorRT时的CPU推理后端，开启全部图优化
+ * - 输入张量直接引用预处理生成的blob内存，不做额外拷贝
+ * - 输出张量与OpenCV DNN形状一致，供检测器后处理复用
+ */
+#include "inference_backend.hpp"
+#include "logger.hpp"
+
+#include <onnxruntime_cxx_api.h>
+
+#include <algorithm>
+#include <thread>
+
+/**
+ * @brief ONNX Runtime推理后端
+ */
+class OnnxRuntimeBackend : public IInferenceBackend {
+private:
+    Ort::Env env_;
+    std::unique_ptr<Ort::Session> session_;
+    Ort::MemoryInfo memory_info_;
+    std::vector<std::string> input_names_;
+    std::vector<std::string> output_names_;
+    std::vector<const char*> input_name_ptrs_;
+    std::vector<const char*> output_name_ptrs_;
+    std::vector<Ort::Value> output_values_;   // 持有上一次推理的输出，cv::Mat直接引用其内存
+    int max_batch_ = 1;
+
+public:
+    OnnxRuntimeBackend()
+        : env_(ORT_LOGGING_LEVEL_WARNING, "VehiclePerception"),
+          memory_info_(Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault)) {}
+
+    bool initialize(const SystemConfig::DetectorConfig& config) override {
+        try {
+            Ort::SessionOptions options;
+            options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+            options.SetIntraOpNumThreads(static_cast<int>(std::max(1u, std::thread::hardware_concurrency() / 2)));
+
+            if (config.precision != "fp32") {
+                LOG_WARN("ONNX Runtime CPU backend runs the model at its stored precision, ignoring {}",
+                        config.precision);
+            }
+
+            session_ = std::make_unique<Ort::Session>(env_, config.model_path.c_str(), options);
+
+            Ort::AllocatorWithDefaultOptions allocator;
+            for (size_t i = 0; i < session_->GetInputCount(); ++i) {
+                input_names_.push_back(session_->GetInputNameAllocated(i, allocator).get());
+            }
+            for (size_t i = 0; i < session_->GetOutputCount(); ++i) {
+                output_names_.push_back(session_->GetOutputNameAllocated(i, allocator).get());
+            }
+            if (input_names_.size() != 1 || output_names_.empty()) {
+                LOG_ERROR("ONNX model must have exactly one input, found {}", input_names_.size());
+                return false;
+            }
+            for (const auto& name : input_names_) {
+                input_name_ptrs_.push_back(name.c_str());
+            }
+            for (const auto& name : output_names_) {
+                output_name_ptrs_.push_back(name.c_str());
+            }
+
+            // batch维为-1时为动态batch
+            auto input_shape = session_->GetInputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape();
+            max_batch_ = (!input_shape.empty() && input_shape[0] > 0) ? static_cast<int>(input_shape[0])
+                                                                      : std::max(1, config.batch_size);
+
+            LOG_INFO("ONNX Runtime session ready: inputs={}, outputs={}, max batch={}",
+                    input_names_.size(), output_names_.size(), max_batch_);
+            return true;
+        } catch (const Ort::Exception& e) {
+            LOG_ERROR("Failed to initialize ONNX Runtime backend: {}", e.what());
+            return false;
+        }
+    }
+
+    void forward(const cv::Mat& blob, std::vector<cv::Mat>& outputs) override {
+        const cv::Mat input = blob.isContinuous() ? blob : blob.clone();
+        std::vector<int64_t> shape(input.dims);
+        for (int i = 0; i < input.dims; ++i) {
+            shape[i] = input.size[i];
+        }
+
+        Ort::Value input_tensor = Ort::Value::CreateTensor<float>(
+            memory_info_, const_cast<float*>(input.ptr<float>()), input.total(),
+            shape.data(), shape.size());
+
+        output_values_ = session_->Run(Ort::RunOptions{nullptr},
+                                       input_name_ptrs_.data(), &input_tensor, 1,
+                                       output_name_ptrs_.data(), output_name_ptrs_.size());
+
+        outputs.resize(output_values_.size());
+        for (size_t i = 0; i < output_values_.size(); ++i) {
+            auto out_shape = output_values_[i].GetTensorTypeAndShapeInfo().GetShape();
+            std::vector<int> sizes(out_shape.begin(), out_shape.end());
+            outputs[i] = cv::Mat(sizes, CV_32F, output_values_[i].GetTensorMutableData<float>());
+        }
+    }
+
+    int maxBatchSize() const override {
+        return max_batch_;
+    }
+
+    std::string name() const override {
+        return "onnxruntime";
+    }
+};
+
+std::unique_ptr<IInferenceBackend> createOnnxRuntimeBackend() {
+    return std::make_unique<OnnxRuntimeBackend>();
+}
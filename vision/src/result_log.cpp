@@ -0,0 +1,351 @@
+/**
+ * @file result_log.cpp
+ * @brief 二进制结果日志实现
+ * @author pengchengkang
+ * @date 2025-9-16
+ */
+#include "result_log.hpp"
+#include "logger.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace result_log;
+
+namespace {
+
+// 块在文件中按8字节对齐，映射后可直接按结构体访问
+constexpr size_t kAlignment = 8;
+
+size_t alignedSize(size_t size) {
+    return (size + kAlignment - 1) & ~(kAlignment - 1);
+}
+
+template <typename T>
+void appendPod(std::string& out, const T& value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+} // namespace
+
+// ==================== ResultLogWriter ====================
+
+void ResultLogWriter::begin(std::string& out, int index_interval) {
+    strings_.clear();
+    segment_strings_.clear();
+    next_string_id_ = 1;
+    pending_frames_.clear();
+    pending_strings_.clear();
+    offset_ = 0;
+    last_index_ = 0;
+    index_interval_ = static_cast<size_t>(std::max(1, index_interval));
+    pending_frames_.reserve(index_interval_);
+
+    FileHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(header.magic));
+    header.version = kVersion;
+    header.record_size = sizeof(ResultLogRecord);
+    appendPod(out, header);
+    offset_ += sizeof(header);
+}
+
+void ResultLogWriter::appendChunk(std::string& out, uint32_t type, const void* payload, size_t size) {
+    ChunkHeader header{type, static_cast<uint32_t>(alignedSize(size))};
+    appendPod(out, header);
+    out.append(static_cast<const char*>(payload), size);
+    out.append(header.size - size, '\0');
+    offset_ += sizeof(header) + header.size;
+}
+
+uint32_t ResultLogWriter::intern(std::string& out, const std::string& text,
+                                 std::unordered_map<std::string, uint32_t>& table) {
+    if (text.empty()) {
+        return 0;
+    }
+    auto it = table.find(text);
+    if (it != table.end()) {
+        return it->second;
+    }
+
+    const uint32_t id = next_string_id_++;
+    table.emplace(text, id);
+
+    const uint32_t length = static_cast<uint32_t>(text.size());
+    scratch_.clear();
+    appendPod(scratch_, id);
+    appendPod(scratch_, length);
+    scratch_.append(text);
+
+    pending_strings_.push_back(offset_);
+    appendChunk(out, kChunkString, scratch_.data(), scratch_.size());
+    return id;
+}
+
+void ResultLogWriter::appendFrame(std::string& out, const std::vector<BehaviorAnalysis>& results,
+                                  uint64_t timestamp) {
+    // 字符串块须写在引用它的帧之前
+    records_.resize(results.size());
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BehaviorAnalysis& result = results[i];
+        ResultLogRecord& record = records_[i];
+        record = ResultLogRecord{};
+        record.track_id = result.track_id;
+        record.stream_id = result.stream_id;
+        record.behavior = static_cast<uint8_t>(result.behavior);
+        record.risk_level = static_cast<uint8_t>(result.risk_level);
+        record.confidence = result.confidence;
+        record.location_x = result.location.x;
+        record.location_y = result.location.y;
+        record.distance_to_vehicle = result.distance_to_vehicle;
+        record.time_to_collision = result.time_to_collision;
+        record.timestamp = result.timestamp;
+        record.behavior_name_id = intern(out, result.behavior_name, strings_);
+        record.risk_description_id = intern(out, result.risk_description, strings_);
+        record.llm_analysis_id = intern(out, result.llm_analysis, segment_strings_);
+    }
+
+    pending_frames_.push_back({timestamp, offset_});
+
+    FrameHeader frame{};
+    frame.timestamp = timestamp;
+    frame.count = static_cast<uint32_t>(records_.size());
+    const size_t payload = sizeof(frame) + records_.size() * sizeof(ResultLogRecord);
+    ChunkHeader header{kChunkFrame, static_cast<uint32_t>(payload)};
+    appendPod(out, header);
+    appendPod(out, frame);
+    out.append(reinterpret_cast<const char*>(records_.data()), records_.size() * sizeof(ResultLogRecord));
+    offset_ += sizeof(header) + payload;
+
+    if (pending_frames_.size() >= index_interval_) {
+        appendIndex(out);
+    }
+}
+
+void ResultLogWriter::appendIndex(std::string& out) {
+    if (pending_frames_.empty() && pending_strings_.empty()) {
+        return;
+    }
+
+    IndexHeader index{};
+    index.prev_offset = last_index_;
+    index.frame_count = static_cast<uint32_t>(pending_frames_.size());
+    index.string_count = static_cast<uint32_t>(pending_strings_.size());
+
+    scratch_.clear();
+    appendPod(scratch_, index);
+    scratch_.append(reinterpret_cast<const char*>(pending_frames_.data()),
+                    pending_frames_.size() * sizeof(IndexEntry));
+    scratch_.append(reinterpret_cast<const char*>(pending_strings_.data()),
+                    pending_strings_.size() * sizeof(uint64_t));
+
+    last_index_ = offset_;
+    appendChunk(out, kChunkIndex, scratch_.data(), scratch_.size());
+    pending_frames_.clear();
+    pending_strings_.clear();
+    // 下一段重新写入用到的LLM文本
+    segment_strings_.clear();
+}
+
+void ResultLogWriter::finish(std::string& out) {
+    appendIndex(out);
+    appendChunk(out, kChunkTrailer, &last_index_, sizeof(last_index_));
+}
+
+// ==================== ResultLogReader ====================
+
+ResultLogReader::~ResultLogReader() {
+    close();
+}
+
+bool ResultLogReader::open(const std::string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        LOG_ERROR("Failed to open result log: {}", path);
+        return false;
+    }
+
+    struct stat st {};
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(FileHeader)) {
+        LOG_ERROR("Result log too small: {}", path);
+        ::close(fd);
+        return false;
+    }
+
+    void* mapped = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        LOG_ERROR("Failed to mmap result log: {}", path);
+        return false;
+    }
+    data_ = static_cast<const uint8_t*>(mapped);
+    size_ = static_cast<size_t>(st.st_size);
+
+    FileHeader header;
+    std::memcpy(&header, data_, sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion ||
+        header.record_size != sizeof(ResultLogRecord)) {
+        LOG_ERROR("Unsupported result log format: {}", path);
+        close();
+        return false;
+    }
+
+    // 正常关闭的文件以TRAILER结尾，沿索引链加载；否则逐块扫描
+    bool indexed = false;
+    const size_t trailer_size = sizeof(ChunkHeader) + sizeof(uint64_t);
+    if (size_ >= sizeof(FileHeader) + trailer_size) {
+        ChunkHeader trailer;
+        const uint64_t trailer_offset = size_ - trailer_size;
+        if (readChunk(trailer_offset, trailer) && trailer.type == kChunkTrailer) {
+            uint64_t last_index;
+            std::memcpy(&last_index, data_ + trailer_offset + sizeof(ChunkHeader), sizeof(last_index));
+            indexed = loadFromIndex(last_index);
+        }
+    }
+    if (!indexed) {
+        LOG_WARN("Result log {} has no valid index, scanning", path);
+        loadByScan();
+    }
+
+    LOG_INFO("Result log {} opened: {} frames, {} strings", path, frames_.size(), strings_.size());
+    return true;
+}
+
+void ResultLogReader::close() {
+    if (data_) {
+        ::munmap(const_cast<uint8_t*>(data_), size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    frames_.clear();
+    strings_.clear();
+}
+
+bool ResultLogReader::readChunk(uint64_t offset, ChunkHeader& header) const {
+    if (offset % kAlignment != 0 || offset + sizeof(ChunkHeader) > size_) {
+        return false;
+    }
+    std::memcpy(&header, data_ + offset, sizeof(header));
+    return offset + sizeof(ChunkHeader) + header.size <= size_;
+}
+
+void ResultLogReader::addString(uint64_t offset) {
+    ChunkHeader header;
+    if (!readChunk(offset, header) || header.type != kChunkString || header.size < 2 * sizeof(uint32_t)) {
+        return;
+    }
+    const uint8_t* payload = data_ + offset + sizeof(ChunkHeader);
+    uint32_t id, length;
+    std::memcpy(&id, payload, sizeof(id));
+    std::memcpy(&length, payload + sizeof(id), sizeof(length));
+    if (length <= header.size - 2 * sizeof(uint32_t)) {
+        strings_[id] = {reinterpret_cast<const char*>(payload + 2 * sizeof(uint32_t)), length};
+    }
+}
+
+bool ResultLogReader::loadFromIndex(uint64_t last_index) {
+    // 索引链从后往前，收集后按文件顺序拼接
+    std::vector<const uint8_t*> blocks;
+    uint64_t offset = last_index;
+    while (offset != 0) {
+        ChunkHeader header;
+        if (!readChunk(offset, header) || header.type != kChunkIndex || header.size < sizeof(IndexHeader)) {
+            return false;
+        }
+        const uint8_t* payload = data_ + offset + sizeof(ChunkHeader);
+        IndexHeader index;
+        std::memcpy(&index, payload, sizeof(index));
+        const size_t expected = sizeof(IndexHeader) + index.frame_count * sizeof(IndexEntry) +
+                                index.string_count * sizeof(uint64_t);
+        if (expected > header.size || (index.prev_offset != 0 && index.prev_offset >= offset)) {
+            return false;
+        }
+        blocks.push_back(payload);
+        offset = index.prev_offset;
+    }
+
+    frames_.clear();
+    strings_.clear();
+    for (auto it = blocks.rbegin(); it != blocks.rend(); ++it) {
+        IndexHeader index;
+        std::memcpy(&index, *it, sizeof(index));
+        const auto* entries = reinterpret_cast<const IndexEntry*>(*it + sizeof(IndexHeader));
+        frames_.insert(frames_.end(), entries, entries + index.frame_count);
+
+        const auto* string_offsets = reinterpret_cast<const uint64_t*>(entries + index.frame_count);
+        for (uint32_t i = 0; i < index.string_count; ++i) {
+            addString(string_offsets[i]);
+        }
+    }
+    return true;
+}
+
+void ResultLogReader::loadByScan() {
+    frames_.clear();
+    strings_.clear();
+
+    uint64_t offset = sizeof(FileHeader);
+    ChunkHeader header;
+    while (readChunk(offset, header)) {
+        if (header.type == kChunkFrame && header.size >= sizeof(FrameHeader)) {
+            FrameHeader frame;
+            std::memcpy(&frame, data_ + offset + sizeof(ChunkHeader), sizeof(frame));
+            if (sizeof(FrameHeader) + frame.count * sizeof(ResultLogRecord) > header.size) {
+                break;
+            }
+            frames_.push_back({frame.timestamp, offset});
+        } else if (header.type == kChunkString) {
+            addString(offset);
+        }
+        offset += sizeof(ChunkHeader) + header.size;
+    }
+}
+
+ResultLogReader::Frame ResultLogReader::frame(size_t index) const {
+    Frame result;
+    if (index >= frames_.size()) {
+        return result;
+    }
+    const uint8_t* chunk = data_ + frames_[index].offset + sizeof(ChunkHeader);
+    FrameHeader header;
+    std::memcpy(&header, chunk, sizeof(header));
+    result.timestamp = header.timestamp;
+    result.records = reinterpret_cast<const ResultLogRecord*>(chunk + sizeof(FrameHeader));
+    result.count = header.count;
+    return result;
+}
+
+size_t ResultLogReader::seek(uint64_t timestamp) const {
+    auto it = std::lower_bound(frames_.begin(), frames_.end(), timestamp,
+                               [](const IndexEntry& entry, uint64_t value) { return entry.timestamp < value; });
+    return static_cast<size_t>(it - frames_.begin());
+}
+
+std::string ResultLogReader::string(uint32_t id) const {
+    auto it = strings_.find(id);
+    if (it == strings_.end()) {
+        return std::string();
+    }
+    return std::string(it->second.first, it->second.second);
+}
+
+BehaviorAnalysis ResultLogReader::decode(const ResultLogRecord& record) const {
+    BehaviorAnalysis analysis;
+    analysis.track_id = record.track_id;
+    analysis.stream_id = record.stream_id;
+    analysis.behavior = static_cast<BehaviorType>(record.behavior);
+    analysis.risk_level = static_cast<RiskLevel>(record.risk_level);
+    analysis.confidence = record.confidence;
+    analysis.location = cv::Point2f(record.location_x, record.location_y);
+    analysis.distance_to_vehicle = record.distance_to_vehicle;
+    analysis.time_to_collision = record.time_to_collision;
+    analysis.timestamp = record.timestamp;
+    analysis.behavior_name = string(record.behavior_name_id);
+    analysis.risk_description = string(record.risk_description_id);
+    analysis.llm_analysis = string(record.llm_analysis_id);
+    return analysis;
+}
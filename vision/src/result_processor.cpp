@@ -9,15 +9,79 @@
  * - 支持多种输出格式（视频、图像、JSON日志）
  * - 提供实时性能统计和结果保存功能
  * - 可配置的可视化样式和输出选项
+ *
+ * 异步写出：
+ * - process()只把结果和帧引用放入有界队列，绘制、视频编码和JSON序列化都在写出线程中执行
+ * - 结果记录序列化到内存缓冲区，累计flush_bytes字节或间隔flush_interval_ms毫秒才写盘
+ * - results_format选择结果格式：json(JSON数组，每帧一行)、ndjson(每行一个独立的JSON对象，
+ *   可追加、可流式读取)、binary(定长记录的二进制日志，见result_log.hpp)
+ * - 写出线程积压时先丢弃可视化帧(同时在途的帧不超过video_queue_size)，
+ *   结果记录队列(result_queue_size)满时才丢弃最旧的记录
+ *
+ * 视频录制：
+ * - 编码器见video_encoder.hpp，帧率取视频源的实际帧率
+ * - video_fps/video_scale降低录制帧率和分辨率，叠加信息在缩放后的帧上绘制，抽掉的帧不绘制
+ * - 不缩放时直接在池化缓冲区上绘制；缓冲区仍被其他持有者引用(如视频源保留的断流重发帧)时
+ *   绘制在复用的画布上，不改写共享的像素
+ * - video_record_mode为events时只录制事件片段：出现高风险/严重风险目标时打开新片段，
+ *   先写入预录环形缓冲区中的最近event_pre_seconds秒，风险消失event_post_seconds秒后关闭
  */
 
 #include "module_interface.hpp"
+#include "bounded_queue.hpp"
+#include "result_log.hpp"
+#include "video_encoder.hpp"
 #include "logger.hpp"
 #include <opencv2/opencv.hpp>
 #include <nlohmann/json.hpp>
 #include <fstream>
 #include <iomanip>
 #include <sstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// 交给写出线程的一帧输出
+struct OutputRecord {
+    std::vector<BehaviorAnalysis> results;
+    cv::Mat frame;                // 待绘制和编码的帧，丢弃可视化时为空
+    FrameHandle frame_buffer;     // frame所在的池化缓冲区，编码完成前不归还
+    std::shared_ptr<void> frame_lease; // 在途帧计数的租约，记录写出或被队列丢弃时归还
+    uint64_t timestamp = 0;
+};
+
+// 结果文件格式
+enum class ResultsFormat {
+    JSON,
+    NDJSON,
+    BINARY
+};
+
+ResultsFormat parseResultsFormat(const std::string& name) {
+    if (name == "ndjson") return ResultsFormat::NDJSON;
+    if (name == "binary") return ResultsFormat::BINARY;
+    if (name != "json") {
+        LOG_WARN("Unknown results format '{}', falling back to json", name);
+    }
+    return ResultsFormat::JSON;
+}
+
+const char* resultsExtension(ResultsFormat format) {
+    switch (format) {
+        case ResultsFormat::NDJSON: return ".ndjson";
+        case ResultsFormat::BINARY: return ".vpsr";
+        default: return ".json";
+    }
+}
+
+} // namespace
 
 /**
  * @brief 结果处理器实现类
@@ -26,13 +90,43 @@
 class ResultProcessor : public IResultProcessor {
 private:
     SystemConfig::OutputConfig config_;
-    cv::Mat processed_frame_;
-    std::vector<BehaviorAnalysis> current_results_;
-    cv::VideoWriter video_writer_;
-    std::ofstream results_file_;
     std::string session_id_;
-    int frame_count_;
-    double total_processing_time_;
+    
+    std::atomic<double> source_fps_{0.0};
+    
+    // 以下成员只在写出线程中访问
+    VideoEncoder encoder_;
+    cv::Mat canvas_;                          // 缩放录制或帧缓冲区共享时的绘制画布
+    double frame_credit_ = 1.0;               // 降帧率抽帧累加器
+    bool event_mode_ = false;
+    uint64_t event_until_ = 0;                // 当前事件片段的结束时间戳
+    int event_count_ = 0;
+    std::vector<cv::Mat> preroll_;            // 预录环形缓冲区
+    size_t preroll_head_ = 0;
+    size_t preroll_count_ = 0;
+    std::ofstream results_file_;
+    ResultsFormat results_format_ = ResultsFormat::JSON;
+    ResultLogWriter log_writer_;
+    std::string write_buffer_;
+    bool first_record_ = true;
+    std::chrono::steady_clock::time_point last_flush_;
+    
+    // 最近一帧的结果，供saveResults()读取
+    std::vector<BehaviorAnalysis> current_results_;
+    mutable std::mutex current_mutex_;
+    
+    std::unique_ptr<BoundedQueue<OutputRecord>> queue_;
+    std::thread writer_;
+    std::atomic<int> frames_in_flight_{0};
+    std::atomic<uint64_t> dropped_frames_{0};
+    
+    // flush()等待已提交的记录落盘
+    std::mutex idle_mutex_;
+    std::condition_variable idle_cv_;
+    uint64_t submitted_ = 0;
+    uint64_t written_ = 0;        // 已序列化的记录数(写出线程)
+    uint64_t persisted_ = 0;      // 已写入文件的记录数
+    std::atomic<bool> flush_requested_{false};
     
     // 颜色定义
     const cv::Scalar COLOR_SAFE = cv::Scalar(0, 255, 0);        // 绿色
@@ -45,7 +139,7 @@ public:
     /**
      * @brief 构造函数，初始化结果处理器
      */
-    ResultProcessor() : frame_count_(0), total_processing_time_(0.0) {
+    ResultProcessor() {
         // 生成会话ID
         auto now = std::chrono::system_clock::now();
         auto time_t = std::chrono::system_clock::to_time_t(now);
@@ -56,13 +150,8 @@ public:
         session_id_ = oss.str();
     }
     
-    ~ResultProcessor() {
-        if (video_writer_.isOpened()) {
-            video_writer_.release();
-        }
-        if (results_file_.is_open()) {
-            results_file_.close();
-        }
+    ~ResultProcessor() override {
+        shutdown();
     }
     
     /**
@@ -71,6 +160,7 @@ public:
      * @return bool 初始化是否成功
      */
     bool initialize(const SystemConfig::OutputConfig& config) override {
+        shutdown();
         config_ = config;
         
         // 创建输出目录
@@ -78,16 +168,43 @@ public:
             std::filesystem::create_directories(config.video_path);
         }
         
+        std::string record_mode = config.video_record_mode;
+        std::transform(record_mode.begin(), record_mode.end(), record_mode.begin(), ::tolower);
+        event_mode_ = record_mode == "events";
+        if (!event_mode_ && record_mode != "continuous") {
+            LOG_WARN("Unknown video record mode {}, recording continuously", config.video_record_mode);
+        }
+        frame_credit_ = 1.0;
+        event_until_ = 0;
+        event_count_ = 0;
+        preroll_head_ = 0;
+        preroll_count_ = 0;
+        
+        first_record_ = true;
+        write_buffer_.clear();
+        write_buffer_.reserve(static_cast<size_t>(std::max(4096, config_.flush_bytes)) * 2);
+        results_format_ = parseResultsFormat(config.results_format);
+        
         if (config.save_results) {
             std::filesystem::create_directories(config.results_path);
             
-            // 打开结果文件
-            std::string results_filename = config.results_path + "results_" + session_id_ + ".json";
-            results_file_.open(results_filename);
+            // 打开结果文件，文件头随第一次写盘写入
+            std::string results_filename = config.results_path + "results_" + session_id_ +
+                                           resultsExtension(results_format_);
+            results_file_.open(results_filename, std::ios::binary);
             if (results_file_.is_open()) {
-                results_file_ << "[\n";
+                if (results_format_ == ResultsFormat::JSON) {
+                    write_buffer_ += "[\n";
+                } else if (results_format_ == ResultsFormat::BINARY) {
+                    log_writer_.begin(write_buffer_, config_.index_interval);
+                }
             }
         }
+        last_flush_ = std::chrono::steady_clock::now();
+        
+        queue_ = std::make_unique<BoundedQueue<OutputRecord>>(
+            static_cast<size_t>(std::max(1, config_.result_queue_size)), OverflowPolicy::DROP_OLDEST);
+        writer_ = std::thread(&ResultProcessor::writerLoop, this);
         
         LOG_INFO("Result processor initialized successfully");
         LOG_INFO("Save video: {}, Save results: {}", config.save_video, config.save_results);
@@ -96,36 +213,64 @@ public:
     }
     
     /**
-     * @brief 处理和可视化检测结果
-     * @param frame 原始视频帧
-     * @param results 检测结果列表
+     * @brief 把结果和帧引用交给写出线程，立即返回
+     * @param results 行为分析结果
+     * @param frame 原始视频帧(可为空)
+     * @param frame_buffer frame所在的池化缓冲区(可为空)
      * @param timestamp 时间戳
      */
-    void process(const std::vector<BehaviorAnalysis>& results,
-                const cv::Mat& frame, uint64_t timestamp) override {
-        if (frame.empty()) return;
+    void process(std::vector<BehaviorAnalysis> results, const cv::Mat& frame,
+                 FrameHandle frame_buffer, uint64_t timestamp) override {
+        if (!queue_) {
+            return;
+        }
         
-        current_results_ = results;
-        processed_frame_ = frame.clone();
+        OutputRecord record;
+        record.results = std::move(results);
+        record.timestamp = timestamp;
         
-        // 绘制检测结果
-        if (config_.draw_bboxes || config_.draw_labels || config_.draw_trails) {
-            drawResults(processed_frame_, results);
+        // 只有保存视频时才需要帧；在途帧过多时丢弃可视化，保留结果记录
+        // GPU解码且无需绘制时不下载帧，此时只保存分析结果
+        if (config_.save_video && !frame.empty()) {
+            if (frames_in_flight_.load(std::memory_order_relaxed) < std::max(1, config_.video_queue_size)) {
+                frames_in_flight_.fetch_add(1, std::memory_order_relaxed);
+                record.frame_lease = std::shared_ptr<void>(nullptr, [this](void*) {
+                    frames_in_flight_.fetch_sub(1, std::memory_order_relaxed);
+                });
+                record.frame = frame;
+                record.frame_buffer = std::move(frame_buffer);
+            } else {
+                dropped_frames_.fetch_add(1, std::memory_order_relaxed);
+            }
         }
         
-        // 保存视频帧
-        if (config_.save_video) {
-            saveVideoFrame(processed_frame_, timestamp);
+        {
+            std::lock_guard<std::mutex> lock(idle_mutex_);
+            submitted_++;
         }
-        
-        // 保存分析结果
-        if (config_.save_results) {
-            saveResults(results, timestamp);
+        queue_->push(std::move(record));
+    }
+    
+    /**
+     * @brief 等待已提交的输出全部写入文件
+     */
+    void flush() override {
+        if (!queue_ || !writer_.joinable()) {
+            return;
         }
+        flush_requested_ = true;
+        std::unique_lock<std::mutex> lock(idle_mutex_);
+        // 被队列丢弃的记录不会写出，一并计入
+        idle_cv_.wait_for(lock, std::chrono::seconds(5), [this]() {
+            return persisted_ + queue_->droppedCount() >= submitted_;
+        });
     }
     
-    cv::Mat getProcessedFrame() const override {
-        return processed_frame_;
+    /**
+     * @brief 设置视频源帧率，录制视频时使用
+     */
+    void setSourceFps(double fps) override {
+        source_fps_ = fps;
     }
     
     bool saveResults(const std::string& path) const override {
@@ -135,6 +280,7 @@ public:
                 return false;
             }
             
+            std::lock_guard<std::mutex> lock(current_mutex_);
             file << "[\n";
             for (size_t i = 0; i < current_results_.size(); ++i) {
                 file << current_results_[i].toJson().dump(2);
@@ -153,15 +299,20 @@ public:
     }
     
 private:
-    void drawResults(cv::Mat& frame, const std::vector<BehaviorAnalysis>& results) {
+    /**
+     * @brief 绘制叠加信息
+     * @param scale 画布相对原始帧的缩放比例，结果坐标按此缩放
+     */
+    void drawResults(cv::Mat& frame, const std::vector<BehaviorAnalysis>& results, float scale) {
         for (const auto& result : results) {
             cv::Scalar color = getRiskColor(result.risk_level);
+            const cv::Point2f location = result.location * scale;
             
             // 绘制边界框（需要从跟踪结果中获取）
             if (config_.draw_bboxes) {
                 // 这里简化处理，实际需要从跟踪器获取边界框信息
-                cv::Point2f center = result.location;
-                cv::Rect bbox(center.x - 50, center.y - 50, 100, 100);
+                const float half = 50.0f * scale;
+                cv::Rect bbox(location.x - half, location.y - half, 2 * half, 2 * half);
                 cv::rectangle(frame, bbox, color, 2);
             }
             
@@ -170,7 +321,7 @@ private:
                 std::string label = result.behavior_name + " (" + 
                                   std::to_string(static_cast<int>(result.confidence * 100)) + "%)";
                 
-                cv::Point2f label_pos(result.location.x, result.location.y - 10);
+                cv::Point2f label_pos(location.x, location.y - 10);
                 
                 // 绘制背景
                 int baseline = 0;
@@ -186,7 +337,7 @@ private:
                 
                 // 绘制风险描述
                 if (!result.risk_description.empty()) {
-                    cv::Point2f risk_pos(result.location.x, result.location.y + 20);
+                    cv::Point2f risk_pos(location.x, location.y + 20);
                     cv::putText(frame, result.risk_description, risk_pos, 
                                cv::FONT_HERSHEY_SIMPLEX, 0.4, color, 1);
                 }
@@ -195,7 +346,7 @@ private:
                 if (result.distance_to_vehicle > 0) {
                     std::string distance_text = "Dist: " + 
                         std::to_string(static_cast<int>(result.distance_to_vehicle)) + "m";
-                    cv::Point2f dist_pos(result.location.x, result.location.y + 35);
+                    cv::Point2f dist_pos(location.x, location.y + 35);
                     cv::putText(frame, distance_text, dist_pos, 
                                cv::FONT_HERSHEY_SIMPLEX, 0.4, color, 1);
                 }
@@ -203,7 +354,7 @@ private:
                 if (result.time_to_collision > 0) {
                     std::string ttc_text = "TTC: " + 
                         std::to_string(static_cast<int>(result.time_to_collision)) + "s";
-                    cv::Point2f ttc_pos(result.location.x, result.location.y + 50);
+                    cv::Point2f ttc_pos(location.x, location.y + 50);
                     cv::putText(frame, ttc_text, ttc_pos, 
                                cv::FONT_HERSHEY_SIMPLEX, 0.4, color, 1);
                 }
@@ -260,25 +411,145 @@ private:
         }
     }
     
-    void saveVideoFrame(const cv::Mat& frame, uint64_t timestamp) {
-        if (!video_writer_.isOpened()) {
-            // 初始化视频写入器
-            std::string video_filename = config_.video_path + "output_" + session_id_ + ".mp4";
-            int fourcc = cv::VideoWriter::fourcc('m', 'p', '4', 'v');
-            video_writer_.open(video_filename, fourcc, 30.0, frame.size());
-            
-            if (!video_writer_.isOpened()) {
-                LOG_ERROR("Failed to open video writer: {}", video_filename);
+    // 录制帧率：video_fps为0或高于源帧率时取源帧率
+    double recordFps() const {
+        double source = source_fps_.load();
+        if (source <= 0.0) {
+            source = 30.0;
+        }
+        return config_.video_fps > 0.0f ? std::min<double>(config_.video_fps, source) : source;
+    }
+    
+    /**
+     * @brief 录制一帧：抽帧、缩放绘制，按录制模式写入编码器或预录缓冲区
+     */
+    void saveVideoFrame(cv::Mat& frame, bool frame_shared, const std::vector<BehaviorAnalysis>& results,
+                        uint64_t timestamp) {
+        // 事件判定使用全部帧，与抽帧无关
+        bool risky = false;
+        if (event_mode_) {
+            for (const auto& result : results) {
+                if (result.risk_level == RiskLevel::HIGH_RISK || result.risk_level == RiskLevel::CRITICAL_RISK) {
+                    risky = true;
+                    break;
+                }
+            }
+            if (risky) {
+                event_until_ = timestamp + static_cast<uint64_t>(std::max(0.0f, config_.event_post_seconds) * 1000.0f);
+            }
+        }
+        
+        // 降帧率：按录制帧率与源帧率之比累加，满1帧时保留
+        double source = source_fps_.load();
+        frame_credit_ += source > 0.0 ? recordFps() / source : 1.0;
+        if (frame_credit_ < 1.0) {
+            return;
+        }
+        frame_credit_ -= 1.0;
+        
+        cv::Mat& canvas = renderFrame(frame, frame_shared, results);
+        
+        if (!event_mode_) {
+            if (!encoder_.isOpened() &&
+                !openEncoder(config_.video_path + "output_" + session_id_ + ".mp4", canvas.size())) {
                 return;
             }
+            encoder_.write(canvas);
+            return;
         }
         
-        video_writer_.write(frame);
+        if (encoder_.isOpened()) {
+            encoder_.write(canvas);
+            if (timestamp >= event_until_) {
+                encoder_.close();
+                LOG_INFO("Event clip {} closed", event_count_);
+            }
+            return;
+        }
+        
+        // 风险帧可能被抽掉，以事件窗口判定
+        if (risky || timestamp < event_until_) {
+            // 新事件：先写入预录帧(按时间顺序)，再写当前帧
+            event_count_++;
+            std::string path = config_.video_path + "event_" + session_id_ + "_" +
+                               std::to_string(event_count_) + ".mp4";
+            if (openEncoder(path, canvas.size())) {
+                const size_t capacity = preroll_.size();
+                for (size_t i = 0; i < preroll_count_; ++i) {
+                    const cv::Mat& buffered = preroll_[(preroll_head_ + capacity - preroll_count_ + i) % capacity];
+                    if (buffered.size() == canvas.size()) {
+                        encoder_.write(buffered);
+                    }
+                }
+                encoder_.write(canvas);
+                LOG_INFO("Event clip {} started with {} pre-roll frames", event_count_, preroll_count_);
+            }
+            preroll_count_ = 0;
+            return;
+        }
+        
+        pushPreroll(canvas);
+    }
+    
+    /**
+     * @brief 按录制分辨率绘制帧：不缩放时直接在池化缓冲区上绘制，否则缩放到复用的画布上
+     * @param frame_shared 帧所在缓冲区仍有其他持有者，需绘制时先复制到画布
+     */
+    cv::Mat& renderFrame(cv::Mat& frame, bool frame_shared, const std::vector<BehaviorAnalysis>& results) {
+        const float scale = config_.video_scale > 0.0f && config_.video_scale < 1.0f ? config_.video_scale : 1.0f;
+        const bool draw = config_.draw_bboxes || config_.draw_labels || config_.draw_trails;
+        cv::Mat* target = &frame;
+        if (scale < 1.0f) {
+            // 编码器要求偶数尺寸
+            cv::Size size(std::max(2, static_cast<int>(frame.cols * scale) & ~1),
+                          std::max(2, static_cast<int>(frame.rows * scale) & ~1));
+            cv::resize(frame, canvas_, size, 0, 0, cv::INTER_AREA);
+            target = &canvas_;
+        } else if (draw && frame_shared) {
+            frame.copyTo(canvas_);
+            target = &canvas_;
+        }
+        
+        if (draw) {
+            drawResults(*target, results, scale);
+        }
+        return *target;
+    }
+    
+    /**
+     * @brief 把绘制好的帧存入预录环形缓冲区，缓冲区内存循环复用
+     */
+    void pushPreroll(const cv::Mat& canvas) {
+        const size_t capacity = static_cast<size_t>(
+            std::max(0.0, std::ceil(std::max(0.0f, config_.event_pre_seconds) * recordFps())));
+        if (capacity == 0) {
+            return;
+        }
+        if (preroll_.size() != capacity) {
+            preroll_.assign(capacity, cv::Mat());
+            preroll_head_ = 0;
+            preroll_count_ = 0;
+        }
+        canvas.copyTo(preroll_[preroll_head_]);
+        preroll_head_ = (preroll_head_ + 1) % capacity;
+        preroll_count_ = std::min(preroll_count_ + 1, capacity);
     }
     
+    bool openEncoder(const std::string& path, const cv::Size& size) {
+        return encoder_.open(path, size, recordFps(), config_.video_encoder, config_.video_bitrate_kbps);
+    }
+    
+    /**
+     * @brief 把一帧结果按所选格式序列化追加到写缓冲区
+     */
     void saveResults(const std::vector<BehaviorAnalysis>& results, uint64_t timestamp) {
         if (!results_file_.is_open()) return;
         
+        if (results_format_ == ResultsFormat::BINARY) {
+            log_writer_.appendFrame(write_buffer_, results, timestamp);
+            return;
+        }
+        
         nlohmann::json frame_data;
         frame_data["timestamp"] = timestamp;
         frame_data["results"] = nlohmann::json::array();
@@ -287,14 +558,123 @@ private:
             frame_data["results"].push_back(result.toJson());
         }
         
-        static bool first_frame = true;
-        if (!first_frame) {
-            results_file_ << ",\n";
+        if (results_format_ == ResultsFormat::NDJSON) {
+            write_buffer_ += frame_data.dump();
+            write_buffer_ += '\n';
+            return;
+        }
+        
+        if (!first_record_) {
+            write_buffer_ += ",\n";
+        }
+        first_record_ = false;
+        
+        write_buffer_ += frame_data.dump();
+    }
+    
+    /**
+     * @brief 写出线程：处理队列中的记录，按大小或时间批量写盘
+     */
+    void writerLoop() {
+        const auto flush_interval = std::chrono::milliseconds(std::max(1, config_.flush_interval_ms));
+        const size_t flush_bytes = static_cast<size_t>(std::max(1, config_.flush_bytes));
+        
+        OutputRecord record;
+        while (true) {
+            if (queue_->popFor(record, flush_interval)) {
+                writeRecord(record);
+                record = OutputRecord();
+                written_++;
+            } else if (queue_->isClosed()) {
+                break;
+            }
+            
+            // 缓冲区满或距上次写盘超过间隔时写盘；flush()请求在队列排空后立即写盘
+            auto now = std::chrono::steady_clock::now();
+            if (write_buffer_.size() >= flush_bytes || now - last_flush_ >= flush_interval ||
+                (flush_requested_ && queue_->size() == 0)) {
+                flushBuffer(now);
+            }
+        }
+        
+        flushBuffer(std::chrono::steady_clock::now());
+    }
+    
+    /**
+     * @brief 绘制并编码帧，序列化结果
+     */
+    void writeRecord(OutputRecord& record) {
+        if (!record.frame.empty()) {
+            // 写出线程通常是帧的最后使用者，不缩放时直接在池化缓冲区上绘制，不再复制整帧；
+            // 缓冲区仍被其他持有者引用时引用计数只会减少，此时绘制到画布上
+            const bool frame_shared = record.frame_buffer && record.frame_buffer.use_count() > 1;
+            saveVideoFrame(record.frame, frame_shared, record.results, record.timestamp);
+            
+            // 先释放像素引用再归还缓冲区
+            record.frame.release();
+            record.frame_buffer.reset();
+            record.frame_lease.reset();
+        }
+        
+        if (config_.save_results) {
+            saveResults(record.results, record.timestamp);
+        }
+        
+        std::lock_guard<std::mutex> lock(current_mutex_);
+        current_results_.swap(record.results);
+    }
+    
+    void flushBuffer(std::chrono::steady_clock::time_point now) {
+        last_flush_ = now;
+        flush_requested_ = false;
+        if (!write_buffer_.empty() && results_file_.is_open()) {
+            results_file_.write(write_buffer_.data(), static_cast<std::streamsize>(write_buffer_.size()));
+            results_file_.flush();
+            write_buffer_.clear();
         }
-        first_frame = false;
         
-        results_file_ << frame_data.dump(2);
-        results_file_.flush();
+        {
+            std::lock_guard<std::mutex> lock(idle_mutex_);
+            persisted_ = written_;
+        }
+        idle_cv_.notify_all();
+    }
+    
+    /**
+     * @brief 排空队列并停止写出线程，关闭输出文件
+     */
+    void shutdown() {
+        if (queue_) {
+            queue_->close();
+        }
+        if (writer_.joinable()) {
+            writer_.join();
+            if (dropped_frames_ > 0 || queue_->droppedCount() > 0) {
+                LOG_WARN("Result writer overloaded: {} video frames and {} result records dropped",
+                         dropped_frames_.load(), queue_->droppedCount());
+            }
+        }
+        queue_.reset();
+        
+        encoder_.close();
+        preroll_.clear();
+        canvas_.release();
+        if (results_file_.is_open()) {
+            // 补齐文件尾：JSON数组的结束括号，二进制日志的最后索引块和TRAILER
+            if (results_format_ == ResultsFormat::JSON) {
+                write_buffer_ += "\n]\n";
+            } else if (results_format_ == ResultsFormat::BINARY) {
+                log_writer_.finish(write_buffer_);
+            }
+            results_file_.write(write_buffer_.data(), static_cast<std::streamsize>(write_buffer_.size()));
+            write_buffer_.clear();
+            results_file_.close();
+        }
+        frames_in_flight_ = 0;
+        dropped_frames_ = 0;
+        submitted_ = 0;
+        written_ = 0;
+        persisted_ = 0;
     }
 };
 
@@ -0,0 +1,525 @@
+/**
+ * @file tensorrt_backend.cpp
+ * @brief TensorRT推理后端实现(仅在ENABLE_TENSORRT=ON时编译)
+ * @author pengchengkang
+ * @date 2025-9-9
+ *
+ * 功能描述：
+ * - 直接加载序列化引擎(.engine/.plan)
+ * - 从ONNX构建引擎，支持FP16和INT8(熵校准，校准图像取自calibration_path)
+ * - 构建结果序列化保存到engine_cache_dir，文件名由模型内容哈希、精度、输入尺寸、最大batch、
+ *   GPU型号与算力和TensorRT版本共同决定，下次启动直接加载；换GPU或升级TensorRT时自动重新构建
+ * - 动态batch模型按batch_size创建优化配置
+ * - 设备缓冲区和锁页主机输出缓冲区按最大batch一次分配，推理时不再分配
+ */
+#include "inference_backend.hpp"
+#include "logger.hpp"
+
+#include <opencv2/dnn.hpp>
+
+#include <NvInfer.h>
+#include <NvOnnxParser.h>
+#include <cuda_runtime_api.h>
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+// CUDA调用检查，失败时抛出异常由检测器统一处理
+void checkCuda(cudaError_t status, const char* what) {
+    if (status != cudaSuccess) {
+        throw std::runtime_error(std::string(what) + ": " + cudaGetErrorString(status));
+    }
+}
+
+// TensorRT日志适配到系统日志
+class TrtLogger : public nvinfer1::ILogger {
+public:
+    void log(Severity severity, const char* msg) noexcept override {
+        switch (severity) {
+            case Severity::kINTERNAL_ERROR:
+            case Severity::kERROR:
+                LOG_ERROR("[TensorRT] {}", msg);
+                break;
+            case Severity::kWARNING:
+                LOG_WARN("[TensorRT] {}", msg);
+                break;
+            case Severity::kINFO:
+                LOG_DEBUG("[TensorRT] {}", msg);
+                break;
+            default:
+                break;
+        }
+    }
+};
+
+TrtLogger& trtLogger() {
+    static TrtLogger logger;
+    return logger;
+}
+
+// TensorRT对象删除器
+struct TrtDeleter {
+    template <typename T>
+    void operator()(T* obj) const {
+        delete obj;
+    }
+};
+
+template <typename T>
+using TrtPtr = std::unique_ptr<T, TrtDeleter>;
+
+size_t volume(const nvinfer1::Dims& dims) {
+    size_t v = 1;
+    for (int i = 0; i < dims.nbDims; ++i) {
+        v *= static_cast<size_t>(std::max<int64_t>(dims.d[i], 1));
+    }
+    return v;
+}
+
+// 64位FNV-1a哈希，用于按模型内容生成引擎缓存键
+uint64_t fnv1a(const char* data, size_t size, uint64_t hash = 14695981039346656037ull) {
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+/**
+ * @brief 引擎缓存文件路径
+ * 模型内容、精度(INT8另含校准数据目录)、输入尺寸、最大batch、GPU型号与算力、TensorRT版本
+ * 任一项不同都对应不同的文件，不会加载与当前环境不兼容的引擎
+ */
+std::filesystem::path engineCachePath(const SystemConfig::DetectorConfig& config, const std::vector<char>& model) {
+    cudaDeviceProp prop{};
+    checkCuda(cudaGetDeviceProperties(&prop, config.device_id), "cudaGetDeviceProperties");
+    std::string gpu = prop.name;
+    std::replace_if(gpu.begin(), gpu.end(), [](unsigned char c) { return !std::isalnum(c); }, '_');
+
+    uint64_t hash = fnv1a(model.data(), model.size());
+    if (config.precision == "int8") {
+        hash = fnv1a(config.calibration_path.data(), config.calibration_path.size(), hash);
+    }
+
+    std::ostringstream name;
+    name << std::filesystem::path(config.model_path).stem().string() << '-' << std::hex << std::setw(16)
+         << std::setfill('0') << hash << std::dec << '.' << config.precision << ".b" << std::max(1, config.batch_size)
+         << '.' << config.input_width << 'x' << config.input_height << ".sm" << prop.major << prop.minor << '.'
+         << gpu << ".trt" << getInferLibVersion() << ".engine";
+    return std::filesystem::path(config.engine_cache_dir) / name.str();
+}
+
+// 先写临时文件再改名，并发启动的进程不会读到写了一半的引擎
+void saveEngine(const std::filesystem::path& path, const std::vector<char>& data) {
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+    std::filesystem::path temp = path;
+    temp += ".tmp";
+    {
+        std::ofstream file(temp, std::ios::binary);
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+        if (!file) {
+            LOG_WARN("Failed to write TensorRT engine cache {}", temp.string());
+            return;
+        }
+    }
+    std::filesystem::rename(temp, path, ec);
+    if (ec) {
+        LOG_WARN("Failed to save TensorRT engine cache {}: {}", path.string(), ec.message());
+        std::filesystem::remove(temp, ec);
+        return;
+    }
+    LOG_INFO("Serialized TensorRT engine to {}", path.string());
+}
+
+/**
+ * @brief INT8熵校准器
+ * 逐张读取calibration_path下的图像，按检测器相同的方式预处理后送入TensorRT；
+ * 校准结果缓存到校准目录，后续构建直接复用
+ */
+class Int8Calibrator : public nvinfer1::IInt8EntropyCalibrator2 {
+private:
+    std::vector<std::string> images_;
+    size_t next_ = 0;
+    cv::Size input_size_;
+    size_t input_bytes_;
+    void* device_input_ = nullptr;
+    std::string cache_path_;
+    std::vector<char> cache_;
+
+public:
+    Int8Calibrator(const std::string& calibration_path, const cv::Size& input_size)
+        : input_size_(input_size),
+          input_bytes_(3 * static_cast<size_t>(input_size.area()) * sizeof(float)) {
+        cache_path_ = (std::filesystem::path(calibration_path) / "calibration.cache").string();
+
+        if (std::filesystem::is_directory(calibration_path)) {
+            for (const auto& entry : std::filesystem::directory_iterator(calibration_path)) {
+                std::string ext = entry.path().extension().string();
+                std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+                if (ext == ".jpg" || ext == ".jpeg" || ext == ".png" || ext == ".bmp") {
+                    images_.push_back(entry.path().string());
+                }
+            }
+            std::sort(images_.begin(), images_.end());
+        }
+        LOG_INFO("INT8 calibration: {} images from {}", images_.size(), calibration_path);
+
+        checkCuda(cudaMalloc(&device_input_, input_bytes_), "cudaMalloc calibration input");
+    }
+
+    ~Int8Calibrator() override {
+        cudaFree(device_input_);
+    }
+
+    int getBatchSize() const noexcept override {
+        return 1;
+    }
+
+    bool getBatch(void* bindings[], const char* names[], int nb_bindings) noexcept override {
+        while (next_ < images_.size()) {
+            cv::Mat image = cv::imread(images_[next_++]);
+            if (image.empty()) {
+                continue;
+            }
+            cv::Mat blob;
+            cv::dnn::blobFromImage(image, blob, 1.0/255.0, input_size_, cv::Scalar(0,0,0), true, false);
+            if (cudaMemcpy(device_input_, blob.ptr<float>(), input_bytes_, cudaMemcpyHostToDevice) != cudaSuccess) {
+                return false;
+            }
+            bindings[0] = device_input_;
+            return true;
+        }
+        return false;
+    }
+
+    const void* readCalibrationCache(size_t& length) noexcept override {
+        cache_.clear();
+        std::ifstream file(cache_path_, std::ios::binary);
+        if (file) {
+            cache_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            LOG_INFO("Using INT8 calibration cache: {}", cache_path_);
+        }
+        length = cache_.size();
+        return cache_.empty() ? nullptr : cache_.data();
+    }
+
+    void writeCalibrationCache(const void* cache, size_t length) noexcept override {
+        std::ofstream file(cache_path_, std::ios::binary);
+        if (file) {
+            file.write(static_cast<const char*>(cache), length);
+        }
+    }
+};
+
+} // namespace
+
+/**
+ * @brief TensorRT推理后端
+ */
+class TensorRTBackend : public IInferenceBackend {
+private:
+    // 网络输入/输出张量
+    struct Tensor {
+        std::string name;
+        nvinfer1::Dims dims;          // 引擎中声明的形状(batch维可能为-1)
+        size_t elems_per_image = 0;   // 去掉batch维后的元素数
+        void* device = nullptr;       // 设备缓冲区(按最大batch分配)
+        float* host = nullptr;        // 锁页主机缓冲区(仅输出)
+    };
+
+    TrtPtr<nvinfer1::IRuntime> runtime_;
+    TrtPtr<nvinfer1::ICudaEngine> engine_;
+    TrtPtr<nvinfer1::IExecutionContext> context_;
+    cudaStream_t stream_ = nullptr;
+    Tensor input_;
+    std::vector<Tensor> outputs_;
+    int max_batch_ = 1;
+    bool dynamic_batch_ = false;
+
+public:
+    ~TensorRTBackend() override {
+        if (stream_) {
+            cudaStreamSynchronize(stream_);
+        }
+        cudaFree(input_.device);
+        for (auto& output : outputs_) {
+            cudaFree(output.device);
+            cudaFreeHost(output.host);
+        }
+        if (stream_) {
+            cudaStreamDestroy(stream_);
+        }
+        context_.reset();
+        engine_.reset();
+        runtime_.reset();
+    }
+
+    bool initialize(const SystemConfig::DetectorConfig& config) override {
+        try {
+            checkCuda(cudaSetDevice(config.device_id), "cudaSetDevice");
+            runtime_.reset(nvinfer1::createInferRuntime(trtLogger()));
+            if (!runtime_) {
+                LOG_ERROR("Failed to create TensorRT runtime");
+                return false;
+            }
+
+            std::vector<char> engine_data;
+            std::filesystem::path cache_path;   // 非空表示引擎来自缓存
+            std::filesystem::path model_path(config.model_path);
+            std::string ext = model_path.extension().string();
+            std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+
+            if (ext == ".engine" || ext == ".plan") {
+                engine_data = readFile(config.model_path);
+            } else if (ext == ".onnx") {
+                // 缓存中有当前模型和环境对应的引擎时直接加载，否则构建并写入缓存
+                std::filesystem::path engine_path;
+                if (!config.engine_cache_dir.empty()) {
+                    engine_path = engineCachePath(config, readFile(config.model_path));
+                }
+                if (!engine_path.empty() && std::filesystem::exists(engine_path)) {
+                    LOG_INFO("Loading cached TensorRT engine: {}", engine_path.string());
+                    engine_data = readFile(engine_path.string());
+                    cache_path = engine_path;
+                } else {
+                    engine_data = buildEngine(config);
+                    if (!engine_data.empty() && !engine_path.empty()) {
+                        saveEngine(engine_path, engine_data);
+                    }
+                }
+            } else {
+                LOG_ERROR("Unsupported model format for TensorRT: {}", ext);
+                return false;
+            }
+
+            if (engine_data.empty()) {
+                LOG_ERROR("No TensorRT engine available for {}", config.model_path);
+                return false;
+            }
+
+            engine_.reset(runtime_->deserializeCudaEngine(engine_data.data(), engine_data.size()));
+            if (!engine_ && !cache_path.empty()) {
+                // 缓存文件损坏时重新构建并覆盖
+                LOG_WARN("Cached TensorRT engine {} is unusable, rebuilding", cache_path.string());
+                engine_data = buildEngine(config);
+                if (!engine_data.empty()) {
+                    saveEngine(cache_path, engine_data);
+                    engine_.reset(runtime_->deserializeCudaEngine(engine_data.data(), engine_data.size()));
+                }
+            }
+            if (!engine_) {
+                LOG_ERROR("Failed to deserialize TensorRT engine");
+                return false;
+            }
+            context_.reset(engine_->createExecutionContext());
+            if (!context_) {
+                LOG_ERROR("Failed to create TensorRT execution context");
+                return false;
+            }
+            checkCuda(cudaStreamCreate(&stream_), "cudaStreamCreate");
+
+            return allocateTensors(config);
+        } catch (const std::exception& e) {
+            LOG_ERROR("Failed to initialize TensorRT backend: {}", e.what());
+            return false;
+        }
+    }
+
+    void forward(const cv::Mat& blob, std::vector<cv::Mat>& outputs) override {
+        const int batch = blob.dims == 4 ? blob.size[0] : 1;
+        if (batch > max_batch_) {
+            throw std::runtime_error("batch " + std::to_string(batch) + " exceeds engine maximum " +
+                                     std::to_string(max_batch_));
+        }
+
+        if (dynamic_batch_) {
+            nvinfer1::Dims dims = input_.dims;
+            dims.d[0] = batch;
+            if (!context_->setInputShape(input_.name.c_str(), dims)) {
+                throw std::runtime_error("failed to set TensorRT input shape");
+            }
+        }
+
+        const cv::Mat input = blob.isContinuous() ? blob : blob.clone();
+        checkCuda(cudaMemcpyAsync(input_.device, input.ptr<float>(),
+                                  batch * input_.elems_per_image * sizeof(float),
+                                  cudaMemcpyHostToDevice, stream_), "cudaMemcpyAsync input");
+
+        if (!context_->enqueueV3(stream_)) {
+            throw std::runtime_error("TensorRT enqueue failed");
+        }
+
+        outputs.resize(outputs_.size());
+        for (size_t i = 0; i < outputs_.size(); ++i) {
+            const Tensor& tensor = outputs_[i];
+            nvinfer1::Dims dims = context_->getTensorShape(tensor.name.c_str());
+            checkCuda(cudaMemcpyAsync(tensor.host, tensor.device, volume(dims) * sizeof(float),
+                                      cudaMemcpyDeviceToHost, stream_), "cudaMemcpyAsync output");
+
+            std::vector<int> sizes(dims.d, dims.d + dims.nbDims);
+            outputs[i] = cv::Mat(sizes, CV_32F, tensor.host);
+        }
+        checkCuda(cudaStreamSynchronize(stream_), "cudaStreamSynchronize");
+    }
+
+    int maxBatchSize() const override {
+        return max_batch_;
+    }
+
+    std::string name() const override {
+        return "tensorrt";
+    }
+
+private:
+    static std::vector<char> readFile(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            LOG_ERROR("Failed to open {}", path);
+            return {};
+        }
+        return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    /**
+     * @brief 从ONNX模型构建序列化引擎
+     * @param config 检测器配置(precision、calibration_path、batch_size、workspace_mb)
+     * @return std::vector<char> 序列化引擎数据，失败时为空
+     */
+    std::vector<char> buildEngine(const SystemConfig::DetectorConfig& config) {
+        LOG_INFO("Building TensorRT engine from {} (precision={}), this may take a while",
+                config.model_path, config.precision);
+
+        TrtPtr<nvinfer1::IBuilder> builder(nvinfer1::createInferBuilder(trtLogger()));
+        const auto explicit_batch = 1U << static_cast<uint32_t>(
+            nvinfer1::NetworkDefinitionCreationFlag::kEXPLICIT_BATCH);
+        TrtPtr<nvinfer1::INetworkDefinition> network(builder->createNetworkV2(explicit_batch));
+        TrtPtr<nvonnxparser::IParser> parser(nvonnxparser::createParser(*network, trtLogger()));
+
+        if (!parser->parseFromFile(config.model_path.c_str(),
+                                   static_cast<int>(nvinfer1::ILogger::Severity::kWARNING))) {
+            LOG_ERROR("Failed to parse ONNX model: {}", config.model_path);
+            return {};
+        }
+
+        TrtPtr<nvinfer1::IBuilderConfig> build_config(builder->createBuilderConfig());
+        build_config->setMemoryPoolLimit(nvinfer1::MemoryPoolType::kWORKSPACE,
+                                         static_cast<size_t>(config.workspace_mb) << 20);
+
+        // 动态batch模型：按配置的batch_size建立优化配置
+        nvinfer1::ITensor* input = network->getInput(0);
+        nvinfer1::Dims dims = input->getDimensions();
+        if (dims.d[0] < 0) {
+            const int max_batch = std::max(1, config.batch_size);
+            nvinfer1::IOptimizationProfile* profile = builder->createOptimizationProfile();
+            nvinfer1::Dims min_dims = dims, max_dims = dims;
+            min_dims.d[0] = 1;
+            max_dims.d[0] = max_batch;
+            for (int i = 1; i < dims.nbDims; ++i) {
+                if (dims.d[i] < 0) {
+                    // 空间维度未固定时使用配置的输入尺寸
+                    int value = (i == 2) ? config.input_height : (i == 3) ? config.input_width : 3;
+                    min_dims.d[i] = max_dims.d[i] = value;
+                }
+            }
+            profile->setDimensions(input->getName(), nvinfer1::OptProfileSelector::kMIN, min_dims);
+            profile->setDimensions(input->getName(), nvinfer1::OptProfileSelector::kOPT, max_dims);
+            profile->setDimensions(input->getName(), nvinfer1::OptProfileSelector::kMAX, max_dims);
+            build_config->addOptimizationProfile(profile);
+        }
+
+        std::unique_ptr<Int8Calibrator> calibrator;
+        if (config.precision == "fp16" || config.precision == "int8") {
+            if (builder->platformHasFastFp16()) {
+                build_config->setFlag(nvinfer1::BuilderFlag::kFP16);
+            } else {
+                LOG_WARN("Platform has no fast FP16 support");
+            }
+        }
+        if (config.precision == "int8") {
+            if (builder->platformHasFastInt8()) {
+                build_config->setFlag(nvinfer1::BuilderFlag::kINT8);
+                calibrator = std::make_unique<Int8Calibrator>(
+                    config.calibration_path, cv::Size(config.input_width, config.input_height));
+                build_config->setInt8Calibrator(calibrator.get());
+            } else {
+                LOG_WARN("Platform has no fast INT8 support, building FP16 engine");
+            }
+        }
+
+        TrtPtr<nvinfer1::IHostMemory> serialized(builder->buildSerializedNetwork(*network, *build_config));
+        if (!serialized) {
+            LOG_ERROR("TensorRT engine build failed");
+            return {};
+        }
+
+        const char* data = static_cast<const char*>(serialized->data());
+        return std::vector<char>(data, data + serialized->size());
+    }
+
+    /**
+     * @brief 按最大batch分配所有输入/输出缓冲区并绑定到执行上下文
+     */
+    bool allocateTensors(const SystemConfig::DetectorConfig& config) {
+        for (int i = 0; i < engine_->getNbIOTensors(); ++i) {
+            const char* tensor_name = engine_->getIOTensorName(i);
+            if (engine_->getTensorDataType(tensor_name) != nvinfer1::DataType::kFLOAT) {
+                LOG_ERROR("TensorRT tensor {} is not FP32, unsupported I/O type", tensor_name);
+                return false;
+            }
+
+            Tensor tensor;
+            tensor.name = tensor_name;
+            tensor.dims = engine_->getTensorShape(tensor_name);
+
+            nvinfer1::Dims per_image = tensor.dims;
+            per_image.d[0] = 1;
+            tensor.elems_per_image = volume(per_image);
+
+            if (engine_->getTensorIOMode(tensor_name) == nvinfer1::TensorIOMode::kINPUT) {
+                dynamic_batch_ = tensor.dims.d[0] < 0;
+                if (dynamic_batch_) {
+                    nvinfer1::Dims max_dims = engine_->getProfileShape(
+                        tensor_name, 0, nvinfer1::OptProfileSelector::kMAX);
+                    max_batch_ = static_cast<int>(max_dims.d[0]);
+                } else {
+                    max_batch_ = static_cast<int>(std::max<int64_t>(tensor.dims.d[0], 1));
+                }
+                input_ = tensor;
+            } else {
+                outputs_.push_back(tensor);
+            }
+        }
+
+        if (input_.name.empty() || outputs_.empty()) {
+            LOG_ERROR("TensorRT engine has no input or output tensors");
+            return false;
+        }
+
+        checkCuda(cudaMalloc(&input_.device, max_batch_ * input_.elems_per_image * sizeof(float)),
+                  "cudaMalloc input");
+        context_->setTensorAddress(input_.name.c_str(), input_.device);
+        for (auto& output : outputs_) {
+            const size_t bytes = max_batch_ * output.elems_per_image * sizeof(float);
+            checkCuda(cudaMalloc(&output.device, bytes), "cudaMalloc output");
+            checkCuda(cudaMallocHost(reinterpret_cast<void**>(&output.host), bytes), "cudaMallocHost output");
+            context_->setTensorAddress(output.name.c_str(), output.device);
+        }
+
+        LOG_INFO("TensorRT engine ready: precision={}, max batch={}, outputs={}",
+                config.precision, max_batch_, outputs_.size());
+        return true;
+    }
+};
+
+std::unique_ptr<IInferenceBackend> createTensorRTBackend() {
+    return std::make_unique<TensorRTBackend>();
+}
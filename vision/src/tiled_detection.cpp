@@ -0,0 +1,167 @@
+/**
+ * @file tiled_detection.cpp
+ * @brief 切片推理实现
+ * @author pengchengkang
+ * @date 2025-9-16
+ */
+#include "tiled_detection.hpp"
+#include "logger.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// 框边距切片边界不超过该像素数时视为被截断
+constexpr float kEdgeTolerance = 2.0f;
+
+/**
+ * @brief 在[begin, end)上均匀铺设长度为length的区间，相邻重叠不少于overlap
+ * @return 各区间起点
+ */
+std::vector<int> tileOrigins(int begin, int end, int length, int overlap) {
+    const int span = end - begin;
+    if (span <= length) {
+        return {begin};
+    }
+    const int stride = std::max(1, length - overlap);
+    const int count = 1 + (span - length + stride - 1) / stride;
+    std::vector<int> origins(count);
+    for (int i = 0; i < count; ++i) {
+        // 首尾切片贴齐边界，中间按等间距分布，实际重叠不小于配置值
+        origins[i] = begin + static_cast<int>(std::lround(static_cast<double>(span - length) * i / (count - 1)));
+    }
+    return origins;
+}
+
+// 本次执行的切片中是否有切片越过region的某条边、并覆盖帧坐标点probe
+bool hasNeighbour(const std::vector<TiledDetection::Part>& parts, const cv::Rect& region,
+                  const cv::Point2f& probe, int dx, int dy) {
+    for (const auto& part : parts) {
+        const cv::Rect& t = part.region;
+        if (!part.tile || t == region) {
+            continue;
+        }
+        const bool across = (dx < 0 && t.x < region.x && t.x + t.width > region.x) ||
+                            (dx > 0 && t.x + t.width > region.x + region.width && t.x < region.x + region.width) ||
+                            (dy < 0 && t.y < region.y && t.y + t.height > region.y) ||
+                            (dy > 0 && t.y + t.height > region.y + region.height && t.y < region.y + region.height);
+        const bool aligned = dx != 0 ? (probe.y >= t.y && probe.y < t.y + t.height)
+                                     : (probe.x >= t.x && probe.x < t.x + t.width);
+        if (across && aligned) {
+            return true;
+        }
+    }
+    return false;
+}
+
+float intersectionOverSmaller(const cv::Rect2f& a, const cv::Rect2f& b) {
+    const float smaller = std::min(a.area(), b.area());
+    if (smaller <= 0.0f) {
+        return 0.0f;
+    }
+    return (a & b).area() / smaller;
+}
+
+} // namespace
+
+void TiledDetection::configure(const SystemConfig::DetectorConfig& config) {
+    enabled_ = config.tiling;
+    coarse_pass_ = config.tile_coarse_pass;
+    input_size_ = cv::Size(config.input_width, config.input_height);
+    tile_size_ = cv::Size(config.tile_width > 0 ? config.tile_width : config.input_width,
+                          config.tile_height > 0 ? config.tile_height : config.input_height);
+    overlap_ = std::clamp(config.tile_overlap, 0.0f, 0.9f);
+    band_top_ = std::clamp(config.tile_band_top, 0.0f, 1.0f);
+    band_bottom_ = std::clamp(config.tile_band_bottom, band_top_, 1.0f);
+    merge_threshold_ = config.tile_merge_threshold;
+
+    if (enabled_) {
+        LOG_INFO("Tiled inference: {}x{} tiles, overlap {}, band [{}, {}], coarse pass {}",
+                 tile_size_.width, tile_size_.height, overlap_, band_top_, band_bottom_,
+                 coarse_pass_ ? "on" : "off");
+    }
+}
+
+std::vector<cv::Rect> TiledDetection::layout(const cv::Size& frame_size) const {
+    std::vector<cv::Rect> tiles;
+    if (!enabled_ || tile_size_.area() <= 0 ||
+        (frame_size.width <= input_size_.width && frame_size.height <= input_size_.height)) {
+        return tiles;
+    }
+
+    int band_y0 = static_cast<int>(std::floor(band_top_ * frame_size.height));
+    int band_y1 = static_cast<int>(std::ceil(band_bottom_ * frame_size.height));
+    if (band_y1 - band_y0 < 1) {
+        band_y0 = 0;
+        band_y1 = frame_size.height;
+    }
+
+    const int tile_w = std::min(tile_size_.width, frame_size.width);
+    const int tile_h = std::min(tile_size_.height, band_y1 - band_y0);
+    const auto xs = tileOrigins(0, frame_size.width, tile_w, static_cast<int>(tile_w * overlap_));
+    const auto ys = tileOrigins(band_y0, band_y1, tile_h, static_cast<int>(tile_h * overlap_));
+    tiles.reserve(xs.size() * ys.size());
+    for (int y : ys) {
+        for (int x : xs) {
+            tiles.emplace_back(x, y, tile_w, tile_h);
+        }
+    }
+    return tiles;
+}
+
+std::vector<Detection> TiledDetection::merge(std::vector<Part>& parts) const {
+    std::vector<Detection> merged;
+    for (auto& part : parts) {
+        const cv::Rect& region = part.region;
+        const float overlap_x = overlap_ * region.width;
+        const float overlap_y = overlap_ * region.height;
+        const cv::Point2f offset(static_cast<float>(region.x), static_cast<float>(region.y));
+        for (auto& detection : part.detections) {
+            if (part.tile) {
+                // 小于重叠宽度且贴着切片边界的框在越过该边界的相邻切片中完整出现；
+                // 相邻切片本帧未执行(画面边缘，或ROI模式下被跳过)时保留
+                const cv::Rect2f& b = detection.bbox;
+                const cv::Point2f center = detection.center + offset;
+                const bool cut_left = b.x <= kEdgeTolerance && b.width < overlap_x &&
+                                      hasNeighbour(parts, region, center, -1, 0);
+                const bool cut_right = b.x + b.width >= region.width - kEdgeTolerance && b.width < overlap_x &&
+                                       hasNeighbour(parts, region, center, 1, 0);
+                const bool cut_top = b.y <= kEdgeTolerance && b.height < overlap_y &&
+                                     hasNeighbour(parts, region, center, 0, -1);
+                const bool cut_bottom = b.y + b.height >= region.height - kEdgeTolerance && b.height < overlap_y &&
+                                        hasNeighbour(parts, region, center, 0, 1);
+                if (cut_left || cut_right || cut_top || cut_bottom) {
+                    continue;
+                }
+            }
+            detection.bbox.x += offset.x;
+            detection.bbox.y += offset.y;
+            detection.center += offset;
+            merged.push_back(std::move(detection));
+        }
+    }
+    if (parts.size() <= 1) {
+        return merged;
+    }
+
+    // 跨切片NMS：重叠区和粗检测会重复检出同一目标，按交集占较小框的比例抑制
+    std::sort(merged.begin(), merged.end(),
+              [](const Detection& a, const Detection& b) { return a.confidence > b.confidence; });
+    std::vector<uint8_t> suppressed(merged.size(), 0);
+    std::vector<Detection> kept;
+    kept.reserve(merged.size());
+    for (size_t i = 0; i < merged.size(); ++i) {
+        if (suppressed[i]) {
+            continue;
+        }
+        for (size_t j = i + 1; j < merged.size(); ++j) {
+            if (!suppressed[j] && merged[j].class_index == merged[i].class_index &&
+                intersectionOverSmaller(merged[i].bbox, merged[j].bbox) > merge_threshold_) {
+                suppressed[j] = 1;
+            }
+        }
+        kept.push_back(std::move(merged[i]));
+    }
+    return kept;
+}
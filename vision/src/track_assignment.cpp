@@ -0,0 +1,296 @@
+/**
+ * @file track_assignment.cpp
+ * @brief 轨迹与检测的空间门控和最优分配实现
+ * @author pengchengkang
+ * @date 2025-9-12
+ */
+#include "track_assignment.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+// 网格单元数上限(每维)，检测框分布很散时放大单元尺寸
+constexpr int kMaxGridDim = 64;
+
+// 不可分配的代价，远大于任何有效代价
+constexpr double kInfeasibleCost = 1e6;
+
+} // namespace
+
+float boxIoU(const cv::Rect2f& a, const cv::Rect2f& b) {
+    const float x1 = std::max(a.x, b.x);
+    const float y1 = std::max(a.y, b.y);
+    const float x2 = std::min(a.x + a.width, b.x + b.width);
+    const float y2 = std::min(a.y + a.height, b.y + b.height);
+    if (x2 <= x1 || y2 <= y1) {
+        return 0.0f;
+    }
+    const float intersection = (x2 - x1) * (y2 - y1);
+    return intersection / (a.width * a.height + b.width * b.height - intersection);
+}
+
+void SpatialGrid::build(const std::vector<cv::Rect2f>& boxes) {
+    cols_ = 0;
+    rows_ = 0;
+    if (boxes.empty()) {
+        return;
+    }
+
+    float min_x = boxes[0].x, min_y = boxes[0].y;
+    float max_x = boxes[0].x + boxes[0].width, max_y = boxes[0].y + boxes[0].height;
+    float size_sum = 0.0f;
+    for (const auto& box : boxes) {
+        min_x = std::min(min_x, box.x);
+        min_y = std::min(min_y, box.y);
+        max_x = std::max(max_x, box.x + box.width);
+        max_y = std::max(max_y, box.y + box.height);
+        size_sum += std::max(box.width, box.height);
+    }
+
+    origin_x_ = min_x;
+    origin_y_ = min_y;
+    cell_size_ = std::max(16.0f, size_sum / boxes.size());
+    float extent = std::max(max_x - min_x, max_y - min_y);
+    cell_size_ = std::max(cell_size_, extent / kMaxGridDim);
+    cols_ = std::min(kMaxGridDim, static_cast<int>((max_x - min_x) / cell_size_) + 1);
+    rows_ = std::min(kMaxGridDim, static_cast<int>((max_y - min_y) / cell_size_) + 1);
+
+    // 计数排序构建CSR：先统计每个单元的元素数，再填充
+    const int cells = cols_ * rows_;
+    cell_start_.assign(cells + 1, 0);
+    for (const auto& box : boxes) {
+        int c0, r0, c1, r1;
+        cellRange(box, c0, r0, c1, r1);
+        for (int r = r0; r <= r1; ++r) {
+            for (int c = c0; c <= c1; ++c) {
+                cell_start_[r * cols_ + c + 1]++;
+            }
+        }
+    }
+    for (int i = 0; i < cells; ++i) {
+        cell_start_[i + 1] += cell_start_[i];
+    }
+    cell_items_.resize(cell_start_[cells]);
+    cell_fill_.assign(cell_start_.begin(), cell_start_.end() - 1);
+    for (int i = 0; i < static_cast<int>(boxes.size()); ++i) {
+        int c0, r0, c1, r1;
+        cellRange(boxes[i], c0, r0, c1, r1);
+        for (int r = r0; r <= r1; ++r) {
+            for (int c = c0; c <= c1; ++c) {
+                cell_items_[cell_fill_[r * cols_ + c]++] = i;
+            }
+        }
+    }
+
+    if (visit_stamp_.size() < boxes.size()) {
+        visit_stamp_.resize(boxes.size(), 0);
+    }
+}
+
+void SpatialGrid::query(const cv::Rect2f& box, std::vector<int>& out) {
+    if (cols_ == 0 || rows_ == 0) {
+        return;
+    }
+    int c0, r0, c1, r1;
+    cellRange(box, c0, r0, c1, r1);
+
+    // 时间戳去重，跨多个单元的元素只返回一次
+    if (++stamp_ == 0) {
+        std::fill(visit_stamp_.begin(), visit_stamp_.end(), 0);
+        stamp_ = 1;
+    }
+    for (int r = r0; r <= r1; ++r) {
+        for (int c = c0; c <= c1; ++c) {
+            const int cell = r * cols_ + c;
+            for (int k = cell_start_[cell]; k < cell_start_[cell + 1]; ++k) {
+                const int item = cell_items_[k];
+                if (visit_stamp_[item] != stamp_) {
+                    visit_stamp_[item] = stamp_;
+                    out.push_back(item);
+                }
+            }
+        }
+    }
+}
+
+void SpatialGrid::cellRange(const cv::Rect2f& box, int& c0, int& r0, int& c1, int& r1) const {
+    auto clampCell = [](float v, int limit) {
+        return std::min(limit - 1, std::max(0, static_cast<int>(std::floor(v))));
+    };
+    c0 = clampCell((box.x - origin_x_) / cell_size_, cols_);
+    r0 = clampCell((box.y - origin_y_) / cell_size_, rows_);
+    c1 = clampCell((box.x + box.width - origin_x_) / cell_size_, cols_);
+    r1 = clampCell((box.y + box.height - origin_y_) / cell_size_, rows_);
+}
+
+int LinearAssignment::find(int x) {
+    while (parent_[x] != x) {
+        parent_[x] = parent_[parent_[x]];
+        x = parent_[x];
+    }
+    return x;
+}
+
+void LinearAssignment::solve(int rows, int cols, const std::vector<AssignmentEdge>& edges,
+                             std::vector<std::pair<int, int>>& matches) {
+    matches.clear();
+    if (rows == 0 || cols == 0 || edges.empty()) {
+        return;
+    }
+
+    // 候选边把行列连成若干连通分量，各分量的分配互不影响
+    parent_.resize(rows + cols);
+    for (int i = 0; i < rows + cols; ++i) {
+        parent_[i] = i;
+    }
+    for (const auto& edge : edges) {
+        int a = find(edge.row);
+        int b = find(rows + edge.col);
+        if (a != b) {
+            parent_[a] = b;
+        }
+    }
+
+    edge_order_.resize(edges.size());
+    edge_root_.resize(edges.size());
+    for (size_t i = 0; i < edges.size(); ++i) {
+        edge_order_[i] = static_cast<int>(i);
+        edge_root_[i] = find(edges[i].row);
+    }
+    std::sort(edge_order_.begin(), edge_order_.end(), [&](int a, int b) {
+        return edge_root_[a] < edge_root_[b];
+    });
+
+    local_row_.assign(rows, -1);
+    local_col_.assign(cols, -1);
+
+    size_t begin = 0;
+    while (begin < edge_order_.size()) {
+        const int root = edge_root_[edge_order_[begin]];
+        size_t end = begin;
+        while (end < edge_order_.size() && edge_root_[edge_order_[end]] == root) {
+            ++end;
+        }
+
+        // 单条边的分量直接匹配
+        if (end - begin == 1) {
+            const auto& edge = edges[edge_order_[begin]];
+            matches.emplace_back(edge.row, edge.col);
+            begin = end;
+            continue;
+        }
+
+        row_ids_.clear();
+        col_ids_.clear();
+        for (size_t k = begin; k < end; ++k) {
+            const auto& edge = edges[edge_order_[k]];
+            if (local_row_[edge.row] < 0) {
+                local_row_[edge.row] = static_cast<int>(row_ids_.size());
+                row_ids_.push_back(edge.row);
+            }
+            if (local_col_[edge.col] < 0) {
+                local_col_[edge.col] = static_cast<int>(col_ids_.size());
+                col_ids_.push_back(edge.col);
+            }
+        }
+
+        // 稠密子问题要求行数不大于列数，否则转置
+        const int nr = static_cast<int>(row_ids_.size());
+        const int nc = static_cast<int>(col_ids_.size());
+        const bool transposed = nr > nc;
+        const int n = transposed ? nc : nr;
+        const int m = transposed ? nr : nc;
+        cost_.assign(static_cast<size_t>(n) * m, kInfeasibleCost);
+        for (size_t k = begin; k < end; ++k) {
+            const auto& edge = edges[edge_order_[k]];
+            const int r = local_row_[edge.row];
+            const int c = local_col_[edge.col];
+            if (transposed) {
+                cost_[static_cast<size_t>(c) * m + r] = edge.cost;
+            } else {
+                cost_[static_cast<size_t>(r) * m + c] = edge.cost;
+            }
+        }
+
+        solveDense(n, m, transposed, matches);
+
+        for (int row : row_ids_) {
+            local_row_[row] = -1;
+        }
+        for (int col : col_ids_) {
+            local_col_[col] = -1;
+        }
+        begin = end;
+    }
+
+    std::sort(matches.begin(), matches.end());
+}
+
+void LinearAssignment::solveDense(int n, int m, bool transposed, std::vector<std::pair<int, int>>& matches) {
+    // 基于势函数的最短增广路算法，O(n^2·m)，下标从1开始，p_[j]为列j匹配的行
+    const double inf = std::numeric_limits<double>::max();
+    u_.assign(n + 1, 0.0);
+    v_.assign(m + 1, 0.0);
+    p_.assign(m + 1, 0);
+    way_.assign(m + 1, 0);
+    min_v_.resize(m + 1);
+    used_.resize(m + 1);
+
+    for (int i = 1; i <= n; ++i) {
+        p_[0] = i;
+        int j0 = 0;
+        std::fill(min_v_.begin(), min_v_.end(), inf);
+        std::fill(used_.begin(), used_.end(), 0);
+        do {
+            used_[j0] = 1;
+            const int i0 = p_[j0];
+            const double* row = cost_.data() + static_cast<size_t>(i0 - 1) * m;
+            double delta = inf;
+            int j1 = 0;
+            for (int j = 1; j <= m; ++j) {
+                if (used_[j]) {
+                    continue;
+                }
+                const double reduced = row[j - 1] - u_[i0] - v_[j];
+                if (reduced < min_v_[j]) {
+                    min_v_[j] = reduced;
+                    way_[j] = j0;
+                }
+                if (min_v_[j] < delta) {
+                    delta = min_v_[j];
+                    j1 = j;
+                }
+            }
+            for (int j = 0; j <= m; ++j) {
+                if (used_[j]) {
+                    u_[p_[j]] += delta;
+                    v_[j] -= delta;
+                } else {
+                    min_v_[j] -= delta;
+                }
+            }
+            j0 = j1;
+        } while (p_[j0] != 0);
+
+        do {
+            const int j1 = way_[j0];
+            p_[j0] = p_[j1];
+            j0 = j1;
+        } while (j0 != 0);
+    }
+
+    // 丢弃落在不可分配位置上的匹配
+    for (int j = 1; j <= m; ++j) {
+        const int i = p_[j];
+        if (i == 0 || cost_[static_cast<size_t>(i - 1) * m + (j - 1)] >= kInfeasibleCost) {
+            continue;
+        }
+        if (transposed) {
+            matches.emplace_back(row_ids_[j - 1], col_ids_[i - 1]);
+        } else {
+            matches.emplace_back(row_ids_[i - 1], col_ids_[j - 1]);
+        }
+    }
+}
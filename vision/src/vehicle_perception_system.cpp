@@ -5,18 +5,19 @@
  * @date 2025-9-6
  * 
  * 本文件实现了车辆感知系统的核心功能，包括：
- * 1. 系统初始化：配置加载、模块初始化、线程池创建
+ * 1. 系统初始化：配置加载、模块初始化、流水线构建
  * 2. 生命周期管理：系统启动、停止、暂停、恢复等状态转换
- * 3. 帧处理流程：目标检测、跟踪、行为分析和结果处理
- * 4. 性能监控：实时统计系统各项性能指标
+ * 3. 帧处理流程：预处理、推理、跟踪、行为分析和结果处理分级流水执行
+ * 4. 性能监控：各级耗时直方图、端到端延迟分位数、资源使用率，经Prometheus端点或JSON快照导出
  * 5. 异常处理：完善的错误处理和日志记录机制
  * 
  * 实现特点：
- * - 采用多线程处理提高系统效率
- * - 使用线程池管理并发任务
+ * - 采用多级流水线提高系统吞吐
+ * - 多路相机共享一个检测器和一条流水线，推理可跨流凑批；跟踪、分析和输出状态按流隔离
+ * - 有状态的跟踪和分析按帧序号严格顺序执行，避免数据竞争
  * - 实现了模块间的松耦合设计
  * - 提供了完整的性能监控和统计
- * - 支持动态配置更新
+ * - 支持动态配置更新：阈值经参数快照在线生效，检测模型在后台重建后热替换
  * - 实现了优雅的错误处理和恢复机制
  */
 #include "vehicle_perception_system.hpp"
@@ -24,6 +25,33 @@
 #include <thread>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
+
+namespace {
+
+// 预热推理次数(首次推理包含CUDA上下文、cuDNN句柄、显存分配和内核选择)
+constexpr int kDetectorWarmupRuns = 2;
+
+float elapsedMs(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+/**
+ * @brief 以全零帧执行预热推理，使一次性初始化开销不落在第一帧真实画面上
+ * batch_size大于1时另以满批推理一次，动态batch的最大形状同样完成初始化
+ */
+void warmUpDetector(IObjectDetector& detector, const cv::Size& frame_size, int batch_size) {
+    const cv::Mat frame(frame_size, CV_8UC3, cv::Scalar::all(0));
+    const DetectorInput input = detector.preprocess(frame);
+    for (int i = 0; i < kDetectorWarmupRuns; ++i) {
+        detector.infer(input);
+    }
+    if (batch_size > 1) {
+        detector.inferBatch(std::vector<DetectorInput>(static_cast<size_t>(batch_size), input));
+    }
+}
+
+} // namespace
 
 VehiclePerceptionSystem::VehiclePerceptionSystem()
     : state_(SystemState::STOPPED),
@@ -34,18 +62,36 @@ VehiclePerceptionSystem::VehiclePerceptionSystem()
 }
 
 VehiclePerceptionSystem::~VehiclePerceptionSystem() {
+    joinReload();
     stop();
+    if (metrics_exporter_) {
+        metrics_exporter_->stop();
+    }
 }
 
 bool VehiclePerceptionSystem::initialize(const SystemConfig& config) {
     setState(SystemState::INITIALIZING);
+    startup_begin_ = std::chrono::steady_clock::now();
+    startup_timings_ = StartupTimings();
+    first_result_ms_ = -1.0f;
+    first_result_pending_ = true;
     
     try {
         // 保存配置
         config_ = config;
         
-        // 初始化线程池
-        thread_pool_ = std::make_unique<ThreadPool>(4); // 4个工作线程
+        // 按配置设置日志级别、输出文件和缓冲区溢出策略
+        const auto& oc = config_.output;
+        if (oc.log_overflow != "drop" && oc.log_overflow != "block") {
+            LOG_WARN("Unknown log overflow policy '{}', using drop", oc.log_overflow);
+        }
+        Logger::initialize(oc.log_path, static_cast<LogLevel>(std::clamp(oc.log_level, 0, 5)), oc.log_to_file,
+                           oc.log_overflow == "block" ? LogOverflowPolicy::BLOCK : LogOverflowPolicy::DROP);
+        
+        // 流水线各级、批量分析和多路初始化共用的线程池
+        ThreadPool::configureShared(static_cast<size_t>(std::max(0, config_.pipeline.worker_threads)),
+                                    config_.pipeline.cpu_affinity);
+        LOG_INFO("Thread pool started with {} workers", ThreadPool::shared().size());
         
         // 初始化各个模块
         if (!initializeModules()) {
@@ -54,8 +100,31 @@ bool VehiclePerceptionSystem::initialize(const SystemConfig& config) {
             return false;
         }
         
-        // 重置性能统计
+        // 构建帧处理流水线并发布在线参数
+        auto pipeline_start = std::chrono::steady_clock::now();
+        buildPipeline();
+        publishTuning();
+        startup_timings_.pipeline_ms = elapsedMs(pipeline_start);
+        
+        // 重置性能统计并启动指标导出
         resetPerformanceStats();
+        startMetrics();
+        
+        startup_timings_.initialize_ms = elapsedMs(startup_begin_);
+        auto& registry = MetricsRegistry::instance();
+        const std::pair<const char*, float> phases[] = {
+            {"detector_load", startup_timings_.detector_load_ms}, {"warmup", startup_timings_.warmup_ms},
+            {"streams", startup_timings_.streams_ms}, {"modules", startup_timings_.modules_ms},
+            {"pipeline", startup_timings_.pipeline_ms}, {"initialize", startup_timings_.initialize_ms}};
+        for (const auto& [phase, ms] : phases) {
+            registry.gauge("vps_startup_phase_seconds", std::string("phase=\"") + phase + "\"",
+                           "Duration of each phase of the last initialization")
+                .set(ms / 1000.0);
+        }
+        LOG_INFO("Startup: detector load {}ms + warm-up {}ms in parallel with streams {}ms, "
+                 "modules {}ms, pipeline {}ms, total {}ms",
+                 startup_timings_.detector_load_ms, startup_timings_.warmup_ms, startup_timings_.streams_ms,
+                 startup_timings_.modules_ms, startup_timings_.pipeline_ms, startup_timings_.initialize_ms);
         
         setState(SystemState::STOPPED);
         return true;
@@ -67,61 +136,343 @@ bool VehiclePerceptionSystem::initialize(const SystemConfig& config) {
 }
 
 bool VehiclePerceptionSystem::initializeModules() {
+    // 后台重建的检测器不能覆盖按新配置创建的检测器
+    joinReload();
+    
+    // 检测器(所有视频流共享)的加载、引擎构建和预热与打开视频源并行，
+    // 相机等待连接期间完成模型初始化
+    auto modules_start = std::chrono::steady_clock::now();
+    auto detector_task = ThreadPool::shared().submit([this]() -> std::shared_ptr<IObjectDetector> {
+        auto load_start = std::chrono::steady_clock::now();
+        std::shared_ptr<IObjectDetector> detector = IObjectDetector::create();
+        if (!detector || !detector->initialize(config_.detector)) {
+            return nullptr;
+        }
+        startup_timings_.detector_load_ms = elapsedMs(load_start);
+        auto warmup_start = std::chrono::steady_clock::now();
+        warmUpDetector(*detector, cv::Size(config_.detector.input_width, config_.detector.input_height),
+                       config_.detector.batch_size);
+        startup_timings_.warmup_ms = elapsedMs(warmup_start);
+        return detector;
+    });
+    
+    // 初始化各路视频流，多路时并行打开(网络相机连接耗时较长)
+    auto streams_start = std::chrono::steady_clock::now();
+    streams_.clear();
+    auto stream_configs = config_.resolveStreams();
+    bool multi_stream = stream_configs.size() > 1;
+    std::vector<std::unique_ptr<Stream>> streams(stream_configs.size());
+    std::vector<char> stream_ok(stream_configs.size(), 0);
+    ThreadPool::shared().parallelFor(0, stream_configs.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            streams[i] = std::make_unique<Stream>();
+            streams[i]->id = static_cast<int>(i);
+            streams[i]->name = stream_configs[i].name;
+            stream_ok[i] = initializeStream(*streams[i], stream_configs[i], multi_stream);
+        }
+    });
+    startup_timings_.streams_ms = elapsedMs(streams_start);
+    
+    // 任务引用了本对象，无论视频流是否成功都先等待检测器就绪
+    std::shared_ptr<IObjectDetector> detector = detector_task.get();
+    startup_timings_.modules_ms = elapsedMs(modules_start);
+    if (!detector) {
+        LOG_ERROR("Failed to initialize object detector");
+        return false;
+    }
+    std::atomic_store(&object_detector_, std::move(detector));
+    
+    for (size_t i = 0; i < streams.size(); ++i) {
+        if (!stream_ok[i]) {
+            LOG_ERROR("Failed to initialize stream {} ({})", streams[i]->id, streams[i]->name);
+            return false;
+        }
+        streams_.push_back(std::move(streams[i]));
+    }
+    if (multi_stream) {
+        LOG_INFO("Multi-stream mode: {} streams share one detector", streams_.size());
+    }
+    
+    // 初始化LLM增强器(如果启用)
+    if (config_.llm.enable) {
+        llm_enhancer_ = ILLMEnhancer::create();
+        if (!llm_enhancer_ || !llm_enhancer_->initialize(config_.llm)) {
+            LOG_WARN("Failed to initialize LLM enhancer, proceeding without it");
+            llm_enhancer_.reset();
+        }
+    }
+    
+    return true;
+}
+
+bool VehiclePerceptionSystem::initializeStream(Stream& stream, const SystemConfig::StreamConfig& stream_config,
+                                               bool multi_stream) {
     // 初始化视频处理器
-    video_processor_ = IVideoProcessor::create();
-    if (!video_processor_ || !video_processor_->initialize(config_.video, config_.camera)) {
+    stream.video_processor = IVideoProcessor::create();
+    if (!stream.video_processor ||
+        !stream.video_processor->initialize(stream_config.video, stream_config.camera)) {
         LOG_ERROR("Failed to initialize video processor");
         return false;
     }
     
-    // 设置视频帧回调
-    auto frame_callback = [this](const cv::Mat& frame, uint64_t timestamp) {
+    // 设置视频帧回调，池化帧句柄携带流编号进入共享流水线
+    const int stream_id = stream.id;
+    auto frame_callback = [this, stream_id](const FrameHandle& frame) {
         if (state_ == SystemState::RUNNING && !paused_) {
-            thread_pool_->submit(&VehiclePerceptionSystem::processFrame, this, frame, timestamp);
+            pipeline_->submit(frame, stream_id);
         }
     };
-    video_processor_->registerFrameCallback(frame_callback);
+    stream.video_processor->registerFrameBufferCallback(frame_callback);
     
-    // 初始化目标检测器
-    object_detector_ = IObjectDetector::create();
-    if (!object_detector_ || !object_detector_->initialize(config_.detector)) {
-        LOG_ERROR("Failed to initialize object detector");
-        return false;
-    }
+    // GPU解码时帧留在显存中直接进入流水线
+    auto gpu_frame_callback = [this, stream_id](const cv::cuda::GpuMat& frame, const FrameTrace& trace) {
+        if (state_ == SystemState::RUNNING && !paused_) {
+            pipeline_->submit(frame, trace, stream_id);
+        }
+    };
+    stream.video_processor->registerGpuFrameCallback(gpu_frame_callback);
     
     // 初始化目标跟踪器
-    object_tracker_ = IObjectTracker::create();
-    if (!object_tracker_ || !object_tracker_->initialize(config_.tracker)) {
+    stream.object_tracker = IObjectTracker::create(config_.tracker.type);
+    if (!stream.object_tracker || !stream.object_tracker->initialize(config_.tracker)) {
         LOG_ERROR("Failed to initialize object tracker");
         return false;
     }
+    stream.object_tracker->setTrajectoryLength(config_.behavior.trajectory_history_length);
     
-    // 初始化行为分析器
-    behavior_analyzer_ = IBehaviorAnalyzer::create();
-    if (!behavior_analyzer_ || !behavior_analyzer_->initialize(config_.behavior, config_.camera, config_.vehicle)) {
+    // 初始化行为分析器，启用ROI时检测坐标相对ROI，主点随之平移
+    CameraParams analysis_camera = stream_config.camera;
+    if (stream_config.video.enable_roi && stream_config.video.roi_rect.area() > 0) {
+        analysis_camera.cx -= stream_config.video.roi_rect.x;
+        analysis_camera.cy -= stream_config.video.roi_rect.y;
+    }
+    stream.behavior_analyzer = IBehaviorAnalyzer::create();
+    if (!stream.behavior_analyzer ||
+        !stream.behavior_analyzer->initialize(config_.behavior, analysis_camera, config_.vehicle)) {
         LOG_ERROR("Failed to initialize behavior analyzer");
         return false;
     }
     
-    // 初始化结果处理器
-    result_processor_ = IResultProcessor::create();
-    if (!result_processor_ || !result_processor_->initialize(config_.output)) {
+    // 初始化结果处理器，多路模式下每路输出到以流名称命名的子目录
+    SystemConfig::OutputConfig output_config = config_.output;
+    if (multi_stream) {
+        output_config.video_path += stream.name + "/";
+        output_config.results_path += stream.name + "/";
+    }
+    stream.result_processor = IResultProcessor::create();
+    if (!stream.result_processor || !stream.result_processor->initialize(output_config)) {
         LOG_ERROR("Failed to initialize result processor");
         return false;
     }
+    stream.result_processor->setSourceFps(stream.video_processor->getVideoProperties().fps);
     
-    // 初始化LLM增强器(如果启用)
-    if (config_.llm.enable) {
-        llm_enhancer_ = ILLMEnhancer::create();
-        if (!llm_enhancer_ || !llm_enhancer_->initialize(config_.llm)) {
-            LOG_WARN("Failed to initialize LLM enhancer, proceeding without it");
-            llm_enhancer_.reset();
+    return true;
+}
+
+bool VehiclePerceptionSystem::startVideo() {
+    for (auto& stream : streams_) {
+        if (!stream->video_processor->start()) {
+            LOG_ERROR("Failed to start video processor for stream {} ({})", stream->id, stream->name);
+            return false;
         }
     }
-    
     return true;
 }
 
+void VehiclePerceptionSystem::stopVideo() {
+    for (auto& stream : streams_) {
+        if (stream->video_processor) {
+            stream->video_processor->stop();
+        }
+    }
+}
+
+namespace {
+
+// 解析入口丢帧策略
+OverflowPolicy parseOverflowPolicy(const std::string& name) {
+    if (name == "drop_oldest") return OverflowPolicy::DROP_OLDEST;
+    if (name == "drop_newest") return OverflowPolicy::DROP_NEWEST;
+    if (name == "latest") return OverflowPolicy::LATEST_ONLY;
+    if (name != "block") {
+        LOG_WARN("Unknown ingest policy '{}', falling back to block", name);
+    }
+    return OverflowPolicy::BLOCK;
+}
+
+// 检测调度使用的帧序号：采集序号，直接提交的帧没有采集序号时用流水线序号
+uint64_t schedulingIndex(const FrameContext& context) {
+    return context.trace.frame_id > 0 ? context.trace.frame_id : context.sequence + 1;
+}
+
+// 配置变更的生效范围
+enum class ReloadScope {
+    NONE,       // 无变化
+    LIVE,       // 只有可在线调整的阈值变化
+    DETECTOR,   // 检测模型变化，后台重建检测器
+    FULL        // 重建全部模块和流水线
+};
+
+const char* reloadScopeName(ReloadScope scope) {
+    switch (scope) {
+        case ReloadScope::NONE: return "none";
+        case ReloadScope::LIVE: return "live";
+        case ReloadScope::DETECTOR: return "detector";
+        case ReloadScope::FULL: return "full";
+    }
+    return "full";
+}
+
+json streamsJson(const SystemConfig& config) {
+    json streams = json::array();
+    for (const auto& stream : config.streams) {
+        streams.push_back(stream.toJson());
+    }
+    return streams;
+}
+
+ReloadScope classifyChange(const SystemConfig& from, const SystemConfig& to) {
+    if (from.video.toJson() != to.video.toJson() || from.llm.toJson() != to.llm.toJson() ||
+        from.output.toJson() != to.output.toJson() || from.pipeline.toJson() != to.pipeline.toJson() ||
+        from.metrics.toJson() != to.metrics.toJson() || from.trace.toJson() != to.trace.toJson() ||
+        from.scheduler.toJson() != to.scheduler.toJson() || from.camera.toJson() != to.camera.toJson() ||
+        from.vehicle.toJson() != to.vehicle.toJson() || streamsJson(from) != streamsJson(to)) {
+        return ReloadScope::FULL;
+    }
+    
+    // 在线字段对齐后仍不同的部分需要重新初始化
+    SystemConfig::TrackerConfig tracker = to.tracker;
+    tracker.max_age = from.tracker.max_age;
+    tracker.min_hits = from.tracker.min_hits;
+    tracker.iou_threshold = from.tracker.iou_threshold;
+    if (tracker.toJson() != from.tracker.toJson()) {
+        return ReloadScope::FULL;
+    }
+    // 轨迹长度和测距模型(含测距上限)在初始化时确定
+    SystemConfig::BehaviorConfig behavior = to.behavior;
+    behavior.high_risk_distance = from.behavior.high_risk_distance;
+    behavior.collision_risk_ttc = from.behavior.collision_risk_ttc;
+    behavior.pedestrian_running_threshold = from.behavior.pedestrian_running_threshold;
+    behavior.non_motor_speeding_threshold = from.behavior.non_motor_speeding_threshold;
+    if (behavior.toJson() != from.behavior.toJson()) {
+        return ReloadScope::FULL;
+    }
+    
+    // 批量推理和切片参数决定流水线结构，只有模型相关字段可以换检测器生效
+    SystemConfig::DetectorConfig model = from.detector;
+    model.model_path = to.detector.model_path;
+    model.model_type = to.detector.model_type;
+    model.input_width = to.detector.input_width;
+    model.input_height = to.detector.input_height;
+    model.confidence_threshold = to.detector.confidence_threshold;
+    model.nms_threshold = to.detector.nms_threshold;
+    model.precision = to.detector.precision;
+    model.calibration_path = to.detector.calibration_path;
+    model.backend = to.detector.backend;
+    model.device_id = to.detector.device_id;
+    model.workspace_mb = to.detector.workspace_mb;
+    model.engine_cache_dir = to.detector.engine_cache_dir;
+    model.letterbox = to.detector.letterbox;
+    const bool tiled_input_changed = to.detector.tiling && (from.detector.input_width != to.detector.input_width ||
+                                                            from.detector.input_height != to.detector.input_height);
+    if (model.toJson() != to.detector.toJson() || tiled_input_changed) {
+        return ReloadScope::FULL;
+    }
+    SystemConfig::DetectorConfig detector = to.detector;
+    detector.confidence_threshold = from.detector.confidence_threshold;
+    detector.nms_threshold = from.detector.nms_threshold;
+    if (detector.toJson() != from.detector.toJson()) {
+        return ReloadScope::DETECTOR;
+    }
+    
+    if (from.detector.confidence_threshold != to.detector.confidence_threshold ||
+        from.detector.nms_threshold != to.detector.nms_threshold ||
+        from.tracker.toJson() != to.tracker.toJson() || from.behavior.toJson() != to.behavior.toJson()) {
+        return ReloadScope::LIVE;
+    }
+    return ReloadScope::NONE;
+}
+
+} // namespace
+
+void VehiclePerceptionSystem::buildPipeline() {
+    if (pipeline_) {
+        pipeline_->stop();
+    }
+    
+    const auto& pc = config_.pipeline;
+    auto pipeline = std::make_unique<FramePipeline>();
+    detection_scheduler_.configure(config_.scheduler, streams_.size());
+    tiled_detection_.configure(config_.detector);
+    
+    // 实时流过载时丢弃过期帧以保证延迟有界；视频文件不丢帧，阻塞读取线程
+    OverflowPolicy ingest_policy = OverflowPolicy::BLOCK;
+    bool has_live_stream = std::any_of(streams_.begin(), streams_.end(), [](const auto& stream) {
+        return stream->video_processor && stream->video_processor->getVideoProperties().is_stream;
+    });
+    if (has_live_stream) {
+        ingest_policy = parseOverflowPolicy(pc.live_ingest_policy);
+        // 入口队列由所有流共享，只保留最新一帧会饿死其他相机
+        if (ingest_policy == OverflowPolicy::LATEST_ONLY && streams_.size() > 1) {
+            LOG_WARN("Ingest policy 'latest' starves other streams in multi-stream mode, using drop_oldest");
+            ingest_policy = OverflowPolicy::DROP_OLDEST;
+        }
+    }
+    
+    // 预处理无状态，可并行；推理、跟踪、分析、输出均有状态，按帧序串行执行
+    // 各级不占用专属线程，由共享线程池执行
+    pipeline->addStage({"preprocess", static_cast<size_t>(std::max(1, pc.preprocess_threads)),
+                         static_cast<size_t>(pc.preprocess_queue_depth), false, ingest_policy},
+                        [this](FrameContext& ctx) { preprocessStage(ctx); });
+    if (config_.detector.batch_size > 1) {
+        // 批量推理：凑满batch_size帧或等待max_batch_wait_ms后执行一次forward
+        FramePipeline::StageOptions inference_options{"inference", 1,
+                                                      static_cast<size_t>(pc.inference_queue_depth), true};
+        inference_options.batch_size = static_cast<size_t>(config_.detector.batch_size);
+        inference_options.max_batch_wait_ms = config_.detector.max_batch_wait_ms;
+        pipeline->addBatchStage(inference_options,
+                                 [this](std::vector<FrameContext>& batch) { inferenceBatchStage(batch); });
+    } else {
+        pipeline->addStage({"inference", 1, static_cast<size_t>(pc.inference_queue_depth), true},
+                            [this](FrameContext& ctx) { inferenceStage(ctx); });
+    }
+    pipeline->addStage({"track", 1, static_cast<size_t>(pc.track_queue_depth), true},
+                        [this](FrameContext& ctx) { trackStage(ctx); });
+    pipeline->addStage({"analyze", 1, static_cast<size_t>(pc.analyze_queue_depth), true},
+                        [this](FrameContext& ctx) { analyzeStage(ctx); });
+    // 输出(绘制、编码、写盘)让位于感知各级
+    FramePipeline::StageOptions output_options{"output", 1, static_cast<size_t>(pc.output_queue_depth), true};
+    output_options.priority = TaskPriority::LOW;
+    pipeline->addStage(output_options, [this](FrameContext& ctx) { outputStage(ctx); });
+    
+    pipeline->setErrorCallback([this](const std::string& stage, const std::exception& e) {
+        LOG_ERROR("Error processing frame in stage {}: {}", stage, e.what());
+        setState(SystemState::ERROR);
+    });
+    
+    // 抽样帧离开流水线后写出各级进出时刻
+    frame_tracer_.reset();
+    if (config_.trace.enable) {
+        std::vector<std::string> stage_names;
+        for (size_t i = 0; i < pipeline->stageCount(); ++i) {
+            stage_names.push_back(pipeline->stageName(i));
+        }
+        std::vector<std::string> stream_names;
+        for (const auto& stream : streams_) {
+            stream_names.push_back(stream->name);
+        }
+        auto tracer = std::make_unique<FrameTracer>();
+        if (tracer->open(config_.trace, stage_names, stream_names)) {
+            frame_tracer_ = std::move(tracer);
+            FrameTracer* raw = frame_tracer_.get();
+            pipeline->setCompletionCallback([raw](const FrameContext& ctx) { raw->record(ctx); });
+        }
+    }
+    
+    std::lock_guard<std::mutex> lock(pipeline_mutex_);
+    pipeline_ = std::move(pipeline);
+}
+
 bool VehiclePerceptionSystem::start() {
     if (state_ != SystemState::STOPPED && state_ != SystemState::PAUSED) {
         LOG_WARN("System is not in a state that can be started");
@@ -132,9 +483,15 @@ bool VehiclePerceptionSystem::start() {
         setState(SystemState::RUNNING);
         paused_ = false;
         
-        // 启动视频处理器
-        if (!video_processor_->start()) {
-            LOG_ERROR("Failed to start video processor");
+        // 先启动流水线，再启动视频处理器
+        if (!pipeline_ || !pipeline_->start()) {
+            LOG_ERROR("Failed to start frame pipeline");
+            setState(SystemState::ERROR);
+            return false;
+        }
+        
+        // 启动各路视频处理器
+        if (!startVideo()) {
             setState(SystemState::ERROR);
             return false;
         }
@@ -158,17 +515,25 @@ void VehiclePerceptionSystem::stop() {
     paused_ = false;
     
     // 停止视频处理器
-    if (video_processor_) {
-        video_processor_->stop();
+    stopVideo();
+    
+    // 等待流水线中已入队的帧处理完成
+    if (pipeline_) {
+        pipeline_->stop();
     }
     
-    // 等待所有任务完成
-    if (thread_pool_) {
-        thread_pool_->stop();
-        thread_pool_->start(); // 重新启动以清理线程
+    // 等待写出线程把已提交的结果写入文件
+    for (auto& stream : streams_) {
+        if (stream->result_processor) {
+            stream->result_processor->flush();
+        }
+    }
+    if (frame_tracer_) {
+        frame_tracer_->flush();
     }
     
     LOG_INFO("System stopped");
+    Logger::getInstance().flush();
 }
 
 void VehiclePerceptionSystem::pause() {
@@ -201,7 +566,29 @@ const SystemConfig& VehiclePerceptionSystem::getConfig() const {
 }
 
 bool VehiclePerceptionSystem::updateConfig(const SystemConfig& config) {
-    std::lock_guard<std::mutex> lock(callback_mutex_);
+    ReloadScope scope = classifyChange(config_, config);
+    if (scope == ReloadScope::DETECTOR && !std::atomic_load(&object_detector_)) {
+        scope = ReloadScope::FULL;
+    }
+    MetricsRegistry::instance()
+        .counter("vps_config_reloads_total", std::string("scope=\"") + reloadScopeName(scope) + "\"",
+                 "Configuration updates by how they were applied")
+        .add();
+    if (scope == ReloadScope::NONE) {
+        return true;
+    }
+    if (scope != ReloadScope::FULL) {
+        // 流水线不停止，只替换在线生效的配置段；各级从参数快照读取新值
+        config_.detector = config.detector;
+        config_.tracker = config.tracker;
+        config_.behavior = config.behavior;
+        publishTuning();
+        if (scope == ReloadScope::DETECTOR) {
+            reloadDetector(config_.detector);
+        }
+        LOG_INFO("Configuration updated without restart ({})", reloadScopeName(scope));
+        return true;
+    }
     
     // 保存旧状态
     SystemState old_state = state_;
@@ -212,40 +599,203 @@ bool VehiclePerceptionSystem::updateConfig(const SystemConfig& config) {
         pause();
     }
     
+    // 停止视频源并排空流水线，确保没有帧仍在使用旧模块
+    stopVideo();
+    if (pipeline_) {
+        pipeline_->stop();
+    }
+    
     // 更新配置
     config_ = config;
     
-    // 重新初始化模块
+    // 重新初始化模块并重建流水线
     bool success = initializeModules();
+    if (success) {
+        buildPipeline();
+        publishTuning();
+    }
     
     // 恢复之前的状态
     if (was_running && success) {
+        success = pipeline_->start() && startVideo();
         resume();
     }
     
     return success;
 }
 
+void VehiclePerceptionSystem::publishTuning() {
+    auto tuning = std::make_shared<LiveTuning>();
+    tuning->generation = tuning_generation_.load(std::memory_order_relaxed) + 1;
+    tuning->confidence_threshold = config_.detector.confidence_threshold;
+    tuning->nms_threshold = config_.detector.nms_threshold;
+    tuning->max_age = config_.tracker.max_age;
+    tuning->min_hits = config_.tracker.min_hits;
+    tuning->iou_threshold = config_.tracker.iou_threshold;
+    tuning->behavior = config_.behavior;
+    // 先发布快照再递增版本，读到新版本的一方一定能取到不旧于它的快照
+    std::atomic_store(&tuning_, std::shared_ptr<const LiveTuning>(std::move(tuning)));
+    tuning_generation_.fetch_add(1, std::memory_order_release);
+}
+
+std::shared_ptr<const VehiclePerceptionSystem::LiveTuning> VehiclePerceptionSystem::pendingTuning(
+    uint64_t& applied) const {
+    if (tuning_generation_.load(std::memory_order_acquire) == applied) {
+        return nullptr;
+    }
+    auto tuning = std::atomic_load(&tuning_);
+    if (!tuning) {
+        return nullptr;
+    }
+    applied = tuning->generation;
+    return tuning;
+}
+
+void VehiclePerceptionSystem::reloadDetector(const SystemConfig::DetectorConfig& config) {
+    cv::Size frame_size(config.input_width, config.input_height);
+    if (!streams_.empty() && streams_.front()->video_processor) {
+        const auto props = streams_.front()->video_processor->getVideoProperties();
+        if (props.width > 0 && props.height > 0) {
+            frame_size = cv::Size(props.width, props.height);
+        }
+    }
+    
+    std::lock_guard<std::mutex> lock(reload_mutex_);
+    pending_detector_ = config;
+    reload_frame_size_ = frame_size;
+    if (reload_active_) {
+        return;
+    }
+    if (reload_thread_.joinable()) {
+        reload_thread_.join();
+    }
+    reload_active_ = true;
+    reload_thread_ = std::thread(&VehiclePerceptionSystem::reloadLoop, this);
+}
+
+void VehiclePerceptionSystem::reloadLoop() {
+    for (;;) {
+        SystemConfig::DetectorConfig config;
+        cv::Size frame_size;
+        {
+            std::lock_guard<std::mutex> lock(reload_mutex_);
+            if (!pending_detector_) {
+                reload_active_ = false;
+                return;
+            }
+            config = *pending_detector_;
+            frame_size = reload_frame_size_;
+            pending_detector_.reset();
+        }
+        
+        // 构建期间旧检测器照常推理，新旧引擎短暂同时占用显存
+        auto build_start = std::chrono::steady_clock::now();
+        std::shared_ptr<IObjectDetector> detector = IObjectDetector::create();
+        try {
+            if (!detector || !detector->initialize(config)) {
+                LOG_ERROR("Failed to build detector from {}, keeping the current detector", config.model_path);
+                continue;
+            }
+            warmUpDetector(*detector, frame_size, config.batch_size);
+        } catch (const std::exception& e) {
+            LOG_ERROR("Detector reload error: {}, keeping the current detector", e.what());
+            continue;
+        }
+        const float build_ms = elapsedMs(build_start);
+        
+        // 之后预处理的帧使用新检测器，旧检测器在最后一个在途帧推理完后释放
+        std::atomic_store(&object_detector_, std::move(detector));
+        LOG_INFO("Detector reloaded from {} in {}ms", config.model_path, build_ms);
+    }
+}
+
+void VehiclePerceptionSystem::joinReload() {
+    {
+        std::lock_guard<std::mutex> lock(reload_mutex_);
+        pending_detector_.reset();
+    }
+    if (reload_thread_.joinable()) {
+        reload_thread_.join();
+    }
+}
+
 std::vector<BehaviorAnalysis> VehiclePerceptionSystem::getLastResults() const {
     std::lock_guard<std::mutex> lock(results_mutex_);
-    return last_results_;
+    if (streams_.size() == 1) {
+        return streams_.front()->last_results;
+    }
+    std::vector<BehaviorAnalysis> results;
+    for (const auto& stream : streams_) {
+        results.insert(results.end(), stream->last_results.begin(), stream->last_results.end());
+    }
+    return results;
+}
+
+size_t VehiclePerceptionSystem::streamCount() const {
+    return streams_.size();
+}
+
+bool VehiclePerceptionSystem::inputFinished() const {
+    return !streams_.empty() && std::all_of(streams_.begin(), streams_.end(), [](const auto& stream) {
+        return stream->video_processor && stream->video_processor->isFinished();
+    });
 }
 
 void VehiclePerceptionSystem::registerResultCallback(
     std::function<void(const std::vector<BehaviorAnalysis>&)> callback) {
-    std::lock_guard<std::mutex> lock(callback_mutex_);
-    result_callback_ = callback;
+    result_callback_.set(std::move(callback));
 }
 
 void VehiclePerceptionSystem::registerStateCallback(
     std::function<void(SystemState)> callback) {
-    std::lock_guard<std::mutex> lock(callback_mutex_);
-    state_callback_ = callback;
+    state_callback_.set(std::move(callback));
 }
 
 SystemPerformance VehiclePerceptionSystem::getPerformanceStats() const {
-    std::lock_guard<std::mutex> lock(performance_mutex_);
-    return performance_stats_;
+    SystemPerformance stats{};
+    {
+        std::lock_guard<std::mutex> lock(pipeline_mutex_);
+        if (pipeline_) {
+            stats.frames_submitted = pipeline_->submittedFrames();
+            stats.frames_dropped = pipeline_->droppedFrames();
+        }
+    }
+    stats.cpu_usage = -1.0f;
+    stats.gpu_usage = -1.0f;
+    if (!metrics_exporter_) {
+        return stats;
+    }
+    
+    // 取最近一个采样区间的统计
+    const MetricsSummary summary = metrics_exporter_->summary();
+    auto latency = [&summary](const char* name, const char* stage) {
+        static const MetricsSummary::Latency kEmpty;
+        const auto* found = summary.find(name, stage ? std::string("stage=\"") + stage + "\"" : std::string());
+        return found ? *found : kEmpty;
+    };
+    const auto end_to_end = latency("vps_capture_to_result_seconds", nullptr);
+    const auto inference = latency("vps_stage_latency_seconds", "inference");
+    stats.fps = static_cast<float>(summary.fps);
+    stats.detection_time_ms = static_cast<float>(latency("vps_stage_latency_seconds", "preprocess").mean_ms +
+                                                 inference.mean_ms +
+                                                 latency("vps_stage_latency_seconds", "postprocess").mean_ms);
+    stats.tracking_time_ms = static_cast<float>(latency("vps_stage_latency_seconds", "track").mean_ms);
+    stats.analysis_time_ms = static_cast<float>(latency("vps_stage_latency_seconds", "analyze").mean_ms);
+    stats.total_latency_ms = static_cast<float>(end_to_end.mean_ms);
+    stats.latency_p50_ms = static_cast<float>(end_to_end.p50_ms);
+    stats.latency_p99_ms = static_cast<float>(end_to_end.p99_ms);
+    stats.latency_max_ms = static_cast<float>(end_to_end.max_ms);
+    stats.detection_p99_ms = static_cast<float>(inference.p99_ms);
+    stats.cpu_usage = static_cast<float>(summary.cpu_percent);
+    stats.gpu_usage = static_cast<float>(summary.gpu_percent);
+    stats.memory_usage_mb = static_cast<size_t>(summary.rss_mb);
+    return stats;
+}
+
+StartupTimings VehiclePerceptionSystem::getStartupTimings() const {
+    StartupTimings timings = startup_timings_;
+    timings.first_result_ms = first_result_ms_.load();
+    return timings;
 }
 
 bool VehiclePerceptionSystem::reset() {
@@ -266,106 +816,316 @@ bool VehiclePerceptionSystem::reset() {
     return success;
 }
 
-void VehiclePerceptionSystem::processFrame(const cv::Mat& frame, uint64_t timestamp) {
-    if (paused_) {
-        std::unique_lock<std::mutex> lock(pause_mutex_);
-        pause_cv_.wait(lock, [this]() { return !paused_ || state_ != SystemState::RUNNING; });
+void VehiclePerceptionSystem::preprocessStage(FrameContext& context) {
+    // 自适应调度决定本帧全图检测、只检测ROI还是只做跟踪外推
+    const bool gpu = context.frame.empty() && !context.gpu_frame.empty();
+    const cv::Size frame_size = gpu ? context.gpu_frame.size() : context.frame.size();
+    // 断流期间重复交付的最后一帧不做检测，跟踪器按运动模型外推
+    const auto decision = context.trace.stale
+                              ? DetectionScheduler::Decision{DetectionMode::SKIP, cv::Rect()}
+                              : detection_scheduler_.decide(context.stream_id, schedulingIndex(context), frame_size);
+    context.detect_mode = decision.mode;
+    context.detect_roi = decision.roi;
+    
+    if (decision.mode != DetectionMode::SKIP) {
+        // 本帧固定使用当前检测器，预处理和推理须出自同一模型
+        context.detector = std::atomic_load(&object_detector_);
+        const IObjectDetector& detector = *context.detector;
         
-        if (state_ != SystemState::RUNNING) {
+        // 区域为空时处理整帧
+        auto prepare = [&](const cv::Rect& region) {
+            DetectorInput input;
+            if (gpu) {
+                input = region.area() > 0 ? detector.preprocess(context.gpu_frame(region))
+                                          : detector.preprocess(context.gpu_frame);
+            } else {
+                input = region.area() > 0 ? detector.preprocess(context.frame(region))
+                                          : detector.preprocess(context.frame);
+            }
+            input.trace = context.trace;
+            context.preprocess_ms += input.preprocess_time_ms;
+            return input;
+        };
+        const cv::Rect coarse_region = decision.mode == DetectionMode::ROI ? decision.roi : cv::Rect();
+        
+        // 切片推理：ROI模式下只保留与ROI相交的切片
+        for (const cv::Rect& tile : tiled_detection_.layout(frame_size)) {
+            if (decision.mode == DetectionMode::ROI && (tile & decision.roi).area() == 0) {
+                continue;
+            }
+            context.tile_inputs.push_back(prepare(tile));
+            context.tile_rects.push_back(tile);
+        }
+        if (context.tile_inputs.empty() || tiled_detection_.coarsePass()) {
+            context.input = prepare(coarse_region);
+        }
+    }
+    
+    // 只有绘制、录像或外观特征跟踪需要主机内存中的帧
+    if (gpu) {
+        const auto& oc = config_.output;
+        if (oc.save_video || oc.draw_bboxes || oc.draw_labels || oc.draw_trails ||
+            streams_.at(context.stream_id)->object_tracker->needsFrame()) {
+            context.gpu_frame.download(context.frame);
+        }
+        context.gpu_frame.release();
+    }
+}
+
+void VehiclePerceptionSystem::inferenceStage(FrameContext& context) {
+    FrameContext* frames[] = {&context};
+    detectFrames(frames, 1);
+}
+
+void VehiclePerceptionSystem::inferenceBatchStage(std::vector<FrameContext>& batch) {
+    std::vector<FrameContext*> frames;
+    frames.reserve(batch.size());
+    for (auto& context : batch) {
+        frames.push_back(&context);
+    }
+    detectFrames(frames.data(), frames.size());
+}
+
+void VehiclePerceptionSystem::detectFrames(FrameContext* const* frames, size_t count) {
+    // 检测器热替换前后预处理的帧不能同批推理，在检测器变化处拆开
+    std::shared_ptr<IObjectDetector> detector;
+    for (size_t f = 0; f < count; ++f) {
+        const auto& pinned = frames[f]->detector;
+        if (frames[f]->detect_mode == DetectionMode::SKIP || !pinned) {
+            continue;
+        }
+        if (!detector) {
+            detector = pinned;
+        } else if (pinned != detector) {
+            detectFrames(frames, f);
+            detectFrames(frames + f, count - f);
             return;
         }
     }
+    if (!detector) {
+        return;
+    }
     
-    auto total_start = std::chrono::steady_clock::now();
+    // 在线阈值在推理线程上应用，与后处理不并发；新换入的检测器重新应用当前快照
+    if (tuned_detector_.owner_before(detector) || detector.owner_before(tuned_detector_)) {
+        tuned_detector_ = detector;
+        detector_tuning_ = 0;
+    }
+    if (auto tuning = pendingTuning(detector_tuning_)) {
+        detector->setConfidenceThreshold(tuning->confidence_threshold);
+        detector->setNmsThreshold(tuning->nms_threshold);
+    }
     
-    try {
-        // 1. 目标检测
-        auto detect_start = std::chrono::steady_clock::now();
-        auto detections = object_detector_->detect(frame);
-        auto detect_end = std::chrono::steady_clock::now();
-        float detect_ms = std::chrono::duration<float, std::milli>(detect_end - detect_start).count();
-        
-        // 2. 目标跟踪
-        auto track_start = std::chrono::steady_clock::now();
-        auto tracked_objects = object_tracker_->update(detections, timestamp);
-        auto track_end = std::chrono::steady_clock::now();
-        float track_ms = std::chrono::duration<float, std::milli>(track_end - track_start).count();
-        
-        // 3. 行为分析
-        auto analysis_start = std::chrono::steady_clock::now();
-        auto behaviors = behavior_analyzer_->analyze(tracked_objects);
-        auto analysis_end = std::chrono::steady_clock::now();
-        float analysis_ms = std::chrono::duration<float, std::milli>(analysis_end - analysis_start).count();
-        
-        // 4. LLM增强分析(如果启用)
-        if (llm_enhancer_ && timestamp % (config_.llm.analysis_interval * 1000) == 0) {
-            behaviors = llm_enhancer_->enhanceAnalysis(behaviors, tracked_objects);
+    // 收集各帧的粗检测和切片输入，跳过检测的帧不进入批次
+    struct Source {
+        size_t frame;
+        cv::Rect region;
+        bool tile;
+    };
+    std::vector<DetectorInput> inputs;
+    std::vector<Source> sources;
+    size_t detected_frames = 0;
+    for (size_t f = 0; f < count; ++f) {
+        FrameContext& context = *frames[f];
+        if (context.detect_mode == DetectionMode::SKIP) {
+            continue;
         }
-        
-        // 5. 结果处理
-        result_processor_->process(behaviors, frame, timestamp);
-        
-        // 6. 缓存结果并触发回调
-        {
-            std::lock_guard<std::mutex> lock(results_mutex_);
-            last_results_ = behaviors;
+        ++detected_frames;
+        if (!context.input.blob.empty()) {
+            const bool crop = context.detect_mode == DetectionMode::ROI;
+            sources.push_back({f, crop ? context.detect_roi : cv::Rect(), false});
+            inputs.push_back(std::move(context.input));
         }
-        
-        {
-            std::lock_guard<std::mutex> lock(callback_mutex_);
-            if (result_callback_) {
-                result_callback_(behaviors);
+        for (size_t t = 0; t < context.tile_inputs.size(); ++t) {
+            sources.push_back({f, context.tile_rects[t], true});
+            inputs.push_back(std::move(context.tile_inputs[t]));
+        }
+        // 网络输入不再需要，尽早归还输入缓冲区和检测器引用
+        context.input = DetectorInput();
+        context.tile_inputs.clear();
+        context.detector.reset();
+    }
+    if (inputs.empty()) {
+        return;
+    }
+    
+    auto detect_start = std::chrono::steady_clock::now();
+    auto results = inputs.size() == 1 ? std::vector<std::vector<Detection>>{detector->infer(inputs.front())}
+                                       : detector->inferBatch(inputs);
+    auto detect_end = std::chrono::steady_clock::now();
+    const float detect_ms = std::chrono::duration<float, std::milli>(detect_end - detect_start).count();
+    inputs.clear();
+    
+    // 按帧合并结果(各帧的输入在批次中连续)，坐标转回帧坐标
+    for (size_t begin = 0; begin < sources.size();) {
+        const size_t f = sources[begin].frame;
+        size_t end = begin;
+        std::vector<TiledDetection::Part> parts;
+        for (; end < sources.size() && sources[end].frame == f; ++end) {
+            TiledDetection::Part part;
+            if (end < results.size()) {
+                part.detections = std::move(results[end]);
             }
+            part.region = sources[end].region;
+            part.tile = sources[end].tile;
+            parts.push_back(std::move(part));
         }
+        FrameContext& context = *frames[f];
+        context.detections = tiled_detection_.merge(parts);
+        context.tile_rects.clear();
         
-        // 7. 更新性能统计
-        auto total_end = std::chrono::steady_clock::now();
-        float total_ms = std::chrono::duration<float, std::milli>(total_end - total_start).count();
-        updatePerformanceStats(detect_ms, track_ms, analysis_ms, total_ms);
-        
-    } catch (const std::exception& e) {
-        LOG_ERROR("Error processing frame: {}", e.what());
-        setState(SystemState::ERROR);
+        // 每帧都要等待整批完成，因此记录整批耗时；调度按每帧分摊的耗时计算
+        context.detection_ms = detect_ms;
+        detection_scheduler_.observeCost(context.preprocess_ms + detect_ms / static_cast<float>(detected_frames));
+        begin = end;
     }
 }
 
-void VehiclePerceptionSystem::setState(SystemState new_state) {
-    state_ = new_state;
+void VehiclePerceptionSystem::trackStage(FrameContext& context) {
+    auto track_start = std::chrono::steady_clock::now();
+    Stream& stream = *streams_.at(context.stream_id);
+    if (auto tuning = pendingTuning(stream.tracker_tuning)) {
+        stream.object_tracker->setMaxAge(tuning->max_age);
+        stream.object_tracker->setMinHits(tuning->min_hits);
+        stream.object_tracker->setIouThreshold(tuning->iou_threshold);
+    }
+    if (context.detect_mode == DetectionMode::SKIP) {
+        context.tracked_objects = stream.object_tracker->predictTracks(context.timestamp);
+    } else {
+        context.tracked_objects = stream.object_tracker->update(context.detections, context.frame, context.timestamp);
+    }
+    detection_scheduler_.observeTracks(context.stream_id, context.tracked_objects->view());
+    auto track_end = std::chrono::steady_clock::now();
+    context.tracking_ms = std::chrono::duration<float, std::milli>(track_end - track_start).count();
+}
+
+void VehiclePerceptionSystem::analyzeStage(FrameContext& context) {
+    auto analysis_start = std::chrono::steady_clock::now();
+    Stream& stream = *streams_.at(context.stream_id);
+    if (auto tuning = pendingTuning(stream.analyzer_tuning)) {
+        stream.behavior_analyzer->setThresholds(tuning->behavior);
+    }
+    context.behaviors = stream.behavior_analyzer->analyze(context.tracked_objects->view());
+    auto analysis_end = std::chrono::steady_clock::now();
+    context.analysis_ms = std::chrono::duration<float, std::milli>(analysis_end - analysis_start).count();
+    
+    // 标记结果来源的视频流和帧
+    for (auto& behavior : context.behaviors) {
+        behavior.stream_id = context.stream_id;
+        behavior.trace = context.trace;
+    }
+    detection_scheduler_.observeRisk(context.stream_id, schedulingIndex(context), context.behaviors);
     
-    std::lock_guard<std::mutex> lock(callback_mutex_);
-    if (state_callback_) {
-        state_callback_(new_state);
+    // LLM增强分析(如果启用)，异步执行，这里只附带已缓存的结果
+    if (llm_enhancer_) {
+        llm_enhancer_->enhanceAnalysis(context.behaviors, context.tracked_objects->view());
     }
 }
 
+void VehiclePerceptionSystem::outputStage(FrameContext& context) {
+    auto output_start = std::chrono::steady_clock::now();
+    Stream& stream = *streams_.at(context.stream_id);
+    
+    // 缓存结果并触发回调
+    {
+        std::lock_guard<std::mutex> lock(results_mutex_);
+        stream.last_results = context.behaviors;
+    }
+    
+    result_callback_(context.behaviors);
+    
+    // 结果和帧引用移交给写出线程，绘制、编码和写盘不占用流水线
+    stream.result_processor->process(std::move(context.behaviors), context.frame,
+                                     std::move(context.frame_buffer), context.timestamp);
+    context.frame.release();
+    
+    static LatencyHistogram& output_latency = stageLatency("output");
+    output_latency.record(std::chrono::steady_clock::now() - output_start);
+    if (first_result_pending_.load(std::memory_order_relaxed) && first_result_pending_.exchange(false)) {
+        const float first_result_ms = elapsedMs(startup_begin_);
+        first_result_ms_ = first_result_ms;
+        MetricsRegistry::instance()
+            .gauge("vps_startup_phase_seconds", "phase=\"first_result\"",
+                   "Duration of each phase of the last initialization")
+            .set(first_result_ms / 1000.0);
+        LOG_INFO("First result {}ms after startup", first_result_ms);
+    }
+    updatePerformanceStats(context);
+}
+
+void VehiclePerceptionSystem::setState(SystemState new_state) {
+    state_ = new_state;
+    state_callback_(new_state);
+}
+
 void VehiclePerceptionSystem::resetPerformanceStats() {
-    std::lock_guard<std::mutex> lock(performance_mutex_);
-    performance_stats_ = SystemPerformance();
+    MetricsRegistry::instance().resetHistograms();
+}
+
+void VehiclePerceptionSystem::startMetrics() {
+    if (!config_.metrics.enable) {
+        if (metrics_exporter_) {
+            metrics_exporter_->stop();
+            metrics_exporter_.reset();
+        }
+        return;
+    }
+    if (!metrics_exporter_) {
+        metrics_exporter_ = std::make_unique<MetricsExporter>();
+    }
+    
+    // 每次采样前刷新队列深度和流水线计数
+    metrics_exporter_->start(config_.metrics, [this]() {
+        auto& registry = MetricsRegistry::instance();
+        std::lock_guard<std::mutex> lock(pipeline_mutex_);
+        if (!pipeline_) {
+            return;
+        }
+        for (size_t i = 0; i < pipeline_->stageCount(); ++i) {
+            registry.gauge("vps_queue_depth", "stage=\"" + pipeline_->stageName(i) + "\"",
+                           "Frames waiting in front of each pipeline stage")
+                .set(static_cast<double>(pipeline_->queueSize(i)));
+        }
+        registry.gauge("vps_pipeline_submitted_frames", "", "Frames submitted since the pipeline started")
+            .set(static_cast<double>(pipeline_->submittedFrames()));
+        registry.gauge("vps_pipeline_dropped_frames", "", "Frames dropped by ingest overflow since the pipeline started")
+            .set(static_cast<double>(pipeline_->droppedFrames()));
+        if (detection_scheduler_.enabled()) {
+            for (size_t i = 0; i < detection_scheduler_.streamCount(); ++i) {
+                registry.gauge("vps_detect_interval", "stream=\"" + std::to_string(i) + "\"",
+                               "Frames between detections chosen by the adaptive scheduler")
+                    .set(static_cast<double>(detection_scheduler_.detectInterval(static_cast<int>(i))));
+            }
+        }
+    });
 }
 
-void VehiclePerceptionSystem::updatePerformanceStats(float detection_ms, float tracking_ms, 
-                                                   float analysis_ms, float total_ms) {
-    std::lock_guard<std::mutex> lock(performance_mutex_);
+void VehiclePerceptionSystem::updatePerformanceStats(const FrameContext& context) {
+    static LatencyHistogram& preprocess_latency = stageLatency("preprocess");
+    static LatencyHistogram& track_latency = stageLatency("track");
+    static LatencyHistogram& analyze_latency = stageLatency("analyze");
+    static auto& registry = MetricsRegistry::instance();
+    static LatencyHistogram& pipeline_latency = registry.histogram(
+        "vps_pipeline_latency_seconds", "", "Time from pipeline ingest to output");
+    static LatencyHistogram& end_to_end_latency = registry.histogram(
+        "vps_capture_to_result_seconds", "", "Time from frame capture to result output");
+    static Counter& frames_output = registry.counter(
+        "vps_frames_output_total", "", "Frames that completed every pipeline stage");
     
-    // 简单的滑动平均更新
-    const float alpha = 0.2f; // 平滑因子
+    preprocess_latency.recordMs(context.preprocess_ms);
+    track_latency.recordMs(context.tracking_ms);
+    analyze_latency.recordMs(context.analysis_ms);
     
-    performance_stats_.detection_time_ms = 
-        alpha * detection_ms + (1 - alpha) * performance_stats_.detection_time_ms;
-        
-    performance_stats_.tracking_time_ms = 
-        alpha * tracking_ms + (1 - alpha) * performance_stats_.tracking_time_ms;
-        
-    performance_stats_.analysis_time_ms = 
-        alpha * analysis_ms + (1 - alpha) * performance_stats_.analysis_time_ms;
-        
-    performance_stats_.total_latency_ms = 
-        alpha * total_ms + (1 - alpha) * performance_stats_.total_latency_ms;
-        
-    // 计算帧率
-    if (total_ms > 0) {
-        performance_stats_.fps = alpha * (1000.0f / total_ms) + (1 - alpha) * performance_stats_.fps;
-    }
+    const auto now = std::chrono::steady_clock::now();
+    pipeline_latency.record(now - context.ingest_time);
     
-    // 这里可以添加CPU/GPU使用率和内存使用的更新逻辑
+    // 采集时刻未知(直接提交的帧)时以进入流水线的时间代替
+    const uint64_t now_us = traceClockMicros();
+    const uint64_t capture_us = context.trace.capture_time_us;
+    if (capture_us > 0 && capture_us <= now_us) {
+        end_to_end_latency.record(now_us - capture_us);
+    } else {
+        end_to_end_latency.record(now - context.ingest_time);
+    }
+    frames_output.add();
 }
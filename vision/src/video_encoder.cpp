@@ -0,0 +1,101 @@
+/**
+ * @file video_encoder.cpp
+ * @brief 输出视频编码器实现
+ * @author pengchengkang
+ * @date 2025-9-16
+ */
+#include "video_encoder.hpp"
+#include "logger.hpp"
+#include <algorithm>
+
+bool VideoEncoder::open(const std::string& path, const cv::Size& size, double fps,
+                        const std::string& mode, int bitrate_kbps) {
+    close();
+    path_ = path;
+    size_ = size;
+    fps_ = fps > 0.0 ? fps : 30.0;
+
+    std::string encoder_mode = mode;
+    std::transform(encoder_mode.begin(), encoder_mode.end(), encoder_mode.begin(), ::tolower);
+    const int kbps = std::max(100, bitrate_kbps);
+    const std::string kbps_text = std::to_string(kbps);
+    const std::string bps_text = std::to_string(kbps * 1000);
+
+    const bool try_nvenc = encoder_mode == "auto" || encoder_mode == "nvenc";
+    const bool try_vaapi = encoder_mode == "auto" || encoder_mode == "vaapi";
+    if (!try_nvenc && !try_vaapi && encoder_mode != "cpu") {
+        LOG_WARN("Unknown video encoder {}, using CPU", mode);
+    }
+
+    const int h264 = cv::VideoWriter::fourcc('a', 'v', 'c', '1');
+    bool opened =
+        (try_nvenc && (openGStreamer("videoconvert ! video/x-raw,format=I420 ! nvh264enc bitrate=" +
+                                     kbps_text, "nvenc") ||
+                       openGStreamer("videoconvert ! video/x-raw,format=BGRx ! nvvidconv"
+                                     " ! video/x-raw(memory:NVMM),format=I420 ! nvv4l2h264enc bitrate=" +
+                                     bps_text, "nvenc-jetson"))) ||
+        (try_vaapi && (openGStreamer("videoconvert ! vaapih264enc bitrate=" + kbps_text, "vaapi") ||
+                       openFfmpeg(h264, cv::VIDEO_ACCELERATION_VAAPI, "ffmpeg-vaapi"))) ||
+        (encoder_mode == "auto" && openFfmpeg(h264, cv::VIDEO_ACCELERATION_ANY, "ffmpeg-hw")) ||
+        openFfmpeg(h264, cv::VIDEO_ACCELERATION_NONE, "h264") ||
+        openFfmpeg(cv::VideoWriter::fourcc('m', 'p', '4', 'v'), cv::VIDEO_ACCELERATION_NONE, "mpeg4");
+
+    if (!opened) {
+        LOG_ERROR("Failed to open video writer: {}", path);
+        return false;
+    }
+    if ((try_nvenc || try_vaapi) && (name_ == "h264" || name_ == "mpeg4")) {
+        LOG_WARN("Hardware video encoding unavailable, encoding {} on CPU", path);
+    }
+    LOG_INFO("Video writer opened: {} ({}x{} @ {} fps, encoder {})",
+             path, size.width, size.height, fps_, name_);
+    return true;
+}
+
+bool VideoEncoder::openGStreamer(const std::string& encoder_chain, const char* name) {
+    std::string pipeline = "appsrc ! " + encoder_chain +
+                           " ! h264parse ! mp4mux ! filesink location=" + path_;
+    try {
+        if (!writer_.open(pipeline, cv::CAP_GSTREAMER, 0, fps_, size_, true)) {
+            return false;
+        }
+    } catch (const cv::Exception& e) {
+        LOG_DEBUG("GStreamer encoder {} unavailable: {}", name, e.what());
+        return false;
+    }
+    name_ = name;
+    return true;
+}
+
+bool VideoEncoder::openFfmpeg(int fourcc, int acceleration, const char* name) {
+    std::vector<int> params = {cv::VIDEOWRITER_PROP_HW_ACCELERATION, acceleration};
+    try {
+        if (!writer_.open(path_, cv::CAP_FFMPEG, fourcc, fps_, size_, params)) {
+            return false;
+        }
+    } catch (const cv::Exception& e) {
+        LOG_DEBUG("FFmpeg encoder {} unavailable: {}", name, e.what());
+        return false;
+    }
+    if (acceleration != cv::VIDEO_ACCELERATION_NONE &&
+        static_cast<int>(writer_.get(cv::VIDEOWRITER_PROP_HW_ACCELERATION)) == cv::VIDEO_ACCELERATION_NONE) {
+        // 已打开但回退到软件编码，交给后面的软件编码分支
+        writer_.release();
+        return false;
+    }
+    name_ = name;
+    return true;
+}
+
+void VideoEncoder::write(const cv::Mat& frame) {
+    if (writer_.isOpened()) {
+        writer_.write(frame);
+    }
+}
+
+void VideoEncoder::close() {
+    if (writer_.isOpened()) {
+        writer_.release();
+    }
+    name_.clear();
+}
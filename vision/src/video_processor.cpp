@@ -7,6 +7,19 @@
  * 该文件实现了视频处理器模块，负责从各种视频源（摄像头、文件、网络流）
  * 读取视频帧，进行预处理（畸变校正、ROI裁剪），并通过回调函数将处理后的
  * 帧传递给后续模块。支持摄像头连接重试机制和超时控制。
+ *
+ * 解码模式(decode_mode)：
+ * - cuda：优先NVDEC(cv::cudacodec)，帧以GpuMat留在显存；其次Jetson上的
+ *   GStreamer nvv4l2decoder管线；再次FFmpeg硬件加速
+ * - vaapi：FFmpeg + VAAPI硬件解码
+ * - cpu：软件解码
+ * 硬件解码不可用时自动回退到软件解码。摄像头设备始终使用普通采集。
+ *
+ * 实时源(摄像头、网络流)由专用采集线程读帧(CPU解码和NVDEC均是)，交付线程做畸变校正、ROI裁剪并交付：
+ * - 网络流按read_timeout_ms设置FFmpeg打开和读帧超时(NVDEC经其内部的FFmpeg解复用器)，卡死的连接不会无限阻塞
+ * - 读帧失败时采集线程按reconnect_initial_ms起指数退避重连，上限reconnect_max_ms
+ * - 超过stale_timeout_ms没有新帧时交付线程重复交付最后一帧并标记stale，下游不会停顿
+ * - 重连次数、断流时长和当前连接状态见vps_capture_*指标
  */
 
 #include "../include/vehicle_perception_system.hpp"
@@ -14,11 +27,23 @@
 #include "../../config/config.hpp"
 #include "../../data/data_structs.hpp"
 #include "../../main/logger.hpp"
+#include "../../main/metrics.hpp"
+#include "../../main/callback_slot.hpp"
 #include <opencv2/opencv.hpp>
 #include <thread>
 #include <chrono>
 #include <filesystem>
 #include <atomic>
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+
+#if defined(HAVE_OPENCV_CUDACODEC) && defined(HAVE_OPENCV_CUDAIMGPROC) && defined(HAVE_OPENCV_CUDAWARPING)
+#include <opencv2/cudacodec.hpp>
+#include <opencv2/cudaimgproc.hpp>
+#include <opencv2/cudawarping.hpp>
+#define VIDEO_CUDA_DECODE 1
+#endif
 
 /**
  * @brief 视频处理器实现类
@@ -30,10 +55,12 @@ private:
     SystemConfig::VideoSourceConfig config_;
     ProcessingState state_;
     VideoProperties properties_;
-    std::function<void(const cv::Mat&, uint64_t)> frame_callback_;
+    // 回调以原子指针发布，读帧线程每帧调用时不加锁
+    CallbackSlot<void(const cv::Mat&, uint64_t)> frame_callback_;
+    CallbackSlot<void(const FrameHandle&)> frame_buffer_callback_;
+    CallbackSlot<void(const cv::cuda::GpuMat&, const FrameTrace&)> gpu_frame_callback_;
     std::atomic<bool> running_;
     std::thread processing_thread_;
-    std::mutex callback_mutex_;
     
     // ROI and distortion correction
     cv::Rect roi_rect_;
@@ -43,15 +70,57 @@ private:
     cv::Mat distortion_coeffs_;
     bool distortion_correction_enabled_;
     
+    // 畸变校正映射表，初始化时以及相机参数、分辨率或ROI变化时重建
+    cv::Mat undistort_map1_;      // CPU定点映射表(CV_16SC2)
+    cv::Mat undistort_map2_;
+    cv::Size map_frame_size_;     // 映射表对应的输入分辨率
+    cv::Rect map_roi_;            // 折叠进映射表的ROI，为空表示整帧
+    std::atomic<bool> maps_dirty_;
+    
     // Processing control
     std::atomic<bool> paused_;
+    std::atomic<bool> finished_{false}; // 视频文件已读到末尾
+    
+    // Decoding
+    std::string decoder_name_;    // 实际使用的解码器
+    bool gpu_decoding_;           // 帧由NVDEC解码并位于显存
+    uint64_t frames_read_;
+    FramePool frame_pool_;        // 主机内存帧缓冲池(CPU解码路径)
+    
+    // 实时源后台采集：采集线程只读帧和重连，processing_thread_负责交付
+    std::thread capture_thread_;
+    std::mutex slot_mutex_;
+    std::condition_variable slot_cv_;
+    FrameHandle latest_frame_;    // 已读取、尚未交付的最新帧(CPU解码)，受slot_mutex_保护
+    cv::cuda::GpuMat latest_gpu_frame_; // 已读取、尚未交付的最新帧(NVDEC)，受slot_mutex_保护
+    FrameTrace latest_gpu_trace_;
+    bool gpu_frame_ready_ = false;
+    // 断流时重复交付的最后一帧(交付线程访问)，只保留引用，断流时才复制像素。
+    // 输出级在缓冲区仍被共享时绘制在自己的画布上，原始像素不会被改写；
+    // NVDEC每帧解码到新的显存，同样保留引用即可
+    FrameHandle last_good_frame_;
+    cv::cuda::GpuMat last_good_gpu_frame_;
+    FrameTrace last_good_gpu_trace_;
+    
+    // 连接指标(start()时按视频源注册)
+    Counter* reconnects_ = nullptr;
+    Counter* stale_frames_ = nullptr;
+    Gauge* downtime_ = nullptr;
+    Gauge* connected_ = nullptr;
+    double downtime_sec_ = 0.0;   // 累计断流时长(采集线程访问)
+#ifdef VIDEO_CUDA_DECODE
+    cv::Ptr<cv::cudacodec::VideoReader> gpu_reader_;
+    cv::cuda::GpuMat gpu_map_x_;  // GPU畸变校正映射表(CV_32FC1)
+    cv::cuda::GpuMat gpu_map_y_;
+#endif
 
 public:
     /**
      * @brief 构造函数，初始化视频处理器状态
      */
     VideoProcessor() : state_(ProcessingState::IDLE), running_(false), 
-                      roi_enabled_(false), distortion_correction_enabled_(false), paused_(false) {}
+                      roi_enabled_(false), distortion_correction_enabled_(false), maps_dirty_(true), paused_(false),
+                      decoder_name_("cpu"), gpu_decoding_(false), frames_read_(0) {}
     
     ~VideoProcessor() override {
         stop();
@@ -85,26 +154,52 @@ public:
             return false;
         }
         
-        // 设置视频参数
-        if (config_.width > 0 && config_.height > 0) {
-            cap_.set(cv::CAP_PROP_FRAME_WIDTH, config_.width);
-            cap_.set(cv::CAP_PROP_FRAME_HEIGHT, config_.height);
+#ifdef VIDEO_CUDA_DECODE
+        if (gpu_decoding_) {
+            // NVDEC按码流原始分辨率输出，不支持设置采集参数
+            cv::cudacodec::FormatInfo format = gpu_reader_->format();
+            properties_.width = format.width;
+            properties_.height = format.height;
+            properties_.fps = config_.fps > 0 ? config_.fps : 30.0f;
+            properties_.is_stream = isLiveSource();
+        } else
+#endif
+        {
+            applyCaptureSettings();
+            
+            // 获取实际的视频属性
+            properties_.width = static_cast<int>(cap_.get(cv::CAP_PROP_FRAME_WIDTH));
+            properties_.height = static_cast<int>(cap_.get(cv::CAP_PROP_FRAME_HEIGHT));
+            properties_.fps = cap_.get(cv::CAP_PROP_FPS);
+            int total_frames = static_cast<int>(cap_.get(cv::CAP_PROP_FRAME_COUNT));
+            // GStreamer管线不报告帧数，按源类型判断
+            properties_.is_stream = decoder_name_ == "gstreamer" ? isLiveSource() : (total_frames <= 0);
+        }
+        if (properties_.fps <= 0) {
+            properties_.fps = config_.fps > 0 ? config_.fps : 30.0f;
         }
         
-        if (config_.fps > 0) {
-            cap_.set(cv::CAP_PROP_FPS, config_.fps);
+        // 预先生成畸变校正映射表，处理循环中只做remap
+        maps_dirty_ = true;
+        roi_enabled_ = config_.enable_roi && !config_.roi_rect.empty();
+        roi_rect_ = roi_enabled_ ? config_.roi_rect : cv::Rect();
+        distortion_correction_enabled_ = config_.correct_distortion && !camera_matrix_.empty() &&
+                                         !distortion_coeffs_.empty();
+        if (distortion_correction_enabled_ && properties_.width > 0 && properties_.height > 0) {
+            ensureUndistortMaps(cv::Size(properties_.width, properties_.height));
         }
         
-        // 获取实际的视频属性
-        properties_.width = static_cast<int>(cap_.get(cv::CAP_PROP_FRAME_WIDTH));
-        properties_.height = static_cast<int>(cap_.get(cv::CAP_PROP_FRAME_HEIGHT));
-        properties_.fps = cap_.get(cv::CAP_PROP_FPS);
-        int total_frames = static_cast<int>(cap_.get(cv::CAP_PROP_FRAME_COUNT));
-        properties_.is_stream = (total_frames <= 0);
+        // 按实际分辨率预分配帧缓冲区，畸变校正需要同时持有输入和输出两个缓冲区；
+        // 后台采集另占用待交付帧和断流时重复交付的最后一帧
+        if (!gpu_decoding_) {
+            const int min_pool = properties_.is_stream ? 4 : 2;
+            frame_pool_.reset(cv::Size(properties_.width, properties_.height), CV_8UC3,
+                              static_cast<size_t>(std::max(min_pool, config_.frame_pool_size)));
+        }
         
         state_ = ProcessingState::IDLE;
-        LOG_INFO("Video processor initialized successfully. Resolution: {}x{}, FPS: {}", 
-                properties_.width, properties_.height, properties_.fps);
+        LOG_INFO("Video processor initialized successfully. Resolution: {}x{}, FPS: {}, decoder: {}", 
+                properties_.width, properties_.height, properties_.fps, decoder_name_);
         
         return true;
     }
@@ -114,15 +209,22 @@ public:
             return true;
         }
         
-        if (!cap_.isOpened()) {
+        if (!isSourceOpened()) {
             LOG_ERROR("Cannot start: video source not opened");
             return false;
         }
         
         running_ = true;
         paused_ = false;
+        finished_ = false;
         state_ = ProcessingState::PROCESSING;
-        processing_thread_ = std::thread(&VideoProcessor::processLoop, this);
+        registerConnectionMetrics();
+        if (usesCaptureThread()) {
+            capture_thread_ = std::thread(&VideoProcessor::captureLoop, this);
+            processing_thread_ = std::thread(&VideoProcessor::deliveryLoop, this);
+        } else {
+            processing_thread_ = std::thread(&VideoProcessor::processLoop, this);
+        }
         LOG_INFO("Video processing started");
         return true;
     }
@@ -132,16 +234,33 @@ public:
             return;
         }
         
-        running_ = false;
+        {
+            std::lock_guard<std::mutex> lock(slot_mutex_);
+            running_ = false;
+        }
+        slot_cv_.notify_all();
         state_ = ProcessingState::IDLE;
         
+        // 采集线程正阻塞在读帧时最多等待read_timeout_ms
         if (processing_thread_.joinable()) {
             processing_thread_.join();
         }
+        if (capture_thread_.joinable()) {
+            capture_thread_.join();
+        }
+        latest_frame_.reset();
+        latest_gpu_frame_.release();
+        gpu_frame_ready_ = false;
+        last_good_frame_.reset();
+        last_good_gpu_frame_.release();
         
         if (cap_.isOpened()) {
             cap_.release();
         }
+#ifdef VIDEO_CUDA_DECODE
+        gpu_reader_.release();
+#endif
+        gpu_decoding_ = false;
         
         LOG_INFO("Video processor stopped");
     }
@@ -166,12 +285,16 @@ public:
         return state_;
     }
     
+    bool isFinished() const override {
+        return finished_;
+    }
+    
     VideoProperties getVideoProperties() const override {
         return properties_;
     }
     
     bool seek(double timestamp) override {
-        if (!cap_.isOpened()) {
+        if (!isSourceOpened()) {
             return false;
         }
         
@@ -180,6 +303,10 @@ public:
             LOG_WARN("Seek operation not supported for live streams");
             return false;
         }
+        if (gpu_decoding_) {
+            LOG_WARN("Seek operation not supported with NVDEC decoding");
+            return false;
+        }
         
         // 计算目标帧号
         double fps = cap_.get(cv::CAP_PROP_FPS);
@@ -190,7 +317,7 @@ public:
     }
     
     double getCurrentTimestamp() const override {
-        if (!cap_.isOpened()) {
+        if (!isSourceOpened()) {
             return -1.0;
         }
         
@@ -201,6 +328,10 @@ public:
             return std::chrono::duration_cast<std::chrono::milliseconds>(duration).count() / 1000.0;
         }
         
+        if (gpu_decoding_) {
+            return frames_read_ / properties_.fps;
+        }
+        
         // 对于文件，返回当前播放位置
         double fps = cap_.get(cv::CAP_PROP_FPS);
         if (fps <= 0) fps = 30.0;
@@ -210,13 +341,25 @@ public:
     }
     
     void registerFrameCallback(std::function<void(const cv::Mat&, uint64_t)> callback) override {
-        std::lock_guard<std::mutex> lock(callback_mutex_);
-        frame_callback_ = callback;
+        frame_callback_.set(std::move(callback));
+    }
+    
+    void registerFrameBufferCallback(std::function<void(const FrameHandle&)> callback) override {
+        frame_buffer_callback_.set(std::move(callback));
+    }
+    
+    void registerGpuFrameCallback(std::function<void(const cv::cuda::GpuMat&, const FrameTrace&)> callback) override {
+        gpu_frame_callback_.set(std::move(callback));
+    }
+    
+    bool isGpuDecoding() const override {
+        return gpu_decoding_;
     }
     
     void setROI(const cv::Rect& roi) override {
         roi_rect_ = roi;
         roi_enabled_ = !roi.empty();
+        maps_dirty_ = true;
         LOG_INFO("ROI set to ({}, {}, {}, {})", roi.x, roi.y, roi.width, roi.height);
     }
     
@@ -230,6 +373,7 @@ public:
             return;
         }
         distortion_correction_enabled_ = enable;
+        maps_dirty_ = true;
         LOG_INFO("Distortion correction {}", enable ? "enabled" : "disabled");
     }
 
@@ -281,33 +425,153 @@ private:
     }
     
     /**
-     * @brief 单次尝试打开视频源
+     * @brief 单次尝试打开视频源，按decode_mode选择解码器，硬件不可用时回退到软件解码
+     * @param allow_gpu 是否允许NVDEC(断流重连时保持原有解码路径)
      * @return bool 是否成功打开
      */
-    bool openVideoSource() {
+    bool openVideoSource(bool allow_gpu = true) {
         try {
+            gpu_decoding_ = false;
+            decoder_name_ = "cpu";
+            
             // 检查source是否为数字（摄像头索引）
             if (isNumeric(config_.source)) {
                 int camera_id = std::stoi(config_.source);
                 LOG_DEBUG("Attempting to open camera with ID: {}", camera_id);
                 return cap_.open(camera_id);
-            } else {
-                // 文件路径或网络流
-                LOG_DEBUG("Attempting to open video source: {}", config_.source);
-                return cap_.open(config_.source);
             }
+            
+            std::string mode = config_.decode_mode;
+            std::transform(mode.begin(), mode.end(), mode.begin(), ::tolower);
+            
+            if (mode == "cuda") {
+                if ((allow_gpu && openCudaDecoder()) || openGStreamerDecoder() ||
+                    openFfmpegHardwareDecoder(cv::VIDEO_ACCELERATION_ANY, "ffmpeg-hw")) {
+                    return true;
+                }
+                LOG_WARN("CUDA decoding unavailable for {}, falling back to CPU", config_.source);
+            } else if (mode == "vaapi") {
+                if (openFfmpegHardwareDecoder(cv::VIDEO_ACCELERATION_VAAPI, "vaapi")) {
+                    return true;
+                }
+                LOG_WARN("VAAPI decoding unavailable for {}, falling back to CPU", config_.source);
+            } else if (mode != "cpu") {
+                LOG_WARN("Unknown decode mode {}, using CPU", config_.decode_mode);
+            }
+            
+            // 文件路径或网络流
+            LOG_DEBUG("Attempting to open video source: {}", config_.source);
+            return cap_.open(config_.source, cv::CAP_ANY, networkTimeoutParams());
         } catch (const std::exception& e) {
             LOG_ERROR("Exception while opening video source: {}", e.what());
             return false;
         }
     }
     
+    /**
+     * @brief 使用NVDEC解码，帧保留在显存中
+     */
+    bool openCudaDecoder() {
+#ifdef VIDEO_CUDA_DECODE
+        if (cv::cuda::getCudaEnabledDeviceCount() <= 0) {
+            return false;
+        }
+        try {
+            // 打开和读帧超时参数交给NVDEC读取器内部的FFmpeg解复用器
+            gpu_reader_ = cv::cudacodec::createVideoReader(config_.source, networkTimeoutParams());
+        } catch (const cv::Exception& e) {
+            LOG_DEBUG("NVDEC reader unavailable: {}", e.what());
+            gpu_reader_.release();
+            return false;
+        }
+        if (!gpu_reader_) {
+            return false;
+        }
+        gpu_decoding_ = true;
+        decoder_name_ = "nvdec";
+        return true;
+#else
+        return false;
+#endif
+    }
+    
+    /**
+     * @brief 使用GStreamer硬件解码管线(Jetson nvv4l2decoder，由uridecodebin自动选择)
+     */
+    bool openGStreamerDecoder() {
+        std::string uri = config_.source;
+        if (uri.find("://") == std::string::npos) {
+            std::error_code ec;
+            uri = "file://" + std::filesystem::absolute(config_.source, ec).string();
+        }
+        std::string pipeline = "uridecodebin uri=" + uri +
+                               " ! nvvidconv ! video/x-raw,format=BGRx ! videoconvert"
+                               " ! video/x-raw,format=BGR ! appsink drop=true max-buffers=2 sync=false";
+        if (!cap_.open(pipeline, cv::CAP_GSTREAMER)) {
+            return false;
+        }
+        decoder_name_ = "gstreamer";
+        return true;
+    }
+    
+    /**
+     * @brief 使用FFmpeg后端的硬件解码
+     * @param acceleration cv::VideoAccelerationType
+     * @param name 解码器名称(用于日志)
+     */
+    bool openFfmpegHardwareDecoder(int acceleration, const char* name) {
+        std::vector<int> params = networkTimeoutParams();
+        params.insert(params.end(), {cv::CAP_PROP_HW_ACCELERATION, acceleration});
+        if (!cap_.open(config_.source, cv::CAP_FFMPEG, params)) {
+            return false;
+        }
+        if (static_cast<int>(cap_.get(cv::CAP_PROP_HW_ACCELERATION)) == cv::VIDEO_ACCELERATION_NONE) {
+            // FFmpeg已打开但回退到软件解码，保留连接避免重复打开
+            LOG_WARN("FFmpeg hardware acceleration ({}) not available, decoding on CPU", name);
+            decoder_name_ = "cpu";
+            return true;
+        }
+        decoder_name_ = name;
+        return true;
+    }
+    
+    /**
+     * @brief 网络流的打开和读帧超时参数，卡死的连接在超时后返回失败而不是无限阻塞
+     */
+    std::vector<int> networkTimeoutParams() const {
+        if (isNumeric(config_.source) || !isLiveSource() || config_.read_timeout_ms <= 0) {
+            return {};
+        }
+        return {cv::CAP_PROP_OPEN_TIMEOUT_MSEC, config_.read_timeout_ms,
+                cv::CAP_PROP_READ_TIMEOUT_MSEC, config_.read_timeout_ms};
+    }
+    
+    bool isSourceOpened() const {
+#ifdef VIDEO_CUDA_DECODE
+        if (gpu_decoding_) {
+            return !gpu_reader_.empty();
+        }
+#endif
+        return cap_.isOpened();
+    }
+    
+    /**
+     * @brief 是否为实时源(摄像头或网络流)
+     */
+    bool isLiveSource() const {
+        if (isNumeric(config_.source)) {
+            return true;
+        }
+        return config_.source.find("://") != std::string::npos &&
+               config_.source.rfind("file://", 0) != 0;
+    }
+    
     /**
      * @brief 检查字符串是否为数字
      * @param str 待检查的字符串
      * @return bool 是否为数字
      */
-    bool isNumeric(const std::string& str) {
+    static bool isNumeric(const std::string& str) {
         if (str.empty()) return false;
         
         for (char c : str) {
@@ -319,11 +583,10 @@ private:
     }
     
     /**
-     * @brief 视频处理主循环
+     * @brief 视频文件处理主循环(CPU解码和NVDEC)，读帧和交付在同一线程
      */
     void processLoop() {
-        cv::Mat frame;
-        auto last_frame_time = std::chrono::steady_clock::now();
+        auto next_frame_time = std::chrono::steady_clock::now();
         double frame_interval = 1000.0 / properties_.fps; // 毫秒
         
         while (running_) {
@@ -332,64 +595,585 @@ private:
                 continue;
             }
             
-            if (!cap_.read(frame)) {
-                LOG_WARN("Failed to read frame from video source");
-                if (properties_.is_stream) {
-                    // 对于流，尝试重新连接
-                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                    continue;
-                } else {
-                    // 对于文件，到达末尾
-                    LOG_INFO("Reached end of video file");
+#ifdef VIDEO_CUDA_DECODE
+            if (gpu_decoding_) {
+                // 每帧使用新的GpuMat，下游仍持有的显存不会被覆盖
+                static LatencyHistogram& decode_latency = stageLatency("decode");
+                static Counter& frames_captured = MetricsRegistry::instance().counter(
+                    "vps_frames_captured_total", "", "Frames decoded from the video source");
+                cv::cuda::GpuMat gpu_frame;
+                const auto decode_start = std::chrono::steady_clock::now();
+                if (!gpu_reader_->nextFrame(gpu_frame)) {
+                    if (handleReadFailure()) {
+                        continue;
+                    }
                     break;
                 }
+                decode_latency.record(std::chrono::steady_clock::now() - decode_start);
+                frames_captured.add();
+                frames_read_++;
+                if (!gpu_frame.empty()) {
+                    FrameTrace trace;
+                    trace.frame_id = frames_read_;
+                    trace.capture_time_us = traceClockMicros();
+                    dispatchGpuFrame(gpu_frame, trace);
+                }
+                throttle(next_frame_time, frame_interval);
+                continue;
             }
+#endif
             
-            if (frame.empty()) {
+            // 从帧池借出缓冲区，解码直接写入预分配内存；下游仍持有的缓冲区不会被覆盖
+            FrameHandle buffer = acquireFrameBuffer();
+            if (!buffer) {
+                skipFrame();
                 continue;
             }
+            if (!readFrame(buffer)) {
+                if (handleReadFailure()) {
+                    continue;
+                }
+                break;
+            }
+            deliverFrame(std::move(buffer));
             
-            // 应用畸变校正
-            if (distortion_correction_enabled_ && !camera_matrix_.empty() && !distortion_coeffs_.empty()) {
-                cv::Mat undistorted;
-                cv::undistort(frame, undistorted, camera_matrix_, distortion_coeffs_);
-                frame = undistorted;
+            throttle(next_frame_time, frame_interval);
+        }
+        
+        LOG_INFO("Video processing loop ended");
+    }
+    
+    /**
+     * @brief 实时源采集线程：读帧写入待交付槽位，断流时在本线程重连，不影响交付
+     * 交付线程来不及取走时新帧覆盖旧帧，下游总是拿到最新画面
+     */
+    void captureLoop() {
+        static Counter& overrun_drops = MetricsRegistry::instance().counter(
+            "vps_frames_dropped_total", "reason=\"capture_overrun\"", "Frames dropped before processing");
+        
+        while (running_) {
+#ifdef VIDEO_CUDA_DECODE
+            if (gpu_decoding_) {
+                captureGpuFrame(overrun_drops);
+                continue;
+            }
+#endif
+            FrameHandle buffer = acquireFrameBuffer();
+            if (!buffer) {
+                skipFrame();
+                continue;
+            }
+            if (!readFrame(buffer)) {
+                LOG_WARN("Failed to read frame from {}, reconnecting", config_.source);
+                recoverStream();
+                continue;
+            }
+            if (buffer->storage.empty()) {
+                continue;
             }
             
-            // 应用ROI裁剪
-            if (roi_enabled_ && !roi_rect_.empty()) {
-                // 确保ROI在图像范围内
-                cv::Rect safe_roi = roi_rect_ & cv::Rect(0, 0, frame.cols, frame.rows);
-                if (!safe_roi.empty()) {
-                    frame = frame(safe_roi);
+            {
+                std::lock_guard<std::mutex> lock(slot_mutex_);
+                if (latest_frame_) {
+                    overrun_drops.add();
+                }
+                latest_frame_ = std::move(buffer);
+            }
+            slot_cv_.notify_one();
+        }
+        LOG_INFO("Video capture loop ended");
+    }
+    
+#ifdef VIDEO_CUDA_DECODE
+    /**
+     * @brief NVDEC解码一帧写入待交付槽位(采集线程调用)，读帧失败时重连
+     */
+    void captureGpuFrame(Counter& overrun_drops) {
+        static LatencyHistogram& decode_latency = stageLatency("decode");
+        static Counter& frames_captured = MetricsRegistry::instance().counter(
+            "vps_frames_captured_total", "", "Frames decoded from the video source");
+        
+        // 每帧使用新的GpuMat，下游仍持有的显存不会被覆盖
+        cv::cuda::GpuMat gpu_frame;
+        const auto decode_start = std::chrono::steady_clock::now();
+        if (!gpu_reader_->nextFrame(gpu_frame)) {
+            LOG_WARN("Failed to read frame from {}, reconnecting", config_.source);
+            recoverStream();
+            return;
+        }
+        decode_latency.record(std::chrono::steady_clock::now() - decode_start);
+        frames_captured.add();
+        frames_read_++;
+        if (gpu_frame.empty()) {
+            return;
+        }
+        
+        FrameTrace trace;
+        trace.frame_id = frames_read_;
+        trace.capture_time_us = traceClockMicros();
+        {
+            std::lock_guard<std::mutex> lock(slot_mutex_);
+            if (gpu_frame_ready_) {
+                overrun_drops.add();
+            }
+            latest_gpu_frame_ = gpu_frame;
+            latest_gpu_trace_ = trace;
+            gpu_frame_ready_ = true;
+        }
+        slot_cv_.notify_one();
+    }
+#endif
+    
+    /**
+     * @brief 实时源交付线程：取最新帧处理并交付；超过stale_timeout_ms无新帧时
+     * 每stale_timeout_ms重复交付一次最后一帧(标记stale)，直到采集恢复
+     */
+    void deliveryLoop() {
+        const auto stale_timeout = std::chrono::milliseconds(std::max(1, config_.stale_timeout_ms));
+        bool stale = false;
+        
+        while (running_) {
+            FrameHandle buffer;
+            cv::cuda::GpuMat gpu_frame;
+            FrameTrace gpu_trace;
+            bool gpu_ready = false;
+            {
+                std::unique_lock<std::mutex> lock(slot_mutex_);
+                slot_cv_.wait_for(lock, stale_timeout,
+                                  [this]() { return latest_frame_ || gpu_frame_ready_ || !running_; });
+                if (!running_) {
+                    break;
+                }
+                buffer = std::move(latest_frame_);
+                if (gpu_frame_ready_) {
+                    gpu_frame = latest_gpu_frame_;
+                    gpu_trace = latest_gpu_trace_;
+                    latest_gpu_frame_.release();
+                    gpu_frame_ready_ = false;
+                    gpu_ready = true;
                 }
             }
+            if (paused_) {
+                continue;
+            }
             
-            // 调用帧回调函数
-            if (frame_callback_) {
-                uint64_t timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
-                    std::chrono::steady_clock::now().time_since_epoch()).count();
-                
-                std::lock_guard<std::mutex> lock(callback_mutex_);
-                frame_callback_(frame, timestamp);
+            if (buffer || gpu_ready) {
+                if (stale) {
+                    LOG_INFO("Frames from {} resumed", config_.source);
+                    stale = false;
+                }
+                if (buffer) {
+                    if (!buffer->storage.empty()) {
+                        last_good_frame_ = buffer;
+                    }
+                    deliverFrame(std::move(buffer));
+                }
+#ifdef VIDEO_CUDA_DECODE
+                if (gpu_ready) {
+                    last_good_gpu_frame_ = gpu_frame;
+                    last_good_gpu_trace_ = gpu_trace;
+                    dispatchGpuFrame(gpu_frame, gpu_trace);
+                }
+#endif
+                continue;
+            }
+            if (!last_good_frame_ && last_good_gpu_frame_.empty()) {
+                continue;
+            }
+            if (!stale) {
+                LOG_WARN("No frame from {} for {}ms, repeating the last frame as stale", config_.source,
+                         stale_timeout.count());
+                stale = true;
+            }
+            deliverStaleFrame();
+        }
+        LOG_INFO("Video processing loop ended");
+    }
+    
+    /**
+     * @brief 把一帧解码到缓冲区并填写采集信息
+     * @return bool 读帧是否成功(成功时帧仍可能为空)
+     */
+    bool readFrame(const FrameHandle& buffer) {
+        static LatencyHistogram& decode_latency = stageLatency("decode");
+        static Counter& frames_captured = MetricsRegistry::instance().counter(
+            "vps_frames_captured_total", "", "Frames decoded from the video source");
+        
+        const auto decode_start = std::chrono::steady_clock::now();
+        if (!cap_.read(buffer->storage)) {
+            return false;
+        }
+        decode_latency.record(std::chrono::steady_clock::now() - decode_start);
+        frames_captured.add();
+        frames_read_++;
+        
+        // 采集时刻取解码完成时，畸变校正等耗时计入下游延迟
+        buffer->capture_time_us = traceClockMicros();
+        buffer->media_time_ms = readMediaTime();
+        buffer->sequence = frames_read_;
+        buffer->timestamp = buffer->capture_time_us / 1000;
+        buffer->stale = false;
+        return true;
+    }
+    
+    /**
+     * @brief 对原始帧做畸变校正和ROI裁剪后交付
+     */
+    void deliverFrame(FrameHandle buffer) {
+        if (buffer->storage.empty()) {
+            return;
+        }
+        buffer->image = buffer->storage;
+        
+        // 应用畸变校正，输出写入池中另一个缓冲区；ROI已折叠进映射表时只计算ROI内的像素
+        bool roi_applied = false;
+        if (isDistortionCorrectionActive()) {
+            ensureUndistortMaps(buffer->storage.size());
+            FrameHandle undistorted = acquireFrameBuffer();
+            if (!undistorted) {
+                return;
+            }
+            undistorted->storage.create(buffer->storage.size(), buffer->storage.type());
+            cv::Size output_size = map_roi_.empty() ? buffer->storage.size() : map_roi_.size();
+            // 写入缓冲区左上角，保持池化缓冲区尺寸不变
+            cv::Mat output = undistorted->storage(cv::Rect(0, 0, output_size.width, output_size.height));
+            cv::remap(buffer->storage, output, undistort_map1_, undistort_map2_, cv::INTER_LINEAR);
+            undistorted->image = output;
+            undistorted->sequence = buffer->sequence;
+            undistorted->timestamp = buffer->timestamp;
+            undistorted->capture_time_us = buffer->capture_time_us;
+            undistorted->media_time_ms = buffer->media_time_ms;
+            undistorted->stale = buffer->stale;
+            buffer = std::move(undistorted);
+            roi_applied = !map_roi_.empty();
+        }
+        
+        // 应用ROI裁剪(只调整视图，不复制像素)
+        if (!roi_applied && roi_enabled_ && !roi_rect_.empty()) {
+            // 确保ROI在图像范围内
+            cv::Rect safe_roi = roi_rect_ & cv::Rect(0, 0, buffer->storage.cols, buffer->storage.rows);
+            if (!safe_roi.empty()) {
+                buffer->image = buffer->storage(safe_roi);
+            }
+        }
+        
+        dispatchFrame(buffer);
+    }
+    
+    /**
+     * @brief 重复交付最后一帧：像素复制到新缓冲区，时间戳取当前时刻，采集序号沿用原帧
+     */
+    void deliverStaleFrame() {
+#ifdef VIDEO_CUDA_DECODE
+        if (!last_good_gpu_frame_.empty()) {
+            FrameTrace trace = last_good_gpu_trace_;
+            trace.capture_time_us = traceClockMicros();
+            trace.media_time_ms = -1.0;
+            trace.stale = true;
+            if (stale_frames_) {
+                stale_frames_->add();
+            }
+            dispatchGpuFrame(last_good_gpu_frame_, trace);
+            return;
+        }
+#endif
+        FrameHandle copy = frame_pool_.acquire(std::chrono::milliseconds(0));
+        if (!copy) {
+            return;
+        }
+        last_good_frame_->storage.copyTo(copy->storage);
+        copy->sequence = last_good_frame_->sequence;
+        copy->capture_time_us = traceClockMicros();
+        copy->timestamp = copy->capture_time_us / 1000;
+        copy->media_time_ms = -1.0;
+        copy->stale = true;
+        if (stale_frames_) {
+            stale_frames_->add();
+        }
+        deliverFrame(std::move(copy));
+    }
+    
+    /**
+     * @brief 实时源断流后重连，每次失败退避时间加倍，直到成功或停止
+     * 解码路径保持不变(NVDEC只重建NVDEC读取器)，期间交付线程继续交付stale帧
+     * @return bool 是否已重新连接
+     */
+    bool recoverStream() {
+        const auto lost_at = std::chrono::steady_clock::now();
+        if (connected_) {
+            connected_->set(0.0);
+        }
+        int backoff_ms = std::max(1, config_.reconnect_initial_ms);
+        for (int attempt = 1; running_; ++attempt) {
+            // 分段休眠，停止时及时退出
+            const auto wake = std::chrono::steady_clock::now() + std::chrono::milliseconds(backoff_ms);
+            while (running_ && std::chrono::steady_clock::now() < wake) {
+                std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+                    std::chrono::milliseconds(50), wake - std::chrono::steady_clock::now()));
+            }
+            if (!running_) {
+                break;
             }
             
-            // 控制帧率
-            if (!properties_.is_stream) {
-                auto current_time = std::chrono::steady_clock::now();
-                auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-                    current_time - last_frame_time).count();
-                
-                if (elapsed < frame_interval) {
-                    std::this_thread::sleep_for(
-                        std::chrono::milliseconds(static_cast<int>(frame_interval - elapsed)));
+            if (reopenSource()) {
+                const double down_sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - lost_at).count();
+                downtime_sec_ += down_sec;
+                if (reconnects_) {
+                    reconnects_->add();
+                    downtime_->set(downtime_sec_);
+                    connected_->set(1.0);
                 }
-                last_frame_time = std::chrono::steady_clock::now();
+                LOG_INFO("Reconnected to {} on attempt {} after {}s", config_.source, attempt, down_sec);
+                return true;
+            }
+            backoff_ms = std::min(backoff_ms * 2, std::max(backoff_ms, config_.reconnect_max_ms));
+            LOG_WARN("Reconnect attempt {} to {} failed, retrying in {}ms", attempt, config_.source, backoff_ms);
+        }
+        return false;
+    }
+    
+    /**
+     * @brief 按当前解码路径重新打开视频源
+     */
+    bool reopenSource() {
+#ifdef VIDEO_CUDA_DECODE
+        if (gpu_decoding_) {
+            gpu_reader_.release();
+            return openCudaDecoder();
+        }
+#endif
+        cap_.release();
+        if (!openVideoSource(false)) {
+            return false;
+        }
+        applyCaptureSettings();
+        return true;
+    }
+    
+    // 设置采集分辨率和帧率(摄像头有效，文件和网络流忽略)
+    void applyCaptureSettings() {
+        if (config_.width > 0 && config_.height > 0) {
+            cap_.set(cv::CAP_PROP_FRAME_WIDTH, config_.width);
+            cap_.set(cv::CAP_PROP_FRAME_HEIGHT, config_.height);
+        }
+        if (config_.fps > 0) {
+            cap_.set(cv::CAP_PROP_FPS, config_.fps);
+        }
+    }
+    
+    // 是否使用后台采集线程(实时源，CPU解码和NVDEC均是)
+    bool usesCaptureThread() const {
+        return properties_.is_stream;
+    }
+    
+    /**
+     * @brief 按视频源注册连接指标，标签中的源地址去掉用户名和密码
+     */
+    void registerConnectionMetrics() {
+        std::string source = config_.source;
+        const size_t scheme = source.find("://");
+        const size_t at = source.find('@', scheme == std::string::npos ? 0 : scheme + 3);
+        if (scheme != std::string::npos && at != std::string::npos && at < source.find('/', scheme + 3)) {
+            source.erase(scheme + 3, at + 1 - (scheme + 3));
+        }
+        std::string escaped;
+        for (char c : source) {
+            if (c == '"' || c == '\\') {
+                escaped += '\\';
             }
+            escaped += c;
         }
+        const std::string labels = "source=\"" + escaped + "\"";
         
-        LOG_INFO("Video processing loop ended");
+        auto& registry = MetricsRegistry::instance();
+        reconnects_ = &registry.counter("vps_capture_reconnects_total", labels,
+                                        "Successful reconnects after a live source stopped delivering");
+        stale_frames_ = &registry.counter("vps_capture_stale_frames_total", labels,
+                                          "Last good frame re-delivered while a live source was down");
+        downtime_ = &registry.gauge("vps_capture_downtime_seconds", labels,
+                                    "Accumulated time a live source spent disconnected");
+        connected_ = &registry.gauge("vps_capture_connected", labels,
+                                     "Whether the video source is currently delivering frames");
+        connected_->set(1.0);
+    }
+    
+    bool isDistortionCorrectionActive() const {
+        return distortion_correction_enabled_ && !camera_matrix_.empty() && !distortion_coeffs_.empty();
+    }
+    
+    /**
+     * @brief 按需重建畸变校正映射表
+     * 映射表只依赖相机参数、分辨率和ROI，每帧只需remap，不再像cv::undistort那样重复计算。
+     * ROI有效时只保留ROI内的映射，remap直接输出裁剪后的图像，ROI外的像素不做校正
+     * @param frame_size 输入帧尺寸
+     */
+    void ensureUndistortMaps(const cv::Size& frame_size) {
+        bool ready = !undistort_map1_.empty();
+#ifdef VIDEO_CUDA_DECODE
+        if (gpu_decoding_) {
+            ready = !gpu_map_x_.empty();
+        }
+#endif
+        if (!maps_dirty_ && ready && frame_size == map_frame_size_) {
+            return;
+        }
+        maps_dirty_ = false;
+        
+        cv::Mat map_x, map_y;
+        cv::initUndistortRectifyMap(camera_matrix_, distortion_coeffs_, cv::Mat(), camera_matrix_,
+                                    frame_size, CV_32FC1, map_x, map_y);
+        
+        map_roi_ = cv::Rect();
+        if (roi_enabled_ && !roi_rect_.empty()) {
+            cv::Rect safe_roi = roi_rect_ & cv::Rect(0, 0, frame_size.width, frame_size.height);
+            if (!safe_roi.empty() && safe_roi.size() != frame_size) {
+                map_roi_ = safe_roi;
+                map_x = map_x(safe_roi).clone();
+                map_y = map_y(safe_roi).clone();
+            }
+        }
+        
+        if (gpu_decoding_) {
+#ifdef VIDEO_CUDA_DECODE
+            // cv::cuda::remap只接受浮点映射表
+            gpu_map_x_.upload(map_x);
+            gpu_map_y_.upload(map_y);
+#endif
+        } else {
+            // 定点映射表使remap走查表插值的快速路径
+            cv::convertMaps(map_x, map_y, undistort_map1_, undistort_map2_, CV_16SC2);
+        }
+        map_frame_size_ = frame_size;
+        
+        LOG_INFO("Undistortion maps built for {}x{}, output {}x{}", frame_size.width, frame_size.height,
+                 map_x.cols, map_x.rows);
+    }
+    
+    /**
+     * @brief 借出帧缓冲区
+     * 实时流不等待，池耗尽即丢帧以保证延迟；视频文件阻塞等待下游归还缓冲区，形成背压
+     */
+    FrameHandle acquireFrameBuffer() {
+        if (properties_.is_stream) {
+            return frame_pool_.acquire(std::chrono::milliseconds(0));
+        }
+        while (running_) {
+            FrameHandle buffer = frame_pool_.acquire(std::chrono::milliseconds(100));
+            if (buffer) {
+                return buffer;
+            }
+        }
+        return nullptr;
+    }
+    
+    /**
+     * @brief 当前帧的源媒体时间(毫秒)，文件为播放位置，网络流由后端按PTS换算；不支持时为-1
+     */
+    double readMediaTime() const {
+        const double position = cap_.get(cv::CAP_PROP_POS_MSEC);
+        return position >= 0.0 ? position : -1.0;
+    }
+    
+    /**
+     * @brief 缓冲池耗尽时跳过一帧，实时流仍需取走该帧以免采集积压
+     */
+    void skipFrame() {
+        if (!properties_.is_stream) {
+            return;
+        }
+        if (cap_.grab()) {
+            frames_read_++;
+            static Counter& pool_drops = MetricsRegistry::instance().counter(
+                "vps_frames_dropped_total", "reason=\"frame_pool\"", "Frames dropped before processing");
+            pool_drops.add();
+            LOG_DEBUG("Frame pool exhausted, dropped frame {}", frames_read_);
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    
+    /**
+     * @brief 交付帧，优先使用池化句柄回调，否则以cv::Mat交付
+     */
+    void dispatchFrame(const FrameHandle& buffer) {
+        if (!frame_buffer_callback_(buffer)) {
+            frame_callback_(buffer->image, buffer->timestamp);
+        }
+    }
+    
+    /**
+     * @brief 处理读帧失败
+     * @return bool true表示继续读取(流等待重连)，false表示结束(文件末尾)
+     */
+    bool handleReadFailure() {
+        LOG_WARN("Failed to read frame from video source");
+        if (properties_.is_stream) {
+            // 对于流，退避重连
+            return recoverStream();
+        }
+        // 对于文件，到达末尾
+        LOG_INFO("Reached end of video file");
+        finished_ = true;
+        return false;
+    }
+    
+    /**
+     * @brief 视频文件按原始帧率乘以回放倍速播放，playback_rate为0时不限速
+     * 按固定节拍计算下一帧的截止时间，休眠误差不会逐帧累积；落后超过一帧时重新对齐
+     */
+    void throttle(std::chrono::steady_clock::time_point& next_frame_time, double frame_interval) {
+        if (properties_.is_stream || config_.playback_rate <= 0.0f) {
+            return;
+        }
+        const auto interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double, std::milli>(frame_interval / config_.playback_rate));
+        next_frame_time += interval;
+        const auto now = std::chrono::steady_clock::now();
+        if (next_frame_time > now) {
+            std::this_thread::sleep_until(next_frame_time);
+        } else if (now - next_frame_time > interval) {
+            next_frame_time = now;
+        }
+    }
+    
+#ifdef VIDEO_CUDA_DECODE
+    /**
+     * @brief 在GPU上完成通道转换、畸变校正和ROI裁剪后交付帧
+     * 注册了GPU回调时帧不离开显存，否则下载后走普通回调
+     */
+    void dispatchGpuFrame(cv::cuda::GpuMat frame, const FrameTrace& trace) {
+        // NVDEC默认输出BGRA
+        if (frame.channels() == 4) {
+            cv::cuda::GpuMat bgr;
+            cv::cuda::cvtColor(frame, bgr, cv::COLOR_BGRA2BGR);
+            frame = bgr;
+        }
+        
+        // 应用畸变校正，ROI已折叠进映射表时输出即为裁剪后的图像
+        bool roi_applied = false;
+        if (isDistortionCorrectionActive()) {
+            ensureUndistortMaps(frame.size());
+            cv::cuda::GpuMat undistorted;
+            cv::cuda::remap(frame, undistorted, gpu_map_x_, gpu_map_y_, cv::INTER_LINEAR);
+            frame = undistorted;
+            roi_applied = !map_roi_.empty();
+        }
+        
+        // 应用ROI裁剪
+        if (!roi_applied && roi_enabled_ && !roi_rect_.empty()) {
+            cv::Rect safe_roi = roi_rect_ & cv::Rect(0, 0, frame.cols, frame.rows);
+            if (!safe_roi.empty()) {
+                frame = frame(safe_roi);
+            }
+        }
+        
+        if (!gpu_frame_callback_(frame, trace) && !frame_callback_.empty()) {
+            cv::Mat host;
+            frame.download(host);
+            frame_callback_(host, trace.capture_time_us / 1000);
+        }
     }
+#endif
 };
 
 // 静态工厂函数实现